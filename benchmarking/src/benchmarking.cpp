@@ -1,17 +1,47 @@
 #include "avl_tree/avl_tree.h"
+#include "btree/btree.h"
+#include "compact_avl/compact_avl_tree.h"
+#include "concurrent_avl/concurrent_avl_tree.h"
+#include "concurrent_skiplist/concurrent_skiplist.h"
 #include "container.h"
+#include "mmap_avl/mmap_avl_tree.h"
+#include "persistent_avl/persistent_avl_tree.h"
 #include "placeholder.h"
+#include "skiplist/skiplist.h"
+#include "stats.h"
+#include "unrolled_skiplist/unrolled_skiplist.h"
 
+#include <algorithm>
 #include <array>
 #include <chrono>
 #include <cstring> // for strcmp
+#include <filesystem>
 #include <iostream>
+#include <memory>
+#include <random>
 #include <set>
+#include <span>
 #include <string>
+#include <thread>
+#include <vector>
 
 namespace {
+// MmapAVLTree on a scratch file, so the runs can default construct it
+template <typename T> class ScratchMmapAVLTree : public MmapAVLTree<T> {
+  public:
+    ScratchMmapAVLTree() : MmapAVLTree<T>(scratchPath()) { this->clear(); }
+    ScratchMmapAVLTree(const ScratchMmapAVLTree &) = delete;
+    ScratchMmapAVLTree &operator=(const ScratchMmapAVLTree &) = delete;
+    ~ScratchMmapAVLTree() { std::filesystem::remove(scratchPath()); }
+
+  private:
+    static std::filesystem::path scratchPath() {
+        return std::filesystem::temp_directory_path() / "mmap_avl_bench.tree";
+    }
+};
+
 template <typename C, typename T, size_t N>
-    requires Dontainer<C, T>
+    requires Dontainer<C, T> || ConcurrentDontainer<C, T>
 double testInsertSearchRemove(const std::array<T, N> &dataset) {
     C container;
 
@@ -76,19 +106,63 @@ void runFullTestMode(const std::array<T, N> &dataset,
         double avlTime = testInsertSearchRemove<AVLTree<T>>(dataset);
         std::cout << "AVLTree insert+search+remove time: " << avlTime
                   << " ms\n";
+    } else if (mode == "avl-pool") {
+        double avlTime = testInsertSearchRemove<PooledAVLTree<T>>(dataset);
+        std::cout << "PooledAVLTree insert+search+remove time: " << avlTime
+                  << " ms\n";
+    } else if (mode == "avl-compact") {
+        double avlTime = testInsertSearchRemove<CompactAVLTree<T>>(dataset);
+        std::cout << "CompactAVLTree insert+search+remove time: " << avlTime
+                  << " ms\n";
+    } else if (mode == "avl-concurrent") {
+        double avlTime = testInsertSearchRemove<ConcurrentAVLTree<T>>(dataset);
+        std::cout << "ConcurrentAVLTree insert+search+remove time: " << avlTime
+                  << " ms\n";
+    } else if (mode == "avl-persistent") {
+        double avlTime = testInsertSearchRemove<PersistentAVLTree<T>>(dataset);
+        std::cout << "PersistentAVLTree insert+search+remove time: " << avlTime
+                  << " ms\n";
+    } else if (mode == "avl-mmap") {
+        double avlTime =
+            testInsertSearchRemove<ScratchMmapAVLTree<T>>(dataset);
+        std::cout << "MmapAVLTree insert+search+remove time: " << avlTime
+                  << " ms\n";
+    } else if (mode == "avl-frozen") {
+        std::cout << "FrozenSet is read only, no insert+search+remove run\n";
+    } else if (mode == "skiplist") {
+        double skipTime = testInsertSearchRemove<SkipList<T>>(dataset);
+        std::cout << "SkipList insert+search+remove time: " << skipTime
+                  << " ms\n";
+    } else if (mode == "skiplist-concurrent") {
+        double skipTime =
+            testInsertSearchRemove<ConcurrentSkipList<T>>(dataset);
+        std::cout << "ConcurrentSkipList insert+search+remove time: "
+                  << skipTime << " ms\n";
+    } else if (mode == "skiplist-unrolled") {
+        double skipTime = testInsertSearchRemove<UnrolledSkipList<T>>(dataset);
+        std::cout << "UnrolledSkipList insert+search+remove time: " << skipTime
+                  << " ms\n";
+    } else if (mode == "btree") {
+        double btreeTime = testInsertSearchRemove<BTreeSet<T>>(dataset);
+        std::cout << "BTreeSet insert+search+remove time: " << btreeTime
+                  << " ms\n";
     } else if (mode == "set") {
         double setTime = testInsertSearchRemoveSet(dataset);
         std::cout << "std::set insert+search+erase time: " << setTime
                   << " ms\n";
     } else {
-        std::cerr << "Unknown mode '" << mode << "'. Use 'avl' or 'set'.\n";
+        std::cerr << "Unknown mode '" << mode
+                  << "'. Use 'avl', 'avl-pool', 'avl-compact', "
+                     "'avl-concurrent', 'avl-persistent', 'avl-mmap', "
+                     "'avl-frozen', 'skiplist', 'skiplist-concurrent', "
+                     "'skiplist-unrolled', 'btree' or 'set'.\n";
     }
 
     std::cout << "\n";
 }
 
 template <typename C, typename T, size_t N>
-    requires Dontainer<C, T>
+    requires Dontainer<C, T> || ConcurrentDontainer<C, T>
 double testInsertHeavySearchLight(const std::array<T, N> &dataset,
                                   size_t searchRepeats) {
     C container;
@@ -114,6 +188,32 @@ double testInsertHeavySearchLight(const std::array<T, N> &dataset,
     return duration_ms.count();
 }
 
+// The searches run on a frozen copy of the tree, freezing is not timed
+template <typename T, size_t N>
+double testInsertHeavySearchLightFrozen(const std::array<T, N> &dataset,
+                                        size_t searchRepeats) {
+    AVLTree<T> tree;
+
+    for (auto &datapoint : dataset) {
+        tree.insert(datapoint);
+    }
+    FrozenSet<T> container = tree.freeze();
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (size_t repeat = 0; repeat < searchRepeats; ++repeat) {
+        for (auto &datapoint : dataset) {
+            volatile bool found = container.contains(datapoint);
+            (void)found;
+        }
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+
+    std::chrono::duration<double, std::milli> duration_ms = end - start;
+    return duration_ms.count();
+}
+
 template <typename T, size_t N>
 double testInsertHeavySearchLightSet(const std::array<T, N> &dataset,
                                      size_t searchRepeats) {
@@ -138,6 +238,167 @@ double testInsertHeavySearchLightSet(const std::array<T, N> &dataset,
     return duration_ms.count();
 }
 
+// The placeholder datasets fit in cache, the lookup comparison needs a set
+// large enough for every descent to miss
+constexpr size_t LOOKUP_MANY_SIZE = 1 << 22;
+constexpr size_t LOOKUP_MANY_KEYS = 1 << 20;
+
+template <typename C>
+void testLookupMany(const std::string &name, const std::vector<int> &values,
+                    const std::vector<int> &keys) {
+    C container;
+    container.insertBatch(values);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    size_t scalarHits = 0;
+    for (int key : keys) {
+        scalarHits += container.contains(key) ? 1 : 0;
+    }
+    auto middle = std::chrono::high_resolution_clock::now();
+    auto found = std::make_unique<bool[]>(keys.size());
+    size_t batchHits =
+        container.containsMany(keys, std::span<bool>(found.get(), keys.size()));
+    auto end = std::chrono::high_resolution_clock::now();
+
+    std::chrono::duration<double, std::milli> scalarMs = middle - start;
+    std::chrono::duration<double, std::milli> batchMs = end - middle;
+    std::cout << name << " contains loop: " << scalarMs.count()
+              << " ms, containsMany: " << batchMs.count() << " ms ("
+              << scalarMs.count() / batchMs.count() << "x, " << batchHits
+              << "/" << scalarHits << " hits)\n";
+}
+
+void runLookupManyMode() {
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> dist(0, 2 * LOOKUP_MANY_SIZE);
+    std::vector<int> values(LOOKUP_MANY_SIZE);
+    for (int &value : values) {
+        value = dist(gen);
+    }
+    std::vector<int> keys(LOOKUP_MANY_KEYS);
+    for (int &key : keys) {
+        key = dist(gen);
+    }
+
+    std::cout << "Dataset: " << LOOKUP_MANY_SIZE << " random ints, "
+              << LOOKUP_MANY_KEYS << " lookups\n";
+    testLookupMany<AVLTree<int>>("AVLTree", values, keys);
+    testLookupMany<SkipList<int>>("SkipList", values, keys);
+}
+
+constexpr size_t STATS_SIZE = 1 << 20;
+
+// Print what a random insert, search and remove workload costs in
+// comparisons, rotations, allocations and search depth
+template <typename C> void printStats(const std::string &name) {
+    C container;
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> dist(0, 2 * STATS_SIZE);
+    for (size_t i = 0; i < STATS_SIZE; ++i) {
+        container.insert(dist(gen));
+    }
+    for (size_t i = 0; i < STATS_SIZE; ++i) {
+        volatile bool found = container.contains(dist(gen));
+        (void)found;
+    }
+    for (size_t i = 0; i < STATS_SIZE / 2; ++i) {
+        container.remove(dist(gen));
+    }
+
+    const StatsSnapshot stats = container.stats().snapshot();
+    std::cout << name << ": " << stats.comparisons << " comparisons, "
+              << stats.leftRotations << " left / " << stats.rightRotations
+              << " right / " << stats.doubleRotations << " double rotations, "
+              << stats.allocations << " allocations\n";
+    std::cout << "  search depth:";
+    for (size_t depth = 0; depth < STATS_HISTOGRAM_SIZE; ++depth) {
+        if (stats.searchDepths[depth] > 0) {
+            std::cout << " " << depth << ":" << stats.searchDepths[depth];
+        }
+    }
+    std::cout << "\n";
+    if (stats.levels[1] > 0) {
+        std::cout << "  node levels:";
+        for (size_t level = 1; level < STATS_HISTOGRAM_SIZE; ++level) {
+            if (stats.levels[level] > 0) {
+                std::cout << " " << level << ":" << stats.levels[level];
+            }
+        }
+        std::cout << "\n";
+    }
+}
+
+void runStatsMode() {
+    std::cout << "Workload: " << STATS_SIZE << " inserts, " << STATS_SIZE
+              << " searches, " << STATS_SIZE / 2 << " removes\n";
+    printStats<AVLTree<int, std::less<int>, std::allocator<int>,
+                       CountingStats>>("AVLTree");
+    printStats<SkipList<int, std::less<int>, CountingStats>>("SkipList");
+}
+
+constexpr size_t SCALING_SIZE = 1 << 20;
+constexpr size_t SCALING_OPS = 1 << 21;
+
+// Every thread runs its share of SCALING_OPS operations on a container
+// prefilled with SCALING_SIZE values, 80% contains and 10% each insert and
+// remove of random values, so the size stays about the same
+template <typename C> void testScaling(const std::string &name) {
+    const unsigned maxThreads =
+        std::max(8U, std::thread::hardware_concurrency());
+    for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+        C container;
+        std::mt19937 fill(42);
+        std::uniform_int_distribution<int> dist(0, 2 * SCALING_SIZE);
+        for (size_t i = 0; i < SCALING_SIZE; ++i) {
+            container.insert(dist(fill));
+        }
+
+        std::vector<size_t> hits(threads);
+        std::vector<std::thread> workers;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (unsigned t = 0; t < threads; ++t) {
+            workers.emplace_back([&container, &hits, dist, t, threads] {
+                std::mt19937 gen(t);
+                auto local = dist;
+                size_t found = 0;
+                for (size_t i = 0; i < SCALING_OPS / threads; ++i) {
+                    const int value = local(gen);
+                    const unsigned op = gen() % 10;
+                    if (op == 0) {
+                        found += container.insert(value) ? 1 : 0;
+                    } else if (op == 1) {
+                        found += container.remove(value) ? 1 : 0;
+                    } else {
+                        found += container.contains(value) ? 1 : 0;
+                    }
+                }
+                hits[t] = found;
+            });
+        }
+        for (auto &worker : workers) {
+            worker.join();
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+
+        size_t total = 0;
+        for (size_t found : hits) {
+            total += found;
+        }
+        std::chrono::duration<double, std::milli> duration_ms = end - start;
+        std::cout << name << " " << threads
+                  << " threads: " << duration_ms.count() << " ms, "
+                  << SCALING_OPS / duration_ms.count() / 1000 << " Mops/s ("
+                  << total << " hits)\n";
+    }
+}
+
+void runScalingMode() {
+    std::cout << "Workload: " << SCALING_SIZE << " values, " << SCALING_OPS
+              << " operations, 80% contains, 10% insert, 10% remove\n";
+    testScaling<ConcurrentSkipList<int>>("ConcurrentSkipList");
+    testScaling<ConcurrentAVLTree<int>>("ConcurrentAVLTree");
+}
+
 template <typename T, size_t N>
 void runStrongSearchTestMode(const std::array<T, N> &dataset,
                              size_t searchRepeats,
@@ -151,12 +412,66 @@ void runStrongSearchTestMode(const std::array<T, N> &dataset,
             testInsertHeavySearchLight<AVLTree<T>>(dataset, searchRepeats);
         std::cout << "AVLTree insert + repeated search time: " << avlTime
                   << " ms\n";
+    } else if (mode == "avl-pool") {
+        double avlTime = testInsertHeavySearchLight<PooledAVLTree<T>>(
+            dataset, searchRepeats);
+        std::cout << "PooledAVLTree insert + repeated search time: " << avlTime
+                  << " ms\n";
+    } else if (mode == "avl-compact") {
+        double avlTime = testInsertHeavySearchLight<CompactAVLTree<T>>(
+            dataset, searchRepeats);
+        std::cout << "CompactAVLTree insert + repeated search time: "
+                  << avlTime << " ms\n";
+    } else if (mode == "avl-concurrent") {
+        double avlTime = testInsertHeavySearchLight<ConcurrentAVLTree<T>>(
+            dataset, searchRepeats);
+        std::cout << "ConcurrentAVLTree insert + repeated search time: "
+                  << avlTime << " ms\n";
+    } else if (mode == "avl-persistent") {
+        double avlTime = testInsertHeavySearchLight<PersistentAVLTree<T>>(
+            dataset, searchRepeats);
+        std::cout << "PersistentAVLTree insert + repeated search time: "
+                  << avlTime << " ms\n";
+    } else if (mode == "avl-mmap") {
+        double avlTime = testInsertHeavySearchLight<ScratchMmapAVLTree<T>>(
+            dataset, searchRepeats);
+        std::cout << "MmapAVLTree insert + repeated search time: " << avlTime
+                  << " ms\n";
+    } else if (mode == "avl-frozen") {
+        double frozenTime =
+            testInsertHeavySearchLightFrozen(dataset, searchRepeats);
+        std::cout << "FrozenSet insert + repeated search time: " << frozenTime
+                  << " ms\n";
+    } else if (mode == "skiplist") {
+        double skipTime =
+            testInsertHeavySearchLight<SkipList<T>>(dataset, searchRepeats);
+        std::cout << "SkipList insert + repeated search time: " << skipTime
+                  << " ms\n";
+    } else if (mode == "skiplist-concurrent") {
+        double skipTime = testInsertHeavySearchLight<ConcurrentSkipList<T>>(
+            dataset, searchRepeats);
+        std::cout << "ConcurrentSkipList insert + repeated search time: "
+                  << skipTime << " ms\n";
+    } else if (mode == "skiplist-unrolled") {
+        double skipTime = testInsertHeavySearchLight<UnrolledSkipList<T>>(
+            dataset, searchRepeats);
+        std::cout << "UnrolledSkipList insert + repeated search time: "
+                  << skipTime << " ms\n";
+    } else if (mode == "btree") {
+        double btreeTime =
+            testInsertHeavySearchLight<BTreeSet<T>>(dataset, searchRepeats);
+        std::cout << "BTreeSet insert + repeated search time: " << btreeTime
+                  << " ms\n";
     } else if (mode == "set") {
         double setTime = testInsertHeavySearchLightSet(dataset, searchRepeats);
         std::cout << "std::set insert + repeated search time: " << setTime
                   << " ms\n";
     } else {
-        std::cerr << "Unknown mode '" << mode << "'. Use 'avl' or 'set'.\n";
+        std::cerr << "Unknown mode '" << mode
+                  << "'. Use 'avl', 'avl-pool', 'avl-compact', "
+                     "'avl-concurrent', 'avl-persistent', 'avl-mmap', "
+                     "'avl-frozen', 'skiplist', 'skiplist-concurrent', "
+                     "'skiplist-unrolled', 'btree' or 'set'.\n";
     }
 
     std::cout << "\n";
@@ -167,11 +482,30 @@ void runStrongSearchTestMode(const std::array<T, N> &dataset,
 int main(int argc, char *argv[]) {
     if (argc < 2) {
         std::cerr << "Usage: " << argv[0] << " <mode>\n";
-        std::cerr << "mode: 'avl' or 'set'\n";
+        std::cerr << "mode: 'avl', 'avl-pool', 'avl-compact', "
+                     "'avl-concurrent', 'avl-persistent', 'avl-mmap', "
+                     "'avl-frozen', 'skiplist', 'skiplist-concurrent', "
+                     "'skiplist-unrolled', 'btree' or 'set'\n";
+        std::cerr << "or 'lookup-many' to compare contains with containsMany\n";
+        std::cerr << "or 'stats' to print the counters of a random workload\n";
+        std::cerr << "or 'scaling' to run the concurrent containers on more "
+                     "and more threads\n";
         return 1;
     }
 
     std::string mode = argv[1];
+    if (mode == "lookup-many") {
+        runLookupManyMode();
+        return 0;
+    }
+    if (mode == "stats") {
+        runStatsMode();
+        return 0;
+    }
+    if (mode == "scaling") {
+        runScalingMode();
+        return 0;
+    }
 
     runFullTestMode(placeholder, "Uniform Random", mode);
     runFullTestMode(placeholder, "Sorted", mode);
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+/**
+ * Allocators that own all of their memory in one place and can hand it back
+ * in a single call. Containers use this to skip per-node deallocation when
+ * they are cleared or destroyed.
+ */
+template <typename A>
+concept BulkReleasableAllocator = requires(A allocator) {
+    { allocator.release() } -> std::same_as<void>;
+};
+
+constexpr std::size_t ARENA_INITIAL_CHUNK_SIZE = 4096;
+constexpr std::size_t ARENA_MAX_CHUNK_SIZE = std::size_t{1} << 20;
+constexpr std::size_t ARENA_HUGE_PAGE_SIZE = std::size_t{2} << 20;
+constexpr std::size_t ARENA_PAGE_SIZE = 4096;
+
+/**
+ * Slab arena for node sized allocations.
+ *
+ * Memory is carved out of geometrically growing chunks with a bump pointer.
+ * Freed blocks go onto a free list per 16 byte size class and are reused by
+ * the next allocation of that class. Blocks that are too big or too strictly
+ * aligned for a size class get a dedicated chunk. release() returns every
+ * chunk at once, so its cost depends on the number of chunks, not on the
+ * number of live blocks.
+ *
+ * With HugePages set, chunks are 2 MiB and backed by transparent huge pages
+ * where the platform supports it (Linux), and by the regular heap otherwise.
+ *
+ * The arena is not thread safe.
+ */
+template <bool HugePages = false> class NodeArena {
+  public:
+    NodeArena() = default;
+    NodeArena(const NodeArena &) = delete;
+    NodeArena(NodeArena &&) = delete;
+    NodeArena &operator=(const NodeArena &) = delete;
+    NodeArena &operator=(NodeArena &&) = delete;
+    ~NodeArena() { release(); }
+
+    /**
+     * Returns a block of at least `bytes` bytes aligned to `alignment`.
+     * Throws std::bad_alloc if the system is out of memory.
+     */
+    [[nodiscard]] void *allocate(std::size_t bytes, std::size_t alignment);
+    /**
+     * Returns a block to the arena. `bytes` and `alignment` must match the
+     * values it was allocated with.
+     */
+    void deallocate(void *ptr, std::size_t bytes,
+                    std::size_t alignment) noexcept;
+    /**
+     * Makes sure the next `count` allocations of `bytes` bytes are carved out
+     * of one contiguous region, unless the free list has blocks to reuse.
+     */
+    void reserve(std::size_t count, std::size_t bytes, std::size_t alignment);
+    /**
+     * Frees every chunk, invalidating all blocks handed out so far.
+     */
+    void release() noexcept;
+
+  private:
+    static constexpr std::size_t GRANULE = alignof(std::max_align_t);
+    static constexpr std::size_t MAX_POOLED_SIZE = 1024;
+    static constexpr std::size_t SIZE_CLASSES = MAX_POOLED_SIZE / GRANULE + 1;
+
+    struct FreeBlock {
+        FreeBlock *next;
+    };
+
+    struct alignas(std::max_align_t) Chunk {
+        Chunk *prev;
+        Chunk *next;
+        std::size_t bytes;
+        std::size_t alignment;
+        bool mapped;
+    };
+
+    [[nodiscard]] static bool pooled(std::size_t bytes,
+                                     std::size_t alignment) noexcept;
+    [[nodiscard]] static std::size_t sizeClass(std::size_t bytes) noexcept;
+    [[nodiscard]] static std::size_t headerSize(std::size_t alignment) noexcept;
+
+    void grow(std::size_t minimum);
+    [[nodiscard]] Chunk *allocateChunk(std::size_t bytes,
+                                       std::size_t alignment);
+    void freeChunk(Chunk *chunk) noexcept;
+    void link(Chunk *chunk) noexcept;
+    void unlink(Chunk *chunk) noexcept;
+
+    std::array<FreeBlock *, SIZE_CLASSES> freeLists{};
+    Chunk *chunks = nullptr;
+    std::byte *cursor = nullptr;
+    std::byte *limit = nullptr;
+    std::size_t nextChunkSize =
+        HugePages ? ARENA_HUGE_PAGE_SIZE : ARENA_INITIAL_CHUNK_SIZE;
+};
+
+/**
+ * Standard allocator backed by a NodeArena. Copies and rebinds share the same
+ * arena, so a container that default constructs its allocator gets a private
+ * arena that it can release() in bulk.
+ */
+template <typename T, bool HugePages = false> class PoolAllocator {
+  public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::false_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+    using is_always_equal = std::false_type;
+
+    template <typename U> struct rebind {
+        using other = PoolAllocator<U, HugePages>;
+    };
+
+    PoolAllocator() : arena(std::make_shared<NodeArena<HugePages>>()) {}
+    // Copies instead of moves, a moved-from allocator must stay usable
+    PoolAllocator(const PoolAllocator &) noexcept = default;
+    PoolAllocator &operator=(const PoolAllocator &) noexcept = default;
+    ~PoolAllocator() = default;
+    template <typename U>
+    // NOLINTNEXTLINE(google-explicit-constructor)
+    PoolAllocator(const PoolAllocator<U, HugePages> &other) noexcept
+        : arena(other.arena) {}
+
+    [[nodiscard]] T *allocate(std::size_t n);
+    void deallocate(T *ptr, std::size_t n) noexcept;
+    /**
+     * Prepares the arena so the next n single element allocations are laid
+     * out back to back in memory.
+     */
+    void reserve(std::size_t n);
+    /**
+     * Frees all memory of the shared arena at once. Every allocator sharing
+     * the arena loses its blocks, so only call this when the caller owns all
+     * of them.
+     */
+    void release() noexcept;
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U, HugePages> &other) const noexcept {
+        return arena == other.arena;
+    }
+
+  private:
+    template <typename U, bool H> friend class PoolAllocator;
+
+    std::shared_ptr<NodeArena<HugePages>> arena;
+};
+
+#include "allocator/pool_allocator.hpp"
+
+static_assert(BulkReleasableAllocator<PoolAllocator<int>>);
+static_assert(!BulkReleasableAllocator<std::allocator<int>>);
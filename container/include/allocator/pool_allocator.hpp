@@ -0,0 +1,208 @@
+#pragma once
+
+#include "allocator/pool_allocator.h"
+#include <algorithm>
+#include <cstddef>
+#include <new>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+template <bool HugePages>
+void *NodeArena<HugePages>::allocate(std::size_t bytes,
+                                     std::size_t alignment) {
+    if (!pooled(bytes, alignment)) {
+        // Oversized blocks get a chunk of their own so release() still
+        // covers them
+        Chunk *chunk = allocateChunk(headerSize(alignment) + bytes, alignment);
+        link(chunk);
+        return reinterpret_cast<std::byte *>(chunk) + headerSize(alignment);
+    }
+
+    const std::size_t index = sizeClass(bytes);
+    if (FreeBlock *block = freeLists[index]) {
+        freeLists[index] = block->next;
+        return block;
+    }
+
+    const std::size_t rounded = index * GRANULE;
+    if (cursor == nullptr ||
+        static_cast<std::size_t>(limit - cursor) < rounded) {
+        grow(rounded);
+    }
+
+    void *block = cursor;
+    cursor += rounded;
+    return block;
+}
+
+template <bool HugePages>
+void NodeArena<HugePages>::deallocate(void *ptr, std::size_t bytes,
+                                      std::size_t alignment) noexcept {
+    if (ptr == nullptr) {
+        return;
+    }
+
+    if (!pooled(bytes, alignment)) {
+        auto *chunk = reinterpret_cast<Chunk *>(static_cast<std::byte *>(ptr) -
+                                                headerSize(alignment));
+        unlink(chunk);
+        freeChunk(chunk);
+        return;
+    }
+
+    const std::size_t index = sizeClass(bytes);
+    auto *block = static_cast<FreeBlock *>(ptr);
+    block->next = freeLists[index];
+    freeLists[index] = block;
+}
+
+template <bool HugePages>
+void NodeArena<HugePages>::reserve(std::size_t count, std::size_t bytes,
+                                   std::size_t alignment) {
+    if (!pooled(bytes, alignment)) {
+        return;
+    }
+
+    const std::size_t total = count * sizeClass(bytes) * GRANULE;
+    if (cursor == nullptr || static_cast<std::size_t>(limit - cursor) < total) {
+        grow(total);
+    }
+}
+
+template <bool HugePages> void NodeArena<HugePages>::release() noexcept {
+    while (chunks != nullptr) {
+        Chunk *next = chunks->next;
+        freeChunk(chunks);
+        chunks = next;
+    }
+
+    freeLists.fill(nullptr);
+    cursor = nullptr;
+    limit = nullptr;
+    nextChunkSize = HugePages ? ARENA_HUGE_PAGE_SIZE : ARENA_INITIAL_CHUNK_SIZE;
+}
+
+template <bool HugePages>
+bool NodeArena<HugePages>::pooled(std::size_t bytes,
+                                  std::size_t alignment) noexcept {
+    return bytes <= MAX_POOLED_SIZE && alignment <= GRANULE;
+}
+
+template <bool HugePages>
+std::size_t NodeArena<HugePages>::sizeClass(std::size_t bytes) noexcept {
+    return std::max<std::size_t>((bytes + GRANULE - 1) / GRANULE, 1);
+}
+
+template <bool HugePages>
+std::size_t NodeArena<HugePages>::headerSize(std::size_t alignment) noexcept {
+    const std::size_t align = std::max(alignment, alignof(Chunk));
+    return (sizeof(Chunk) + align - 1) / align * align;
+}
+
+// Start a new bump region, the tail of the previous one is abandoned until
+// release()
+template <bool HugePages>
+void NodeArena<HugePages>::grow(std::size_t minimum) {
+    const std::size_t header = headerSize(GRANULE);
+    const std::size_t bytes = std::max(nextChunkSize, header + minimum);
+
+    Chunk *chunk = allocateChunk(bytes, GRANULE);
+    link(chunk);
+
+    cursor = reinterpret_cast<std::byte *>(chunk) + header;
+    limit = reinterpret_cast<std::byte *>(chunk) + chunk->bytes;
+
+    if constexpr (!HugePages) {
+        nextChunkSize = std::min(nextChunkSize * 2, ARENA_MAX_CHUNK_SIZE);
+    }
+}
+
+template <bool HugePages>
+typename NodeArena<HugePages>::Chunk *
+NodeArena<HugePages>::allocateChunk(std::size_t bytes, std::size_t alignment) {
+    alignment = std::max(alignment, alignof(Chunk));
+    void *memory = nullptr;
+    bool mapped = false;
+
+#if defined(__linux__)
+    if (HugePages && alignment <= ARENA_PAGE_SIZE) {
+        bytes = (bytes + ARENA_HUGE_PAGE_SIZE - 1) / ARENA_HUGE_PAGE_SIZE *
+                ARENA_HUGE_PAGE_SIZE;
+        memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        // Only a hint, the kernel may still back the chunk with small pages
+        madvise(memory, bytes, MADV_HUGEPAGE);
+        mapped = true;
+    }
+#endif
+
+    if (memory == nullptr) {
+        memory = ::operator new(bytes, std::align_val_t(alignment));
+    }
+
+    auto *chunk = static_cast<Chunk *>(memory);
+    chunk->prev = nullptr;
+    chunk->next = nullptr;
+    chunk->bytes = bytes;
+    chunk->alignment = alignment;
+    chunk->mapped = mapped;
+    return chunk;
+}
+
+template <bool HugePages>
+void NodeArena<HugePages>::freeChunk(Chunk *chunk) noexcept {
+#if defined(__linux__)
+    if (chunk->mapped) {
+        munmap(chunk, chunk->bytes);
+        return;
+    }
+#endif
+    ::operator delete(chunk, std::align_val_t(chunk->alignment));
+}
+
+template <bool HugePages>
+void NodeArena<HugePages>::link(Chunk *chunk) noexcept {
+    chunk->prev = nullptr;
+    chunk->next = chunks;
+    if (chunks != nullptr) {
+        chunks->prev = chunk;
+    }
+    chunks = chunk;
+}
+
+template <bool HugePages>
+void NodeArena<HugePages>::unlink(Chunk *chunk) noexcept {
+    if (chunk->prev != nullptr) {
+        chunk->prev->next = chunk->next;
+    } else {
+        chunks = chunk->next;
+    }
+    if (chunk->next != nullptr) {
+        chunk->next->prev = chunk->prev;
+    }
+}
+
+template <typename T, bool HugePages>
+T *PoolAllocator<T, HugePages>::allocate(std::size_t n) {
+    return static_cast<T *>(arena->allocate(n * sizeof(T), alignof(T)));
+}
+
+template <typename T, bool HugePages>
+void PoolAllocator<T, HugePages>::deallocate(T *ptr, std::size_t n) noexcept {
+    arena->deallocate(ptr, n * sizeof(T), alignof(T));
+}
+
+template <typename T, bool HugePages>
+void PoolAllocator<T, HugePages>::reserve(std::size_t n) {
+    arena->reserve(n, sizeof(T), alignof(T));
+}
+
+template <typename T, bool HugePages>
+void PoolAllocator<T, HugePages>::release() noexcept {
+    arena->release();
+}
@@ -1,21 +1,59 @@
 #pragma once
 
+#include "allocator/pool_allocator.h"
 #include "container.h"
+#include "frozen/frozen_set.h"
+#include "snapshot/snapshot_file.h"
+#include "stats.h"
+#include <filesystem>
+#include <initializer_list>
+#include <iterator>
 #include <memory>
-#include <stack>
+#include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * Upper bound on the height of any AVLTree, a tree of height 92 needs more
+ * than 2^64 nodes. Sizes the path buffers of the iterative operations.
+ */
+constexpr int AVL_MAX_HEIGHT = 92;
+
+/**
+ * Set operations only hand subtrees to another thread when the two inputs
+ * together have at least this many nodes.
+ */
+constexpr size_t AVL_PARALLEL_GRAIN = 1 << 14;
+
+/**
+ * Descents containsMany and searchMany interleave, enough to keep the memory
+ * system busy with misses without spilling the cursors out of registers.
+ */
+constexpr size_t AVL_LOOKUP_GROUP = 16;
 
 template <typename T, typename Compare = std::less<T>,
-          typename Allocator = std::allocator<T>>
+          typename Allocator = std::allocator<T>, typename Stats = NoStats>
 class AVLTree {
+    static_assert(StatsPolicy<Stats>);
+
   private:
     struct Node {
         T value;
         int height = 1;
+        // number of nodes in the subtree rooted here
+        size_t count = 1;
         Node *left;
         Node *right;
+        Node *parent;
 
-        explicit Node(T &&value)
-            : value(std::move(value)), left(nullptr), right(nullptr) {}
+        template <typename... Args>
+        explicit Node(std::in_place_t /*unused*/, Args &&...args)
+            : value(std::forward<Args>(args)...), left(nullptr),
+              right(nullptr), parent(nullptr) {}
     };
 
     using NodeAllocator =
@@ -23,45 +61,74 @@ class AVLTree {
 
   public:
     AVLTree() : head(nullptr) {};
+    /**
+     * Builds the tree from a range in O(n) if the range is strictly
+     * increasing, otherwise the values are sorted and deduplicated first.
+     */
+    template <std::input_iterator InputIt, std::sentinel_for<InputIt> Sentinel>
+    AVLTree(InputIt first, Sentinel last) : head(nullptr) {
+        assign(first, last);
+    }
+    AVLTree(std::initializer_list<T> values) : head(nullptr) {
+        assign(values.begin(), values.end());
+    }
     AVLTree(const AVLTree &) = delete;
-    AVLTree(AVLTree &&) = delete;
+    /**
+     * Takes over the nodes of other without copying, other is left empty.
+     */
+    AVLTree(AVLTree &&other) noexcept(
+        std::is_nothrow_default_constructible_v<NodeAllocator>);
     AVLTree &operator=(const AVLTree &) = delete;
-    AVLTree &operator=(AVLTree &&) = delete;
-    ~AVLTree() = default;
+    /**
+     * Takes over the nodes of other unless the allocators differ and stay
+     * put, then the values are moved into new nodes, which may throw.
+     */
+    AVLTree &operator=(AVLTree &&other) noexcept(
+        std::allocator_traits<
+            NodeAllocator>::propagate_on_container_move_assignment::value ||
+        std::allocator_traits<NodeAllocator>::is_always_equal::value);
+    ~AVLTree() { clear(); }
 
     // iterator
+    /**
+     * Bidirectional in-order iterator. Walks the parent links, so it holds no
+     * state besides the current node and never allocates. The end iterator
+     * has no node and steps back onto the max of the tree.
+     */
     class Iterator {
       public:
-        using iterator_category = std::forward_iterator_tag;
+        using iterator_category = std::bidirectional_iterator_tag;
         using difference_type = std::ptrdiff_t;
         using value_type = T;
         using pointer = T *;   // or also value_type*
         using reference = T &; // or also value_type&
 
         Iterator() = default;
-        explicit Iterator(Node *node) { pushLeftNodes(node); }
+        Iterator(Node *node, const AVLTree *tree) : node(node), tree(tree) {}
 
         reference operator*() const;
         pointer operator->() const;
 
         Iterator &operator++();
         Iterator operator++(int);
+        Iterator &operator--();
+        Iterator operator--(int);
         bool operator==(const Iterator &other) const;
 
         bool operator!=(const Iterator &other) const;
 
       private:
-        std::stack<Node *> nodeStack;
-        /**
-         * Push current nodes and all nodes in preorder into the stack, however
-         * stop when a leaf is reached. Equivalent to recursively pushing the
-         * left node.
-         */
-        void pushLeftNodes(Node *node);
+        friend class AVLTree;
+
+        Node *node = nullptr;
+        const AVLTree *tree = nullptr;
     };
+    using ReverseIterator = std::reverse_iterator<Iterator>;
 
     [[nodiscard]] Iterator begin() const;
     [[nodiscard]] Iterator end() const;
+    [[nodiscard]] ReverseIterator rbegin() const;
+    [[nodiscard]] ReverseIterator rend() const;
 
     // modifiers
 
@@ -69,17 +136,121 @@ class AVLTree {
      * Copies the value into the tree and inserts it. Returns false if the value
      * already existed in the tree.
      */
-    bool insert(T value) noexcept;
+    bool insert(const T &value) noexcept;
+    /**
+     * Moves the value into the tree, the value is left untouched if it
+     * already existed in the tree.
+     */
+    bool insert(T &&value) noexcept;
+    /**
+     * Constructs the value in place inside a new node and inserts it. The node
+     * is thrown away again if an equivalent value already existed.
+     */
+    template <typename... Args> bool emplace(Args &&...args);
+    /**
+     * Inserts the value right before hint if it belongs there, which costs
+     * two comparisons instead of a descent from the root. A hint that does
+     * not fit falls back to a regular insert. Returns an iterator to the
+     * inserted value, or to the equivalent value that was already there.
+     *
+     * Appending at either end needs no hint, insert compares against the
+     * min and max first.
+     */
+    Iterator insertHint(Iterator hint, const T &value) noexcept;
+    Iterator insertHint(Iterator hint, T &&value) noexcept;
+    /**
+     * Replaces the contents of the tree with the values of a range. A strictly
+     * increasing range is turned into a perfectly balanced tree in O(n),
+     * any other range is sorted and deduplicated first.
+     */
+    template <std::input_iterator InputIt, std::sentinel_for<InputIt> Sentinel>
+    void assign(InputIt first, Sentinel last);
     /**
      * Removes and equivalent value from the tree, returns false if the value
      * does not exist in the tree.
      */
     bool remove(const T &value) noexcept;
+    /**
+     * Heterogeneous remove, only available with a transparent comparator.
+     */
+    template <typename K>
+        requires LookupKey<K, T, Compare>
+    bool remove(const K &key) noexcept;
 
     /**
-     * Clear the tree.
+     * Clear the tree. With a BulkReleasableAllocator the nodes are not freed
+     * one by one, the whole arena is released at once instead.
      */
     void clear() noexcept;
+    /**
+     * Exchanges the contents of two trees in O(1).
+     */
+    void swap(AVLTree &other) noexcept;
+    friend void swap(AVLTree &lhs, AVLTree &rhs) noexcept { lhs.swap(rhs); }
+
+    // join based bulk operations
+    /**
+     * Moves every value greater than key into `greater`, replacing its
+     * contents, and keeps the smaller ones. key itself is dropped. Returns
+     * true if key was in the tree. O(log n).
+     */
+    bool split(const T &key, AVLTree &greater);
+    /**
+     * Appends pivot and every value of `greater` to this tree, leaving
+     * `greater` empty. All values in this tree must be smaller than pivot and
+     * pivot must be smaller than all values in `greater`. O(log n).
+     */
+    void join(T pivot, AVLTree &&greater);
+    /**
+     * Turns this tree into the union of itself and `other`, consuming
+     * `other`. Runs in O(m log(n/m + 1)) for sizes m <= n, large inputs are
+     * processed on several threads when the allocator is stateless.
+     */
+    void setUnion(AVLTree &&other);
+    /**
+     * Keeps only values that are also in `other`, consuming `other`. Same
+     * complexity and threading as setUnion.
+     */
+    void setIntersection(AVLTree &&other);
+    /**
+     * Removes every value that is in `other`, consuming `other`. Same
+     * complexity and threading as setUnion.
+     */
+    void setDifference(AVLTree &&other);
+    /**
+     * Inserts every value of a range, returns how many were new. The batch is
+     * sorted and built into a balanced tree first, which is then merged in
+     * with the same join based union as setUnion: one pass instead of a
+     * descent per value, rebalancing only where the pieces are joined, and
+     * several threads for large batches. Values already in the tree are kept.
+     */
+    template <std::ranges::input_range R>
+        requires std::constructible_from<T, std::ranges::range_reference_t<R>>
+    size_t insertBatch(R &&values);
+    /**
+     * Removes every value of a range, returns how many were in the tree. Same
+     * execution as insertBatch, merged in with setDifference.
+     */
+    template <std::ranges::input_range R>
+        requires std::constructible_from<T, std::ranges::range_reference_t<R>>
+    size_t removeBatch(R &&values);
+
+    // snapshots
+    /**
+     * Writes the values in order to a snapshot file with a header and a
+     * checksum, see writeSnapshot. O(n).
+     */
+    void save(const std::filesystem::path &path) const
+        requires std::is_trivially_copyable_v<T>;
+    /**
+     * Replaces the contents with the values of a file written by save. The
+     * file is mapped and the tree built straight out of it in O(n), like
+     * assign does with sorted input. Throws like SnapshotMapping and leaves
+     * the tree untouched if the file cannot be read or is damaged.
+     */
+    void load(const std::filesystem::path &path)
+        requires std::is_trivially_copyable_v<T>;
+
     // access
 
     /**
@@ -88,6 +259,14 @@ class AVLTree {
      * returns nullptr if not found
      */
     [[nodiscard]] T *search(const T &value) const noexcept;
+    /**
+     * Heterogeneous search, only available with a transparent comparator.
+     * Lets e.g. a std::string tree be searched with a std::string_view
+     * without building a temporary string.
+     */
+    template <typename K>
+        requires LookupKey<K, T, Compare>
+    [[nodiscard]] T *search(const K &key) const noexcept;
     /**
      * Returns the max value in the tree, returns nullptr if the tree is empty.
      */
@@ -99,6 +278,78 @@ class AVLTree {
     [[nodiscard]] T *min() const noexcept;
     // Check if the tree contains a specific value
     [[nodiscard]] bool contains(const T &value) const noexcept;
+    template <typename K>
+        requires LookupKey<K, T, Compare>
+    [[nodiscard]] bool contains(const K &key) const noexcept;
+    /**
+     * Looks up a batch of keys and stores in found whether each one is in
+     * the tree, found needs room for every key. Returns how many were found.
+     * Up to AVL_LOOKUP_GROUP descents run interleaved: each takes one step in
+     * turn and prefetches the node it visits next, so their cache misses
+     * overlap instead of stalling one after another.
+     */
+    size_t containsMany(std::span<const T> keys,
+                        std::span<bool> found) const noexcept;
+    /**
+     * Same as containsMany, but stores a pointer to every value that was
+     * found and nullptr for the others.
+     */
+    void searchMany(std::span<const T> keys,
+                    std::span<T *> results) const noexcept;
+    /**
+     * Returns the k-th smallest value (0 based), returns nullptr if k is not
+     * smaller than the size of the tree.
+     */
+    [[nodiscard]] T *select(size_t k) const noexcept;
+    /**
+     * Returns the number of values in the tree that are smaller than value.
+     */
+    [[nodiscard]] size_t rank(const T &value) const noexcept;
+    /**
+     * Returns the number of values in the half open range [lo, hi).
+     */
+    [[nodiscard]] size_t countRange(const T &lo, const T &hi) const noexcept;
+    /**
+     * Copies the values into an immutable FrozenSet laid out for lookups,
+     * for sets that are built once and then only queried. O(n).
+     */
+    [[nodiscard]] FrozenSet<T, Compare> freeze() const;
+
+    // range queries
+    /**
+     * Returns an iterator to the first value not smaller than value, or end().
+     */
+    [[nodiscard]] Iterator lower_bound(const T &value) const noexcept;
+    /**
+     * Returns an iterator to the first value greater than value, or end().
+     */
+    [[nodiscard]] Iterator upper_bound(const T &value) const noexcept;
+    /**
+     * Returns the range of values equivalent to value, which is empty or
+     * holds a single value.
+     */
+    [[nodiscard]] std::pair<Iterator, Iterator>
+    equal_range(const T &value) const noexcept;
+    /**
+     * Calls fn with every value in the half open range [lo, hi) in order,
+     * O(log n + k) for k visited values. If fn returns a bool, returning
+     * false stops the scan.
+     */
+    template <typename F>
+    void forEachInRange(const T &lo, const T &hi, F &&fn) const;
+    template <typename K>
+        requires LookupKey<K, T, Compare>
+    [[nodiscard]] Iterator lower_bound(const K &key) const noexcept;
+    template <typename K>
+        requires LookupKey<K, T, Compare>
+    [[nodiscard]] Iterator upper_bound(const K &key) const noexcept;
+    template <typename K>
+        requires LookupKey<K, T, Compare>
+    [[nodiscard]] std::pair<Iterator, Iterator>
+    equal_range(const K &key) const noexcept;
+    template <typename K, typename F>
+        requires LookupKey<K, T, Compare>
+    void forEachInRange(const K &lo, const K &hi, F &&fn) const;
 
     // info
     /**
@@ -113,39 +364,175 @@ class AVLTree {
      * Returns true if the tree is empty
      */
     [[nodiscard]] bool empty() const noexcept;
+    /**
+     * What the tree has counted so far, see StatsPolicy. With the default
+     * NoStats nothing is counted and the hooks compile away.
+     */
+    [[nodiscard]] const Stats &stats() const noexcept { return statistics; }
+    Stats &stats() noexcept { return statistics; }
 
   private:
     Node *head;
+    // fingers on the min and max node, nullptr while the tree is empty
+    Node *leftmost = nullptr;
+    Node *rightmost = nullptr;
 
     // modifiers
-    bool insert(Node *&node, T &&value) noexcept;
-    bool remove(Node *&node, const T &value) noexcept;
     /**
-     * Remove a node, modify the pointer to point at one of their children or if
-     * they have two children perform rotations.
+     * Build a perfectly balanced subtree out of the next n values of a sorted
+     * sequence. Nodes are allocated in order, so with a pool allocator they
+     * end up next to each other in memory.
+     */
+    template <typename InputIt>
+    Node *buildBalanced(InputIt &it, size_t n, Node *parent);
+    /**
+     * Copy a range into a vector, sorted and without duplicates.
+     */
+    template <typename InputIt, typename Sentinel>
+    std::vector<T> sortedValues(InputIt first, Sentinel last) const;
+    template <typename... Args> Node *createNode(Args &&...args);
+    /**
+     * Find the empty link where value belongs, recording the links walked on
+     * the way in path. Values beyond the min or max are placed next to the
+     * fingers without a descent. Returns nullptr if an equivalent value
+     * already exists, the link to that value is then the last one on the
+     * path.
      */
-    void removeNode(Node *&node) noexcept;
+    Node **findLink(const T &value, Node **path[], int &depth) const noexcept;
+    /**
+     * Same as above, but tries the gap right before hint first.
+     */
+    Node **findLink(Iterator hint, const T &value, Node **path[],
+                    int &depth) const noexcept;
+    /**
+     * Fill the path with the links from the root down to parent by following
+     * the parent pointers, no comparisons needed. Returns link.
+     */
+    Node **fingerLink(Node *parent, Node **link, Node **path[],
+                      int &depth) const noexcept;
+    /**
+     * The link in the parent (or the head) that points to node.
+     */
+    Node **linkTo(Node *node) const noexcept;
+    /**
+     * Hang a new node into the link found by findLink and rebalance.
+     */
+    void attachNode(Node *node, Node **link, Node **path[], int depth) noexcept;
+    /**
+     * Unlink the node at *link from the tree and return it. A node with two
+     * children is replaced by its in-order successor, the links walked to
+     * reach the successor are appended to the path.
+     */
+    Node *unlinkNode(Node **link, Node **path[], int &depth) noexcept;
+    /**
+     * Walk the path back towards the root restoring heights and balance, stop
+     * as soon as a subtree ends up with the height it had before.
+     */
+    void rebalancePath(Node **path[], int depth) noexcept;
+    /**
+     * Restore the AVL property at a node whose subtrees differ by at most two
+     * in height.
+     */
+    void rebalance(Node *&node) noexcept;
+    /**
+     * Recompute the fingers after the shape of the tree changed in bulk.
+     */
+    void resetFingers() noexcept;
+    void destroyNode(Node *node) noexcept;
+    void destroyTree(Node *node) noexcept;
     void clear(Node *node) noexcept;
     void leftRotate(Node *&node) noexcept;
     void rightRotate(Node *&node) noexcept;
     void updateHeight(Node *&node) noexcept;
+    void updateCount(Node *node) noexcept;
+
+    // join based bulk operations, see join.hpp
+    struct SplitResult {
+        Node *left;
+        Node *found;
+        Node *right;
+    };
+
+    /**
+     * Take over the nodes of another tree. If the allocators differ the
+     * values are moved into freshly built nodes instead, O(m).
+     */
+    Node *adopt(Node *root, AVLTree &source);
+    /**
+     * Make pivot the parent of two detached subtrees and recompute its
+     * height and count.
+     */
+    Node *connect(Node *left, Node *pivot, Node *right) noexcept;
+    Node *joinNodes(Node *left, Node *pivot, Node *right) noexcept;
+    Node *joinRight(Node *left, Node *pivot, Node *right) noexcept;
+    Node *joinLeft(Node *left, Node *pivot, Node *right) noexcept;
+    /**
+     * Join two subtrees without a pivot, all values of left must be smaller.
+     */
+    Node *joinNodes(Node *left, Node *right) noexcept;
+    Node *splitLast(Node *node, Node *&last) noexcept;
+    SplitResult splitNode(Node *node, const T &key) noexcept;
+    Node *unionNodes(Node *lhs, Node *rhs, int forkDepth);
+    Node *intersectionNodes(Node *lhs, Node *rhs, int forkDepth);
+    Node *differenceNodes(Node *lhs, Node *rhs, int forkDepth);
+    using SetOperation = Node *(AVLTree::*)(Node *, Node *, int);
+    /**
+     * Apply a set operation to the left halves and to the right halves of
+     * two split trees. The left halves go to another thread if the inputs
+     * are large enough and the fork budget is not used up yet.
+     */
+    std::pair<Node *, Node *> fork(SetOperation operation, Node *lhsLeft,
+                                   Node *rhsLeft, Node *lhsRight,
+                                   Node *rhsRight, int forkDepth);
+    [[nodiscard]] static int parallelForkDepth() noexcept;
+    [[nodiscard]] static int height(Node *node) noexcept;
 
     // access
-    [[nodiscard]] T *search(Node *node, const T &value) const noexcept;
-    [[nodiscard]] T *max(Node *node) const noexcept;
-    [[nodiscard]] T *min(Node *node) const noexcept;
-    [[nodiscard]] Node *minNode(Node *node) const noexcept;
-    [[nodiscard]] bool contains(Node *node, const T &value) const noexcept;
+    template <typename K>
+    [[nodiscard]] Node *searchNode(const K &key) const noexcept;
+    /**
+     * The interleaved descents behind containsMany and searchMany, calls
+     * visit(i, node) with the node holding keys[i], or nullptr.
+     */
+    template <typename Visit>
+    void lookupMany(std::span<const T> keys, Visit visit) const noexcept;
+    [[nodiscard]] static Node *minNode(Node *node) noexcept;
+    [[nodiscard]] static Node *maxNode(Node *node) noexcept;
+    // in-order neighbours, nullptr past either end
+    [[nodiscard]] static Node *nextNode(Node *node) noexcept;
+    [[nodiscard]] static Node *prevNode(Node *node) noexcept;
 
     // info
-    [[nodiscard]] size_t size(Node *node) const noexcept;
+    [[nodiscard]] static size_t count(Node *node) noexcept;
     [[nodiscard]] int getBalance(Node *node) const noexcept;
+    /**
+     * comp(lhs, rhs), counted as a comparison.
+     */
+    template <typename L, typename R>
+    [[nodiscard]] bool compare(const L &lhs, const R &rhs) const;
     Compare comp;
     NodeAllocator allocator;
+    // counters stay with the tree, moves and swaps do not exchange them
+    [[no_unique_address]] mutable Stats statistics;
 };
 
 #include "avl_tree/avl_tree.hpp"
 #include "avl_tree/iterator.hpp" // IWYU pragma: keep
+#include "avl_tree/join.hpp"     // IWYU pragma: keep
+
+/**
+ * AVLTree whose nodes live in a private slab arena, clear() and destruction
+ * release the arena in one go instead of freeing every node.
+ */
+template <typename T, typename Compare = std::less<T>, bool HugePages = false>
+using PooledAVLTree = AVLTree<T, Compare, PoolAllocator<T, HugePages>>;
 
 static_assert(Dontainer<AVLTree<int>, int>);
-static_assert(std::ranges::range<AVLTree<int>>);
+static_assert(RangeDontainer<AVLTree<int>, int>);
+static_assert(std::ranges::bidirectional_range<AVLTree<int>>);
+static_assert(std::bidirectional_iterator<AVLTree<int>::Iterator>);
+static_assert(Dontainer<PooledAVLTree<int>, int>);
+static_assert(std::is_nothrow_move_assignable_v<AVLTree<int>>);
+static_assert(std::is_nothrow_move_assignable_v<PooledAVLTree<int>>);
+static_assert(TransparentDontainer<AVLTree<std::string, std::less<>>,
+                                   std::string, std::string_view>);
@@ -4,298 +4,927 @@
 #include <algorithm>
 #include <cstddef>
 #include <cstdlib>
+#include <filesystem>
+#include <iterator>
 #include <memory>
+#include <span>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
-template <typename T, typename Compare, typename Allocator>
-bool AVLTree<T, Compare, Allocator>::insert(Node *&node, T &&value) noexcept {
-    if (node == nullptr) {
-        Node *newNode = allocator.allocate(1);
-        std::allocator_traits<NodeAllocator>::construct(allocator, newNode,
-                                                        std::move(value));
-        node = newNode;
-        return true;
-    }
+template <typename T, typename Compare, typename Allocator, typename Stats>
+AVLTree<T, Compare, Allocator, Stats>::AVLTree(AVLTree &&other) noexcept(
+    std::is_nothrow_default_constructible_v<NodeAllocator>)
+    : head(nullptr) {
+    swap(other);
+}
 
-    if (value == node->value) {
-        return false;
+template <typename T, typename Compare, typename Allocator, typename Stats>
+AVLTree<T, Compare, Allocator, Stats> &
+AVLTree<T, Compare, Allocator, Stats>::operator=(AVLTree &&other) noexcept(
+    std::allocator_traits<
+        NodeAllocator>::propagate_on_container_move_assignment::value ||
+    std::allocator_traits<NodeAllocator>::is_always_equal::value) {
+    if (this == &other) {
+        return *this;
     }
 
-    const bool valueBigger = comp(node->value, value);
-
-    if (valueBigger) {
-        if (!insert(node->right, std::forward<T>(value))) {
-            return false;
-        };
+    clear();
+    if constexpr (std::allocator_traits<NodeAllocator>::
+                      propagate_on_container_move_assignment::value) {
+        // other ends up with our, now empty, allocator. Handing over a copy
+        // instead would let both trees bulk release the same arena.
+        using std::swap;
+        swap(this->head, other.head);
+        swap(leftmost, other.leftmost);
+        swap(rightmost, other.rightmost);
+        swap(comp, other.comp);
+        swap(allocator, other.allocator);
     } else {
-        if (!insert(node->left, std::forward<T>(value))) {
-            return false;
-        };
+        this->head = adopt(other.head, other);
+        other.head = nullptr;
+        other.resetFingers();
+        resetFingers();
+        comp = other.comp;
     }
+    return *this;
+}
 
-    // update height
-    updateHeight(node);
+template <typename T, typename Compare, typename Allocator, typename Stats>
+void AVLTree<T, Compare, Allocator, Stats>::swap(AVLTree &other) noexcept {
+    using std::swap;
+    swap(this->head, other.head);
+    swap(leftmost, other.leftmost);
+    swap(rightmost, other.rightmost);
+    swap(comp, other.comp);
+    if constexpr (std::allocator_traits<
+                      NodeAllocator>::propagate_on_container_swap::value) {
+        swap(allocator, other.allocator);
+    }
+}
 
-    int balance = getBalance(node);
+template <typename T, typename Compare, typename Allocator, typename Stats>
+bool AVLTree<T, Compare, Allocator, Stats>::insert(const T &value) noexcept {
+    Node **path[AVL_MAX_HEIGHT];
+    int depth = 0;
+    Node **link = findLink(value, path, depth);
+    if (link == nullptr) {
+        return false;
+    }
 
-    const bool subTreeRight =
-        ((valueBigger && node->right && comp(node->right->value, value)) ||
-         (!valueBigger && node->left && comp(node->left->value, value)));
+    attachNode(createNode(value), link, path, depth);
+    return true;
+}
 
-    // Left side
-    if (balance > 1 && !subTreeRight) {
-        rightRotate(node);
+template <typename T, typename Compare, typename Allocator, typename Stats>
+bool AVLTree<T, Compare, Allocator, Stats>::insert(T &&value) noexcept {
+    Node **path[AVL_MAX_HEIGHT];
+    int depth = 0;
+    Node **link = findLink(value, path, depth);
+    if (link == nullptr) {
+        return false;
     }
 
-    if (balance > 1 && subTreeRight) {
-        leftRotate(node->left);
-        rightRotate(node);
+    attachNode(createNode(std::move(value)), link, path, depth);
+    return true;
+}
+
+template <typename T, typename Compare, typename Allocator, typename Stats>
+AVLTree<T, Compare, Allocator, Stats>::Iterator
+AVLTree<T, Compare, Allocator, Stats>::insertHint(Iterator hint,
+                                                  const T &value) noexcept {
+    Node **path[AVL_MAX_HEIGHT];
+    int depth = 0;
+    Node **link = findLink(hint, value, path, depth);
+    if (link == nullptr) {
+        return Iterator(*path[depth - 1], this);
     }
 
-    // Right side
-    if (balance < -1 && subTreeRight) {
-        leftRotate(node);
+    Node *node = createNode(value);
+    attachNode(node, link, path, depth);
+    return Iterator(node, this);
+}
+
+template <typename T, typename Compare, typename Allocator, typename Stats>
+AVLTree<T, Compare, Allocator, Stats>::Iterator
+AVLTree<T, Compare, Allocator, Stats>::insertHint(Iterator hint,
+                                                  T &&value) noexcept {
+    Node **path[AVL_MAX_HEIGHT];
+    int depth = 0;
+    Node **link = findLink(hint, value, path, depth);
+    if (link == nullptr) {
+        return Iterator(*path[depth - 1], this);
     }
 
-    if (balance < -1 && !subTreeRight) {
-        rightRotate(node->right);
-        leftRotate(node);
+    Node *node = createNode(std::move(value));
+    attachNode(node, link, path, depth);
+    return Iterator(node, this);
+}
+
+template <typename T, typename Compare, typename Allocator, typename Stats>
+template <typename... Args>
+bool AVLTree<T, Compare, Allocator, Stats>::emplace(Args &&...args) {
+    // The value has to exist before it can be compared
+    Node *newNode = createNode(std::forward<Args>(args)...);
+
+    Node **path[AVL_MAX_HEIGHT];
+    int depth = 0;
+    Node **link = findLink(newNode->value, path, depth);
+    if (link == nullptr) {
+        destroyNode(newNode);
+        return false;
     }
 
+    attachNode(newNode, link, path, depth);
     return true;
 }
 
-template <typename T, typename Compare, typename Allocator>
-bool AVLTree<T, Compare, Allocator>::insert(T value) noexcept {
-    return insert(this->head, std::forward<T>(value));
+template <typename T, typename Compare, typename Allocator, typename Stats>
+template <typename... Args>
+AVLTree<T, Compare, Allocator, Stats>::Node *
+AVLTree<T, Compare, Allocator, Stats>::createNode(Args &&...args) {
+    Node *node = allocator.allocate(1);
+    std::allocator_traits<NodeAllocator>::construct(
+        allocator, node, std::in_place, std::forward<Args>(args)...);
+    statistics.allocation();
+    return node;
 }
 
-template <typename T, typename Compare, typename Allocator>
-bool AVLTree<T, Compare, Allocator>::remove(Node *&node,
-                                            const T &value) noexcept {
-    if (node == nullptr) {
-        return false;
+template <typename T, typename Compare, typename Allocator, typename Stats>
+AVLTree<T, Compare, Allocator, Stats>::Node **
+AVLTree<T, Compare, Allocator, Stats>::findLink(const T &value, Node **path[],
+                                                int &depth) const noexcept {
+    // Ascending or descending input never has to descend from the root
+    if (rightmost != nullptr && compare(rightmost->value, value)) {
+        statistics.search(1);
+        return fingerLink(rightmost, &rightmost->right, path, depth);
     }
+    if (leftmost != nullptr && compare(value, leftmost->value)) {
+        statistics.search(1);
+        return fingerLink(leftmost, &leftmost->left, path, depth);
+    }
+
+    auto **link = const_cast<Node **>(&this->head);
 
-    if (comp(node->value, value)) {
-        if (!remove(node->right, value)) {
-            return false;
+    while (*link != nullptr) {
+        Node *node = *link;
+        path[depth++] = link;
+        if (compare(value, node->value)) {
+            link = &node->left;
+        } else if (compare(node->value, value)) {
+            link = &node->right;
+        } else {
+            statistics.search(depth);
+            return nullptr;
         }
-    } else if (comp(value, node->value)) {
-        if (!remove(node->left, value)) {
-            return false;
+    }
+
+    statistics.search(depth);
+    return link;
+}
+
+// The gap before hint lies between its predecessor and the hint node itself,
+// one of the two always has a free link facing the gap
+template <typename T, typename Compare, typename Allocator, typename Stats>
+AVLTree<T, Compare, Allocator, Stats>::Node **
+AVLTree<T, Compare, Allocator, Stats>::findLink(Iterator hint, const T &value,
+                                                Node **path[],
+                                                int &depth) const noexcept {
+    Node *next = hint.node;
+    Node *prev = next ? prevNode(next) : rightmost;
+
+    if (next != nullptr && !compare(value, next->value)) {
+        if (!compare(next->value, value)) {
+            path[depth++] = linkTo(next);
+            return nullptr;
         }
-    } else {
-        // removal logic
-        if (!node->left && !node->right) {
-            std::allocator_traits<NodeAllocator>::destroy(allocator, node);
-            allocator.deallocate(node, 1);
-            node = nullptr;
-            return true;
+        return findLink(value, path, depth);
+    }
+    if (prev != nullptr && !compare(prev->value, value)) {
+        if (!compare(value, prev->value)) {
+            path[depth++] = linkTo(prev);
+            return nullptr;
         }
+        return findLink(value, path, depth);
+    }
 
-        if (!node->left) {
-            Node *temp = node->right;
-            std::allocator_traits<NodeAllocator>::destroy(allocator, node);
-            allocator.deallocate(node, 1);
-            node = temp;
-        } else if (!node->right) {
-
-            Node *temp = node->left;
-            std::allocator_traits<NodeAllocator>::destroy(allocator, node);
-            allocator.deallocate(node, 1);
-            node = temp;
-        } else {
-            removeNode(node);
+    if (prev == nullptr && next == nullptr) {
+        return const_cast<Node **>(&this->head);
+    }
+    if (prev == nullptr || prev->right != nullptr) {
+        return fingerLink(next, &next->left, path, depth);
+    }
+    return fingerLink(prev, &prev->right, path, depth);
+}
+
+template <typename T, typename Compare, typename Allocator, typename Stats>
+AVLTree<T, Compare, Allocator, Stats>::Node **
+AVLTree<T, Compare, Allocator, Stats>::fingerLink(Node *parent, Node **link,
+                                                  Node **path[],
+                                                  int &depth) const noexcept {
+    for (Node *node = parent; node != nullptr; node = node->parent) {
+        path[depth++] = linkTo(node);
+    }
+    std::reverse(path, path + depth);
+    return link;
+}
+
+template <typename T, typename Compare, typename Allocator, typename Stats>
+AVLTree<T, Compare, Allocator, Stats>::Node **
+AVLTree<T, Compare, Allocator, Stats>::linkTo(Node *node) const noexcept {
+    Node *parent = node->parent;
+    if (parent == nullptr) {
+        return const_cast<Node **>(&this->head);
+    }
+    return node == parent->left ? &parent->left : &parent->right;
+}
+
+template <typename T, typename Compare, typename Allocator, typename Stats>
+void AVLTree<T, Compare, Allocator, Stats>::attachNode(Node *node, Node **link,
+                                                       Node **path[],
+                                                       int depth) noexcept {
+    node->parent = depth > 0 ? *path[depth - 1] : nullptr;
+    *link = node;
+
+    // A new min can only hang left of the old one, a new max right of it
+    if (node->parent == nullptr) {
+        leftmost = node;
+        rightmost = node;
+    } else if (link == &leftmost->left) {
+        leftmost = node;
+    } else if (link == &rightmost->right) {
+        rightmost = node;
+    }
+
+    for (int i = 0; i < depth; ++i) {
+        ++(*path[i])->count;
+    }
+
+    rebalancePath(path, depth);
+}
+
+template <typename T, typename Compare, typename Allocator, typename Stats>
+template <std::input_iterator InputIt, std::sentinel_for<InputIt> Sentinel>
+void AVLTree<T, Compare, Allocator, Stats>::assign(InputIt first,
+                                                   Sentinel last) {
+    clear();
+
+    const auto outOfOrder = [this](const T &lhs, const T &rhs) {
+        return !compare(lhs, rhs);
+    };
+
+    // Sorted input is consumed as is, no copy needed
+    if constexpr (std::forward_iterator<InputIt>) {
+        if (std::ranges::adjacent_find(first, last, outOfOrder) == last) {
+            const auto n =
+                static_cast<size_t>(std::ranges::distance(first, last));
+            if constexpr (requires { allocator.reserve(n); }) {
+                allocator.reserve(n);
+            }
+            this->head = buildBalanced(first, n, nullptr);
+            resetFingers();
+            return;
         }
     }
 
-    // rebalancing and height update
-    const bool leftExists = node->left != nullptr;
-    const bool rightExists = node->right != nullptr;
+    std::vector<T> values = sortedValues(std::move(first), last);
+    if constexpr (requires { allocator.reserve(values.size()); }) {
+        allocator.reserve(values.size());
+    }
+    auto it = std::make_move_iterator(values.begin());
+    this->head = buildBalanced(it, values.size(), nullptr);
+    resetFingers();
+}
+
+template <typename T, typename Compare, typename Allocator, typename Stats>
+void AVLTree<T, Compare, Allocator, Stats>::save(
+    const std::filesystem::path &path) const
+    requires std::is_trivially_copyable_v<T>
+{
+    writeSnapshot<T>(path, begin(), size());
+}
+
+// The mapping is checked before the old contents are dropped
+template <typename T, typename Compare, typename Allocator, typename Stats>
+void AVLTree<T, Compare, Allocator, Stats>::load(
+    const std::filesystem::path &path)
+    requires std::is_trivially_copyable_v<T>
+{
+    SnapshotMapping<T> snapshot(path);
+    std::span<const T> values = snapshot.values();
+    assign(values.begin(), values.end());
+}
+
+template <typename T, typename Compare, typename Allocator, typename Stats>
+template <typename InputIt, typename Sentinel>
+std::vector<T>
+AVLTree<T, Compare, Allocator, Stats>::sortedValues(InputIt first,
+                                                    Sentinel last) const {
+    std::vector<T> values;
+    for (; first != last; ++first) {
+        values.emplace_back(*first);
+    }
+    const auto less = [this](const T &lhs, const T &rhs) {
+        return compare(lhs, rhs);
+    };
+    std::sort(values.begin(), values.end(), less);
+    values.erase(std::unique(values.begin(), values.end(),
+                             [&less](const T &lhs, const T &rhs) {
+                                 return !less(lhs, rhs) && !less(rhs, lhs);
+                             }),
+                 values.end());
+    return values;
+}
+
+template <typename T, typename Compare, typename Allocator, typename Stats>
+template <typename InputIt>
+AVLTree<T, Compare, Allocator, Stats>::Node *
+AVLTree<T, Compare, Allocator, Stats>::buildBalanced(InputIt &it, size_t n,
+                                                     Node *parent) {
+    if (n == 0) {
+        return nullptr;
+    }
 
+    const size_t leftCount = (n - 1) / 2;
+    Node *left = buildBalanced(it, leftCount, nullptr);
+
+    Node *node = createNode(*it);
+    ++it;
+
+    node->left = left;
+    node->right = buildBalanced(it, n - 1 - leftCount, node);
+    node->parent = parent;
+    if (left != nullptr) {
+        left->parent = node;
+    }
+    node->count = n;
     updateHeight(node);
 
-    const int balance = getBalance(node);
+    return node;
+}
 
-    if (balance > 1 && leftExists && getBalance(node->left) >= 0) {
-        rightRotate(node);
-    } else if (balance < -1 && rightExists && getBalance(node->right) <= 0) {
-        leftRotate(node);
-    } else if (balance > 1 && leftExists && getBalance(node->left) < 0) {
-        leftRotate(node->left);
-        rightRotate(node);
-    } else if (balance < -1 && rightExists && getBalance(node->right) > 0) {
-        rightRotate(node->right);
-        leftRotate(node);
+template <typename T, typename Compare, typename Allocator, typename Stats>
+bool AVLTree<T, Compare, Allocator, Stats>::remove(const T &value) noexcept {
+    return remove<T>(value);
+}
+
+template <typename T, typename Compare, typename Allocator, typename Stats>
+template <typename K>
+    requires LookupKey<K, T, Compare>
+bool AVLTree<T, Compare, Allocator, Stats>::remove(const K &key) noexcept {
+    Node **path[AVL_MAX_HEIGHT];
+    int depth = 0;
+    Node **link = &this->head;
+
+    while (*link != nullptr) {
+        Node *node = *link;
+        if (compare(key, node->value)) {
+            path[depth++] = link;
+            link = &node->left;
+        } else if (compare(node->value, key)) {
+            path[depth++] = link;
+            link = &node->right;
+        } else {
+            if (node == leftmost) {
+                leftmost = nextNode(node);
+            }
+            if (node == rightmost) {
+                rightmost = prevNode(node);
+            }
+            statistics.search(depth + 1);
+            destroyNode(unlinkNode(link, path, depth));
+            for (int i = 0; i < depth; ++i) {
+                --(*path[i])->count;
+            }
+            rebalancePath(path, depth);
+            return true;
+        }
     }
 
-    return true;
+    statistics.search(depth);
+    return false;
 }
 
-template <typename T, typename Compare, typename Allocator>
-void AVLTree<T, Compare, Allocator>::removeNode(Node *&node) noexcept {
-    Node *successorParent = node;
-    Node *successor = node->right;
+template <typename T, typename Compare, typename Allocator, typename Stats>
+AVLTree<T, Compare, Allocator, Stats>::Node *
+AVLTree<T, Compare, Allocator, Stats>::unlinkNode(Node **link, Node **path[],
+                                                  int &depth) noexcept {
+    Node *node = *link;
 
-    // Find in-order successor and its parent
-    while (successor->left != nullptr) {
-        successorParent = successor;
-        successor = successor->left;
+    if (node->left == nullptr || node->right == nullptr) {
+        Node *child = node->left ? node->left : node->right;
+        if (child != nullptr) {
+            child->parent = node->parent;
+        }
+        *link = child;
+        return node;
     }
 
-    // Unlink the successor from its current location
-    if (successorParent != node) {
-        successorParent->left = successor->right;
-        successor->right = node->right;
+    // The successor takes over the position of the node, so the link to it
+    // stays on the path
+    const int nodeDepth = depth;
+    path[depth++] = link;
+
+    // Find in-order successor, remembering the links leading to it
+    Node **successorLink = &node->right;
+    while ((*successorLink)->left != nullptr) {
+        path[depth++] = successorLink;
+        successorLink = &(*successorLink)->left;
     }
+    Node *successor = *successorLink;
 
-    // Transfer left child
+    // Unlink the successor from its current location and put it in place of
+    // the node
+    *successorLink = successor->right;
+    if (successor->right != nullptr) {
+        successor->right->parent = successor->parent;
+    }
     successor->left = node->left;
+    successor->right = node->right;
+    successor->parent = node->parent;
+    successor->left->parent = successor;
+    if (successor->right != nullptr) {
+        successor->right->parent = successor;
+    }
+    successor->height = node->height;
+    successor->count = node->count;
+    *link = successor;
+
+    // The path went through the right link of the removed node
+    if (depth > nodeDepth + 1) {
+        path[nodeDepth + 1] = &successor->right;
+    }
+
+    return node;
+}
+
+template <typename T, typename Compare, typename Allocator, typename Stats>
+void AVLTree<T, Compare, Allocator, Stats>::rebalancePath(Node **path[],
+                                                          int depth) noexcept {
+    while (depth > 0) {
+        Node *&node = *path[--depth];
+        const int oldHeight = node->height;
+
+        rebalance(node);
+
+        // Ancestors only depend on the height of this subtree
+        if (node->height == oldHeight) {
+            break;
+        }
+    }
+}
+
+template <typename T, typename Compare, typename Allocator, typename Stats>
+void AVLTree<T, Compare, Allocator, Stats>::rebalance(Node *&node) noexcept {
+    updateHeight(node);
 
-    // Delete current node
+    const int balance = getBalance(node);
+
+    // Left side
+    if (balance > 1) {
+        if (getBalance(node->left) < 0) {
+            leftRotate(node->left);
+            statistics.doubleRotation();
+        } else {
+            statistics.rightRotation();
+        }
+        rightRotate(node);
+    }
+
+    // Right side
+    if (balance < -1) {
+        if (getBalance(node->right) > 0) {
+            rightRotate(node->right);
+            statistics.doubleRotation();
+        } else {
+            statistics.leftRotation();
+        }
+        leftRotate(node);
+    }
+}
+
+template <typename T, typename Compare, typename Allocator, typename Stats>
+void AVLTree<T, Compare, Allocator, Stats>::resetFingers() noexcept {
+    leftmost = this->head ? minNode(this->head) : nullptr;
+    rightmost = this->head ? maxNode(this->head) : nullptr;
+}
+
+template <typename T, typename Compare, typename Allocator, typename Stats>
+void AVLTree<T, Compare, Allocator, Stats>::destroyNode(Node *node) noexcept {
     std::allocator_traits<NodeAllocator>::destroy(allocator, node);
     allocator.deallocate(node, 1);
+}
 
-    // Replace with successor
-    node = successor;
+template <typename T, typename Compare, typename Allocator, typename Stats>
+void AVLTree<T, Compare, Allocator, Stats>::destroyTree(Node *node) noexcept {
+    if (node == nullptr) {
+        return;
+    }
+    destroyTree(node->left);
+    destroyTree(node->right);
+    destroyNode(node);
 }
 
-template <typename T, typename Compare, typename Allocator>
-bool AVLTree<T, Compare, Allocator>::remove(const T &value) noexcept {
-    return remove(this->head, value);
+template <typename T, typename Compare, typename Allocator, typename Stats>
+T *AVLTree<T, Compare, Allocator, Stats>::search(
+    const T &value) const noexcept {
+    Node *node = searchNode(value);
+    return node ? &node->value : nullptr;
 }
 
-template <typename T, typename Compare, typename Allocator>
-T *AVLTree<T, Compare, Allocator>::search(const T &value) const noexcept {
-    return search(this->head, value);
+template <typename T, typename Compare, typename Allocator, typename Stats>
+template <typename K>
+    requires LookupKey<K, T, Compare>
+T *AVLTree<T, Compare, Allocator, Stats>::search(const K &key) const noexcept {
+    Node *node = searchNode(key);
+    return node ? &node->value : nullptr;
 }
 
-template <typename T, typename Compare, typename Allocator>
-T *AVLTree<T, Compare, Allocator>::search(Node *node,
-                                          const T &value) const noexcept {
-    if (node == nullptr) {
-        return nullptr;
+template <typename T, typename Compare, typename Allocator, typename Stats>
+template <typename K>
+AVLTree<T, Compare, Allocator, Stats>::Node *
+AVLTree<T, Compare, Allocator, Stats>::searchNode(const K &key) const noexcept {
+    Node *node = this->head;
+    int depth = 0;
+
+    while (node != nullptr) {
+        ++depth;
+        if (compare(key, node->value)) {
+            node = node->left;
+        } else if (compare(node->value, key)) {
+            node = node->right;
+        } else {
+            statistics.search(depth);
+            return node;
+        }
     }
 
-    if (!comp(node->value, value) && !comp(value, node->value)) {
-        return &(node->value);
+    statistics.search(depth);
+    return nullptr;
+}
+
+template <typename T, typename Compare, typename Allocator, typename Stats>
+T *AVLTree<T, Compare, Allocator, Stats>::max() const noexcept {
+    return rightmost ? &rightmost->value : nullptr;
+}
+
+template <typename T, typename Compare, typename Allocator, typename Stats>
+AVLTree<T, Compare, Allocator, Stats>::Node *
+AVLTree<T, Compare, Allocator, Stats>::maxNode(Node *node) noexcept {
+    while (node->right != nullptr) {
+        node = node->right;
     }
+    return node;
+}
 
-    if (comp(value, node->value)) {
-        return search(node->left, value);
+template <typename T, typename Compare, typename Allocator, typename Stats>
+T *AVLTree<T, Compare, Allocator, Stats>::min() const noexcept {
+    return leftmost ? &leftmost->value : nullptr;
+}
+
+template <typename T, typename Compare, typename Allocator, typename Stats>
+AVLTree<T, Compare, Allocator, Stats>::Node *
+AVLTree<T, Compare, Allocator, Stats>::minNode(Node *node) noexcept {
+    while (node->left != nullptr) {
+        node = node->left;
     }
-    return search(node->right, value);
+    return node;
 }
 
-template <typename T, typename Compare, typename Allocator>
-T *AVLTree<T, Compare, Allocator>::max() const noexcept {
-    if (this->head == nullptr) {
-        return nullptr;
+// Successor is the min of the right subtree, or else the first ancestor that
+// is reached from its left side
+template <typename T, typename Compare, typename Allocator, typename Stats>
+AVLTree<T, Compare, Allocator, Stats>::Node *
+AVLTree<T, Compare, Allocator, Stats>::nextNode(Node *node) noexcept {
+    if (node->right != nullptr) {
+        return minNode(node->right);
     }
 
-    return max(this->head);
+    Node *child = node;
+    node = node->parent;
+    while (node != nullptr && child == node->right) {
+        child = node;
+        node = node->parent;
+    }
+    return node;
 }
 
-template <typename T, typename Compare, typename Allocator>
-T *AVLTree<T, Compare, Allocator>::max(Node *node) const noexcept {
-    return node->right ? max(node->right) : &node->value;
+// Mirror image of nextNode
+template <typename T, typename Compare, typename Allocator, typename Stats>
+AVLTree<T, Compare, Allocator, Stats>::Node *
+AVLTree<T, Compare, Allocator, Stats>::prevNode(Node *node) noexcept {
+    if (node->left != nullptr) {
+        return maxNode(node->left);
+    }
+
+    Node *child = node;
+    node = node->parent;
+    while (node != nullptr && child == node->left) {
+        child = node;
+        node = node->parent;
+    }
+    return node;
 }
 
-template <typename T, typename Compare, typename Allocator>
-T *AVLTree<T, Compare, Allocator>::min() const noexcept {
+template <typename T, typename Compare, typename Allocator, typename Stats>
+bool AVLTree<T, Compare, Allocator, Stats>::contains(
+    const T &value) const noexcept {
+    return searchNode(value) != nullptr;
+}
+
+template <typename T, typename Compare, typename Allocator, typename Stats>
+template <typename K>
+    requires LookupKey<K, T, Compare>
+bool AVLTree<T, Compare, Allocator, Stats>::contains(
+    const K &key) const noexcept {
+    return searchNode(key) != nullptr;
+}
+
+template <typename T, typename Compare, typename Allocator, typename Stats>
+size_t AVLTree<T, Compare, Allocator, Stats>::containsMany(
+    std::span<const T> keys, std::span<bool> found) const noexcept {
+    size_t hits = 0;
+    lookupMany(keys, [&](size_t i, Node *node) {
+        found[i] = node != nullptr;
+        hits += node != nullptr ? 1 : 0;
+    });
+    return hits;
+}
+
+template <typename T, typename Compare, typename Allocator, typename Stats>
+void AVLTree<T, Compare, Allocator, Stats>::searchMany(
+    std::span<const T> keys, std::span<T *> results) const noexcept {
+    lookupMany(keys, [&](size_t i, Node *node) {
+        results[i] = node != nullptr ? &node->value : nullptr;
+    });
+}
+
+// Group prefetching: a round gives every unfinished descent of the group one
+// step, by the time a descent gets its next turn the prefetch of its node
+// has had the other steps of the round to complete
+template <typename T, typename Compare, typename Allocator, typename Stats>
+template <typename Visit>
+void AVLTree<T, Compare, Allocator, Stats>::lookupMany(
+    std::span<const T> keys, Visit visit) const noexcept {
     if (this->head == nullptr) {
-        return nullptr;
+        for (size_t i = 0; i < keys.size(); ++i) {
+            visit(i, nullptr);
+        }
+        return;
     }
 
-    return min(this->head);
+    Node *cursor[AVL_LOOKUP_GROUP];
+    for (size_t base = 0; base < keys.size(); base += AVL_LOOKUP_GROUP) {
+        const size_t group = std::min(AVL_LOOKUP_GROUP, keys.size() - base);
+        std::fill_n(cursor, group, this->head);
+
+        for (size_t active = group; active > 0;) {
+            active = 0;
+            for (size_t i = 0; i < group; ++i) {
+                Node *node = cursor[i];
+                if (node == nullptr) {
+                    continue;
+                }
+
+                const T &key = keys[base + i];
+                if (compare(key, node->value)) {
+                    node = node->left;
+                } else if (compare(node->value, key)) {
+                    node = node->right;
+                } else {
+                    visit(base + i, node);
+                    cursor[i] = nullptr;
+                    continue;
+                }
+
+                if (node == nullptr) {
+                    visit(base + i, nullptr);
+                } else {
+#if defined(__GNUC__)
+                    __builtin_prefetch(node);
+#endif
+                    ++active;
+                }
+                cursor[i] = node;
+            }
+        }
+    }
 }
 
-template <typename T, typename Compare, typename Allocator>
-AVLTree<T, Compare, Allocator>::Node *
-AVLTree<T, Compare, Allocator>::minNode(Node *node) const noexcept {
-    return node->left ? minNode(node->left) : node;
+template <typename T, typename Compare, typename Allocator, typename Stats>
+int AVLTree<T, Compare, Allocator, Stats>::height() const noexcept {
+    return this->head ? this->head->height : 0;
 }
 
-template <typename T, typename Compare, typename Allocator>
-T *AVLTree<T, Compare, Allocator>::min(Node *node) const noexcept {
-    return node->left ? min(node->left) : &node->value;
-}
+template <typename T, typename Compare, typename Allocator, typename Stats>
+T *AVLTree<T, Compare, Allocator, Stats>::select(size_t k) const noexcept {
+    Node *node = this->head;
+
+    while (node != nullptr) {
+        const size_t leftCount = count(node->left);
+        if (k < leftCount) {
+            node = node->left;
+        } else if (k > leftCount) {
+            k -= leftCount + 1;
+            node = node->right;
+        } else {
+            return &node->value;
+        }
+    }
 
-template <typename T, typename Compare, typename Allocator>
-bool AVLTree<T, Compare, Allocator>::contains(const T &value) const noexcept {
-    return contains(this->head, value);
+    return nullptr;
 }
 
-template <typename T, typename Compare, typename Allocator>
-bool AVLTree<T, Compare, Allocator>::contains(Node *node,
-                                              const T &value) const noexcept {
-    if (node == nullptr) {
-        return false;
+template <typename T, typename Compare, typename Allocator, typename Stats>
+size_t AVLTree<T, Compare, Allocator, Stats>::rank(
+    const T &value) const noexcept {
+    Node *node = this->head;
+    size_t smaller = 0;
+
+    while (node != nullptr) {
+        if (compare(node->value, value)) {
+            smaller += count(node->left) + 1;
+            node = node->right;
+        } else {
+            node = node->left;
+        }
     }
 
-    if (!comp(node->value, value) && !comp(value, node->value)) {
-        return true;
+    return smaller;
+}
+
+template <typename T, typename Compare, typename Allocator, typename Stats>
+size_t AVLTree<T, Compare, Allocator, Stats>::countRange(
+    const T &lo, const T &hi) const noexcept {
+    if (!compare(lo, hi)) {
+        return 0;
     }
 
-    if (comp(value, node->value)) {
-        return contains(node->left, value);
+    return rank(hi) - rank(lo);
+}
+
+template <typename T, typename Compare, typename Allocator, typename Stats>
+FrozenSet<T, Compare> AVLTree<T, Compare, Allocator, Stats>::freeze() const {
+    return FrozenSet<T, Compare>(begin(), end(), comp);
+}
+
+template <typename T, typename Compare, typename Allocator, typename Stats>
+AVLTree<T, Compare, Allocator, Stats>::Iterator
+AVLTree<T, Compare, Allocator, Stats>::lower_bound(
+    const T &value) const noexcept {
+    return lower_bound<T>(value);
+}
+
+template <typename T, typename Compare, typename Allocator, typename Stats>
+template <typename K>
+    requires LookupKey<K, T, Compare>
+AVLTree<T, Compare, Allocator, Stats>::Iterator
+AVLTree<T, Compare, Allocator, Stats>::lower_bound(
+    const K &key) const noexcept {
+    Node *node = this->head;
+    Node *bound = nullptr;
+
+    while (node != nullptr) {
+        if (compare(node->value, key)) {
+            node = node->right;
+        } else {
+            bound = node;
+            node = node->left;
+        }
     }
 
-    return contains(node->right, value);
+    return Iterator(bound, this);
 }
 
-template <typename T, typename Compare, typename Allocator>
-int AVLTree<T, Compare, Allocator>::height() const noexcept {
-    return this->head ? this->head->height : 0;
+template <typename T, typename Compare, typename Allocator, typename Stats>
+AVLTree<T, Compare, Allocator, Stats>::Iterator
+AVLTree<T, Compare, Allocator, Stats>::upper_bound(
+    const T &value) const noexcept {
+    return upper_bound<T>(value);
 }
 
-template <typename T, typename Compare, typename Allocator>
-size_t AVLTree<T, Compare, Allocator>::size() const noexcept {
-    return size(this->head);
+template <typename T, typename Compare, typename Allocator, typename Stats>
+template <typename K>
+    requires LookupKey<K, T, Compare>
+AVLTree<T, Compare, Allocator, Stats>::Iterator
+AVLTree<T, Compare, Allocator, Stats>::upper_bound(
+    const K &key) const noexcept {
+    return equal_range(key).second;
 }
 
-template <typename T, typename Compare, typename Allocator>
-size_t AVLTree<T, Compare, Allocator>::size(Node *node) const noexcept {
-    if (node == nullptr) {
-        return 0;
+template <typename T, typename Compare, typename Allocator, typename Stats>
+std::pair<typename AVLTree<T, Compare, Allocator, Stats>::Iterator,
+          typename AVLTree<T, Compare, Allocator, Stats>::Iterator>
+AVLTree<T, Compare, Allocator, Stats>::equal_range(
+    const T &value) const noexcept {
+    return equal_range<T>(value);
+}
+
+// Values are unique, so the upper bound is either the lower bound itself or
+// the value right after it
+template <typename T, typename Compare, typename Allocator, typename Stats>
+template <typename K>
+    requires LookupKey<K, T, Compare>
+std::pair<typename AVLTree<T, Compare, Allocator, Stats>::Iterator,
+          typename AVLTree<T, Compare, Allocator, Stats>::Iterator>
+AVLTree<T, Compare, Allocator, Stats>::equal_range(
+    const K &key) const noexcept {
+    Iterator lower = lower_bound(key);
+    if (lower != end() && !compare(key, *lower)) {
+        return {lower, std::next(lower)};
     }
+    return {lower, lower};
+}
 
-    return size(node->left) + size(node->right) + 1;
+template <typename T, typename Compare, typename Allocator, typename Stats>
+template <typename F>
+void AVLTree<T, Compare, Allocator, Stats>::forEachInRange(const T &lo,
+                                                           const T &hi,
+                                                           F &&fn) const {
+    forEachInRange<T>(lo, hi, std::forward<F>(fn));
 }
 
-template <typename T, typename Compare, typename Allocator>
-void AVLTree<T, Compare, Allocator>::clear() noexcept {
-    clear(this->head);
+template <typename T, typename Compare, typename Allocator, typename Stats>
+template <typename K, typename F>
+    requires LookupKey<K, T, Compare>
+void AVLTree<T, Compare, Allocator, Stats>::forEachInRange(const K &lo,
+                                                           const K &hi,
+                                                           F &&fn) const {
+    // An empty range needs no check, its lower bound is already past hi
+    for (Iterator it = lower_bound(lo); it != end() && compare(*it, hi); ++it) {
+        if constexpr (std::is_same_v<std::invoke_result_t<F &, T &>, bool>) {
+            if (!fn(*it)) {
+                return;
+            }
+        } else {
+            fn(*it);
+        }
+    }
+}
+
+template <typename T, typename Compare, typename Allocator, typename Stats>
+size_t AVLTree<T, Compare, Allocator, Stats>::size() const noexcept {
+    return count(this->head);
+}
+
+template <typename T, typename Compare, typename Allocator, typename Stats>
+size_t AVLTree<T, Compare, Allocator, Stats>::count(Node *node) noexcept {
+    return node ? node->count : 0;
+}
+
+template <typename T, typename Compare, typename Allocator, typename Stats>
+void AVLTree<T, Compare, Allocator, Stats>::clear() noexcept {
+    if constexpr (BulkReleasableAllocator<NodeAllocator>) {
+        // Values still need their destructors, the memory goes in one call
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            clear(this->head);
+        }
+        allocator.release();
+    } else {
+        clear(this->head);
+    }
     this->head = nullptr;
+    leftmost = nullptr;
+    rightmost = nullptr;
 }
 
-template <typename T, typename Compare, typename Allocator>
-void AVLTree<T, Compare, Allocator>::clear(Node *node) noexcept {
+template <typename T, typename Compare, typename Allocator, typename Stats>
+void AVLTree<T, Compare, Allocator, Stats>::clear(Node *node) noexcept {
     if (node == nullptr) {
         return;
     }
     clear(node->left);
     clear(node->right);
     std::allocator_traits<NodeAllocator>::destroy(allocator, node);
-    allocator.deallocate(node, 1);
+    if constexpr (!BulkReleasableAllocator<NodeAllocator>) {
+        allocator.deallocate(node, 1);
+    }
 }
 
-template <typename T, typename Compare, typename Allocator>
-bool AVLTree<T, Compare, Allocator>::empty() const noexcept {
+template <typename T, typename Compare, typename Allocator, typename Stats>
+bool AVLTree<T, Compare, Allocator, Stats>::empty() const noexcept {
     return this->head == nullptr;
 }
 
-template <typename T, typename Compare, typename Allocator>
-int AVLTree<T, Compare, Allocator>::getBalance(Node *node) const noexcept {
+template <typename T, typename Compare, typename Allocator, typename Stats>
+template <typename L, typename R>
+bool AVLTree<T, Compare, Allocator, Stats>::compare(const L &lhs,
+                                                    const R &rhs) const {
+    statistics.comparison();
+    return comp(lhs, rhs);
+}
+
+template <typename T, typename Compare, typename Allocator, typename Stats>
+int AVLTree<T, Compare, Allocator, Stats>::getBalance(
+    Node *node) const noexcept {
     const int leftHeight = node->left ? node->left->height : 0;
     const int rightHeight = node->right ? node->right->height : 0;
 
     return leftHeight - rightHeight;
 }
 
-template <typename T, typename Compare, typename Allocator>
-void AVLTree<T, Compare, Allocator>::leftRotate(Node *&node) noexcept {
+template <typename T, typename Compare, typename Allocator, typename Stats>
+void AVLTree<T, Compare, Allocator, Stats>::leftRotate(Node *&node) noexcept {
     if (node == nullptr || node->right == nullptr) {
         return;
     }
@@ -303,15 +932,22 @@ void AVLTree<T, Compare, Allocator>::leftRotate(Node *&node) noexcept {
     Node *newRoot = node->right;
     // Move the left subtree of newRoot into the right subtree of root
     node->right = newRoot->left;
+    if (node->right) {
+        node->right->parent = node;
+    }
     // Make the old root the left child of newRoot
     newRoot->left = node;
+    newRoot->parent = node->parent;
+    node->parent = newRoot;
     node = newRoot;
     updateHeight(node->left);
     updateHeight(node);
+    updateCount(node->left);
+    updateCount(node);
 }
 
-template <typename T, typename Compare, typename Allocator>
-void AVLTree<T, Compare, Allocator>::rightRotate(Node *&node) noexcept {
+template <typename T, typename Compare, typename Allocator, typename Stats>
+void AVLTree<T, Compare, Allocator, Stats>::rightRotate(Node *&node) noexcept {
     if (node == nullptr || node->left == nullptr) {
         return;
     }
@@ -320,16 +956,23 @@ void AVLTree<T, Compare, Allocator>::rightRotate(Node *&node) noexcept {
     Node *newRoot = node->left;
     // Move the right subtree of newRoot into the left subtree of node
     node->left = newRoot->right;
+    if (node->left) {
+        node->left->parent = node;
+    }
     // Make the old root the right child of newRoot
     newRoot->right = node;
+    newRoot->parent = node->parent;
+    node->parent = newRoot;
     // Update node to point to new root
     node = newRoot;
     updateHeight(node->right);
     updateHeight(node);
+    updateCount(node->right);
+    updateCount(node);
 }
 
-template <typename T, typename Compare, typename Allocator>
-void AVLTree<T, Compare, Allocator>::updateHeight(Node *&node) noexcept {
+template <typename T, typename Compare, typename Allocator, typename Stats>
+void AVLTree<T, Compare, Allocator, Stats>::updateHeight(Node *&node) noexcept {
     const bool leftExists = node->left != nullptr;
     const bool rightExists = node->right != nullptr;
 
@@ -338,14 +981,31 @@ void AVLTree<T, Compare, Allocator>::updateHeight(Node *&node) noexcept {
     node->height = std::max(leftHeight, rightHeight) + 1;
 }
 
-template <typename T, typename Compare, typename Allocator>
-AVLTree<T, Compare, Allocator>::Iterator
-AVLTree<T, Compare, Allocator>::begin() const {
-    return Iterator(this->head);
+template <typename T, typename Compare, typename Allocator, typename Stats>
+void AVLTree<T, Compare, Allocator, Stats>::updateCount(Node *node) noexcept {
+    node->count = count(node->left) + count(node->right) + 1;
+}
+
+template <typename T, typename Compare, typename Allocator, typename Stats>
+AVLTree<T, Compare, Allocator, Stats>::Iterator
+AVLTree<T, Compare, Allocator, Stats>::begin() const {
+    return Iterator(leftmost, this);
+}
+
+template <typename T, typename Compare, typename Allocator, typename Stats>
+AVLTree<T, Compare, Allocator, Stats>::Iterator
+AVLTree<T, Compare, Allocator, Stats>::end() const {
+    return Iterator(nullptr, this);
+}
+
+template <typename T, typename Compare, typename Allocator, typename Stats>
+AVLTree<T, Compare, Allocator, Stats>::ReverseIterator
+AVLTree<T, Compare, Allocator, Stats>::rbegin() const {
+    return ReverseIterator(end());
 }
 
-template <typename T, typename Compare, typename Allocator>
-AVLTree<T, Compare, Allocator>::Iterator
-AVLTree<T, Compare, Allocator>::end() const {
-    return Iterator();
+template <typename T, typename Compare, typename Allocator, typename Stats>
+AVLTree<T, Compare, Allocator, Stats>::ReverseIterator
+AVLTree<T, Compare, Allocator, Stats>::rend() const {
+    return ReverseIterator(begin());
 }
@@ -2,54 +2,48 @@
 
 #include "avl_tree/avl_tree.h"
 
-template <typename T, typename Compare, typename Allocator>
-T &AVLTree<T, Compare, Allocator>::Iterator::operator*() const {
-    return nodeStack.top()->value;
+template <typename T, typename Compare, typename Allocator, typename Stats>
+T &AVLTree<T, Compare, Allocator, Stats>::Iterator::operator*() const {
+    return node->value;
 }
-template <typename T, typename Compare, typename Allocator>
-T *AVLTree<T, Compare, Allocator>::Iterator::operator->() const {
-    return &(nodeStack.top()->value);
+template <typename T, typename Compare, typename Allocator, typename Stats>
+T *AVLTree<T, Compare, Allocator, Stats>::Iterator::operator->() const {
+    return &(node->value);
 }
-template <typename T, typename Compare, typename Allocator>
-AVLTree<T, Compare, Allocator>::Iterator &
-AVLTree<T, Compare, Allocator>::Iterator::operator++() {
-    Node *node = nodeStack.top();
-    nodeStack.pop();
-    if (node->right) {
-        pushLeftNodes(node->right);
-    }
+template <typename T, typename Compare, typename Allocator, typename Stats>
+AVLTree<T, Compare, Allocator, Stats>::Iterator &
+AVLTree<T, Compare, Allocator, Stats>::Iterator::operator++() {
+    node = nextNode(node);
     return *this;
 };
-template <typename T, typename Compare, typename Allocator>
-AVLTree<T, Compare, Allocator>::Iterator
-AVLTree<T, Compare, Allocator>::Iterator::operator++(int) {
+template <typename T, typename Compare, typename Allocator, typename Stats>
+AVLTree<T, Compare, Allocator, Stats>::Iterator
+AVLTree<T, Compare, Allocator, Stats>::Iterator::operator++(int) {
     Iterator temp = *this;
     ++(*this);
     return temp;
 }
-template <typename T, typename Compare, typename Allocator>
-bool AVLTree<T, Compare, Allocator>::Iterator::operator==(
-    const AVLTree<T, Compare, Allocator>::Iterator &other) const {
-    if (nodeStack.empty() && other.nodeStack.empty()) {
-        return true;
-    }
-    if (nodeStack.empty() || other.nodeStack.empty()) {
-        return false;
-    }
-
-    return nodeStack.top() == other.nodeStack.top();
+// Stepping back from end() lands on the max
+template <typename T, typename Compare, typename Allocator, typename Stats>
+AVLTree<T, Compare, Allocator, Stats>::Iterator &
+AVLTree<T, Compare, Allocator, Stats>::Iterator::operator--() {
+    node = node ? prevNode(node) : tree->rightmost;
+    return *this;
 }
-template <typename T, typename Compare, typename Allocator>
-bool AVLTree<T, Compare, Allocator>::Iterator::operator!=(
-    const AVLTree<T, Compare, Allocator>::Iterator &other) const {
-    return !(*this == other);
+template <typename T, typename Compare, typename Allocator, typename Stats>
+AVLTree<T, Compare, Allocator, Stats>::Iterator
+AVLTree<T, Compare, Allocator, Stats>::Iterator::operator--(int) {
+    Iterator temp = *this;
+    --(*this);
+    return temp;
 }
-
-template <typename T, typename Compare, typename Allocator>
-void AVLTree<T, Compare, Allocator>::Iterator::pushLeftNodes(
-    AVLTree<T, Compare, Allocator>::Node *node) {
-    while (node) {
-        nodeStack.push(node);
-        node = node->left;
-    }
+template <typename T, typename Compare, typename Allocator, typename Stats>
+bool AVLTree<T, Compare, Allocator, Stats>::Iterator::operator==(
+    const AVLTree<T, Compare, Allocator, Stats>::Iterator &other) const {
+    return node == other.node;
+}
+template <typename T, typename Compare, typename Allocator, typename Stats>
+bool AVLTree<T, Compare, Allocator, Stats>::Iterator::operator!=(
+    const AVLTree<T, Compare, Allocator, Stats>::Iterator &other) const {
+    return !(*this == other);
 }
@@ -0,0 +1,436 @@
+#pragma once
+
+#include "avl_tree/avl_tree.h"
+#include <cstddef>
+#include <future>
+#include <iterator>
+#include <ranges>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Join based split and set algebra, following "Just Join for Parallel Ordered
+// Sets" (Blelloch, Ferizovic, Sun). Everything is built on joinNodes, which
+// merges two subtrees and a pivot in O(|h1 - h2| + 1) time.
+
+template <typename T, typename Compare, typename Allocator, typename Stats>
+bool AVLTree<T, Compare, Allocator, Stats>::split(const T &key,
+                                                  AVLTree &greater) {
+    if (&greater == this) {
+        return false;
+    }
+    greater.clear();
+
+    SplitResult parts = splitNode(this->head, key);
+    this->head = parts.left;
+    if (this->head != nullptr) {
+        this->head->parent = nullptr;
+    }
+
+    const bool found = parts.found != nullptr;
+    if (found) {
+        destroyNode(parts.found);
+    }
+
+    greater.head = greater.adopt(parts.right, *this);
+    resetFingers();
+    greater.resetFingers();
+    return found;
+}
+
+template <typename T, typename Compare, typename Allocator, typename Stats>
+void AVLTree<T, Compare, Allocator, Stats>::join(T pivot, AVLTree &&greater) {
+    Node *right = adopt(greater.head, greater);
+    greater.head = nullptr;
+    greater.resetFingers();
+
+    Node *pivotNode = createNode(std::move(pivot));
+
+    this->head = joinNodes(this->head, pivotNode, right);
+    this->head->parent = nullptr;
+    resetFingers();
+}
+
+template <typename T, typename Compare, typename Allocator, typename Stats>
+void AVLTree<T, Compare, Allocator, Stats>::setUnion(AVLTree &&other) {
+    if (&other == this) {
+        return;
+    }
+
+    Node *rhs = adopt(other.head, other);
+    other.head = nullptr;
+    other.resetFingers();
+
+    this->head = unionNodes(this->head, rhs, parallelForkDepth());
+    if (this->head != nullptr) {
+        this->head->parent = nullptr;
+    }
+    resetFingers();
+}
+
+template <typename T, typename Compare, typename Allocator, typename Stats>
+void AVLTree<T, Compare, Allocator, Stats>::setIntersection(AVLTree &&other) {
+    if (&other == this) {
+        return;
+    }
+
+    Node *rhs = adopt(other.head, other);
+    other.head = nullptr;
+    other.resetFingers();
+
+    this->head = intersectionNodes(this->head, rhs, parallelForkDepth());
+    if (this->head != nullptr) {
+        this->head->parent = nullptr;
+    }
+    resetFingers();
+}
+
+template <typename T, typename Compare, typename Allocator, typename Stats>
+void AVLTree<T, Compare, Allocator, Stats>::setDifference(AVLTree &&other) {
+    if (&other == this) {
+        clear();
+        return;
+    }
+
+    Node *rhs = adopt(other.head, other);
+    other.head = nullptr;
+    other.resetFingers();
+
+    this->head = differenceNodes(this->head, rhs, parallelForkDepth());
+    if (this->head != nullptr) {
+        this->head->parent = nullptr;
+    }
+    resetFingers();
+}
+
+// The batch is the left operand of the union, so its duplicates are the nodes
+// that get dropped and the values in the tree stay untouched
+template <typename T, typename Compare, typename Allocator, typename Stats>
+template <std::ranges::input_range R>
+    requires std::constructible_from<T, std::ranges::range_reference_t<R>>
+size_t AVLTree<T, Compare, Allocator, Stats>::insertBatch(R &&values) {
+    std::vector<T> batch =
+        sortedValues(std::ranges::begin(values), std::ranges::end(values));
+    if (batch.empty()) {
+        return 0;
+    }
+
+    const size_t before = size();
+    auto it = std::make_move_iterator(batch.begin());
+    Node *rhs = buildBalanced(it, batch.size(), nullptr);
+
+    this->head = unionNodes(rhs, this->head, parallelForkDepth());
+    this->head->parent = nullptr;
+    resetFingers();
+    return size() - before;
+}
+
+template <typename T, typename Compare, typename Allocator, typename Stats>
+template <std::ranges::input_range R>
+    requires std::constructible_from<T, std::ranges::range_reference_t<R>>
+size_t AVLTree<T, Compare, Allocator, Stats>::removeBatch(R &&values) {
+    std::vector<T> batch =
+        sortedValues(std::ranges::begin(values), std::ranges::end(values));
+    if (batch.empty() || empty()) {
+        return 0;
+    }
+
+    const size_t before = size();
+    auto it = std::make_move_iterator(batch.begin());
+    Node *rhs = buildBalanced(it, batch.size(), nullptr);
+
+    this->head = differenceNodes(this->head, rhs, parallelForkDepth());
+    if (this->head != nullptr) {
+        this->head->parent = nullptr;
+    }
+    resetFingers();
+    return before - size();
+}
+
+template <typename T, typename Compare, typename Allocator, typename Stats>
+AVLTree<T, Compare, Allocator, Stats>::Node *
+AVLTree<T, Compare, Allocator, Stats>::adopt(Node *root, AVLTree &source) {
+    if (root == nullptr) {
+        return nullptr;
+    }
+    root->parent = nullptr;
+
+    if constexpr (!std::allocator_traits<
+                      NodeAllocator>::is_always_equal::value) {
+        // Nodes have to be freed by the allocator that made them, so they
+        // can only change trees if both share it
+        if (!(allocator == source.allocator)) {
+            auto it = std::make_move_iterator(
+                Iterator(source.minNode(root), &source));
+            Node *copy = buildBalanced(it, root->count, nullptr);
+            source.destroyTree(root);
+            return copy;
+        }
+    }
+
+    return root;
+}
+
+template <typename T, typename Compare, typename Allocator, typename Stats>
+AVLTree<T, Compare, Allocator, Stats>::Node *
+AVLTree<T, Compare, Allocator, Stats>::connect(Node *left, Node *pivot,
+                                               Node *right) noexcept {
+    pivot->left = left;
+    pivot->right = right;
+    pivot->parent = nullptr;
+    if (left != nullptr) {
+        left->parent = pivot;
+    }
+    if (right != nullptr) {
+        right->parent = pivot;
+    }
+    updateHeight(pivot);
+    updateCount(pivot);
+    return pivot;
+}
+
+template <typename T, typename Compare, typename Allocator, typename Stats>
+AVLTree<T, Compare, Allocator, Stats>::Node *
+AVLTree<T, Compare, Allocator, Stats>::joinNodes(Node *left, Node *pivot,
+                                                 Node *right) noexcept {
+    if (height(left) > height(right) + 1) {
+        return joinRight(left, pivot, right);
+    }
+    if (height(right) > height(left) + 1) {
+        return joinLeft(left, pivot, right);
+    }
+    return connect(left, pivot, right);
+}
+
+// Walk down the right spine of the taller left tree until the heights match,
+// attach there and rotate on the way back up where the balance broke
+template <typename T, typename Compare, typename Allocator, typename Stats>
+AVLTree<T, Compare, Allocator, Stats>::Node *
+AVLTree<T, Compare, Allocator, Stats>::joinRight(Node *left, Node *pivot,
+                                                 Node *right) noexcept {
+    Node *leftChild = left->left;
+    Node *middle = left->right;
+
+    if (height(middle) <= height(right) + 1) {
+        Node *joined = connect(middle, pivot, right);
+        if (height(joined) <= height(leftChild) + 1) {
+            return connect(leftChild, left, joined);
+        }
+
+        rightRotate(joined);
+        Node *result = connect(leftChild, left, joined);
+        leftRotate(result);
+        statistics.doubleRotation();
+        return result;
+    }
+
+    Node *joined = joinRight(middle, pivot, right);
+    Node *result = connect(leftChild, left, joined);
+    if (height(joined) > height(leftChild) + 1) {
+        leftRotate(result);
+        statistics.leftRotation();
+    }
+    return result;
+}
+
+// Mirror image of joinRight
+template <typename T, typename Compare, typename Allocator, typename Stats>
+AVLTree<T, Compare, Allocator, Stats>::Node *
+AVLTree<T, Compare, Allocator, Stats>::joinLeft(Node *left, Node *pivot,
+                                                Node *right) noexcept {
+    Node *rightChild = right->right;
+    Node *middle = right->left;
+
+    if (height(middle) <= height(left) + 1) {
+        Node *joined = connect(left, pivot, middle);
+        if (height(joined) <= height(rightChild) + 1) {
+            return connect(joined, right, rightChild);
+        }
+
+        leftRotate(joined);
+        Node *result = connect(joined, right, rightChild);
+        rightRotate(result);
+        statistics.doubleRotation();
+        return result;
+    }
+
+    Node *joined = joinLeft(left, pivot, middle);
+    Node *result = connect(joined, right, rightChild);
+    if (height(joined) > height(rightChild) + 1) {
+        rightRotate(result);
+        statistics.rightRotation();
+    }
+    return result;
+}
+
+template <typename T, typename Compare, typename Allocator, typename Stats>
+AVLTree<T, Compare, Allocator, Stats>::Node *
+AVLTree<T, Compare, Allocator, Stats>::joinNodes(Node *left,
+                                                 Node *right) noexcept {
+    if (left == nullptr) {
+        return right;
+    }
+
+    Node *last = nullptr;
+    Node *rest = splitLast(left, last);
+    return joinNodes(rest, last, right);
+}
+
+template <typename T, typename Compare, typename Allocator, typename Stats>
+AVLTree<T, Compare, Allocator, Stats>::Node *
+AVLTree<T, Compare, Allocator, Stats>::splitLast(Node *node,
+                                                 Node *&last) noexcept {
+    if (node->right == nullptr) {
+        last = node;
+        return node->left;
+    }
+
+    Node *rest = splitLast(node->right, last);
+    return joinNodes(node->left, node, rest);
+}
+
+template <typename T, typename Compare, typename Allocator, typename Stats>
+AVLTree<T, Compare, Allocator, Stats>::SplitResult
+AVLTree<T, Compare, Allocator, Stats>::splitNode(Node *node,
+                                                 const T &key) noexcept {
+    if (node == nullptr) {
+        return {nullptr, nullptr, nullptr};
+    }
+
+    if (compare(key, node->value)) {
+        SplitResult parts = splitNode(node->left, key);
+        return {parts.left, parts.found,
+                joinNodes(parts.right, node, node->right)};
+    }
+
+    if (compare(node->value, key)) {
+        SplitResult parts = splitNode(node->right, key);
+        return {joinNodes(node->left, node, parts.left), parts.found,
+                parts.right};
+    }
+
+    return {node->left, node, node->right};
+}
+
+// The root of rhs becomes the pivot, lhs is split around it and both halves
+// are merged independently
+template <typename T, typename Compare, typename Allocator, typename Stats>
+AVLTree<T, Compare, Allocator, Stats>::Node *
+AVLTree<T, Compare, Allocator, Stats>::unionNodes(Node *lhs, Node *rhs,
+                                                  int forkDepth) {
+    if (lhs == nullptr) {
+        return rhs;
+    }
+    if (rhs == nullptr) {
+        return lhs;
+    }
+
+    Node *rhsLeft = rhs->left;
+    Node *rhsRight = rhs->right;
+    SplitResult parts = splitNode(lhs, rhs->value);
+    if (parts.found != nullptr) {
+        destroyNode(parts.found);
+    }
+
+    auto [left, right] = fork(&AVLTree::unionNodes, parts.left, rhsLeft,
+                              parts.right, rhsRight, forkDepth);
+    return joinNodes(left, rhs, right);
+}
+
+template <typename T, typename Compare, typename Allocator, typename Stats>
+AVLTree<T, Compare, Allocator, Stats>::Node *
+AVLTree<T, Compare, Allocator, Stats>::intersectionNodes(Node *lhs, Node *rhs,
+                                                         int forkDepth) {
+    if (lhs == nullptr || rhs == nullptr) {
+        destroyTree(lhs);
+        destroyTree(rhs);
+        return nullptr;
+    }
+
+    Node *rhsLeft = rhs->left;
+    Node *rhsRight = rhs->right;
+    SplitResult parts = splitNode(lhs, rhs->value);
+
+    auto [left, right] = fork(&AVLTree::intersectionNodes, parts.left, rhsLeft,
+                              parts.right, rhsRight, forkDepth);
+
+    if (parts.found != nullptr) {
+        destroyNode(parts.found);
+        return joinNodes(left, rhs, right);
+    }
+
+    destroyNode(rhs);
+    return joinNodes(left, right);
+}
+
+template <typename T, typename Compare, typename Allocator, typename Stats>
+AVLTree<T, Compare, Allocator, Stats>::Node *
+AVLTree<T, Compare, Allocator, Stats>::differenceNodes(Node *lhs, Node *rhs,
+                                                       int forkDepth) {
+    if (lhs == nullptr || rhs == nullptr) {
+        destroyTree(rhs);
+        return lhs;
+    }
+
+    Node *rhsLeft = rhs->left;
+    Node *rhsRight = rhs->right;
+    SplitResult parts = splitNode(lhs, rhs->value);
+    if (parts.found != nullptr) {
+        destroyNode(parts.found);
+    }
+    destroyNode(rhs);
+
+    auto [left, right] = fork(&AVLTree::differenceNodes, parts.left, rhsLeft,
+                              parts.right, rhsRight, forkDepth);
+    return joinNodes(left, right);
+}
+
+template <typename T, typename Compare, typename Allocator, typename Stats>
+std::pair<typename AVLTree<T, Compare, Allocator, Stats>::Node *,
+          typename AVLTree<T, Compare, Allocator, Stats>::Node *>
+AVLTree<T, Compare, Allocator, Stats>::fork(SetOperation operation,
+                                            Node *lhsLeft, Node *rhsLeft,
+                                            Node *lhsRight, Node *rhsRight,
+                                            int forkDepth) {
+    const size_t work =
+        count(lhsLeft) + count(rhsLeft) + count(lhsRight) + count(rhsRight);
+
+    if (forkDepth > 0 && work >= AVL_PARALLEL_GRAIN) {
+        try {
+            auto left = std::async(std::launch::async, [&]() {
+                return (this->*operation)(lhsLeft, rhsLeft, forkDepth - 1);
+            });
+            Node *right = (this->*operation)(lhsRight, rhsRight, forkDepth - 1);
+            return {left.get(), right};
+        } catch (const std::system_error &) {
+            // No thread available, fall through and do both halves here
+        }
+    }
+
+    Node *left = (this->*operation)(lhsLeft, rhsLeft, forkDepth);
+    Node *right = (this->*operation)(lhsRight, rhsRight, forkDepth);
+    return {left, right};
+}
+
+// Forking is only allowed with stateless allocators, a stateful one such as
+// PoolAllocator is not safe to use from several threads
+template <typename T, typename Compare, typename Allocator, typename Stats>
+int AVLTree<T, Compare, Allocator, Stats>::parallelForkDepth() noexcept {
+    if constexpr (!std::allocator_traits<
+                      NodeAllocator>::is_always_equal::value) {
+        return 0;
+    }
+
+    const unsigned threads = std::thread::hardware_concurrency();
+    int depth = 0;
+    while ((1U << depth) < threads) {
+        ++depth;
+    }
+    return depth;
+}
+
+template <typename T, typename Compare, typename Allocator, typename Stats>
+int AVLTree<T, Compare, Allocator, Stats>::height(Node *node) noexcept {
+    return node ? node->height : 0;
+}
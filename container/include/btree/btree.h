@@ -0,0 +1,299 @@
+#pragma once
+
+#include "btree/sorted_keys.h"
+#include "container.h"
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <new>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+/**
+ * Bytes of keys stored per node by default, four cache lines. Large enough
+ * that a lookup in a set of 10M ints touches five nodes, small enough that a
+ * node is scanned in a few vector compares.
+ */
+constexpr std::size_t BTREE_NODE_SIZE = 256;
+
+constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+/**
+ * Upper bound on the height of any BTreeSet. Every inner node has at least
+ * two children, so this covers more nodes than fit in memory. Sizes the path
+ * buffers of insert and remove.
+ */
+constexpr int BTREE_MAX_HEIGHT = 64;
+
+/**
+ * Ordered set stored as a B+-tree.
+ *
+ * Values live in the leaves, which are linked for iteration and range scans.
+ * Inner nodes hold copies of leaf values as separators, so T has to be copy
+ * constructible. Every node keeps up to NodeSize bytes of keys at the start
+ * of a cache line aligned block. Arithmetic keys ordered by std::less are
+ * located inside a node with SIMD compares (see countLess), any other key
+ * type with a binary search.
+ */
+template <typename T, typename Compare = std::less<T>,
+          std::size_t NodeSize = BTREE_NODE_SIZE>
+class BTreeSet {
+    static_assert(std::copy_constructible<T>,
+                  "BTreeSet copies values into its inner nodes");
+
+  private:
+    /**
+     * Keys per node, at least three so a split leaves every inner node with
+     * a separator.
+     */
+    static constexpr std::size_t CAPACITY =
+        std::max<std::size_t>(NodeSize / sizeof(T), 3);
+    // Fewest keys a node other than the root may hold
+    static constexpr std::size_t LEAF_MIN = (CAPACITY + 1) / 2;
+    static constexpr std::size_t INNER_MIN = CAPACITY / 2;
+
+    struct alignas(CACHE_LINE_SIZE) Node {
+        // Raw storage, only the first count keys are constructed
+        alignas(T) std::byte storage[CAPACITY * sizeof(T)];
+        std::size_t count = 0;
+        bool leaf;
+
+        explicit Node(bool leaf) : leaf(leaf) {}
+
+        T *keys() noexcept {
+            return std::launder(reinterpret_cast<T *>(storage));
+        }
+        const T *keys() const noexcept {
+            return std::launder(reinterpret_cast<const T *>(storage));
+        }
+    };
+
+    struct Leaf : Node {
+        Leaf *prev = nullptr;
+        Leaf *next = nullptr;
+
+        Leaf() : Node(true) {}
+    };
+
+    struct Inner : Node {
+        // all keys in children[i] < keys[i] <= all keys in children[i + 1]
+        Node *children[CAPACITY + 1];
+
+        Inner() : Node(false) {}
+    };
+
+    // Inner node and the child index taken on the way down
+    struct PathEntry {
+        Inner *node;
+        std::size_t index;
+    };
+
+  public:
+    BTreeSet() = default;
+    BTreeSet(const BTreeSet &) = delete;
+    /**
+     * Takes over the nodes of other without copying, other is left empty.
+     */
+    BTreeSet(BTreeSet &&other) noexcept;
+    BTreeSet &operator=(const BTreeSet &) = delete;
+    BTreeSet &operator=(BTreeSet &&other) noexcept;
+    ~BTreeSet() { clear(); }
+
+    // iterator
+    /**
+     * Bidirectional in-order iterator, a leaf and a position in it. The end
+     * iterator has no leaf and steps back onto the max of the set.
+     */
+    class Iterator {
+      public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = T;
+        using pointer = T *;
+        using reference = T &;
+
+        Iterator() = default;
+        Iterator(Leaf *leaf, std::size_t index, const BTreeSet *tree)
+            : leaf(leaf), index(index), tree(tree) {}
+
+        reference operator*() const;
+        pointer operator->() const;
+
+        Iterator &operator++();
+        Iterator operator++(int);
+        Iterator &operator--();
+        Iterator operator--(int);
+        bool operator==(const Iterator &other) const;
+        bool operator!=(const Iterator &other) const;
+
+      private:
+        Leaf *leaf = nullptr;
+        std::size_t index = 0;
+        const BTreeSet *tree = nullptr;
+    };
+
+    [[nodiscard]] Iterator begin() const;
+    [[nodiscard]] Iterator end() const;
+
+    // modifiers
+    /**
+     * Inserts the value, returns false if an equivalent value already
+     * existed.
+     */
+    bool insert(const T &value);
+    bool insert(T &&value);
+    /**
+     * Removes an equivalent value, returns false if there was none.
+     */
+    bool remove(const T &value);
+    template <typename K>
+        requires LookupKey<K, T, Compare>
+    bool remove(const K &key);
+    void clear() noexcept;
+    /**
+     * Exchanges the contents of two sets in O(1).
+     */
+    void swap(BTreeSet &other) noexcept;
+    friend void swap(BTreeSet &lhs, BTreeSet &rhs) noexcept { lhs.swap(rhs); }
+
+    // access
+    /**
+     * Search for a value, returns nullptr if not found.
+     */
+    [[nodiscard]] T *search(const T &value) const noexcept;
+    template <typename K>
+        requires LookupKey<K, T, Compare>
+    [[nodiscard]] T *search(const K &key) const noexcept;
+    /**
+     * Returns the max value, or nullptr if the set is empty.
+     */
+    [[nodiscard]] T *max() const noexcept;
+    /**
+     * Returns the min value, or nullptr if the set is empty.
+     */
+    [[nodiscard]] T *min() const noexcept;
+    [[nodiscard]] bool contains(const T &value) const noexcept;
+    template <typename K>
+        requires LookupKey<K, T, Compare>
+    [[nodiscard]] bool contains(const K &key) const noexcept;
+
+    // range queries
+    /**
+     * Returns an iterator to the first value not smaller than value, or end().
+     */
+    [[nodiscard]] Iterator lower_bound(const T &value) const noexcept;
+    /**
+     * Returns an iterator to the first value greater than value, or end().
+     */
+    [[nodiscard]] Iterator upper_bound(const T &value) const noexcept;
+    /**
+     * Returns the range of values equivalent to value, which is empty or
+     * holds a single value.
+     */
+    [[nodiscard]] std::pair<Iterator, Iterator>
+    equal_range(const T &value) const noexcept;
+    /**
+     * Calls fn with every value in [lo, hi) in order, O(log n + k). If fn
+     * returns a bool, returning false stops the scan.
+     */
+    template <typename F>
+    void forEachInRange(const T &lo, const T &hi, F &&fn) const;
+    template <typename K>
+        requires LookupKey<K, T, Compare>
+    [[nodiscard]] Iterator lower_bound(const K &key) const noexcept;
+    template <typename K>
+        requires LookupKey<K, T, Compare>
+    [[nodiscard]] Iterator upper_bound(const K &key) const noexcept;
+    template <typename K>
+        requires LookupKey<K, T, Compare>
+    [[nodiscard]] std::pair<Iterator, Iterator>
+    equal_range(const K &key) const noexcept;
+    template <typename K, typename F>
+        requires LookupKey<K, T, Compare>
+    void forEachInRange(const K &lo, const K &hi, F &&fn) const;
+
+    // info
+    /**
+     * Get the number of levels, 0 for an empty set.
+     */
+    [[nodiscard]] int height() const noexcept;
+    [[nodiscard]] std::size_t size() const noexcept;
+    [[nodiscard]] bool empty() const noexcept;
+
+  private:
+    Node *root = nullptr;
+    Leaf *first = nullptr;
+    Leaf *last = nullptr;
+    std::size_t count = 0;
+    int levels = 0;
+
+    // search
+    /**
+     * Index of the child of an inner node that covers key.
+     */
+    template <typename K>
+    [[nodiscard]] std::size_t childIndex(const Inner *node,
+                                         const K &key) const noexcept;
+    /**
+     * Walk down to the leaf that covers key, recording the inner nodes on
+     * the way in path when it is given.
+     */
+    template <typename K>
+    [[nodiscard]] Leaf *findLeaf(const K &key, PathEntry *path,
+                                 int *depth) const noexcept;
+
+    // modifiers
+    template <typename V> bool insertValue(V &&value);
+    /**
+     * Split a full leaf while inserting value at pos, returns the new right
+     * half.
+     */
+    template <typename V>
+    Leaf *splitLeaf(Leaf *leaf, std::size_t pos, V &&value);
+    /**
+     * Hand a separator and the new node right of it up the path, splitting
+     * full inner nodes on the way and growing a new root if needed.
+     */
+    void insertSeparator(PathEntry *path, int depth, T separator, Node *right);
+    /**
+     * Restore the minimum fill of a node after a removal by borrowing from
+     * or merging with a sibling, then continue with the parent.
+     */
+    void rebalanceAfterRemove(PathEntry *path, int depth, Node *node);
+    void fixLeaf(Inner *parent, std::size_t index, Leaf *leaf);
+    void fixInner(Inner *parent, std::size_t index, Inner *node);
+    void destroyTree(Node *node) noexcept;
+    /**
+     * Free a node whose keys are already destroyed.
+     */
+    static void freeNode(Node *node) noexcept;
+
+    // raw key storage, see sorted_keys.h for the rest
+    /**
+     * Move the last key out of a node.
+     */
+    static T takeLast(Node *node) noexcept;
+    /**
+     * Insert a separator at pos together with the child right of it.
+     */
+    static void insertEntry(Inner *node, std::size_t pos, T &&key,
+                            Node *child);
+    /**
+     * Remove the separator at pos together with the child right of it.
+     */
+    static void eraseEntry(Inner *node, std::size_t pos) noexcept;
+
+    Compare comp;
+};
+
+#include "btree/btree.hpp"
+#include "btree/iterator.hpp" // IWYU pragma: keep
+
+static_assert(Dontainer<BTreeSet<int>, int>);
+static_assert(RangeDontainer<BTreeSet<int>, int>);
+static_assert(std::bidirectional_iterator<BTreeSet<int>::Iterator>);
+static_assert(TransparentDontainer<BTreeSet<std::string, std::less<>>,
+                                   std::string, std::string_view>);
@@ -0,0 +1,532 @@
+#pragma once
+
+#include "btree/btree.h"
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+template <typename T, typename Compare, std::size_t NodeSize>
+BTreeSet<T, Compare, NodeSize>::BTreeSet(BTreeSet &&other) noexcept {
+    swap(other);
+}
+
+template <typename T, typename Compare, std::size_t NodeSize>
+BTreeSet<T, Compare, NodeSize> &
+BTreeSet<T, Compare, NodeSize>::operator=(BTreeSet &&other) noexcept {
+    if (this != &other) {
+        clear();
+        swap(other);
+    }
+    return *this;
+}
+
+template <typename T, typename Compare, std::size_t NodeSize>
+void BTreeSet<T, Compare, NodeSize>::swap(BTreeSet &other) noexcept {
+    using std::swap;
+    swap(root, other.root);
+    swap(first, other.first);
+    swap(last, other.last);
+    swap(count, other.count);
+    swap(levels, other.levels);
+    swap(comp, other.comp);
+}
+
+template <typename T, typename Compare, std::size_t NodeSize>
+bool BTreeSet<T, Compare, NodeSize>::insert(const T &value) {
+    return insertValue(value);
+}
+
+template <typename T, typename Compare, std::size_t NodeSize>
+bool BTreeSet<T, Compare, NodeSize>::insert(T &&value) {
+    return insertValue(std::move(value));
+}
+
+template <typename T, typename Compare, std::size_t NodeSize>
+template <typename V>
+bool BTreeSet<T, Compare, NodeSize>::insertValue(V &&value) {
+    if (root == nullptr) {
+        auto *leaf = new Leaf();
+        insertSortedKey(leaf, 0, std::forward<V>(value));
+        root = first = last = leaf;
+        levels = 1;
+        count = 1;
+        return true;
+    }
+
+    PathEntry path[BTREE_MAX_HEIGHT];
+    int depth = 0;
+    Leaf *leaf = findLeaf(value, path, &depth);
+    const std::size_t pos = sortedLowerBound(leaf, value, comp);
+    if (pos < leaf->count && equivalent(value, leaf->keys()[pos], comp)) {
+        return false;
+    }
+
+    ++count;
+    if (leaf->count < CAPACITY) {
+        insertSortedKey(leaf, pos, std::forward<V>(value));
+        return true;
+    }
+
+    Leaf *right = splitLeaf(leaf, pos, std::forward<V>(value));
+    insertSeparator(path, depth, T(right->keys()[0]), right);
+    return true;
+}
+
+// The value is placed while splitting, so the leaf never has to hold more
+// than CAPACITY keys
+template <typename T, typename Compare, std::size_t NodeSize>
+template <typename V>
+typename BTreeSet<T, Compare, NodeSize>::Leaf *
+BTreeSet<T, Compare, NodeSize>::splitLeaf(Leaf *leaf, std::size_t pos,
+                                          V &&value) {
+    auto *right = new Leaf();
+    const std::size_t half = (CAPACITY + 1) / 2;
+
+    if (pos < half) {
+        moveSortedKeys(leaf, half - 1, right);
+        insertSortedKey(leaf, pos, std::forward<V>(value));
+    } else {
+        moveSortedKeys(leaf, half, right);
+        insertSortedKey(right, pos - half, std::forward<V>(value));
+    }
+
+    right->prev = leaf;
+    right->next = leaf->next;
+    if (leaf->next != nullptr) {
+        leaf->next->prev = right;
+    } else {
+        last = right;
+    }
+    leaf->next = right;
+    return right;
+}
+
+// A full inner node is split around its middle key, which then travels one
+// level further up
+template <typename T, typename Compare, std::size_t NodeSize>
+void BTreeSet<T, Compare, NodeSize>::insertSeparator(PathEntry *path,
+                                                     int depth, T separator,
+                                                     Node *right) {
+    while (depth > 0) {
+        auto [node, index] = path[--depth];
+        if (node->count < CAPACITY) {
+            insertEntry(node, index, std::move(separator), right);
+            return;
+        }
+
+        auto *sibling = new Inner();
+        const std::size_t half = (CAPACITY + 1) / 2;
+
+        if (index < half) {
+            moveSortedKeys(node, half, sibling);
+            std::copy(node->children + half, node->children + CAPACITY + 1,
+                      sibling->children);
+            T up = takeLast(node);
+            insertEntry(node, index, std::move(separator), right);
+            separator = std::move(up);
+        } else if (index == half) {
+            // The new separator is the middle key itself
+            moveSortedKeys(node, half, sibling);
+            sibling->children[0] = right;
+            std::copy(node->children + half + 1, node->children + CAPACITY + 1,
+                      sibling->children + 1);
+        } else {
+            moveSortedKeys(node, half + 1, sibling);
+            std::copy(node->children + half + 1, node->children + CAPACITY + 1,
+                      sibling->children);
+            T up = takeLast(node);
+            insertEntry(sibling, index - half - 1, std::move(separator), right);
+            separator = std::move(up);
+        }
+        right = sibling;
+    }
+
+    auto *newRoot = new Inner();
+    insertSortedKey(newRoot, 0, std::move(separator));
+    newRoot->children[0] = root;
+    newRoot->children[1] = right;
+    root = newRoot;
+    ++levels;
+}
+
+template <typename T, typename Compare, std::size_t NodeSize>
+bool BTreeSet<T, Compare, NodeSize>::remove(const T &value) {
+    return remove<T>(value);
+}
+
+// Separators only bound the keys of their children, so removing a key never
+// has to touch the separator that equals it
+template <typename T, typename Compare, std::size_t NodeSize>
+template <typename K>
+    requires LookupKey<K, T, Compare>
+bool BTreeSet<T, Compare, NodeSize>::remove(const K &key) {
+    if (root == nullptr) {
+        return false;
+    }
+
+    PathEntry path[BTREE_MAX_HEIGHT];
+    int depth = 0;
+    Leaf *leaf = findLeaf(key, path, &depth);
+    const std::size_t pos = sortedLowerBound(leaf, key, comp);
+    if (pos == leaf->count || !equivalent(key, leaf->keys()[pos], comp)) {
+        return false;
+    }
+
+    eraseSortedKey(leaf, pos);
+    --count;
+    rebalanceAfterRemove(path, depth, leaf);
+    return true;
+}
+
+template <typename T, typename Compare, std::size_t NodeSize>
+void BTreeSet<T, Compare, NodeSize>::rebalanceAfterRemove(PathEntry *path,
+                                                          int depth,
+                                                          Node *node) {
+    while (depth > 0) {
+        if (node->count >= (node->leaf ? LEAF_MIN : INNER_MIN)) {
+            return;
+        }
+
+        auto [parent, index] = path[--depth];
+        if (node->leaf) {
+            fixLeaf(parent, index, static_cast<Leaf *>(node));
+        } else {
+            fixInner(parent, index, static_cast<Inner *>(node));
+        }
+        node = parent;
+    }
+
+    // The root may run low, it only goes away once it is empty
+    if (node->count > 0) {
+        return;
+    }
+    if (node->leaf) {
+        root = first = last = nullptr;
+        levels = 0;
+    } else {
+        root = static_cast<Inner *>(node)->children[0];
+        --levels;
+    }
+    freeNode(node);
+}
+
+template <typename T, typename Compare, std::size_t NodeSize>
+void BTreeSet<T, Compare, NodeSize>::fixLeaf(Inner *parent, std::size_t index,
+                                             Leaf *leaf) {
+    if (index > 0) {
+        auto *left = static_cast<Leaf *>(parent->children[index - 1]);
+        if (left->count > LEAF_MIN) {
+            insertSortedKey(leaf, 0, takeLast(left));
+            parent->keys()[index - 1] = leaf->keys()[0];
+            return;
+        }
+    }
+    if (index < parent->count) {
+        auto *right = static_cast<Leaf *>(parent->children[index + 1]);
+        if (right->count > LEAF_MIN) {
+            insertSortedKey(leaf, leaf->count, std::move(right->keys()[0]));
+            eraseSortedKey(right, 0);
+            parent->keys()[index] = right->keys()[0];
+            return;
+        }
+    }
+
+    // Neither sibling can spare a key, merge with one of them
+    const std::size_t separator = index > 0 ? index - 1 : index;
+    auto *left = static_cast<Leaf *>(parent->children[separator]);
+    auto *right = static_cast<Leaf *>(parent->children[separator + 1]);
+
+    moveSortedKeys(right, 0, left);
+    left->next = right->next;
+    if (right->next != nullptr) {
+        right->next->prev = left;
+    } else {
+        last = left;
+    }
+    eraseEntry(parent, separator);
+    freeNode(right);
+}
+
+// Same as fixLeaf, but keys rotate through the separator in the parent
+template <typename T, typename Compare, std::size_t NodeSize>
+void BTreeSet<T, Compare, NodeSize>::fixInner(Inner *parent, std::size_t index,
+                                              Inner *node) {
+    if (index > 0) {
+        auto *left = static_cast<Inner *>(parent->children[index - 1]);
+        if (left->count > INNER_MIN) {
+            std::copy_backward(node->children,
+                               node->children + node->count + 1,
+                               node->children + node->count + 2);
+            node->children[0] = left->children[left->count];
+            insertSortedKey(node, 0, std::move(parent->keys()[index - 1]));
+            parent->keys()[index - 1] = takeLast(left);
+            return;
+        }
+    }
+    if (index < parent->count) {
+        auto *right = static_cast<Inner *>(parent->children[index + 1]);
+        if (right->count > INNER_MIN) {
+            node->children[node->count + 1] = right->children[0];
+            insertSortedKey(node, node->count,
+                            std::move(parent->keys()[index]));
+            parent->keys()[index] = std::move(right->keys()[0]);
+            std::copy(right->children + 1,
+                      right->children + right->count + 1, right->children);
+            eraseSortedKey(right, 0);
+            return;
+        }
+    }
+
+    const std::size_t separator = index > 0 ? index - 1 : index;
+    auto *left = static_cast<Inner *>(parent->children[separator]);
+    auto *right = static_cast<Inner *>(parent->children[separator + 1]);
+
+    const std::size_t leftCount = left->count;
+    insertSortedKey(left, leftCount, std::move(parent->keys()[separator]));
+    std::copy(right->children, right->children + right->count + 1,
+              left->children + leftCount + 1);
+    moveSortedKeys(right, 0, left);
+    eraseEntry(parent, separator);
+    freeNode(right);
+}
+
+template <typename T, typename Compare, std::size_t NodeSize>
+void BTreeSet<T, Compare, NodeSize>::clear() noexcept {
+    if (root != nullptr) {
+        destroyTree(root);
+    }
+    root = first = last = nullptr;
+    count = 0;
+    levels = 0;
+}
+
+template <typename T, typename Compare, std::size_t NodeSize>
+void BTreeSet<T, Compare, NodeSize>::destroyTree(Node *node) noexcept {
+    if (!node->leaf) {
+        auto *inner = static_cast<Inner *>(node);
+        for (std::size_t i = 0; i <= inner->count; ++i) {
+            destroyTree(inner->children[i]);
+        }
+    }
+    std::destroy(node->keys(), node->keys() + node->count);
+    freeNode(node);
+}
+
+template <typename T, typename Compare, std::size_t NodeSize>
+void BTreeSet<T, Compare, NodeSize>::freeNode(Node *node) noexcept {
+    if (node->leaf) {
+        delete static_cast<Leaf *>(node);
+    } else {
+        delete static_cast<Inner *>(node);
+    }
+}
+
+template <typename T, typename Compare, std::size_t NodeSize>
+T *BTreeSet<T, Compare, NodeSize>::search(const T &value) const noexcept {
+    return search<T>(value);
+}
+
+template <typename T, typename Compare, std::size_t NodeSize>
+template <typename K>
+    requires LookupKey<K, T, Compare>
+T *BTreeSet<T, Compare, NodeSize>::search(const K &key) const noexcept {
+    if (root == nullptr) {
+        return nullptr;
+    }
+
+    Leaf *leaf = findLeaf(key, nullptr, nullptr);
+    const std::size_t pos = sortedLowerBound(leaf, key, comp);
+    if (pos < leaf->count && equivalent(key, leaf->keys()[pos], comp)) {
+        return &leaf->keys()[pos];
+    }
+    return nullptr;
+}
+
+template <typename T, typename Compare, std::size_t NodeSize>
+bool BTreeSet<T, Compare, NodeSize>::contains(const T &value) const noexcept {
+    return search<T>(value) != nullptr;
+}
+
+template <typename T, typename Compare, std::size_t NodeSize>
+template <typename K>
+    requires LookupKey<K, T, Compare>
+bool BTreeSet<T, Compare, NodeSize>::contains(const K &key) const noexcept {
+    return search(key) != nullptr;
+}
+
+template <typename T, typename Compare, std::size_t NodeSize>
+T *BTreeSet<T, Compare, NodeSize>::max() const noexcept {
+    return last ? &last->keys()[last->count - 1] : nullptr;
+}
+
+template <typename T, typename Compare, std::size_t NodeSize>
+T *BTreeSet<T, Compare, NodeSize>::min() const noexcept {
+    return first ? &first->keys()[0] : nullptr;
+}
+
+template <typename T, typename Compare, std::size_t NodeSize>
+typename BTreeSet<T, Compare, NodeSize>::Iterator
+BTreeSet<T, Compare, NodeSize>::lower_bound(const T &value) const noexcept {
+    return lower_bound<T>(value);
+}
+
+// The leaf covering key holds every greater key up to the next separator, if
+// all of its keys are smaller the bound is the first key of the next leaf
+template <typename T, typename Compare, std::size_t NodeSize>
+template <typename K>
+    requires LookupKey<K, T, Compare>
+typename BTreeSet<T, Compare, NodeSize>::Iterator
+BTreeSet<T, Compare, NodeSize>::lower_bound(const K &key) const noexcept {
+    if (root == nullptr) {
+        return end();
+    }
+
+    Leaf *leaf = findLeaf(key, nullptr, nullptr);
+    const std::size_t pos = sortedLowerBound(leaf, key, comp);
+    if (pos == leaf->count) {
+        return Iterator(leaf->next, 0, this);
+    }
+    return Iterator(leaf, pos, this);
+}
+
+template <typename T, typename Compare, std::size_t NodeSize>
+typename BTreeSet<T, Compare, NodeSize>::Iterator
+BTreeSet<T, Compare, NodeSize>::upper_bound(const T &value) const noexcept {
+    return upper_bound<T>(value);
+}
+
+template <typename T, typename Compare, std::size_t NodeSize>
+template <typename K>
+    requires LookupKey<K, T, Compare>
+typename BTreeSet<T, Compare, NodeSize>::Iterator
+BTreeSet<T, Compare, NodeSize>::upper_bound(const K &key) const noexcept {
+    return equal_range(key).second;
+}
+
+template <typename T, typename Compare, std::size_t NodeSize>
+std::pair<typename BTreeSet<T, Compare, NodeSize>::Iterator,
+          typename BTreeSet<T, Compare, NodeSize>::Iterator>
+BTreeSet<T, Compare, NodeSize>::equal_range(const T &value) const noexcept {
+    return equal_range<T>(value);
+}
+
+template <typename T, typename Compare, std::size_t NodeSize>
+template <typename K>
+    requires LookupKey<K, T, Compare>
+std::pair<typename BTreeSet<T, Compare, NodeSize>::Iterator,
+          typename BTreeSet<T, Compare, NodeSize>::Iterator>
+BTreeSet<T, Compare, NodeSize>::equal_range(const K &key) const noexcept {
+    Iterator lower = lower_bound(key);
+    if (lower != end() && !comp(key, *lower)) {
+        return {lower, std::next(lower)};
+    }
+    return {lower, lower};
+}
+
+template <typename T, typename Compare, std::size_t NodeSize>
+template <typename F>
+void BTreeSet<T, Compare, NodeSize>::forEachInRange(const T &lo, const T &hi,
+                                                    F &&fn) const {
+    forEachInRange<T>(lo, hi, std::forward<F>(fn));
+}
+
+template <typename T, typename Compare, std::size_t NodeSize>
+template <typename K, typename F>
+    requires LookupKey<K, T, Compare>
+void BTreeSet<T, Compare, NodeSize>::forEachInRange(const K &lo, const K &hi,
+                                                    F &&fn) const {
+    for (Iterator it = lower_bound(lo); it != end() && comp(*it, hi); ++it) {
+        if constexpr (std::is_same_v<std::invoke_result_t<F &, T &>, bool>) {
+            if (!fn(*it)) {
+                return;
+            }
+        } else {
+            fn(*it);
+        }
+    }
+}
+
+template <typename T, typename Compare, std::size_t NodeSize>
+int BTreeSet<T, Compare, NodeSize>::height() const noexcept {
+    return levels;
+}
+
+template <typename T, typename Compare, std::size_t NodeSize>
+std::size_t BTreeSet<T, Compare, NodeSize>::size() const noexcept {
+    return count;
+}
+
+template <typename T, typename Compare, std::size_t NodeSize>
+bool BTreeSet<T, Compare, NodeSize>::empty() const noexcept {
+    return count == 0;
+}
+
+template <typename T, typename Compare, std::size_t NodeSize>
+template <typename K>
+std::size_t
+BTreeSet<T, Compare, NodeSize>::childIndex(const Inner *node,
+                                           const K &key) const noexcept {
+    std::size_t index = sortedLowerBound(node, key, comp);
+    // A key equal to a separator lives right of it
+    if (index < node->count && !comp(key, node->keys()[index])) {
+        ++index;
+    }
+    return index;
+}
+
+template <typename T, typename Compare, std::size_t NodeSize>
+template <typename K>
+typename BTreeSet<T, Compare, NodeSize>::Leaf *
+BTreeSet<T, Compare, NodeSize>::findLeaf(const K &key, PathEntry *path,
+                                         int *depth) const noexcept {
+    Node *node = root;
+    while (!node->leaf) {
+        auto *inner = static_cast<Inner *>(node);
+        const std::size_t index = childIndex(inner, key);
+        if (path != nullptr) {
+            path[(*depth)++] = {inner, index};
+        }
+        node = inner->children[index];
+    }
+    return static_cast<Leaf *>(node);
+}
+
+template <typename T, typename Compare, std::size_t NodeSize>
+T BTreeSet<T, Compare, NodeSize>::takeLast(Node *node) noexcept {
+    T key(std::move(node->keys()[node->count - 1]));
+    eraseSortedKey(node, node->count - 1);
+    return key;
+}
+
+template <typename T, typename Compare, std::size_t NodeSize>
+void BTreeSet<T, Compare, NodeSize>::insertEntry(Inner *node, std::size_t pos,
+                                                 T &&key, Node *child) {
+    std::copy_backward(node->children + pos + 1,
+                       node->children + node->count + 1,
+                       node->children + node->count + 2);
+    node->children[pos + 1] = child;
+    insertSortedKey(node, pos, std::move(key));
+}
+
+template <typename T, typename Compare, std::size_t NodeSize>
+void BTreeSet<T, Compare, NodeSize>::eraseEntry(Inner *node,
+                                                std::size_t pos) noexcept {
+    std::copy(node->children + pos + 2, node->children + node->count + 1,
+              node->children + pos + 1);
+    eraseSortedKey(node, pos);
+}
+
+template <typename T, typename Compare, std::size_t NodeSize>
+typename BTreeSet<T, Compare, NodeSize>::Iterator
+BTreeSet<T, Compare, NodeSize>::begin() const {
+    return Iterator(first, 0, this);
+}
+
+template <typename T, typename Compare, std::size_t NodeSize>
+typename BTreeSet<T, Compare, NodeSize>::Iterator
+BTreeSet<T, Compare, NodeSize>::end() const {
+    return Iterator(nullptr, 0, this);
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "btree/btree.h"
+
+template <typename T, typename Compare, std::size_t NodeSize>
+T &BTreeSet<T, Compare, NodeSize>::Iterator::operator*() const {
+    return leaf->keys()[index];
+}
+
+template <typename T, typename Compare, std::size_t NodeSize>
+T *BTreeSet<T, Compare, NodeSize>::Iterator::operator->() const {
+    return &leaf->keys()[index];
+}
+
+// Leaves are never empty, so the next leaf always has a first key
+template <typename T, typename Compare, std::size_t NodeSize>
+typename BTreeSet<T, Compare, NodeSize>::Iterator &
+BTreeSet<T, Compare, NodeSize>::Iterator::operator++() {
+    if (++index == leaf->count) {
+        leaf = leaf->next;
+        index = 0;
+    }
+    return *this;
+}
+
+template <typename T, typename Compare, std::size_t NodeSize>
+typename BTreeSet<T, Compare, NodeSize>::Iterator
+BTreeSet<T, Compare, NodeSize>::Iterator::operator++(int) {
+    Iterator temp = *this;
+    ++(*this);
+    return temp;
+}
+
+// Stepping back from end() lands on the max
+template <typename T, typename Compare, std::size_t NodeSize>
+typename BTreeSet<T, Compare, NodeSize>::Iterator &
+BTreeSet<T, Compare, NodeSize>::Iterator::operator--() {
+    if (leaf == nullptr) {
+        leaf = tree->last;
+        index = leaf->count - 1;
+    } else if (index == 0) {
+        leaf = leaf->prev;
+        index = leaf->count - 1;
+    } else {
+        --index;
+    }
+    return *this;
+}
+
+template <typename T, typename Compare, std::size_t NodeSize>
+typename BTreeSet<T, Compare, NodeSize>::Iterator
+BTreeSet<T, Compare, NodeSize>::Iterator::operator--(int) {
+    Iterator temp = *this;
+    --(*this);
+    return temp;
+}
+
+template <typename T, typename Compare, std::size_t NodeSize>
+bool BTreeSet<T, Compare, NodeSize>::Iterator::operator==(
+    const Iterator &other) const {
+    return leaf == other.leaf && index == other.index;
+}
+
+template <typename T, typename Compare, std::size_t NodeSize>
+bool BTreeSet<T, Compare, NodeSize>::Iterator::operator!=(
+    const Iterator &other) const {
+    return !(*this == other);
+}
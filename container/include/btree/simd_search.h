@@ -0,0 +1,124 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+/**
+ * Returns the number of keys in the sorted array [keys, keys + n) that are
+ * smaller than key, which is the index lower_bound would return.
+ *
+ * The keys are compared a whole vector at a time where the target has the
+ * instructions for the key type: 32 bit integers, float and double with SSE2,
+ * 64 bit integers with SSE4.2, and all of them twice as wide with AVX2. The
+ * remainder, and every other arithmetic type, goes through a branchless
+ * scalar loop. A node has few enough keys that a linear scan without
+ * mispredictions beats a binary search.
+ */
+template <typename T>
+    requires std::is_arithmetic_v<T>
+std::size_t countLess(const T *keys, std::size_t n, T key) noexcept {
+    std::size_t i = 0;
+    std::size_t count = 0;
+
+#if defined(__AVX2__)
+    if constexpr (std::is_integral_v<T> && sizeof(T) == 4) {
+        // Unsigned keys are shifted into signed range by flipping the top bit
+        const __m256i bias =
+            _mm256_set1_epi32(std::is_signed_v<T> ? 0 : INT32_MIN);
+        const __m256i needle = _mm256_xor_si256(
+            _mm256_set1_epi32(static_cast<int32_t>(key)), bias);
+        for (; i + 8 <= n; i += 8) {
+            const __m256i block = _mm256_xor_si256(
+                _mm256_loadu_si256(reinterpret_cast<const __m256i *>(keys + i)),
+                bias);
+            const __m256i less = _mm256_cmpgt_epi32(needle, block);
+            count += std::popcount(static_cast<unsigned>(
+                _mm256_movemask_ps(_mm256_castsi256_ps(less))));
+        }
+    } else if constexpr (std::is_integral_v<T> && sizeof(T) == 8) {
+        const __m256i bias =
+            _mm256_set1_epi64x(std::is_signed_v<T> ? 0 : INT64_MIN);
+        const __m256i needle = _mm256_xor_si256(
+            _mm256_set1_epi64x(static_cast<int64_t>(key)), bias);
+        for (; i + 4 <= n; i += 4) {
+            const __m256i block = _mm256_xor_si256(
+                _mm256_loadu_si256(reinterpret_cast<const __m256i *>(keys + i)),
+                bias);
+            const __m256i less = _mm256_cmpgt_epi64(needle, block);
+            count += std::popcount(static_cast<unsigned>(
+                _mm256_movemask_pd(_mm256_castsi256_pd(less))));
+        }
+    } else if constexpr (std::is_same_v<T, float>) {
+        const __m256 needle = _mm256_set1_ps(key);
+        for (; i + 8 <= n; i += 8) {
+            const __m256 less =
+                _mm256_cmp_ps(_mm256_loadu_ps(keys + i), needle, _CMP_LT_OQ);
+            count +=
+                std::popcount(static_cast<unsigned>(_mm256_movemask_ps(less)));
+        }
+    } else if constexpr (std::is_same_v<T, double>) {
+        const __m256d needle = _mm256_set1_pd(key);
+        for (; i + 4 <= n; i += 4) {
+            const __m256d less =
+                _mm256_cmp_pd(_mm256_loadu_pd(keys + i), needle, _CMP_LT_OQ);
+            count +=
+                std::popcount(static_cast<unsigned>(_mm256_movemask_pd(less)));
+        }
+    }
+#elif defined(__SSE2__)
+    if constexpr (std::is_integral_v<T> && sizeof(T) == 4) {
+        const __m128i bias =
+            _mm_set1_epi32(std::is_signed_v<T> ? 0 : INT32_MIN);
+        const __m128i needle =
+            _mm_xor_si128(_mm_set1_epi32(static_cast<int32_t>(key)), bias);
+        for (; i + 4 <= n; i += 4) {
+            const __m128i block = _mm_xor_si128(
+                _mm_loadu_si128(reinterpret_cast<const __m128i *>(keys + i)),
+                bias);
+            const __m128i less = _mm_cmpgt_epi32(needle, block);
+            count += std::popcount(static_cast<unsigned>(
+                _mm_movemask_ps(_mm_castsi128_ps(less))));
+        }
+#if defined(__SSE4_2__)
+    } else if constexpr (std::is_integral_v<T> && sizeof(T) == 8) {
+        const __m128i bias =
+            _mm_set1_epi64x(std::is_signed_v<T> ? 0 : INT64_MIN);
+        const __m128i needle =
+            _mm_xor_si128(_mm_set1_epi64x(static_cast<int64_t>(key)), bias);
+        for (; i + 2 <= n; i += 2) {
+            const __m128i block = _mm_xor_si128(
+                _mm_loadu_si128(reinterpret_cast<const __m128i *>(keys + i)),
+                bias);
+            const __m128i less = _mm_cmpgt_epi64(needle, block);
+            count += std::popcount(static_cast<unsigned>(
+                _mm_movemask_pd(_mm_castsi128_pd(less))));
+        }
+#endif
+    } else if constexpr (std::is_same_v<T, float>) {
+        const __m128 needle = _mm_set1_ps(key);
+        for (; i + 4 <= n; i += 4) {
+            const __m128 less = _mm_cmplt_ps(_mm_loadu_ps(keys + i), needle);
+            count +=
+                std::popcount(static_cast<unsigned>(_mm_movemask_ps(less)));
+        }
+    } else if constexpr (std::is_same_v<T, double>) {
+        const __m128d needle = _mm_set1_pd(key);
+        for (; i + 2 <= n; i += 2) {
+            const __m128d less = _mm_cmplt_pd(_mm_loadu_pd(keys + i), needle);
+            count +=
+                std::popcount(static_cast<unsigned>(_mm_movemask_pd(less)));
+        }
+    }
+#endif
+
+    for (; i < n; ++i) {
+        count += keys[i] < key ? 1 : 0;
+    }
+    return count;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "btree/simd_search.h"
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+/*
+ * Helpers for nodes that keep their keys sorted at the front of raw storage,
+ * the nodes of BTreeSet and the blocks of UnrolledSkipList. A node hands out
+ * the storage through keys() and counts the constructed keys in count.
+ */
+
+/**
+ * Whether countLess can stand in for Compare on keys of type T.
+ */
+template <typename T, typename Compare>
+constexpr bool SIMD_SEARCHABLE =
+    std::is_arithmetic_v<T> && (std::same_as<Compare, std::less<T>> ||
+                                std::same_as<Compare, std::less<>>);
+
+/**
+ * Index of the first key in the node that is not smaller than key.
+ */
+template <typename Node, typename K, typename Compare>
+std::size_t sortedLowerBound(const Node *node, const K &key,
+                             const Compare &comp) noexcept {
+    using T = std::remove_cvref_t<decltype(*node->keys())>;
+    const T *keys = node->keys();
+    if constexpr (SIMD_SEARCHABLE<T, Compare> && std::same_as<K, T>) {
+        return countLess(keys, node->count, key);
+    } else {
+        const T *pos = std::partition_point(
+            keys, keys + node->count,
+            [&](const T &value) { return comp(value, key); });
+        return static_cast<std::size_t>(pos - keys);
+    }
+}
+
+template <typename K, typename T, typename Compare>
+bool equivalent(const K &key, const T &value, const Compare &comp) noexcept {
+    return !comp(key, value) && !comp(value, key);
+}
+
+template <typename Node, typename V>
+void insertSortedKey(Node *node, std::size_t pos, V &&value) {
+    auto *keys = node->keys();
+    const std::size_t n = node->count;
+
+    if (pos == n) {
+        std::construct_at(keys + n, std::forward<V>(value));
+    } else {
+        // Open a gap by shifting into the first unconstructed slot
+        std::construct_at(keys + n, std::move(keys[n - 1]));
+        std::move_backward(keys + pos, keys + n - 1, keys + n);
+        keys[pos] = std::forward<V>(value);
+    }
+    ++node->count;
+}
+
+template <typename Node>
+void eraseSortedKey(Node *node, std::size_t pos) noexcept {
+    auto *keys = node->keys();
+    std::move(keys + pos + 1, keys + node->count, keys + pos);
+    std::destroy_at(keys + node->count - 1);
+    --node->count;
+}
+
+/**
+ * Move the keys from position `from` onwards to the end of another node.
+ */
+template <typename Node>
+void moveSortedKeys(Node *source, std::size_t from, Node *target) noexcept {
+    auto *keys = source->keys();
+    std::uninitialized_move(keys + from, keys + source->count,
+                            target->keys() + target->count);
+    std::destroy(keys + from, keys + source->count);
+    target->count += source->count - from;
+    source->count = from;
+}
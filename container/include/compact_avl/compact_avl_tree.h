@@ -0,0 +1,281 @@
+#pragma once
+
+#include "compact_avl/node_storage.h"
+#include "container.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+/**
+ * Upper bound on the height of a CompactAVLTree. An AVL tree with fewer than
+ * 2^32 nodes is at most 46 levels high. Sizes the path buffers and the
+ * iterator stack.
+ */
+constexpr int COMPACT_AVL_MAX_HEIGHT = 48;
+
+/**
+ * Most values a CompactAVLTree can hold. A parent index shares 32 bits with
+ * the balance factor and keeps 30 of them.
+ */
+constexpr uint32_t COMPACT_AVL_MAX_SIZE = uint32_t{1} << 30;
+
+/**
+ * AVL tree with a compact node layout for small keys.
+ *
+ * The nodes live side by side in one growable array and link to each other
+ * with 32 bit indices. A node keeps a balance factor of -1, 0 or 1 in two
+ * bits instead of its height, next to a 30 bit parent index, so an
+ * AVLTree<int> node of 40 bytes shrinks to 16. Removing a value moves the
+ * last node of the array into the freed slot, the array never has holes,
+ * and the parent index finds the link to the moved node without a search.
+ *
+ * Compared to AVLTree there is no select/rank and no join based algebra, and
+ * the iterator carries its path from the root, so it is larger to copy.
+ * Inserting may move every node, which invalidates pointers and iterators,
+ * and so does removing.
+ *
+ * Storage decides where the array lives, see CompactNodeStorage.
+ */
+template <typename T, typename Compare = std::less<T>,
+          template <typename> class Storage = VectorNodeStorage>
+class CompactAVLTree {
+  private:
+    struct Node {
+        T value;
+        uint32_t left = COMPACT_AVL_NIL;
+        uint32_t right = COMPACT_AVL_NIL;
+        // not used for the root, which hangs off the storage instead
+        uint32_t parent : 30 = 0;
+        // height of the right subtree minus height of the left one
+        int32_t balance : 2 = 0;
+
+        template <typename... Args>
+        explicit Node(std::in_place_t /*unused*/, Args &&...args)
+            : value(std::forward<Args>(args)...) {}
+    };
+
+    static_assert(CompactNodeStorage<Storage<Node>, Node>);
+
+  public:
+    /**
+     * Bytes taken by every value in the tree, including its links.
+     */
+    static constexpr std::size_t NODE_SIZE = sizeof(Node);
+
+    CompactAVLTree() = default;
+    CompactAVLTree(const CompactAVLTree &) = delete;
+    /**
+     * Takes over the nodes of other without copying, other is left empty.
+     */
+    CompactAVLTree(CompactAVLTree &&other) noexcept;
+    CompactAVLTree &operator=(const CompactAVLTree &) = delete;
+    CompactAVLTree &operator=(CompactAVLTree &&other) noexcept;
+    ~CompactAVLTree() = default;
+
+    // iterator
+    /**
+     * Bidirectional in-order iterator. It keeps the indices from the root
+     * down to the current node on a fixed size stack.
+     * The end iterator has an empty stack and steps back onto the max.
+     */
+    class Iterator {
+      public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = T;
+        using pointer = T *;
+        using reference = T &;
+
+        Iterator() = default;
+
+        reference operator*() const;
+        pointer operator->() const;
+
+        Iterator &operator++();
+        Iterator operator++(int);
+        Iterator &operator--();
+        Iterator operator--(int);
+        bool operator==(const Iterator &other) const;
+        bool operator!=(const Iterator &other) const;
+
+      private:
+        friend class CompactAVLTree;
+
+        explicit Iterator(const CompactAVLTree *tree) : tree(tree) {}
+        // push index and then follow the left (or right) links to the end
+        void descend(uint32_t index, bool right);
+
+        const CompactAVLTree *tree = nullptr;
+        uint32_t stack[COMPACT_AVL_MAX_HEIGHT] = {};
+        int depth = 0;
+    };
+
+    [[nodiscard]] Iterator begin() const;
+    [[nodiscard]] Iterator end() const;
+
+    // modifiers
+    /**
+     * Inserts the value, returns false if an equivalent value already
+     * existed. Throws std::length_error once the tree holds
+     * COMPACT_AVL_MAX_SIZE values.
+     */
+    bool insert(const T &value);
+    bool insert(T &&value);
+    /**
+     * Removes an equivalent value, returns false if there was none.
+     */
+    bool remove(const T &value);
+    template <typename K>
+        requires LookupKey<K, T, Compare>
+    bool remove(const K &key);
+    /**
+     * Removes every value and releases the node array.
+     */
+    void clear() noexcept;
+    /**
+     * Makes room for n nodes in total, so the next inserts do not have to
+     * move the array.
+     */
+    void reserve(std::size_t n);
+    void swap(CompactAVLTree &other) noexcept;
+    friend void swap(CompactAVLTree &lhs, CompactAVLTree &rhs) noexcept {
+        lhs.swap(rhs);
+    }
+
+    // access
+    /**
+     * Search for a value, returns nullptr if not found.
+     */
+    [[nodiscard]] T *search(const T &value) const noexcept;
+    template <typename K>
+        requires LookupKey<K, T, Compare>
+    [[nodiscard]] T *search(const K &key) const noexcept;
+    /**
+     * Returns the max value, or nullptr if the tree is empty.
+     */
+    [[nodiscard]] T *max() const noexcept;
+    /**
+     * Returns the min value, or nullptr if the tree is empty.
+     */
+    [[nodiscard]] T *min() const noexcept;
+    [[nodiscard]] bool contains(const T &value) const noexcept;
+    template <typename K>
+        requires LookupKey<K, T, Compare>
+    [[nodiscard]] bool contains(const K &key) const noexcept;
+
+    // range queries
+    /**
+     * Returns an iterator to the first value not smaller than value, or end().
+     */
+    [[nodiscard]] Iterator lower_bound(const T &value) const noexcept;
+    /**
+     * Returns an iterator to the first value greater than value, or end().
+     */
+    [[nodiscard]] Iterator upper_bound(const T &value) const noexcept;
+    /**
+     * Returns the range of values equivalent to value, which is empty or
+     * holds a single value.
+     */
+    [[nodiscard]] std::pair<Iterator, Iterator>
+    equal_range(const T &value) const noexcept;
+    /**
+     * Calls fn with every value in [lo, hi) in order, O(log n + k). If fn
+     * returns a bool, returning false stops the scan.
+     */
+    template <typename F>
+    void forEachInRange(const T &lo, const T &hi, F &&fn) const;
+    template <typename K>
+        requires LookupKey<K, T, Compare>
+    [[nodiscard]] Iterator lower_bound(const K &key) const noexcept;
+    template <typename K>
+        requires LookupKey<K, T, Compare>
+    [[nodiscard]] Iterator upper_bound(const K &key) const noexcept;
+    template <typename K>
+        requires LookupKey<K, T, Compare>
+    [[nodiscard]] std::pair<Iterator, Iterator>
+    equal_range(const K &key) const noexcept;
+    template <typename K, typename F>
+        requires LookupKey<K, T, Compare>
+    void forEachInRange(const K &lo, const K &hi, F &&fn) const;
+
+    // info
+    /**
+     * Get the height of the tree, found by following the taller side down.
+     */
+    [[nodiscard]] int height() const noexcept;
+    [[nodiscard]] std::size_t size() const noexcept;
+    [[nodiscard]] bool empty() const noexcept;
+
+  protected:
+    /**
+     * Lets a derived tree hand arguments through to its storage.
+     */
+    template <typename... Args>
+    explicit CompactAVLTree(std::in_place_t /*unused*/, Args &&...args)
+        : nodes(std::forward<Args>(args)...) {}
+
+    Storage<Node> nodes;
+
+  private:
+    /**
+     * The node at index. Like the pointer based trees, a const tree still
+     * hands out mutable values.
+     */
+    Node &node(uint32_t index) const noexcept;
+    template <typename V> bool insertValue(V &&value);
+    /**
+     * The link that leads to the node at path[depth], which is the root for
+     * depth 0 and otherwise a child link of path[depth - 1].
+     */
+    uint32_t &link(const uint32_t *path, const uint8_t *right,
+                   int depth) noexcept;
+    /**
+     * Hang the subtree at child, which may be empty, off the node at
+     * path[depth - 1], or make it the root for depth 0.
+     */
+    void attach(const uint32_t *path, const uint8_t *right, int depth,
+                uint32_t child) noexcept;
+    /**
+     * Walk back up after the subtree on the recorded side of every path node
+     * grew (insert) or shrank (remove), updating balance factors and rotating
+     * where one reaches two. Stops once a subtree keeps its height.
+     */
+    void retraceInsert(const uint32_t *path, const uint8_t *right,
+                       int depth) noexcept;
+    void retraceRemove(const uint32_t *path, const uint8_t *right,
+                       int depth) noexcept;
+    /**
+     * Rebalance a node whose left (right) subtree is two levels higher and
+     * return the new root of its subtree.
+     */
+    uint32_t fixLeftHeavy(uint32_t index) noexcept;
+    uint32_t fixRightHeavy(uint32_t index) noexcept;
+    uint32_t rotateLeft(uint32_t index) noexcept;
+    uint32_t rotateRight(uint32_t index) noexcept;
+    uint32_t rotateRightLeft(uint32_t index) noexcept;
+    uint32_t rotateLeftRight(uint32_t index) noexcept;
+    /**
+     * Give back the slot of a detached node by moving the last node of the
+     * array into it. Its parent and children are pointed at the new slot.
+     */
+    void releaseSlot(uint32_t index) noexcept;
+    // point the parent index of child at parent, unless child is NIL
+    void reparent(uint32_t child, uint32_t parent) noexcept;
+
+    Compare comp;
+};
+
+#include "compact_avl/compact_avl_tree.hpp"
+#include "compact_avl/iterator.hpp" // IWYU pragma: keep
+
+static_assert(Dontainer<CompactAVLTree<int>, int>);
+static_assert(RangeDontainer<CompactAVLTree<int>, int>);
+static_assert(std::bidirectional_iterator<CompactAVLTree<int>::Iterator>);
+static_assert(TransparentDontainer<CompactAVLTree<std::string, std::less<>>,
+                                   std::string, std::string_view>);
+static_assert(CompactAVLTree<int>::NODE_SIZE == 16);
@@ -0,0 +1,540 @@
+#pragma once
+
+#include "compact_avl/compact_avl_tree.h"
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+template <typename T, typename Compare, template <typename> class Storage>
+CompactAVLTree<T, Compare, Storage>::CompactAVLTree(
+    CompactAVLTree &&other) noexcept {
+    swap(other);
+}
+
+template <typename T, typename Compare, template <typename> class Storage>
+CompactAVLTree<T, Compare, Storage> &
+CompactAVLTree<T, Compare, Storage>::operator=(
+    CompactAVLTree &&other) noexcept {
+    if (this != &other) {
+        clear();
+        swap(other);
+    }
+    return *this;
+}
+
+template <typename T, typename Compare, template <typename> class Storage>
+void CompactAVLTree<T, Compare, Storage>::swap(CompactAVLTree &other) noexcept {
+    using std::swap;
+    swap(nodes, other.nodes);
+    swap(comp, other.comp);
+}
+
+template <typename T, typename Compare, template <typename> class Storage>
+typename CompactAVLTree<T, Compare, Storage>::Iterator
+CompactAVLTree<T, Compare, Storage>::begin() const {
+    Iterator it(this);
+    it.descend(nodes.root(), false);
+    return it;
+}
+
+template <typename T, typename Compare, template <typename> class Storage>
+typename CompactAVLTree<T, Compare, Storage>::Iterator
+CompactAVLTree<T, Compare, Storage>::end() const {
+    return Iterator(this);
+}
+
+template <typename T, typename Compare, template <typename> class Storage>
+bool CompactAVLTree<T, Compare, Storage>::insert(const T &value) {
+    return insertValue(value);
+}
+
+template <typename T, typename Compare, template <typename> class Storage>
+bool CompactAVLTree<T, Compare, Storage>::insert(T &&value) {
+    return insertValue(std::move(value));
+}
+
+// The node is only created once the value is known to be new, so a duplicate
+// costs no allocation
+template <typename T, typename Compare, template <typename> class Storage>
+template <typename V>
+bool CompactAVLTree<T, Compare, Storage>::insertValue(V &&value) {
+    uint32_t path[COMPACT_AVL_MAX_HEIGHT] = {};
+    uint8_t right[COMPACT_AVL_MAX_HEIGHT] = {};
+    int depth = 0;
+
+    for (uint32_t index = nodes.root(); index != COMPACT_AVL_NIL;) {
+        const Node &current = node(index);
+        if (comp(value, current.value)) {
+            right[depth] = 0;
+        } else if (comp(current.value, value)) {
+            right[depth] = 1;
+        } else {
+            return false;
+        }
+        path[depth++] = index;
+        index = right[depth - 1] ? current.right : current.left;
+    }
+
+    if (nodes.size() >= COMPACT_AVL_MAX_SIZE) {
+        throw std::length_error("CompactAVLTree is out of node indices");
+    }
+    const uint32_t added =
+        nodes.emplace(Node(std::in_place, std::forward<V>(value)));
+    attach(path, right, depth, added);
+    retraceInsert(path, right, depth);
+    return true;
+}
+
+template <typename T, typename Compare, template <typename> class Storage>
+bool CompactAVLTree<T, Compare, Storage>::remove(const T &value) {
+    return remove<T>(value);
+}
+
+// A node with two children takes over the value of its successor, which then
+// is the node that gets unlinked
+template <typename T, typename Compare, template <typename> class Storage>
+template <typename K>
+    requires LookupKey<K, T, Compare>
+bool CompactAVLTree<T, Compare, Storage>::remove(const K &key) {
+    uint32_t path[COMPACT_AVL_MAX_HEIGHT] = {};
+    uint8_t right[COMPACT_AVL_MAX_HEIGHT] = {};
+    int depth = 0;
+
+    uint32_t index = nodes.root();
+    while (index != COMPACT_AVL_NIL) {
+        const Node &current = node(index);
+        if (comp(key, current.value)) {
+            right[depth] = 0;
+        } else if (comp(current.value, key)) {
+            right[depth] = 1;
+        } else {
+            break;
+        }
+        path[depth++] = index;
+        index = right[depth - 1] ? current.right : current.left;
+    }
+    if (index == COMPACT_AVL_NIL) {
+        return false;
+    }
+
+    Node &found = node(index);
+    if (found.left != COMPACT_AVL_NIL && found.right != COMPACT_AVL_NIL) {
+        right[depth] = 1;
+        path[depth++] = index;
+        uint32_t successor = found.right;
+        while (node(successor).left != COMPACT_AVL_NIL) {
+            right[depth] = 0;
+            path[depth++] = successor;
+            successor = node(successor).left;
+        }
+        found.value = std::move(node(successor).value);
+        index = successor;
+    }
+
+    const Node &hole = node(index);
+    attach(path, right, depth,
+           hole.left != COMPACT_AVL_NIL ? hole.left : hole.right);
+    retraceRemove(path, right, depth);
+    releaseSlot(index);
+    return true;
+}
+
+template <typename T, typename Compare, template <typename> class Storage>
+void CompactAVLTree<T, Compare, Storage>::clear() noexcept {
+    nodes.clear();
+}
+
+template <typename T, typename Compare, template <typename> class Storage>
+void CompactAVLTree<T, Compare, Storage>::reserve(std::size_t n) {
+    nodes.reserve(n);
+}
+
+template <typename T, typename Compare, template <typename> class Storage>
+T *CompactAVLTree<T, Compare, Storage>::search(const T &value) const noexcept {
+    return search<T>(value);
+}
+
+template <typename T, typename Compare, template <typename> class Storage>
+template <typename K>
+    requires LookupKey<K, T, Compare>
+T *CompactAVLTree<T, Compare, Storage>::search(const K &key) const noexcept {
+    uint32_t index = nodes.root();
+    while (index != COMPACT_AVL_NIL) {
+        Node &current = node(index);
+        if (comp(key, current.value)) {
+            index = current.left;
+        } else if (comp(current.value, key)) {
+            index = current.right;
+        } else {
+            return &current.value;
+        }
+    }
+    return nullptr;
+}
+
+template <typename T, typename Compare, template <typename> class Storage>
+T *CompactAVLTree<T, Compare, Storage>::max() const noexcept {
+    uint32_t index = nodes.root();
+    if (index == COMPACT_AVL_NIL) {
+        return nullptr;
+    }
+    while (node(index).right != COMPACT_AVL_NIL) {
+        index = node(index).right;
+    }
+    return &node(index).value;
+}
+
+template <typename T, typename Compare, template <typename> class Storage>
+T *CompactAVLTree<T, Compare, Storage>::min() const noexcept {
+    uint32_t index = nodes.root();
+    if (index == COMPACT_AVL_NIL) {
+        return nullptr;
+    }
+    while (node(index).left != COMPACT_AVL_NIL) {
+        index = node(index).left;
+    }
+    return &node(index).value;
+}
+
+template <typename T, typename Compare, template <typename> class Storage>
+bool CompactAVLTree<T, Compare, Storage>::contains(
+    const T &value) const noexcept {
+    return search<T>(value) != nullptr;
+}
+
+template <typename T, typename Compare, template <typename> class Storage>
+template <typename K>
+    requires LookupKey<K, T, Compare>
+bool CompactAVLTree<T, Compare, Storage>::contains(
+    const K &key) const noexcept {
+    return search(key) != nullptr;
+}
+
+template <typename T, typename Compare, template <typename> class Storage>
+typename CompactAVLTree<T, Compare, Storage>::Iterator
+CompactAVLTree<T, Compare, Storage>::lower_bound(
+    const T &value) const noexcept {
+    return lower_bound<T>(value);
+}
+
+// The whole search path goes on the iterator stack, which is then cut back to
+// the last node that was not smaller than key
+template <typename T, typename Compare, template <typename> class Storage>
+template <typename K>
+    requires LookupKey<K, T, Compare>
+typename CompactAVLTree<T, Compare, Storage>::Iterator
+CompactAVLTree<T, Compare, Storage>::lower_bound(
+    const K &key) const noexcept {
+    Iterator it(this);
+    int bound = 0;
+    uint32_t index = nodes.root();
+    while (index != COMPACT_AVL_NIL) {
+        it.stack[it.depth++] = index;
+        const Node &current = node(index);
+        if (comp(current.value, key)) {
+            index = current.right;
+        } else {
+            bound = it.depth;
+            index = current.left;
+        }
+    }
+    it.depth = bound;
+    return it;
+}
+
+template <typename T, typename Compare, template <typename> class Storage>
+typename CompactAVLTree<T, Compare, Storage>::Iterator
+CompactAVLTree<T, Compare, Storage>::upper_bound(
+    const T &value) const noexcept {
+    return upper_bound<T>(value);
+}
+
+template <typename T, typename Compare, template <typename> class Storage>
+template <typename K>
+    requires LookupKey<K, T, Compare>
+typename CompactAVLTree<T, Compare, Storage>::Iterator
+CompactAVLTree<T, Compare, Storage>::upper_bound(
+    const K &key) const noexcept {
+    return equal_range(key).second;
+}
+
+template <typename T, typename Compare, template <typename> class Storage>
+std::pair<typename CompactAVLTree<T, Compare, Storage>::Iterator,
+          typename CompactAVLTree<T, Compare, Storage>::Iterator>
+CompactAVLTree<T, Compare, Storage>::equal_range(
+    const T &value) const noexcept {
+    return equal_range<T>(value);
+}
+
+template <typename T, typename Compare, template <typename> class Storage>
+template <typename K>
+    requires LookupKey<K, T, Compare>
+std::pair<typename CompactAVLTree<T, Compare, Storage>::Iterator,
+          typename CompactAVLTree<T, Compare, Storage>::Iterator>
+CompactAVLTree<T, Compare, Storage>::equal_range(
+    const K &key) const noexcept {
+    Iterator lower = lower_bound(key);
+    if (lower != end() && !comp(key, *lower)) {
+        return {lower, std::next(lower)};
+    }
+    return {lower, lower};
+}
+
+template <typename T, typename Compare, template <typename> class Storage>
+template <typename F>
+void CompactAVLTree<T, Compare, Storage>::forEachInRange(const T &lo,
+                                                         const T &hi,
+                                                         F &&fn) const {
+    forEachInRange<T>(lo, hi, std::forward<F>(fn));
+}
+
+template <typename T, typename Compare, template <typename> class Storage>
+template <typename K, typename F>
+    requires LookupKey<K, T, Compare>
+void CompactAVLTree<T, Compare, Storage>::forEachInRange(const K &lo,
+                                                         const K &hi,
+                                                         F &&fn) const {
+    for (Iterator it = lower_bound(lo); it != end() && comp(*it, hi); ++it) {
+        if constexpr (std::is_same_v<std::invoke_result_t<F &, T &>, bool>) {
+            if (!fn(*it)) {
+                return;
+            }
+        } else {
+            fn(*it);
+        }
+    }
+}
+
+template <typename T, typename Compare, template <typename> class Storage>
+int CompactAVLTree<T, Compare, Storage>::height() const noexcept {
+    int levels = 0;
+    for (uint32_t index = nodes.root(); index != COMPACT_AVL_NIL; ++levels) {
+        const Node &current = node(index);
+        index = current.balance > 0 ? current.right : current.left;
+    }
+    return levels;
+}
+
+template <typename T, typename Compare, template <typename> class Storage>
+std::size_t CompactAVLTree<T, Compare, Storage>::size() const noexcept {
+    return nodes.size();
+}
+
+template <typename T, typename Compare, template <typename> class Storage>
+bool CompactAVLTree<T, Compare, Storage>::empty() const noexcept {
+    return nodes.size() == 0;
+}
+
+template <typename T, typename Compare, template <typename> class Storage>
+typename CompactAVLTree<T, Compare, Storage>::Node &
+CompactAVLTree<T, Compare, Storage>::node(uint32_t index) const noexcept {
+    return const_cast<Storage<Node> &>(nodes)[index];
+}
+
+template <typename T, typename Compare, template <typename> class Storage>
+uint32_t &CompactAVLTree<T, Compare, Storage>::link(const uint32_t *path,
+                                                    const uint8_t *right,
+                                                    int depth) noexcept {
+    if (depth == 0) {
+        return nodes.root();
+    }
+    Node &parent = node(path[depth - 1]);
+    return right[depth - 1] ? parent.right : parent.left;
+}
+
+template <typename T, typename Compare, template <typename> class Storage>
+void CompactAVLTree<T, Compare, Storage>::attach(const uint32_t *path,
+                                                 const uint8_t *right,
+                                                 int depth,
+                                                 uint32_t child) noexcept {
+    link(path, right, depth) = child;
+    if (depth > 0) {
+        reparent(child, path[depth - 1]);
+    }
+}
+
+template <typename T, typename Compare, template <typename> class Storage>
+void CompactAVLTree<T, Compare, Storage>::retraceInsert(const uint32_t *path,
+                                                        const uint8_t *right,
+                                                        int depth) noexcept {
+    while (depth-- > 0) {
+        Node &current = node(path[depth]);
+        const int8_t grown = right[depth] ? 1 : -1;
+        if (current.balance == 0) {
+            current.balance = grown;
+            continue;
+        }
+        if (current.balance != grown) {
+            current.balance = 0;
+            return;
+        }
+        // After an insert the rotated subtree is as high as before
+        link(path, right, depth) = grown > 0 ? fixRightHeavy(path[depth])
+                                             : fixLeftHeavy(path[depth]);
+        return;
+    }
+}
+
+template <typename T, typename Compare, template <typename> class Storage>
+void CompactAVLTree<T, Compare, Storage>::retraceRemove(const uint32_t *path,
+                                                        const uint8_t *right,
+                                                        int depth) noexcept {
+    while (depth-- > 0) {
+        const uint32_t index = path[depth];
+        Node &current = node(index);
+        const int8_t shrunk = right[depth] ? 1 : -1;
+        if (current.balance == 0) {
+            current.balance = static_cast<int8_t>(-shrunk);
+            return;
+        }
+        if (current.balance == shrunk) {
+            current.balance = 0;
+            continue;
+        }
+        // A balanced sibling leaves the rotated subtree as high as before
+        const uint32_t sibling = shrunk > 0 ? current.left : current.right;
+        const bool sameHeight = node(sibling).balance == 0;
+        link(path, right, depth) =
+            shrunk > 0 ? fixLeftHeavy(index) : fixRightHeavy(index);
+        if (sameHeight) {
+            return;
+        }
+    }
+}
+
+template <typename T, typename Compare, template <typename> class Storage>
+uint32_t
+CompactAVLTree<T, Compare, Storage>::fixLeftHeavy(uint32_t index) noexcept {
+    return node(node(index).left).balance <= 0 ? rotateRight(index)
+                                                : rotateLeftRight(index);
+}
+
+template <typename T, typename Compare, template <typename> class Storage>
+uint32_t
+CompactAVLTree<T, Compare, Storage>::fixRightHeavy(uint32_t index) noexcept {
+    return node(node(index).right).balance >= 0 ? rotateLeft(index)
+                                                 : rotateRightLeft(index);
+}
+
+template <typename T, typename Compare, template <typename> class Storage>
+uint32_t
+CompactAVLTree<T, Compare, Storage>::rotateLeft(uint32_t index) noexcept {
+    Node &top = node(index);
+    const uint32_t pivot = top.right;
+    Node &child = node(pivot);
+
+    top.right = child.left;
+    child.left = index;
+    reparent(top.right, index);
+    child.parent = top.parent;
+    top.parent = pivot;
+    if (child.balance == 0) {
+        top.balance = 1;
+        child.balance = -1;
+    } else {
+        top.balance = 0;
+        child.balance = 0;
+    }
+    return pivot;
+}
+
+template <typename T, typename Compare, template <typename> class Storage>
+uint32_t
+CompactAVLTree<T, Compare, Storage>::rotateRight(uint32_t index) noexcept {
+    Node &top = node(index);
+    const uint32_t pivot = top.left;
+    Node &child = node(pivot);
+
+    top.left = child.right;
+    child.right = index;
+    reparent(top.left, index);
+    child.parent = top.parent;
+    top.parent = pivot;
+    if (child.balance == 0) {
+        top.balance = -1;
+        child.balance = 1;
+    } else {
+        top.balance = 0;
+        child.balance = 0;
+    }
+    return pivot;
+}
+
+template <typename T, typename Compare, template <typename> class Storage>
+uint32_t
+CompactAVLTree<T, Compare, Storage>::rotateRightLeft(uint32_t index) noexcept {
+    Node &top = node(index);
+    const uint32_t childIndex = top.right;
+    Node &child = node(childIndex);
+    const uint32_t pivot = child.left;
+    Node &middle = node(pivot);
+
+    child.left = middle.right;
+    middle.right = childIndex;
+    top.right = middle.left;
+    middle.left = index;
+    reparent(child.left, childIndex);
+    reparent(top.right, index);
+    middle.parent = top.parent;
+    child.parent = pivot;
+    top.parent = pivot;
+    top.balance = middle.balance > 0 ? -1 : 0;
+    child.balance = middle.balance < 0 ? 1 : 0;
+    middle.balance = 0;
+    return pivot;
+}
+
+template <typename T, typename Compare, template <typename> class Storage>
+uint32_t
+CompactAVLTree<T, Compare, Storage>::rotateLeftRight(uint32_t index) noexcept {
+    Node &top = node(index);
+    const uint32_t childIndex = top.left;
+    Node &child = node(childIndex);
+    const uint32_t pivot = child.right;
+    Node &middle = node(pivot);
+
+    child.right = middle.left;
+    middle.left = childIndex;
+    top.left = middle.right;
+    middle.right = index;
+    reparent(child.right, childIndex);
+    reparent(top.left, index);
+    middle.parent = top.parent;
+    child.parent = pivot;
+    top.parent = pivot;
+    top.balance = middle.balance < 0 ? 1 : 0;
+    child.balance = middle.balance > 0 ? -1 : 0;
+    middle.balance = 0;
+    return pivot;
+}
+
+// The detached node is referenced by nothing, so only the links around the
+// last node have to follow it into the slot
+template <typename T, typename Compare, template <typename> class Storage>
+void CompactAVLTree<T, Compare, Storage>::releaseSlot(uint32_t index) noexcept {
+    const uint32_t last = nodes.size() - 1;
+    if (index != last) {
+        Node &moving = node(last);
+        if (nodes.root() == last) {
+            nodes.root() = index;
+        } else {
+            Node &parent = node(moving.parent);
+            (parent.left == last ? parent.left : parent.right) = index;
+        }
+        reparent(moving.left, index);
+        reparent(moving.right, index);
+        node(index) = std::move(moving);
+    }
+    nodes.pop();
+}
+
+template <typename T, typename Compare, template <typename> class Storage>
+void CompactAVLTree<T, Compare, Storage>::reparent(uint32_t child,
+                                                   uint32_t parent) noexcept {
+    if (child != COMPACT_AVL_NIL) {
+        node(child).parent = parent;
+    }
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "compact_avl/compact_avl_tree.h"
+
+template <typename T, typename Compare, template <typename> class Storage>
+T &CompactAVLTree<T, Compare, Storage>::Iterator::operator*() const {
+    return tree->node(stack[depth - 1]).value;
+}
+
+template <typename T, typename Compare, template <typename> class Storage>
+T *CompactAVLTree<T, Compare, Storage>::Iterator::operator->() const {
+    return &tree->node(stack[depth - 1]).value;
+}
+
+// Without a right subtree the next value is the closest ancestor reached
+// from its left side
+template <typename T, typename Compare, template <typename> class Storage>
+typename CompactAVLTree<T, Compare, Storage>::Iterator &
+CompactAVLTree<T, Compare, Storage>::Iterator::operator++() {
+    const uint32_t right = tree->node(stack[depth - 1]).right;
+    if (right != COMPACT_AVL_NIL) {
+        descend(right, false);
+        return *this;
+    }
+
+    uint32_t child = 0;
+    do {
+        child = stack[--depth];
+    } while (depth > 0 && tree->node(stack[depth - 1]).right == child);
+    return *this;
+}
+
+template <typename T, typename Compare, template <typename> class Storage>
+typename CompactAVLTree<T, Compare, Storage>::Iterator
+CompactAVLTree<T, Compare, Storage>::Iterator::operator++(int) {
+    Iterator temp = *this;
+    ++(*this);
+    return temp;
+}
+
+// Stepping back from end() lands on the max
+template <typename T, typename Compare, template <typename> class Storage>
+typename CompactAVLTree<T, Compare, Storage>::Iterator &
+CompactAVLTree<T, Compare, Storage>::Iterator::operator--() {
+    if (depth == 0) {
+        descend(tree->nodes.root(), true);
+        return *this;
+    }
+
+    const uint32_t left = tree->node(stack[depth - 1]).left;
+    if (left != COMPACT_AVL_NIL) {
+        descend(left, true);
+        return *this;
+    }
+
+    uint32_t child = 0;
+    do {
+        child = stack[--depth];
+    } while (depth > 0 && tree->node(stack[depth - 1]).left == child);
+    return *this;
+}
+
+template <typename T, typename Compare, template <typename> class Storage>
+typename CompactAVLTree<T, Compare, Storage>::Iterator
+CompactAVLTree<T, Compare, Storage>::Iterator::operator--(int) {
+    Iterator temp = *this;
+    --(*this);
+    return temp;
+}
+
+template <typename T, typename Compare, template <typename> class Storage>
+bool CompactAVLTree<T, Compare, Storage>::Iterator::operator==(
+    const Iterator &other) const {
+    return depth == other.depth &&
+           (depth == 0 || stack[depth - 1] == other.stack[depth - 1]);
+}
+
+template <typename T, typename Compare, template <typename> class Storage>
+bool CompactAVLTree<T, Compare, Storage>::Iterator::operator!=(
+    const Iterator &other) const {
+    return !(*this == other);
+}
+
+template <typename T, typename Compare, template <typename> class Storage>
+void CompactAVLTree<T, Compare, Storage>::Iterator::descend(uint32_t index,
+                                                            bool right) {
+    while (index != COMPACT_AVL_NIL) {
+        stack[depth++] = index;
+        const Node &current = tree->node(index);
+        index = right ? current.right : current.left;
+    }
+}
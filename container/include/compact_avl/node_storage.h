@@ -0,0 +1,81 @@
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/**
+ * Index that links to no node, the compact trees use it where a pointer based
+ * tree would use nullptr.
+ */
+constexpr uint32_t COMPACT_AVL_NIL = std::numeric_limits<uint32_t>::max();
+
+/**
+ * Where a CompactAVLTree keeps its nodes: a contiguous array addressed by 32
+ * bit indices, plus the index of the root. Nodes are only ever appended at
+ * the end and popped from the end, the tree moves the last node into the
+ * slot of a removed one itself.
+ */
+template <typename S, typename Node>
+concept CompactNodeStorage =
+    requires(S storage, const S &constStorage, uint32_t index, Node node) {
+        { storage[index] } -> std::same_as<Node &>;
+        { constStorage.size() } -> std::same_as<uint32_t>;
+        { storage.emplace(std::move(node)) } -> std::same_as<uint32_t>;
+        { storage.pop() } -> std::same_as<void>;
+        { storage.clear() } -> std::same_as<void>;
+        { storage.reserve(std::size_t{}) } -> std::same_as<void>;
+        { storage.root() } -> std::same_as<uint32_t &>;
+        { constStorage.root() } -> std::same_as<uint32_t>;
+    };
+
+/**
+ * Default storage of a CompactAVLTree, the nodes live in a std::vector on the
+ * heap.
+ */
+template <typename Node> class VectorNodeStorage {
+  public:
+    Node &operator[](uint32_t index) noexcept { return nodes[index]; }
+    const Node &operator[](uint32_t index) const noexcept {
+        return nodes[index];
+    }
+
+    [[nodiscard]] uint32_t size() const noexcept {
+        return static_cast<uint32_t>(nodes.size());
+    }
+
+    /**
+     * Appends a node and returns its index. Throws std::length_error once
+     * every index short of COMPACT_AVL_NIL is taken.
+     */
+    template <typename... Args> uint32_t emplace(Args &&...args) {
+        if (nodes.size() >= COMPACT_AVL_NIL) {
+            throw std::length_error("CompactAVLTree is out of node indices");
+        }
+        nodes.emplace_back(std::forward<Args>(args)...);
+        return static_cast<uint32_t>(nodes.size() - 1);
+    }
+
+    void pop() noexcept { nodes.pop_back(); }
+
+    /**
+     * Destroys every node and gives the memory back.
+     */
+    void clear() noexcept {
+        std::vector<Node>().swap(nodes);
+        rootIndex = COMPACT_AVL_NIL;
+    }
+
+    void reserve(std::size_t n) { nodes.reserve(n); }
+
+    uint32_t &root() noexcept { return rootIndex; }
+    [[nodiscard]] uint32_t root() const noexcept { return rootIndex; }
+
+  private:
+    std::vector<Node> nodes;
+    uint32_t rootIndex = COMPACT_AVL_NIL;
+};
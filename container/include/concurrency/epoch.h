@@ -0,0 +1,95 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+/**
+ * Threads that can be pinned in an EpochDomain at the same time. Every slot
+ * takes a cache line.
+ */
+constexpr std::size_t EPOCH_MAX_THREADS = 1024;
+
+/**
+ * Epoch based reclamation for the concurrent containers.
+ *
+ * A reader pins the domain for as long as it follows pointers into a
+ * container. A writer that unlinks a node retires it with retireEpoch() and
+ * may free it once advance() returns a later epoch: by then every thread
+ * that could still reach the node has unpinned. The writers keep their own
+ * lists of retired nodes, the domain only tracks which epochs are pinned.
+ *
+ * There is one process wide domain, so a thread holds a single slot no
+ * matter how many containers it reads. Pins nest.
+ */
+class EpochDomain {
+  public:
+    /**
+     * Keeps the calling thread pinned until it goes out of scope.
+     */
+    class Guard {
+      public:
+        Guard(const Guard &) = delete;
+        Guard &operator=(const Guard &) = delete;
+        ~Guard() { domain->leave(); }
+
+      private:
+        friend class EpochDomain;
+
+        explicit Guard(EpochDomain *domain) : domain(domain) {}
+
+        EpochDomain *domain;
+    };
+
+    EpochDomain(const EpochDomain &) = delete;
+    EpochDomain &operator=(const EpochDomain &) = delete;
+
+    static EpochDomain &global() noexcept;
+
+    /**
+     * Pins the current epoch. Throws std::length_error if more than
+     * EPOCH_MAX_THREADS threads want a slot.
+     */
+    [[nodiscard]] Guard pin();
+    /**
+     * The epoch to retire a node with, call it after the node was unlinked.
+     */
+    [[nodiscard]] uint64_t retireEpoch() noexcept;
+    /**
+     * Starts a new epoch and returns the oldest epoch a pinned thread may
+     * still be in. Nodes retired with an earlier epoch can be freed.
+     */
+    [[nodiscard]] uint64_t advance() noexcept;
+
+  private:
+    static constexpr uint64_t IDLE = std::numeric_limits<uint64_t>::max();
+
+    struct alignas(64) Slot {
+        // epoch the owner pinned, IDLE while it is not pinned
+        std::atomic<uint64_t> epoch{IDLE};
+        std::atomic<bool> owned{false};
+    };
+
+    // Gives the slot back when its thread exits
+    struct ThreadState {
+        Slot *slot = nullptr;
+        int depth = 0;
+
+        ~ThreadState();
+    };
+
+    EpochDomain() = default;
+
+    static ThreadState &threadState() noexcept;
+    Slot *claimSlot();
+    void enter();
+    void leave() noexcept;
+
+    Slot slots[EPOCH_MAX_THREADS];
+    // slots at or above this index were never claimed
+    std::atomic<std::size_t> slotsUsed{0};
+    std::atomic<uint64_t> epoch{1};
+};
+
+#include "concurrency/epoch.hpp"
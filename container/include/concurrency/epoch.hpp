@@ -0,0 +1,88 @@
+#pragma once
+
+#include "concurrency/epoch.h"
+#include <algorithm>
+#include <stdexcept>
+
+inline EpochDomain &EpochDomain::global() noexcept {
+    static EpochDomain domain;
+    return domain;
+}
+
+inline EpochDomain::Guard EpochDomain::pin() {
+    enter();
+    return Guard(this);
+}
+
+// The fence orders the unlink before the epoch load, a thread that pins a
+// later epoch is then guaranteed to see the node unlinked
+inline uint64_t EpochDomain::retireEpoch() noexcept {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return epoch.load(std::memory_order_seq_cst);
+}
+
+inline uint64_t EpochDomain::advance() noexcept {
+    uint64_t oldest = epoch.fetch_add(1, std::memory_order_seq_cst) + 1;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    const std::size_t used = slotsUsed.load(std::memory_order_acquire);
+    for (std::size_t i = 0; i < used; ++i) {
+        oldest =
+            std::min(oldest, slots[i].epoch.load(std::memory_order_seq_cst));
+    }
+    return oldest;
+}
+
+inline EpochDomain::ThreadState::~ThreadState() {
+    if (slot != nullptr) {
+        slot->epoch.store(IDLE, std::memory_order_release);
+        slot->owned.store(false, std::memory_order_release);
+    }
+}
+
+inline EpochDomain::ThreadState &EpochDomain::threadState() noexcept {
+    thread_local ThreadState state;
+    return state;
+}
+
+inline EpochDomain::Slot *EpochDomain::claimSlot() {
+    for (std::size_t i = 0; i < EPOCH_MAX_THREADS; ++i) {
+        Slot &slot = slots[i];
+        if (slot.owned.load(std::memory_order_relaxed) ||
+            slot.owned.exchange(true, std::memory_order_acquire)) {
+            continue;
+        }
+
+        std::size_t used = slotsUsed.load(std::memory_order_relaxed);
+        while (used <= i && !slotsUsed.compare_exchange_weak(
+                                used, i + 1, std::memory_order_release)) {
+        }
+        return &slot;
+    }
+    throw std::length_error("EpochDomain is out of thread slots");
+}
+
+// The epoch is published before the pinned thread reads any pointer, see
+// retireEpoch
+inline void EpochDomain::enter() {
+    ThreadState &state = threadState();
+    if (state.depth > 0) {
+        ++state.depth;
+        return;
+    }
+    if (state.slot == nullptr) {
+        state.slot = claimSlot();
+    }
+
+    state.slot->epoch.store(epoch.load(std::memory_order_seq_cst),
+                            std::memory_order_seq_cst);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    state.depth = 1;
+}
+
+inline void EpochDomain::leave() noexcept {
+    ThreadState &state = threadState();
+    if (--state.depth == 0) {
+        state.slot->epoch.store(IDLE, std::memory_order_release);
+    }
+}
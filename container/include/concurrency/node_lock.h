@@ -0,0 +1,31 @@
+#pragma once
+
+#include <atomic>
+
+/**
+ * Spins a waiting NodeLock does before it goes to sleep.
+ */
+constexpr int NODE_LOCK_SPINS = 64;
+
+/**
+ * Lock of a single byte, for containers that give every node its own.
+ *
+ * A holder is usually done after a few pointer updates, so a waiter spins
+ * for a while before it sleeps on the flag with std::atomic::wait. Meets
+ * Lockable, so it works with std::lock_guard.
+ */
+class NodeLock {
+  public:
+    NodeLock() = default;
+    NodeLock(const NodeLock &) = delete;
+    NodeLock &operator=(const NodeLock &) = delete;
+
+    void lock() noexcept;
+    [[nodiscard]] bool try_lock() noexcept;
+    void unlock() noexcept;
+
+  private:
+    std::atomic<bool> locked{false};
+};
+
+#include "concurrency/node_lock.hpp"
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "concurrency/node_lock.h"
+
+inline void NodeLock::lock() noexcept {
+    for (int spins = 0; !try_lock(); ++spins) {
+        if (spins >= NODE_LOCK_SPINS) {
+            locked.wait(true, std::memory_order_relaxed);
+        }
+    }
+}
+
+// Reading first keeps the cache line shared while the lock is taken
+inline bool NodeLock::try_lock() noexcept {
+    return !locked.load(std::memory_order_relaxed) &&
+           !locked.exchange(true, std::memory_order_acquire);
+}
+
+inline void NodeLock::unlock() noexcept {
+    locked.store(false, std::memory_order_release);
+    locked.notify_one();
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "concurrency/epoch.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * What a node needs to wait on a RetiredList, derive the node from it.
+ */
+template <typename Node> struct Retirable {
+    // only used once the node is retired
+    Node *retiredNext = nullptr;
+    uint64_t retiredEpoch = 0;
+};
+
+/**
+ * Lock free list of the nodes a concurrent container unlinked, until no
+ * reader can hold them any more, see EpochDomain.
+ *
+ * Any thread may retire a node. Every Batch retired nodes the retiring
+ * thread frees the ones that became unreachable with Free. Whatever is left
+ * is freed with the list, when no other thread may use it any more.
+ */
+template <typename Node, void (*Free)(Node *) noexcept, std::size_t Batch>
+class RetiredList {
+  public:
+    RetiredList() = default;
+    RetiredList(const RetiredList &) = delete;
+    RetiredList &operator=(const RetiredList &) = delete;
+    ~RetiredList();
+
+    /**
+     * Hand over a node that was unlinked from every place a new reader
+     * could find it.
+     */
+    void retire(Node *node);
+    /**
+     * Free the retired nodes no reader can hold any more.
+     */
+    void reclaim();
+
+  private:
+    // linked through retiredNext
+    std::atomic<Node *> head{nullptr};
+    // nodes retired since the last reclaim
+    std::atomic<std::size_t> count{0};
+};
+
+#include "concurrency/retired_list.hpp"
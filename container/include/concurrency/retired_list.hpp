@@ -0,0 +1,62 @@
+#pragma once
+
+#include "concurrency/retired_list.h"
+
+template <typename Node, void (*Free)(Node *) noexcept, std::size_t Batch>
+RetiredList<Node, Free, Batch>::~RetiredList() {
+    Node *node = head.load(std::memory_order_relaxed);
+    while (node != nullptr) {
+        Node *next = node->retiredNext;
+        Free(node);
+        node = next;
+    }
+}
+
+template <typename Node, void (*Free)(Node *) noexcept, std::size_t Batch>
+void RetiredList<Node, Free, Batch>::retire(Node *node) {
+    node->retiredEpoch = EpochDomain::global().retireEpoch();
+    node->retiredNext = head.load(std::memory_order_relaxed);
+    while (!head.compare_exchange_weak(node->retiredNext, node,
+                                       std::memory_order_release,
+                                       std::memory_order_relaxed)) {
+    }
+    if (count.fetch_add(1, std::memory_order_relaxed) + 1 >= Batch) {
+        count.store(0, std::memory_order_relaxed);
+        reclaim();
+    }
+}
+
+// The reclaiming thread takes the whole list, so no two threads free the
+// same node. What it cannot free yet goes back onto the list.
+template <typename Node, void (*Free)(Node *) noexcept, std::size_t Batch>
+void RetiredList<Node, Free, Batch>::reclaim() {
+    Node *node = head.exchange(nullptr, std::memory_order_acquire);
+    if (node == nullptr) {
+        return;
+    }
+
+    const uint64_t oldest = EpochDomain::global().advance();
+    Node *kept = nullptr;
+    Node *keptLast = nullptr;
+    while (node != nullptr) {
+        Node *next = node->retiredNext;
+        if (node->retiredEpoch < oldest) {
+            Free(node);
+        } else {
+            node->retiredNext = kept;
+            kept = node;
+            if (keptLast == nullptr) {
+                keptLast = node;
+            }
+        }
+        node = next;
+    }
+
+    if (kept != nullptr) {
+        keptLast->retiredNext = head.load(std::memory_order_relaxed);
+        while (!head.compare_exchange_weak(keptLast->retiredNext, kept,
+                                           std::memory_order_release,
+                                           std::memory_order_relaxed)) {
+        }
+    }
+}
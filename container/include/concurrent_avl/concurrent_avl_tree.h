@@ -0,0 +1,260 @@
+#pragma once
+
+#include "concurrency/epoch.h"
+#include "concurrency/node_lock.h"
+#include "concurrency/retired_list.h"
+#include "container.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+/**
+ * Retired nodes a ConcurrentAVLTree collects before it tries to free them.
+ */
+constexpr std::size_t CONCURRENT_AVL_RECLAIM_BATCH = 128;
+
+/**
+ * AVL tree that can be read and written from many threads at once.
+ *
+ * Lookups take no lock. They follow the optimistic scheme of Bronson et al.
+ * ("A Practical Concurrent Binary Search Tree"): every node carries a
+ * version that a rotation bumps when it moves the node down, and a reader
+ * checks the version of a node after it picked the child to go on with. If
+ * it changed, the reader retries from that node instead of from the root.
+ * Unlinked nodes are only freed once no reader can hold them any more, see
+ * EpochDomain.
+ *
+ * Writers descend the same way and then lock only the nodes they change,
+ * always a parent before its child: an insert locks the node it hangs the new
+ * leaf off, an unlink the parent and the node, a rotation the parent of the
+ * subtree and the nodes it moves. The root hangs off a holder that is locked
+ * like any other parent. A value whose node has two children is only marked
+ * removed, the node stays as a routing node until it loses a child and can
+ * be unlinked, so values never move between nodes under a reader. The writer
+ * that changed a node repairs heights and balance on its way back up, until
+ * then they may be off by a little.
+ *
+ * search, min and max return a copy of the value, as a concurrent remove may
+ * free the node right after the lookup. That makes the tree a
+ * ConcurrentDontainer rather than a Dontainer.
+ */
+template <typename T, typename Compare = std::less<T>>
+class ConcurrentAVLTree {
+  private:
+    struct Node;
+
+    // What the nodes share with the root holder, whose right child is the
+    // root
+    struct Anchor {
+        std::atomic<Node *> left{nullptr};
+        std::atomic<Node *> right{nullptr};
+        // see VERSION_SHRINKING
+        std::atomic<uint64_t> version{0};
+        // only changed under the lock of the parent it points to
+        std::atomic<Anchor *> parent{nullptr};
+        std::atomic<int> height{0};
+        NodeLock lock;
+    };
+
+    struct Node : Anchor, Retirable<Node> {
+        T value;
+        // false once the value was removed from a routing node
+        std::atomic<bool> present{true};
+
+        template <typename... Args>
+        explicit Node(std::in_place_t /*unused*/, Anchor *parent,
+                      Args &&...args)
+            : value(std::forward<Args>(args)...) {
+            this->parent.store(parent, std::memory_order_relaxed);
+            this->height.store(1, std::memory_order_relaxed);
+        }
+    };
+
+    /**
+     * A node version is even while the node is stable. A rotation that moves
+     * the node down sets VERSION_SHRINKING for its duration and then adds
+     * VERSION_STEP, unlinking sets it to VERSION_UNLINKED for good.
+     */
+    static constexpr uint64_t VERSION_UNLINKED = 1;
+    static constexpr uint64_t VERSION_SHRINKING = 2;
+    static constexpr uint64_t VERSION_STEP = 4;
+
+    /**
+     * What nodeCondition asks for, any other value is the height the node
+     * should have.
+     */
+    static constexpr int UNLINK_REQUIRED = -1;
+    static constexpr int REBALANCE_REQUIRED = -2;
+    static constexpr int NOTHING_REQUIRED = -3;
+
+  public:
+    ConcurrentAVLTree() = default;
+    ConcurrentAVLTree(const ConcurrentAVLTree &) = delete;
+    ConcurrentAVLTree(ConcurrentAVLTree &&) = delete;
+    ConcurrentAVLTree &operator=(const ConcurrentAVLTree &) = delete;
+    ConcurrentAVLTree &operator=(ConcurrentAVLTree &&) = delete;
+    /**
+     * No other thread may use the tree any more.
+     */
+    ~ConcurrentAVLTree();
+
+    // modifiers
+    /**
+     * Inserts the value, returns false if an equivalent value already
+     * existed.
+     */
+    bool insert(const T &value);
+    bool insert(T &&value);
+    /**
+     * Removes an equivalent value, returns false if there was none.
+     */
+    bool remove(const T &value);
+    template <typename K>
+        requires LookupKey<K, T, Compare>
+    bool remove(const K &key);
+    /**
+     * Removes every value. Readers that are still inside the old tree may
+     * see values from before the clear.
+     */
+    void clear();
+
+    // access
+    /**
+     * Search for a value, returns a copy of it or nothing if not found.
+     * Never blocks.
+     */
+    [[nodiscard]] std::optional<T> search(const T &value) const;
+    template <typename K>
+        requires LookupKey<K, T, Compare>
+    [[nodiscard]] std::optional<T> search(const K &key) const;
+    /**
+     * Returns a copy of the max value, or nothing if the tree is empty.
+     */
+    [[nodiscard]] std::optional<T> max() const;
+    /**
+     * Returns a copy of the min value, or nothing if the tree is empty.
+     */
+    [[nodiscard]] std::optional<T> min() const;
+    /**
+     * Check if the tree contains a value. Never blocks.
+     */
+    [[nodiscard]] bool contains(const T &value) const;
+    template <typename K>
+        requires LookupKey<K, T, Compare>
+    [[nodiscard]] bool contains(const K &key) const;
+
+    // info
+    /**
+     * Get the height of the tree, routing nodes included. Never blocks.
+     */
+    [[nodiscard]] int height() const;
+    [[nodiscard]] std::size_t size() const noexcept;
+    [[nodiscard]] bool empty() const noexcept;
+
+  private:
+    // outcome of a lookup below one node
+    struct Probe {
+        Node *node;
+        // the node changed while the lookup was below it
+        bool retry;
+    };
+
+    // outcome of a writer below one node
+    enum class Update {
+        Applied,
+        // the value already existed, or did not
+        Rejected,
+        // the node changed while the writer was below it
+        Retry,
+    };
+
+    // lock free lookups, the caller has to be pinned
+    template <typename K> [[nodiscard]] Node *findNode(const K &key) const;
+    template <typename K>
+    [[nodiscard]] Probe attemptFind(const K &key, Node *node,
+                                    uint64_t nodeVersion) const;
+    // the min (or max) node, if right
+    [[nodiscard]] Node *findExtreme(bool right) const;
+    [[nodiscard]] Probe attemptExtreme(bool right, Node *node,
+                                       uint64_t nodeVersion) const;
+    // the root with its version, once no rotation is moving it
+    [[nodiscard]] Node *stableRoot(uint64_t &version) const;
+
+    // writers, the caller has to be pinned
+    template <typename V> bool insertValue(V &&value);
+    template <typename V>
+    Update attemptInsert(V &&value, Node *node, uint64_t nodeVersion);
+    template <typename K>
+    Update attemptRemove(const K &key, Anchor *parent, Node *node,
+                         uint64_t nodeVersion);
+    // node holds the value (key), lock it and mark it present (removed)
+    Update insertIntoNode(Node *node);
+    Update removeFromNode(Anchor *parent, Node *node);
+
+    // the caller holds the locks of parent and node
+    bool attemptUnlink(Anchor *parent, Node *node);
+
+    /**
+     * Walk up from node, unlinking routing nodes that lost a child, updating
+     * heights and rotating where the balance is off, until a node needs
+     * nothing. Locks at most the nodes of one rotation at a time.
+     */
+    void fixHeightAndRebalance(Anchor *node);
+    /**
+     * How node has to be repaired, see UNLINK_REQUIRED. Reads the heights of
+     * the children, which may be changing.
+     */
+    [[nodiscard]] int nodeCondition(Node *node) const noexcept;
+    // these return the next node to repair, if any
+    // the caller holds the lock of node
+    Anchor *fixHeight(Anchor *node) noexcept;
+    // the caller holds the locks of parent and node
+    Anchor *rebalance(Anchor *parent, Node *node);
+    Anchor *rebalanceToRight(Anchor *parent, Node *node, Node *left,
+                             int rightHeight) noexcept;
+    Anchor *rebalanceToLeft(Anchor *parent, Node *node, Node *right,
+                            int leftHeight) noexcept;
+    // the caller also holds the lock of the child that moves up
+    Anchor *rotateRight(Anchor *parent, Node *node, Node *left,
+                        int rightHeight, int leftLeftHeight, Node *leftRight,
+                        int leftRightHeight) noexcept;
+    Anchor *rotateLeft(Anchor *parent, Node *node, int leftHeight,
+                       Node *right, Node *rightLeft, int rightLeftHeight,
+                       int rightRightHeight) noexcept;
+    // and of the grandchild that moves up two levels
+    Anchor *rotateRightOverLeft(Anchor *parent, Node *node, Node *left,
+                                int rightHeight, int leftLeftHeight,
+                                Node *leftRight,
+                                int leftRightLeftHeight) noexcept;
+    Anchor *rotateLeftOverRight(Anchor *parent, Node *node, int leftHeight,
+                                Node *right, Node *rightLeft,
+                                int rightRightHeight,
+                                int rightLeftRightHeight) noexcept;
+    static void replaceChild(Anchor *parent, Node *child,
+                             Node *replacement) noexcept;
+
+    static void beginShrink(Node *node) noexcept;
+    static void endShrink(Node *node) noexcept;
+    static void destroyNode(Node *node) noexcept;
+    static void destroyTree(Node *node) noexcept;
+    [[nodiscard]] static bool isChanging(uint64_t version) noexcept;
+    [[nodiscard]] static bool isUnlinked(const Anchor *node) noexcept;
+    [[nodiscard]] static int height(const Node *node) noexcept;
+
+    Anchor holder;
+    std::atomic<std::size_t> count{0};
+    RetiredList<Node, &destroyNode, CONCURRENT_AVL_RECLAIM_BATCH> retired;
+    Compare comp;
+};
+
+#include "concurrent_avl/concurrent_avl_tree.hpp"
+
+static_assert(ConcurrentDontainer<ConcurrentAVLTree<int>, int>);
+static_assert(
+    TransparentDontainer<ConcurrentAVLTree<std::string, std::less<>>,
+                         std::string, std::string_view>);
@@ -0,0 +1,972 @@
+#pragma once
+
+#include "concurrent_avl/concurrent_avl_tree.h"
+#include <algorithm>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+template <typename T, typename Compare>
+ConcurrentAVLTree<T, Compare>::~ConcurrentAVLTree() {
+    destroyTree(holder.right.load(std::memory_order_relaxed));
+}
+
+template <typename T, typename Compare>
+bool ConcurrentAVLTree<T, Compare>::insert(const T &value) {
+    return insertValue(value);
+}
+
+template <typename T, typename Compare>
+bool ConcurrentAVLTree<T, Compare>::insert(T &&value) {
+    return insertValue(std::move(value));
+}
+
+// An empty tree gets its root under the lock of the holder, everything else
+// happens below the root
+template <typename T, typename Compare>
+template <typename V>
+bool ConcurrentAVLTree<T, Compare>::insertValue(V &&value) {
+    EpochDomain::Guard guard = EpochDomain::global().pin();
+    while (true) {
+        uint64_t version = 0;
+        Node *top = stableRoot(version);
+        if (top != nullptr) {
+            const Update update =
+                attemptInsert(std::forward<V>(value), top, version);
+            if (update != Update::Retry) {
+                return update == Update::Applied;
+            }
+            continue;
+        }
+
+        std::lock_guard<NodeLock> lock(holder.lock);
+        if (holder.right.load(std::memory_order_relaxed) == nullptr) {
+            Node *added =
+                new Node(std::in_place, &holder, std::forward<V>(value));
+            count.fetch_add(1, std::memory_order_relaxed);
+            holder.right.store(added, std::memory_order_release);
+            return true;
+        }
+    }
+}
+
+// The value is only moved from once the new node is built, a retry still
+// has it. The count goes up before the node is reachable, so clear never
+// takes it below zero.
+template <typename T, typename Compare>
+template <typename V>
+typename ConcurrentAVLTree<T, Compare>::Update
+ConcurrentAVLTree<T, Compare>::attemptInsert(V &&value, Node *node,
+                                             uint64_t nodeVersion) {
+    bool right = false;
+    if (comp(value, node->value)) {
+        right = false;
+    } else if (comp(node->value, value)) {
+        right = true;
+    } else {
+        return insertIntoNode(node);
+    }
+
+    std::atomic<Node *> &link = right ? node->right : node->left;
+    while (true) {
+        Node *child = link.load(std::memory_order_acquire);
+        if (node->version.load(std::memory_order_acquire) != nodeVersion) {
+            return Update::Retry;
+        }
+
+        if (child == nullptr) {
+            Anchor *damaged = nullptr;
+            {
+                std::lock_guard<NodeLock> lock(node->lock);
+                if (node->version.load(std::memory_order_relaxed) !=
+                    nodeVersion) {
+                    return Update::Retry;
+                }
+                if (link.load(std::memory_order_relaxed) != nullptr) {
+                    // Another writer got there first
+                    continue;
+                }
+                Node *added =
+                    new Node(std::in_place, node, std::forward<V>(value));
+                count.fetch_add(1, std::memory_order_relaxed);
+                link.store(added, std::memory_order_release);
+                damaged = fixHeight(node);
+            }
+            fixHeightAndRebalance(damaged);
+            return Update::Applied;
+        }
+
+        const uint64_t childVersion =
+            child->version.load(std::memory_order_acquire);
+        if (isChanging(childVersion) ||
+            child != link.load(std::memory_order_acquire)) {
+            std::this_thread::yield();
+            continue;
+        }
+        if (node->version.load(std::memory_order_acquire) != nodeVersion) {
+            return Update::Retry;
+        }
+
+        const Update update =
+            attemptInsert(std::forward<V>(value), child, childVersion);
+        if (update != Update::Retry) {
+            return update;
+        }
+    }
+}
+
+template <typename T, typename Compare>
+typename ConcurrentAVLTree<T, Compare>::Update
+ConcurrentAVLTree<T, Compare>::insertIntoNode(Node *node) {
+    std::lock_guard<NodeLock> lock(node->lock);
+    if (isUnlinked(node)) {
+        return Update::Retry;
+    }
+    if (node->present.load(std::memory_order_relaxed)) {
+        return Update::Rejected;
+    }
+    count.fetch_add(1, std::memory_order_relaxed);
+    node->present.store(true, std::memory_order_release);
+    return Update::Applied;
+}
+
+template <typename T, typename Compare>
+bool ConcurrentAVLTree<T, Compare>::remove(const T &value) {
+    return remove<T>(value);
+}
+
+template <typename T, typename Compare>
+template <typename K>
+    requires LookupKey<K, T, Compare>
+bool ConcurrentAVLTree<T, Compare>::remove(const K &key) {
+    EpochDomain::Guard guard = EpochDomain::global().pin();
+    while (true) {
+        uint64_t version = 0;
+        Node *top = stableRoot(version);
+        if (top == nullptr) {
+            return false;
+        }
+        const Update update = attemptRemove(key, &holder, top, version);
+        if (update != Update::Retry) {
+            return update == Update::Applied;
+        }
+    }
+}
+
+template <typename T, typename Compare>
+template <typename K>
+typename ConcurrentAVLTree<T, Compare>::Update
+ConcurrentAVLTree<T, Compare>::attemptRemove(const K &key, Anchor *parent,
+                                             Node *node,
+                                             uint64_t nodeVersion) {
+    bool right = false;
+    if (comp(key, node->value)) {
+        right = false;
+    } else if (comp(node->value, key)) {
+        right = true;
+    } else {
+        return removeFromNode(parent, node);
+    }
+
+    const std::atomic<Node *> &link = right ? node->right : node->left;
+    while (true) {
+        Node *child = link.load(std::memory_order_acquire);
+        if (node->version.load(std::memory_order_acquire) != nodeVersion) {
+            return Update::Retry;
+        }
+        if (child == nullptr) {
+            return Update::Rejected;
+        }
+
+        const uint64_t childVersion =
+            child->version.load(std::memory_order_acquire);
+        if (isChanging(childVersion) ||
+            child != link.load(std::memory_order_acquire)) {
+            std::this_thread::yield();
+            continue;
+        }
+        if (node->version.load(std::memory_order_acquire) != nodeVersion) {
+            return Update::Retry;
+        }
+
+        const Update update = attemptRemove(key, node, child, childVersion);
+        if (update != Update::Retry) {
+            return update;
+        }
+    }
+}
+
+// A node with at most one child is unlinked right away, which needs the
+// lock of its parent first. With two children clearing the flag is all it
+// takes, the node stays in place as a routing node.
+template <typename T, typename Compare>
+typename ConcurrentAVLTree<T, Compare>::Update
+ConcurrentAVLTree<T, Compare>::removeFromNode(Anchor *parent, Node *node) {
+    if (!node->present.load(std::memory_order_acquire)) {
+        return Update::Rejected;
+    }
+
+    if (node->left.load(std::memory_order_acquire) == nullptr ||
+        node->right.load(std::memory_order_acquire) == nullptr) {
+        Anchor *damaged = nullptr;
+        {
+            std::lock_guard<NodeLock> parentLock(parent->lock);
+            if (isUnlinked(parent) ||
+                node->parent.load(std::memory_order_acquire) != parent) {
+                return Update::Retry;
+            }
+            std::lock_guard<NodeLock> lock(node->lock);
+            if (!node->present.load(std::memory_order_relaxed)) {
+                return Update::Rejected;
+            }
+            if (!attemptUnlink(parent, node)) {
+                return Update::Retry;
+            }
+            count.fetch_sub(1, std::memory_order_relaxed);
+            damaged = fixHeight(parent);
+        }
+        fixHeightAndRebalance(damaged);
+        return Update::Applied;
+    }
+
+    std::lock_guard<NodeLock> lock(node->lock);
+    if (isUnlinked(node)) {
+        return Update::Retry;
+    }
+    if (!node->present.load(std::memory_order_relaxed)) {
+        return Update::Rejected;
+    }
+    if (node->left.load(std::memory_order_relaxed) == nullptr ||
+        node->right.load(std::memory_order_relaxed) == nullptr) {
+        // Lost a child in the meantime, unlink it after all
+        return Update::Retry;
+    }
+    node->present.store(false, std::memory_order_release);
+    count.fetch_sub(1, std::memory_order_relaxed);
+    return Update::Applied;
+}
+
+// Readers still inside the node see its version change and back up to the
+// parent, which now leads past it
+template <typename T, typename Compare>
+bool ConcurrentAVLTree<T, Compare>::attemptUnlink(Anchor *parent,
+                                                  Node *node) {
+    Node *parentLeft = parent->left.load(std::memory_order_relaxed);
+    if (parentLeft != node &&
+        parent->right.load(std::memory_order_relaxed) != node) {
+        return false;
+    }
+    Node *left = node->left.load(std::memory_order_relaxed);
+    Node *right = node->right.load(std::memory_order_relaxed);
+    if (left != nullptr && right != nullptr) {
+        return false;
+    }
+
+    Node *splice = left != nullptr ? left : right;
+    (parentLeft == node ? parent->left : parent->right)
+        .store(splice, std::memory_order_release);
+    if (splice != nullptr) {
+        splice->parent.store(parent, std::memory_order_release);
+    }
+    node->version.store(VERSION_UNLINKED, std::memory_order_release);
+    node->present.store(false, std::memory_order_release);
+    retired.retire(node);
+    return true;
+}
+
+// Writers may still be busy inside the old tree. Every old node is unlinked
+// under its own lock, parents before children, and writers check for that
+// under the same locks, so they either finish before clear reaches their
+// nodes or give up and retry in the new tree. A value they added in time is
+// taken off the count here.
+template <typename T, typename Compare>
+void ConcurrentAVLTree<T, Compare>::clear() {
+    EpochDomain::Guard guard = EpochDomain::global().pin();
+    std::vector<Node *> pending;
+    {
+        std::lock_guard<NodeLock> holderLock(holder.lock);
+        Node *top = holder.right.load(std::memory_order_relaxed);
+        if (top == nullptr) {
+            return;
+        }
+        // The old root is unlinked before the holder lets go, so no
+        // rebalance can hang it back in
+        std::lock_guard<NodeLock> lock(top->lock);
+        holder.right.store(nullptr, std::memory_order_release);
+        top->version.store(VERSION_UNLINKED, std::memory_order_release);
+        pending.push_back(top);
+    }
+
+    while (!pending.empty()) {
+        Node *node = pending.back();
+        pending.pop_back();
+        {
+            std::lock_guard<NodeLock> lock(node->lock);
+            node->version.store(VERSION_UNLINKED, std::memory_order_release);
+            if (Node *left = node->left.load(std::memory_order_relaxed)) {
+                pending.push_back(left);
+            }
+            if (Node *right = node->right.load(std::memory_order_relaxed)) {
+                pending.push_back(right);
+            }
+            if (node->present.load(std::memory_order_relaxed)) {
+                count.fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+        retired.retire(node);
+    }
+}
+
+template <typename T, typename Compare>
+std::optional<T> ConcurrentAVLTree<T, Compare>::search(const T &value) const {
+    return search<T>(value);
+}
+
+// The copy is made while still pinned
+template <typename T, typename Compare>
+template <typename K>
+    requires LookupKey<K, T, Compare>
+std::optional<T> ConcurrentAVLTree<T, Compare>::search(const K &key) const {
+    EpochDomain::Guard guard = EpochDomain::global().pin();
+    Node *node = findNode(key);
+    if (node == nullptr) {
+        return std::nullopt;
+    }
+    return node->value;
+}
+
+template <typename T, typename Compare>
+std::optional<T> ConcurrentAVLTree<T, Compare>::max() const {
+    EpochDomain::Guard guard = EpochDomain::global().pin();
+    Node *node = findExtreme(true);
+    if (node == nullptr) {
+        return std::nullopt;
+    }
+    return node->value;
+}
+
+template <typename T, typename Compare>
+std::optional<T> ConcurrentAVLTree<T, Compare>::min() const {
+    EpochDomain::Guard guard = EpochDomain::global().pin();
+    Node *node = findExtreme(false);
+    if (node == nullptr) {
+        return std::nullopt;
+    }
+    return node->value;
+}
+
+template <typename T, typename Compare>
+bool ConcurrentAVLTree<T, Compare>::contains(const T &value) const {
+    return contains<T>(value);
+}
+
+template <typename T, typename Compare>
+template <typename K>
+    requires LookupKey<K, T, Compare>
+bool ConcurrentAVLTree<T, Compare>::contains(const K &key) const {
+    EpochDomain::Guard guard = EpochDomain::global().pin();
+    return findNode(key) != nullptr;
+}
+
+template <typename T, typename Compare>
+int ConcurrentAVLTree<T, Compare>::height() const {
+    EpochDomain::Guard guard = EpochDomain::global().pin();
+    return height(holder.right.load(std::memory_order_acquire));
+}
+
+template <typename T, typename Compare>
+std::size_t ConcurrentAVLTree<T, Compare>::size() const noexcept {
+    return count.load(std::memory_order_relaxed);
+}
+
+template <typename T, typename Compare>
+bool ConcurrentAVLTree<T, Compare>::empty() const noexcept {
+    return size() == 0;
+}
+
+// The root itself can be rotated away, so it is read again after its
+// version to make sure the caller starts at the current one
+template <typename T, typename Compare>
+typename ConcurrentAVLTree<T, Compare>::Node *
+ConcurrentAVLTree<T, Compare>::stableRoot(uint64_t &version) const {
+    while (true) {
+        Node *top = holder.right.load(std::memory_order_acquire);
+        if (top == nullptr) {
+            return nullptr;
+        }
+        version = top->version.load(std::memory_order_acquire);
+        if (!isChanging(version) &&
+            top == holder.right.load(std::memory_order_acquire)) {
+            return top;
+        }
+        std::this_thread::yield();
+    }
+}
+
+template <typename T, typename Compare>
+template <typename K>
+typename ConcurrentAVLTree<T, Compare>::Node *
+ConcurrentAVLTree<T, Compare>::findNode(const K &key) const {
+    while (true) {
+        uint64_t version = 0;
+        Node *top = stableRoot(version);
+        if (top == nullptr) {
+            return nullptr;
+        }
+        Probe probe = attemptFind(key, top, version);
+        if (!probe.retry) {
+            return probe.node;
+        }
+    }
+}
+
+// Holding nodeVersion means the key range of node did not shrink since the
+// lookup arrived, so the key can only be in its subtree. The child is only
+// entered once its own version was read and node was still unchanged, which
+// hands that guarantee down one level.
+template <typename T, typename Compare>
+template <typename K>
+typename ConcurrentAVLTree<T, Compare>::Probe
+ConcurrentAVLTree<T, Compare>::attemptFind(const K &key, Node *node,
+                                           uint64_t nodeVersion) const {
+    while (true) {
+        bool right = false;
+        if (comp(key, node->value)) {
+            right = false;
+        } else if (comp(node->value, key)) {
+            right = true;
+        } else {
+            return {node->present.load(std::memory_order_acquire) ? node
+                                                                  : nullptr,
+                    false};
+        }
+
+        const std::atomic<Node *> &link = right ? node->right : node->left;
+        Node *child = link.load(std::memory_order_acquire);
+        if (node->version.load(std::memory_order_acquire) != nodeVersion) {
+            return {nullptr, true};
+        }
+        if (child == nullptr) {
+            return {nullptr, false};
+        }
+
+        const uint64_t childVersion =
+            child->version.load(std::memory_order_acquire);
+        if (isChanging(childVersion) ||
+            child != link.load(std::memory_order_acquire)) {
+            // A writer is busy with the child, look at it again
+            std::this_thread::yield();
+            continue;
+        }
+        if (node->version.load(std::memory_order_acquire) != nodeVersion) {
+            return {nullptr, true};
+        }
+
+        Probe probe = attemptFind(key, child, childVersion);
+        if (!probe.retry) {
+            return probe;
+        }
+    }
+}
+
+template <typename T, typename Compare>
+typename ConcurrentAVLTree<T, Compare>::Node *
+ConcurrentAVLTree<T, Compare>::findExtreme(bool right) const {
+    while (true) {
+        uint64_t version = 0;
+        Node *top = stableRoot(version);
+        if (top == nullptr) {
+            return nullptr;
+        }
+        Probe probe = attemptExtreme(right, top, version);
+        if (!probe.retry) {
+            return probe.node;
+        }
+    }
+}
+
+// The same hand over hand validation as attemptFind, along the outermost
+// path. The last node on it can be a routing node that just lost its outer
+// child, the writer that removed the child unlinks it next, so the walk
+// waits for that.
+template <typename T, typename Compare>
+typename ConcurrentAVLTree<T, Compare>::Probe
+ConcurrentAVLTree<T, Compare>::attemptExtreme(bool right, Node *node,
+                                              uint64_t nodeVersion) const {
+    const std::atomic<Node *> &link = right ? node->right : node->left;
+    while (true) {
+        Node *child = link.load(std::memory_order_acquire);
+        if (child == nullptr) {
+            const bool present = node->present.load(std::memory_order_acquire);
+            if (node->version.load(std::memory_order_acquire) != nodeVersion) {
+                return {nullptr, true};
+            }
+            if (!present) {
+                std::this_thread::yield();
+                return {nullptr, true};
+            }
+            return {node, false};
+        }
+        if (node->version.load(std::memory_order_acquire) != nodeVersion) {
+            return {nullptr, true};
+        }
+
+        const uint64_t childVersion =
+            child->version.load(std::memory_order_acquire);
+        if (isChanging(childVersion) ||
+            child != link.load(std::memory_order_acquire)) {
+            std::this_thread::yield();
+            continue;
+        }
+        if (node->version.load(std::memory_order_acquire) != nodeVersion) {
+            return {nullptr, true};
+        }
+
+        Probe probe = attemptExtreme(right, child, childVersion);
+        if (!probe.retry) {
+            return probe;
+        }
+    }
+}
+
+// Every step locks at most one parent with the nodes below it that a
+// rotation moves, and lets go before it looks at the next node up. A
+// rotation can hand back a node below it to repair first, and that repair
+// may end before it gets back up to the rotation. The nodes on the way up to
+// the parent of the rotation are then looked at anyway, their heights may be
+// stale.
+template <typename T, typename Compare>
+void ConcurrentAVLTree<T, Compare>::fixHeightAndRebalance(Anchor *anchor) {
+    Anchor *until = nullptr;
+    while (anchor != nullptr && anchor != &holder) {
+        Node *node = static_cast<Node *>(anchor);
+        if (isUnlinked(node)) {
+            return;
+        }
+
+        const int condition = nodeCondition(node);
+        Anchor *next = nullptr;
+        if (condition == UNLINK_REQUIRED || condition == REBALANCE_REQUIRED) {
+            Anchor *parent = node->parent.load(std::memory_order_acquire);
+            std::lock_guard<NodeLock> parentLock(parent->lock);
+            if (isUnlinked(parent) ||
+                node->parent.load(std::memory_order_acquire) != parent) {
+                // Moved or unlinked in the meantime, look at it again
+                continue;
+            }
+            std::lock_guard<NodeLock> lock(node->lock);
+            if (isUnlinked(node)) {
+                return;
+            }
+            next = rebalance(parent, node);
+            if (until == nullptr || until == node) {
+                until = parent;
+            }
+        } else {
+            if (condition != NOTHING_REQUIRED) {
+                std::lock_guard<NodeLock> lock(node->lock);
+                next = isUnlinked(node) ? nullptr : fixHeight(node);
+            }
+            if (until == node) {
+                until = nullptr;
+            }
+        }
+
+        if (next == nullptr && until != nullptr) {
+            next = node->parent.load(std::memory_order_acquire);
+        }
+        anchor = next;
+    }
+}
+
+template <typename T, typename Compare>
+int ConcurrentAVLTree<T, Compare>::nodeCondition(Node *node) const noexcept {
+    Node *left = node->left.load(std::memory_order_acquire);
+    Node *right = node->right.load(std::memory_order_acquire);
+    if ((left == nullptr || right == nullptr) &&
+        !node->present.load(std::memory_order_acquire)) {
+        return UNLINK_REQUIRED;
+    }
+
+    const int leftHeight = height(left);
+    const int rightHeight = height(right);
+    if (leftHeight - rightHeight > 1 || rightHeight - leftHeight > 1) {
+        return REBALANCE_REQUIRED;
+    }
+    const int replacement = 1 + std::max(leftHeight, rightHeight);
+    return node->height.load(std::memory_order_relaxed) != replacement
+               ? replacement
+               : NOTHING_REQUIRED;
+}
+
+// The holder has no height to fix
+template <typename T, typename Compare>
+typename ConcurrentAVLTree<T, Compare>::Anchor *
+ConcurrentAVLTree<T, Compare>::fixHeight(Anchor *anchor) noexcept {
+    if (anchor == &holder) {
+        return nullptr;
+    }
+    Node *node = static_cast<Node *>(anchor);
+    const int condition = nodeCondition(node);
+    if (condition == UNLINK_REQUIRED || condition == REBALANCE_REQUIRED) {
+        return node;
+    }
+    if (condition == NOTHING_REQUIRED) {
+        return nullptr;
+    }
+    node->height.store(condition, std::memory_order_relaxed);
+    return node->parent.load(std::memory_order_acquire);
+}
+
+template <typename T, typename Compare>
+typename ConcurrentAVLTree<T, Compare>::Anchor *
+ConcurrentAVLTree<T, Compare>::rebalance(Anchor *parent, Node *node) {
+    Node *left = node->left.load(std::memory_order_relaxed);
+    Node *right = node->right.load(std::memory_order_relaxed);
+    if ((left == nullptr || right == nullptr) &&
+        !node->present.load(std::memory_order_relaxed)) {
+        return attemptUnlink(parent, node) ? fixHeight(parent) : node;
+    }
+
+    const int leftHeight = height(left);
+    const int rightHeight = height(right);
+    if (leftHeight - rightHeight > 1) {
+        return rebalanceToRight(parent, node, left, rightHeight);
+    }
+    if (rightHeight - leftHeight > 1) {
+        return rebalanceToLeft(parent, node, right, leftHeight);
+    }
+
+    const int replacement = 1 + std::max(leftHeight, rightHeight);
+    if (node->height.load(std::memory_order_relaxed) == replacement) {
+        return nullptr;
+    }
+    node->height.store(replacement, std::memory_order_relaxed);
+    return fixHeight(parent);
+}
+
+// The heights below the locked nodes are only hints, a rotation built on a
+// stale one leaves a node the caller looks at again
+template <typename T, typename Compare>
+typename ConcurrentAVLTree<T, Compare>::Anchor *
+ConcurrentAVLTree<T, Compare>::rebalanceToRight(Anchor *parent, Node *node,
+                                                Node *left,
+                                                int rightHeight) noexcept {
+    std::lock_guard<NodeLock> leftLock(left->lock);
+    if (height(left) - rightHeight <= 1) {
+        return node;
+    }
+
+    Node *leftRight = left->right.load(std::memory_order_relaxed);
+    const int leftLeftHeight =
+        height(left->left.load(std::memory_order_relaxed));
+    const int leftRightHeight = height(leftRight);
+    if (leftLeftHeight >= leftRightHeight) {
+        return rotateRight(parent, node, left, rightHeight, leftLeftHeight,
+                           leftRight, leftRightHeight);
+    }
+
+    {
+        std::lock_guard<NodeLock> innerLock(leftRight->lock);
+        const int innerHeight = height(leftRight);
+        if (leftLeftHeight >= innerHeight) {
+            return rotateRight(parent, node, left, rightHeight,
+                               leftLeftHeight, leftRight, innerHeight);
+        }
+        const int innerLeftHeight =
+            height(leftRight->left.load(std::memory_order_relaxed));
+        const int balance = leftLeftHeight - innerLeftHeight;
+        if (balance >= -1 && balance <= 1) {
+            return rotateRightOverLeft(parent, node, left, rightHeight,
+                                       leftLeftHeight, leftRight,
+                                       innerLeftHeight);
+        }
+    }
+    // The left child leans right too much for a double rotation, fix it
+    // first
+    return rebalanceToLeft(node, left, leftRight, leftLeftHeight);
+}
+
+template <typename T, typename Compare>
+typename ConcurrentAVLTree<T, Compare>::Anchor *
+ConcurrentAVLTree<T, Compare>::rebalanceToLeft(Anchor *parent, Node *node,
+                                               Node *right,
+                                               int leftHeight) noexcept {
+    std::lock_guard<NodeLock> rightLock(right->lock);
+    if (height(right) - leftHeight <= 1) {
+        return node;
+    }
+
+    Node *rightLeft = right->left.load(std::memory_order_relaxed);
+    const int rightLeftHeight = height(rightLeft);
+    const int rightRightHeight =
+        height(right->right.load(std::memory_order_relaxed));
+    if (rightRightHeight >= rightLeftHeight) {
+        return rotateLeft(parent, node, leftHeight, right, rightLeft,
+                          rightLeftHeight, rightRightHeight);
+    }
+
+    {
+        std::lock_guard<NodeLock> innerLock(rightLeft->lock);
+        const int innerHeight = height(rightLeft);
+        if (rightRightHeight >= innerHeight) {
+            return rotateLeft(parent, node, leftHeight, right, rightLeft,
+                              innerHeight, rightRightHeight);
+        }
+        const int innerRightHeight =
+            height(rightLeft->right.load(std::memory_order_relaxed));
+        const int balance = rightRightHeight - innerRightHeight;
+        if (balance >= -1 && balance <= 1) {
+            return rotateLeftOverRight(parent, node, leftHeight, right,
+                                       rightLeft, rightRightHeight,
+                                       innerRightHeight);
+        }
+    }
+    return rebalanceToRight(node, right, rightLeft, rightRightHeight);
+}
+
+// node moves down and is the one that shrinks. The nodes that are left
+// unbalanced or as routing nodes without a second child go back to the
+// caller.
+template <typename T, typename Compare>
+typename ConcurrentAVLTree<T, Compare>::Anchor *
+ConcurrentAVLTree<T, Compare>::rotateRight(Anchor *parent, Node *node,
+                                           Node *left, int rightHeight,
+                                           int leftLeftHeight, Node *leftRight,
+                                           int leftRightHeight) noexcept {
+    beginShrink(node);
+    node->left.store(leftRight, std::memory_order_release);
+    if (leftRight != nullptr) {
+        leftRight->parent.store(node, std::memory_order_release);
+    }
+    left->right.store(node, std::memory_order_release);
+    node->parent.store(left, std::memory_order_release);
+    replaceChild(parent, node, left);
+    left->parent.store(parent, std::memory_order_release);
+
+    const int nodeHeight = 1 + std::max(leftRightHeight, rightHeight);
+    node->height.store(nodeHeight, std::memory_order_relaxed);
+    left->height.store(1 + std::max(leftLeftHeight, nodeHeight),
+                       std::memory_order_relaxed);
+    endShrink(node);
+
+    const int nodeBalance = leftRightHeight - rightHeight;
+    if (nodeBalance < -1 || nodeBalance > 1 ||
+        ((leftRight == nullptr || rightHeight == 0) &&
+         !node->present.load(std::memory_order_relaxed))) {
+        return node;
+    }
+    const int leftBalance = leftLeftHeight - nodeHeight;
+    if (leftBalance < -1 || leftBalance > 1 ||
+        (leftLeftHeight == 0 &&
+         !left->present.load(std::memory_order_relaxed))) {
+        return left;
+    }
+    return fixHeight(parent);
+}
+
+template <typename T, typename Compare>
+typename ConcurrentAVLTree<T, Compare>::Anchor *
+ConcurrentAVLTree<T, Compare>::rotateLeft(Anchor *parent, Node *node,
+                                          int leftHeight, Node *right,
+                                          Node *rightLeft, int rightLeftHeight,
+                                          int rightRightHeight) noexcept {
+    beginShrink(node);
+    node->right.store(rightLeft, std::memory_order_release);
+    if (rightLeft != nullptr) {
+        rightLeft->parent.store(node, std::memory_order_release);
+    }
+    right->left.store(node, std::memory_order_release);
+    node->parent.store(right, std::memory_order_release);
+    replaceChild(parent, node, right);
+    right->parent.store(parent, std::memory_order_release);
+
+    const int nodeHeight = 1 + std::max(leftHeight, rightLeftHeight);
+    node->height.store(nodeHeight, std::memory_order_relaxed);
+    right->height.store(1 + std::max(nodeHeight, rightRightHeight),
+                        std::memory_order_relaxed);
+    endShrink(node);
+
+    const int nodeBalance = rightLeftHeight - leftHeight;
+    if (nodeBalance < -1 || nodeBalance > 1 ||
+        ((rightLeft == nullptr || leftHeight == 0) &&
+         !node->present.load(std::memory_order_relaxed))) {
+        return node;
+    }
+    const int rightBalance = rightRightHeight - nodeHeight;
+    if (rightBalance < -1 || rightBalance > 1 ||
+        (rightRightHeight == 0 &&
+         !right->present.load(std::memory_order_relaxed))) {
+        return right;
+    }
+    return fixHeight(parent);
+}
+
+template <typename T, typename Compare>
+typename ConcurrentAVLTree<T, Compare>::Anchor *
+ConcurrentAVLTree<T, Compare>::rotateRightOverLeft(
+    Anchor *parent, Node *node, Node *left, int rightHeight,
+    int leftLeftHeight, Node *leftRight, int leftRightLeftHeight) noexcept {
+    Node *innerLeft = leftRight->left.load(std::memory_order_relaxed);
+    Node *innerRight = leftRight->right.load(std::memory_order_relaxed);
+    const int innerRightHeight = height(innerRight);
+
+    beginShrink(node);
+    beginShrink(left);
+    node->left.store(innerRight, std::memory_order_release);
+    if (innerRight != nullptr) {
+        innerRight->parent.store(node, std::memory_order_release);
+    }
+    left->right.store(innerLeft, std::memory_order_release);
+    if (innerLeft != nullptr) {
+        innerLeft->parent.store(left, std::memory_order_release);
+    }
+    leftRight->left.store(left, std::memory_order_release);
+    left->parent.store(leftRight, std::memory_order_release);
+    leftRight->right.store(node, std::memory_order_release);
+    node->parent.store(leftRight, std::memory_order_release);
+    replaceChild(parent, node, leftRight);
+    leftRight->parent.store(parent, std::memory_order_release);
+
+    const int nodeHeight = 1 + std::max(innerRightHeight, rightHeight);
+    node->height.store(nodeHeight, std::memory_order_relaxed);
+    int leftNewHeight = 1 + std::max(leftLeftHeight, leftRightLeftHeight);
+    left->height.store(leftNewHeight, std::memory_order_relaxed);
+    endShrink(node);
+    endShrink(left);
+    // A routing node that moved down without its second child is unlinked
+    // right away, it is not on the way up from node
+    if (!left->present.load(std::memory_order_relaxed) &&
+        (innerLeft == nullptr ||
+         left->left.load(std::memory_order_relaxed) == nullptr) &&
+        attemptUnlink(leftRight, left)) {
+        leftNewHeight = std::max(leftLeftHeight, leftRightLeftHeight);
+    }
+    leftRight->height.store(1 + std::max(leftNewHeight, nodeHeight),
+                            std::memory_order_relaxed);
+
+    const int nodeBalance = innerRightHeight - rightHeight;
+    if (nodeBalance < -1 || nodeBalance > 1 ||
+        ((innerRight == nullptr || rightHeight == 0) &&
+         !node->present.load(std::memory_order_relaxed))) {
+        return node;
+    }
+    const int innerBalance = leftNewHeight - nodeHeight;
+    if (innerBalance < -1 || innerBalance > 1) {
+        return leftRight;
+    }
+    return fixHeight(parent);
+}
+
+template <typename T, typename Compare>
+typename ConcurrentAVLTree<T, Compare>::Anchor *
+ConcurrentAVLTree<T, Compare>::rotateLeftOverRight(
+    Anchor *parent, Node *node, int leftHeight, Node *right, Node *rightLeft,
+    int rightRightHeight, int rightLeftRightHeight) noexcept {
+    Node *innerLeft = rightLeft->left.load(std::memory_order_relaxed);
+    Node *innerRight = rightLeft->right.load(std::memory_order_relaxed);
+    const int innerLeftHeight = height(innerLeft);
+
+    beginShrink(node);
+    beginShrink(right);
+    node->right.store(innerLeft, std::memory_order_release);
+    if (innerLeft != nullptr) {
+        innerLeft->parent.store(node, std::memory_order_release);
+    }
+    right->left.store(innerRight, std::memory_order_release);
+    if (innerRight != nullptr) {
+        innerRight->parent.store(right, std::memory_order_release);
+    }
+    rightLeft->right.store(right, std::memory_order_release);
+    right->parent.store(rightLeft, std::memory_order_release);
+    rightLeft->left.store(node, std::memory_order_release);
+    node->parent.store(rightLeft, std::memory_order_release);
+    replaceChild(parent, node, rightLeft);
+    rightLeft->parent.store(parent, std::memory_order_release);
+
+    const int nodeHeight = 1 + std::max(leftHeight, innerLeftHeight);
+    node->height.store(nodeHeight, std::memory_order_relaxed);
+    int rightNewHeight = 1 + std::max(rightLeftRightHeight, rightRightHeight);
+    right->height.store(rightNewHeight, std::memory_order_relaxed);
+    endShrink(node);
+    endShrink(right);
+    if (!right->present.load(std::memory_order_relaxed) &&
+        (innerRight == nullptr ||
+         right->right.load(std::memory_order_relaxed) == nullptr) &&
+        attemptUnlink(rightLeft, right)) {
+        rightNewHeight = std::max(rightLeftRightHeight, rightRightHeight);
+    }
+    rightLeft->height.store(1 + std::max(nodeHeight, rightNewHeight),
+                            std::memory_order_relaxed);
+
+    const int nodeBalance = innerLeftHeight - leftHeight;
+    if (nodeBalance < -1 || nodeBalance > 1 ||
+        ((innerLeft == nullptr || leftHeight == 0) &&
+         !node->present.load(std::memory_order_relaxed))) {
+        return node;
+    }
+    const int innerBalance = rightNewHeight - nodeHeight;
+    if (innerBalance < -1 || innerBalance > 1) {
+        return rightLeft;
+    }
+    return fixHeight(parent);
+}
+
+template <typename T, typename Compare>
+void ConcurrentAVLTree<T, Compare>::replaceChild(Anchor *parent, Node *child,
+                                                 Node *replacement) noexcept {
+    if (parent->left.load(std::memory_order_relaxed) == child) {
+        parent->left.store(replacement, std::memory_order_release);
+    } else {
+        parent->right.store(replacement, std::memory_order_release);
+    }
+}
+
+// The version stores order the pointer changes in between: a reader that
+// sees any of them also sees the node shrinking or shrunk
+template <typename T, typename Compare>
+void ConcurrentAVLTree<T, Compare>::beginShrink(Node *node) noexcept {
+    node->version.store(
+        node->version.load(std::memory_order_relaxed) | VERSION_SHRINKING,
+        std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+template <typename T, typename Compare>
+void ConcurrentAVLTree<T, Compare>::endShrink(Node *node) noexcept {
+    const uint64_t version = node->version.load(std::memory_order_relaxed);
+    node->version.store((version & ~VERSION_SHRINKING) + VERSION_STEP,
+                        std::memory_order_release);
+}
+
+template <typename T, typename Compare>
+void ConcurrentAVLTree<T, Compare>::destroyNode(Node *node) noexcept {
+    delete node;
+}
+
+template <typename T, typename Compare>
+void ConcurrentAVLTree<T, Compare>::destroyTree(Node *node) noexcept {
+    if (node == nullptr) {
+        return;
+    }
+    destroyTree(node->left.load(std::memory_order_relaxed));
+    destroyTree(node->right.load(std::memory_order_relaxed));
+    destroyNode(node);
+}
+
+template <typename T, typename Compare>
+bool ConcurrentAVLTree<T, Compare>::isChanging(uint64_t version) noexcept {
+    return (version & (VERSION_SHRINKING | VERSION_UNLINKED)) != 0;
+}
+
+template <typename T, typename Compare>
+bool ConcurrentAVLTree<T, Compare>::isUnlinked(const Anchor *node) noexcept {
+    return node->version.load(std::memory_order_relaxed) == VERSION_UNLINKED;
+}
+
+template <typename T, typename Compare>
+int ConcurrentAVLTree<T, Compare>::height(const Node *node) noexcept {
+    return node != nullptr ? node->height.load(std::memory_order_relaxed) : 0;
+}
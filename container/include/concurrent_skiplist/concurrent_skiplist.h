@@ -0,0 +1,194 @@
+#pragma once
+
+#include "concurrency/epoch.h"
+#include "concurrency/retired_list.h"
+#include "container.h"
+#include "skiplist/random_level.h"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <new>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+/**
+ * Levels a ConcurrentSkipList node can have at most, enough for 2^32
+ * values.
+ */
+constexpr int CONCURRENT_SKIPLIST_MAX_LEVEL = 32;
+
+/**
+ * Retired nodes a ConcurrentSkipList collects before it tries to free them.
+ */
+constexpr std::size_t CONCURRENT_SKIPLIST_RECLAIM_BATCH = 128;
+
+/**
+ * Skip list that can be read and written from many threads at once, without
+ * any locks.
+ *
+ * This is the lock free skip list of Fraser ("Practical lock-freedom") in
+ * the form Herlihy and Shavit give it. Every forward pointer is updated with
+ * compare and swap. Removing a value first marks the forward pointers of its
+ * node, from the top level down, which freezes them. The thread whose mark
+ * lands on the lowest level has removed the value. Any thread that walks
+ * past a marked node unlinks it on the way. A value is in the list while its
+ * node is linked on the lowest level and not marked there, the upper levels
+ * only speed up the search.
+ *
+ * Lookups never write. Unlinked nodes are only freed once no thread can
+ * hold them any more, see EpochDomain. A node is retired after it was
+ * unlinked from every level and its inserter stopped linking it in.
+ *
+ * Every thread draws the levels of its nodes from its own generator.
+ *
+ * search, min and max return a copy of the value, as a concurrent remove may
+ * free the node right after the lookup. That makes the list a
+ * ConcurrentDontainer rather than a Dontainer.
+ */
+template <typename T, typename Compare = std::less<T>>
+class ConcurrentSkipList {
+  public:
+    ConcurrentSkipList() = default;
+    ConcurrentSkipList(const ConcurrentSkipList &) = delete;
+    ConcurrentSkipList(ConcurrentSkipList &&) = delete;
+    ConcurrentSkipList &operator=(const ConcurrentSkipList &) = delete;
+    ConcurrentSkipList &operator=(ConcurrentSkipList &&) = delete;
+    /**
+     * No other thread may use the list any more.
+     */
+    ~ConcurrentSkipList();
+
+    // modifiers
+    /**
+     * Inserts the value, returns false if an equivalent value already
+     * existed.
+     */
+    bool insert(const T &value);
+    bool insert(T &&value);
+    /**
+     * Removes an equivalent value, returns false if there was none.
+     */
+    bool remove(const T &value);
+    template <typename K>
+        requires LookupKey<K, T, Compare>
+    bool remove(const K &key);
+    /**
+     * Removes every value, one after the other. Values inserted while it
+     * runs may stay.
+     */
+    void clear();
+
+    // access
+    /**
+     * Search for a value, returns a copy of it or nothing if not found.
+     * Never blocks.
+     */
+    [[nodiscard]] std::optional<T> search(const T &value) const;
+    template <typename K>
+        requires LookupKey<K, T, Compare>
+    [[nodiscard]] std::optional<T> search(const K &key) const;
+    /**
+     * Returns a copy of the max value, or nothing if the list is empty.
+     */
+    [[nodiscard]] std::optional<T> max() const;
+    /**
+     * Returns a copy of the min value, or nothing if the list is empty.
+     */
+    [[nodiscard]] std::optional<T> min() const;
+    /**
+     * Check if the list contains a value. Never blocks.
+     */
+    [[nodiscard]] bool contains(const T &value) const;
+    template <typename K>
+        requires LookupKey<K, T, Compare>
+    [[nodiscard]] bool contains(const K &key) const;
+
+    // info
+    [[nodiscard]] std::size_t size() const noexcept;
+    [[nodiscard]] bool empty() const noexcept;
+
+  private:
+    struct Node;
+
+    /**
+     * A forward pointer, the lowest bit marks the node it belongs to as
+     * removed on that level.
+     */
+    using Link = std::atomic<uintptr_t>;
+    static constexpr uintptr_t MARK = 1;
+
+    /**
+     * Who is done with a node. It is retired by whichever of its inserter
+     * and its remover finishes last.
+     */
+    static constexpr uint8_t NODE_LINKED = 1;
+    static constexpr uint8_t NODE_REMOVED = 2;
+
+    // A node and its forward pointers are a single allocation, the pointers
+    // follow the node, one for every level
+    struct Node : Retirable<Node> {
+        T value;
+        int level;
+        std::atomic<uint8_t> done{0};
+
+        template <typename... Args>
+        explicit Node(int level, Args &&...args)
+            : value(std::forward<Args>(args)...), level(level) {}
+
+        Link *forward() noexcept;
+    };
+
+    static constexpr std::size_t TOWER_OFFSET =
+        (sizeof(Node) + alignof(Link) - 1) / alignof(Link) * alignof(Link);
+    static constexpr std::align_val_t NODE_ALIGNMENT{
+        std::max(alignof(Node), alignof(Link))};
+
+    [[nodiscard]] static Node *pointer(uintptr_t link) noexcept;
+    [[nodiscard]] static bool marked(uintptr_t link) noexcept;
+
+    template <typename... Args>
+    static Node *createNode(int level, Args &&...args);
+    static void destroyNode(Node *node) noexcept;
+    // level of a new node, drawn from a generator of the calling thread
+    [[nodiscard]] static int randomLevel();
+
+    template <typename V> bool insertValue(V &&value);
+    /**
+     * Fill preds and succs with the neighbours of key on every level,
+     * unlinking the marked nodes on the way. Returns whether succs[0] holds
+     * an equivalent value. The caller has to be pinned.
+     */
+    template <typename K> bool find(const K &key, Node **preds, Node **succs);
+    // lock free lookup without writes, the caller has to be pinned
+    template <typename K> [[nodiscard]] Node *findNode(const K &key) const;
+    // the first node not marked on the lowest level after node, nullptr for
+    // the head
+    [[nodiscard]] Node *firstAfter(Node *node) const noexcept;
+    // forward pointers of a node, or of the head for nullptr
+    [[nodiscard]] Link *forward(Node *node) const noexcept;
+    // link a node that is already on the lowest level into the levels above
+    void linkUpperLevels(Node *node, Node **preds, Node **succs);
+    /**
+     * Unlinks a node from every level once both its inserter and its
+     * remover set their flag in done, and retires it.
+     */
+    void finish(Node *node, uint8_t flag);
+
+    mutable Link head[CONCURRENT_SKIPLIST_MAX_LEVEL] = {};
+    // levels that may hold nodes, only ever grows
+    std::atomic<int> levels{1};
+    std::atomic<std::size_t> count{0};
+    RetiredList<Node, &destroyNode, CONCURRENT_SKIPLIST_RECLAIM_BATCH> retired;
+    Compare comp;
+};
+
+#include "concurrent_skiplist/concurrent_skiplist.hpp"
+
+static_assert(ConcurrentDontainer<ConcurrentSkipList<int>, int>);
+static_assert(
+    TransparentDontainer<ConcurrentSkipList<std::string, std::less<>>,
+                         std::string, std::string_view>);
@@ -0,0 +1,403 @@
+#pragma once
+
+#include "concurrent_skiplist/concurrent_skiplist.h"
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <optional>
+#include <random>
+#include <utility>
+
+template <typename T, typename Compare>
+ConcurrentSkipList<T, Compare>::~ConcurrentSkipList() {
+    Node *node = pointer(head[0].load(std::memory_order_relaxed));
+    while (node != nullptr) {
+        Node *next =
+            pointer(node->forward()[0].load(std::memory_order_relaxed));
+        destroyNode(node);
+        node = next;
+    }
+}
+
+template <typename T, typename Compare>
+bool ConcurrentSkipList<T, Compare>::insert(const T &value) {
+    return insertValue(value);
+}
+
+template <typename T, typename Compare>
+bool ConcurrentSkipList<T, Compare>::insert(T &&value) {
+    return insertValue(std::move(value));
+}
+
+// The value is in the list as soon as its node is linked on the lowest
+// level, the levels above follow one by one. The node is built only once a
+// first search found no equivalent value, and reused if linking it fails.
+template <typename T, typename Compare>
+template <typename V>
+bool ConcurrentSkipList<T, Compare>::insertValue(V &&value) {
+    const int level = randomLevel();
+    int top = levels.load(std::memory_order_relaxed);
+    while (top < level &&
+           !levels.compare_exchange_weak(top, level, std::memory_order_acq_rel,
+                                         std::memory_order_relaxed)) {
+    }
+
+    EpochDomain::Guard guard = EpochDomain::global().pin();
+    Node *preds[CONCURRENT_SKIPLIST_MAX_LEVEL];
+    Node *succs[CONCURRENT_SKIPLIST_MAX_LEVEL];
+    Node *node = nullptr;
+    while (true) {
+        const bool found = node == nullptr ? find(value, preds, succs)
+                                           : find(node->value, preds, succs);
+        if (found) {
+            if (node != nullptr) {
+                destroyNode(node);
+            }
+            return false;
+        }
+        if (node == nullptr) {
+            node = createNode(level, std::forward<V>(value));
+        }
+
+        Link *tower = node->forward();
+        for (int i = 0; i < level; ++i) {
+            tower[i].store(reinterpret_cast<uintptr_t>(succs[i]),
+                           std::memory_order_relaxed);
+        }
+        uintptr_t expected = reinterpret_cast<uintptr_t>(succs[0]);
+        if (forward(preds[0])[0].compare_exchange_strong(
+                expected, reinterpret_cast<uintptr_t>(node),
+                std::memory_order_release, std::memory_order_relaxed)) {
+            break;
+        }
+    }
+
+    count.fetch_add(1, std::memory_order_relaxed);
+    linkUpperLevels(node, preds, succs);
+    finish(node, NODE_LINKED);
+    return true;
+}
+
+// Only a remover changes a forward pointer of the node before the node is
+// linked on that level, by marking it. Linking stops there, or once the node
+// has left the lowest level again.
+template <typename T, typename Compare>
+void ConcurrentSkipList<T, Compare>::linkUpperLevels(Node *node, Node **preds,
+                                                     Node **succs) {
+    Link *tower = node->forward();
+    for (int i = 1; i < node->level; ++i) {
+        while (true) {
+            uintptr_t next = tower[i].load(std::memory_order_acquire);
+            const auto succ = reinterpret_cast<uintptr_t>(succs[i]);
+            if (marked(next) ||
+                (next != succ && !tower[i].compare_exchange_strong(
+                                     next, succ, std::memory_order_acq_rel,
+                                     std::memory_order_acquire))) {
+                return;
+            }
+
+            uintptr_t expected = succ;
+            if (forward(preds[i])[i].compare_exchange_strong(
+                    expected, reinterpret_cast<uintptr_t>(node),
+                    std::memory_order_release, std::memory_order_relaxed)) {
+                break;
+            }
+            find(node->value, preds, succs);
+            if (succs[0] != node) {
+                return;
+            }
+        }
+    }
+}
+
+template <typename T, typename Compare>
+bool ConcurrentSkipList<T, Compare>::remove(const T &value) {
+    return remove<T>(value);
+}
+
+// Marking the lowest level is what removes the value, the marks above only
+// keep the node from being linked in any further
+template <typename T, typename Compare>
+template <typename K>
+    requires LookupKey<K, T, Compare>
+bool ConcurrentSkipList<T, Compare>::remove(const K &key) {
+    EpochDomain::Guard guard = EpochDomain::global().pin();
+    Node *preds[CONCURRENT_SKIPLIST_MAX_LEVEL];
+    Node *succs[CONCURRENT_SKIPLIST_MAX_LEVEL];
+    if (!find(key, preds, succs)) {
+        return false;
+    }
+
+    Node *node = succs[0];
+    Link *tower = node->forward();
+    for (int i = node->level - 1; i > 0; --i) {
+        uintptr_t next = tower[i].load(std::memory_order_relaxed);
+        while (!marked(next) &&
+               !tower[i].compare_exchange_weak(next, next | MARK,
+                                               std::memory_order_acq_rel,
+                                               std::memory_order_relaxed)) {
+        }
+    }
+
+    uintptr_t next = tower[0].load(std::memory_order_relaxed);
+    do {
+        if (marked(next)) {
+            // another thread removed it first
+            return false;
+        }
+    } while (!tower[0].compare_exchange_weak(next, next | MARK,
+                                             std::memory_order_acq_rel,
+                                             std::memory_order_relaxed));
+
+    count.fetch_sub(1, std::memory_order_relaxed);
+    finish(node, NODE_REMOVED);
+    return true;
+}
+
+// Every round pins on its own, so the nodes removed so far can be freed
+template <typename T, typename Compare>
+void ConcurrentSkipList<T, Compare>::clear() {
+    while (true) {
+        EpochDomain::Guard guard = EpochDomain::global().pin();
+        Node *first = firstAfter(nullptr);
+        if (first == nullptr) {
+            return;
+        }
+        remove(first->value);
+    }
+}
+
+template <typename T, typename Compare>
+std::optional<T> ConcurrentSkipList<T, Compare>::search(const T &value) const {
+    return search<T>(value);
+}
+
+// The copy is made while still pinned
+template <typename T, typename Compare>
+template <typename K>
+    requires LookupKey<K, T, Compare>
+std::optional<T> ConcurrentSkipList<T, Compare>::search(const K &key) const {
+    EpochDomain::Guard guard = EpochDomain::global().pin();
+    Node *node = findNode(key);
+    if (node == nullptr) {
+        return std::nullopt;
+    }
+    return node->value;
+}
+
+// Go as far right as possible on every level, the last node that was not
+// marked on the lowest level holds the max
+template <typename T, typename Compare>
+std::optional<T> ConcurrentSkipList<T, Compare>::max() const {
+    EpochDomain::Guard guard = EpochDomain::global().pin();
+    Node *pred = nullptr;
+    for (int level = levels.load(std::memory_order_acquire) - 1; level >= 0;
+         --level) {
+        Node *curr =
+            pointer(forward(pred)[level].load(std::memory_order_acquire));
+        while (curr != nullptr) {
+            const uintptr_t next =
+                curr->forward()[level].load(std::memory_order_acquire);
+            if (!marked(next)) {
+                pred = curr;
+            }
+            curr = pointer(next);
+        }
+    }
+    if (pred == nullptr) {
+        return std::nullopt;
+    }
+    return pred->value;
+}
+
+template <typename T, typename Compare>
+std::optional<T> ConcurrentSkipList<T, Compare>::min() const {
+    EpochDomain::Guard guard = EpochDomain::global().pin();
+    Node *first = firstAfter(nullptr);
+    if (first == nullptr) {
+        return std::nullopt;
+    }
+    return first->value;
+}
+
+template <typename T, typename Compare>
+bool ConcurrentSkipList<T, Compare>::contains(const T &value) const {
+    return contains<T>(value);
+}
+
+template <typename T, typename Compare>
+template <typename K>
+    requires LookupKey<K, T, Compare>
+bool ConcurrentSkipList<T, Compare>::contains(const K &key) const {
+    EpochDomain::Guard guard = EpochDomain::global().pin();
+    return findNode(key) != nullptr;
+}
+
+template <typename T, typename Compare>
+std::size_t ConcurrentSkipList<T, Compare>::size() const noexcept {
+    return count.load(std::memory_order_relaxed);
+}
+
+template <typename T, typename Compare>
+bool ConcurrentSkipList<T, Compare>::empty() const noexcept {
+    return size() == 0;
+}
+
+template <typename T, typename Compare>
+typename ConcurrentSkipList<T, Compare>::Link *
+ConcurrentSkipList<T, Compare>::Node::forward() noexcept {
+    return std::launder(reinterpret_cast<Link *>(
+        reinterpret_cast<std::byte *>(this) + TOWER_OFFSET));
+}
+
+template <typename T, typename Compare>
+typename ConcurrentSkipList<T, Compare>::Node *
+ConcurrentSkipList<T, Compare>::pointer(uintptr_t link) noexcept {
+    return reinterpret_cast<Node *>(link & ~MARK);
+}
+
+template <typename T, typename Compare>
+bool ConcurrentSkipList<T, Compare>::marked(uintptr_t link) noexcept {
+    return (link & MARK) != 0;
+}
+
+template <typename T, typename Compare>
+template <typename... Args>
+typename ConcurrentSkipList<T, Compare>::Node *
+ConcurrentSkipList<T, Compare>::createNode(int level, Args &&...args) {
+    void *memory =
+        ::operator new(TOWER_OFFSET + level * sizeof(Link), NODE_ALIGNMENT);
+    Node *node = nullptr;
+    try {
+        node = new (memory) Node(level, std::forward<Args>(args)...);
+    } catch (...) {
+        ::operator delete(memory, NODE_ALIGNMENT);
+        throw;
+    }
+    std::uninitialized_value_construct_n(
+        reinterpret_cast<Link *>(static_cast<std::byte *>(memory) +
+                                 TOWER_OFFSET),
+        level);
+    return node;
+}
+
+// the forward pointers are trivially destructible
+template <typename T, typename Compare>
+void ConcurrentSkipList<T, Compare>::destroyNode(Node *node) noexcept {
+    node->~Node();
+    ::operator delete(node, NODE_ALIGNMENT);
+}
+
+template <typename T, typename Compare>
+int ConcurrentSkipList<T, Compare>::randomLevel() {
+    thread_local std::mt19937 gen{std::random_device{}()};
+    return geometricLevel(gen, CONCURRENT_SKIPLIST_MAX_LEVEL);
+}
+
+// A failed unlink means the predecessor changed or was marked itself, the
+// search then starts over from the head
+template <typename T, typename Compare>
+template <typename K>
+bool ConcurrentSkipList<T, Compare>::find(const K &key, Node **preds,
+                                          Node **succs) {
+    while (true) {
+        Node *pred = nullptr;
+        bool restart = false;
+        for (int level = levels.load(std::memory_order_acquire) - 1;
+             level >= 0 && !restart; --level) {
+            Node *curr =
+                pointer(forward(pred)[level].load(std::memory_order_acquire));
+            while (curr != nullptr) {
+                const uintptr_t next =
+                    curr->forward()[level].load(std::memory_order_acquire);
+                if (marked(next)) {
+                    auto expected = reinterpret_cast<uintptr_t>(curr);
+                    if (!forward(pred)[level].compare_exchange_strong(
+                            expected, next & ~MARK, std::memory_order_acq_rel,
+                            std::memory_order_acquire)) {
+                        restart = true;
+                        break;
+                    }
+                    curr = pointer(next);
+                    continue;
+                }
+                if (!comp(curr->value, key)) {
+                    break;
+                }
+                pred = curr;
+                curr = pointer(next);
+            }
+            preds[level] = pred;
+            succs[level] = curr;
+        }
+        if (!restart) {
+            return succs[0] != nullptr && !comp(key, succs[0]->value);
+        }
+    }
+}
+
+// Marked nodes are stepped over but never descended from. Whatever a marked
+// node points to was still linked when this search passed the last unmarked
+// node before it, so it cannot have been freed under the pin.
+template <typename T, typename Compare>
+template <typename K>
+typename ConcurrentSkipList<T, Compare>::Node *
+ConcurrentSkipList<T, Compare>::findNode(const K &key) const {
+    Node *pred = nullptr;
+    Node *curr = nullptr;
+    for (int level = levels.load(std::memory_order_acquire) - 1; level >= 0;
+         --level) {
+        curr = pointer(forward(pred)[level].load(std::memory_order_acquire));
+        while (curr != nullptr) {
+            const uintptr_t next =
+                curr->forward()[level].load(std::memory_order_acquire);
+            if (marked(next)) {
+                curr = pointer(next);
+                continue;
+            }
+            if (!comp(curr->value, key)) {
+                break;
+            }
+            pred = curr;
+            curr = pointer(next);
+        }
+    }
+    return curr != nullptr && !comp(key, curr->value) ? curr : nullptr;
+}
+
+template <typename T, typename Compare>
+typename ConcurrentSkipList<T, Compare>::Node *
+ConcurrentSkipList<T, Compare>::firstAfter(Node *node) const noexcept {
+    Node *curr = pointer(forward(node)[0].load(std::memory_order_acquire));
+    while (curr != nullptr) {
+        const uintptr_t next =
+            curr->forward()[0].load(std::memory_order_acquire);
+        if (!marked(next)) {
+            return curr;
+        }
+        curr = pointer(next);
+    }
+    return nullptr;
+}
+
+template <typename T, typename Compare>
+typename ConcurrentSkipList<T, Compare>::Link *
+ConcurrentSkipList<T, Compare>::forward(Node *node) const noexcept {
+    return node != nullptr ? node->forward() : head;
+}
+
+// A node marked while its inserter was still linking it in may have been
+// linked on a level after the remover's search passed. Once both are done a
+// last search unlinks it from wherever it still is: every level is marked,
+// and a search for its value passes it on every level it is linked on.
+template <typename T, typename Compare>
+void ConcurrentSkipList<T, Compare>::finish(Node *node, uint8_t flag) {
+    if (node->done.fetch_or(flag, std::memory_order_acq_rel) == 0) {
+        return;
+    }
+    Node *preds[CONCURRENT_SKIPLIST_MAX_LEVEL];
+    Node *succs[CONCURRENT_SKIPLIST_MAX_LEVEL];
+    find(node->value, preds, succs);
+    retired.retire(node);
+}
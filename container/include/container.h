@@ -2,6 +2,24 @@
 
 #include <concepts>
 #include <cstddef>
+#include <iterator>
+#include <optional>
+#include <ranges>
+#include <utility>
+
+/**
+ * A key of type K can be used to look up values of type T if it is T itself,
+ * or if the comparator is transparent (declares is_transparent, like
+ * std::less<>) and can compare K against T in both directions.
+ */
+template <typename K, typename T, typename Compare>
+concept LookupKey =
+    std::same_as<K, T> ||
+    (requires { typename Compare::is_transparent; } &&
+     requires(const Compare &comp, const K &key, const T &value) {
+         { comp(key, value) } -> std::convertible_to<bool>;
+         { comp(value, key) } -> std::convertible_to<bool>;
+     });
 
 template <typename C, typename T>
 concept Dontainer = std::default_initializable<C> &&
@@ -23,3 +41,65 @@ concept Dontainer = std::default_initializable<C> &&
                         { container.size() } -> std::same_as<std::size_t>;
                         { container.empty() } -> std::same_as<bool>;
                     };
+
+/**
+ * A Dontainer whose search, min and max return copies of the values. For
+ * containers that other threads modify at the same time, where a pointer
+ * into the container could dangle before the caller reads it.
+ */
+template <typename C, typename T>
+concept ConcurrentDontainer =
+    std::default_initializable<C> &&
+    requires(C container, T value, const T &const_value) {
+        // modifiers
+        { container.insert(value) } -> std::same_as<bool>;
+        { container.remove(const_value) } -> std::same_as<bool>;
+        { container.clear() } -> std::same_as<void>;
+
+        // access
+        { container.search(const_value) } -> std::same_as<std::optional<T>>;
+        { container.max() } -> std::same_as<std::optional<T>>;
+        { container.min() } -> std::same_as<std::optional<T>>;
+
+        // info
+        { container.contains(const_value) } -> std::same_as<bool>;
+        { container.size() } -> std::same_as<std::size_t>;
+        { container.empty() } -> std::same_as<bool>;
+    };
+
+/**
+ * A Dontainer or ConcurrentDontainer that can also be queried and modified
+ * with keys of another type K, without converting them to T first. Searching
+ * for a key returns the same type as searching for a value.
+ */
+template <typename C, typename T, typename K>
+concept TransparentDontainer =
+    (Dontainer<C, T> || ConcurrentDontainer<C, T>) &&
+    requires(C container, const K &key, const T &value) {
+        {
+            container.search(key)
+        } -> std::same_as<decltype(container.search(value))>;
+        { container.contains(key) } -> std::same_as<bool>;
+        { container.remove(key) } -> std::same_as<bool>;
+    };
+
+/**
+ * A Dontainer that can be iterated in order and answer range queries in
+ * O(log n + k). forEachInRange visits the values in [lo, hi).
+ */
+template <typename C, typename T>
+concept RangeDontainer =
+    Dontainer<C, T> && std::ranges::forward_range<C> &&
+    requires(const C container, const T &value, void (*visit)(const T &)) {
+        {
+            container.lower_bound(value)
+        } -> std::same_as<std::ranges::iterator_t<C>>;
+        {
+            container.upper_bound(value)
+        } -> std::same_as<std::ranges::iterator_t<C>>;
+        {
+            container.equal_range(value)
+        } -> std::same_as<std::pair<std::ranges::iterator_t<C>,
+                                    std::ranges::iterator_t<C>>>;
+        { container.forEachInRange(value, value, visit) };
+    };
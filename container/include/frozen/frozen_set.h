@@ -0,0 +1,153 @@
+#pragma once
+
+#include "container.h"
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <utility>
+
+/**
+ * Alignment of the key array of a FrozenSet. The first levels of the
+ * implicit tree then share a cache line and every prefetch pulls in a whole
+ * line of descendants.
+ */
+constexpr std::size_t FROZEN_SET_ALIGNMENT = 64;
+
+/**
+ * Immutable ordered set for read heavy phases, see AVLTree::freeze.
+ *
+ * The values are laid out in Eytzinger order: one array holding the implicit
+ * complete tree level by level, the children of slot k in slots 2k and
+ * 2k + 1. A lookup walks down with a comparison turned into an index
+ * instead of a branch, and prefetches the cache line holding the
+ * descendants a few levels below while it compares (four for int), so the
+ * search is bound by memory bandwidth rather than by the latency of
+ * dependent loads.
+ *
+ * The set cannot be changed after construction, lookups return const
+ * values.
+ */
+template <typename T, typename Compare = std::less<T>> class FrozenSet {
+  public:
+    FrozenSet() = default;
+    /**
+     * Builds the set from a strictly increasing range in O(n).
+     */
+    template <std::input_iterator InputIt, std::sentinel_for<InputIt> Sentinel>
+    FrozenSet(InputIt first, Sentinel last, Compare comp = Compare());
+    FrozenSet(const FrozenSet &) = delete;
+    FrozenSet(FrozenSet &&other) noexcept;
+    FrozenSet &operator=(const FrozenSet &) = delete;
+    FrozenSet &operator=(FrozenSet &&other) noexcept;
+    ~FrozenSet() { clear(); }
+
+    // iterator
+    /**
+     * In-order iterator, steps through the implicit tree by index.
+     */
+    class Iterator {
+      public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = T;
+        using pointer = const T *;
+        using reference = const T &;
+
+        Iterator() = default;
+
+        reference operator*() const;
+        pointer operator->() const;
+
+        Iterator &operator++();
+        Iterator operator++(int);
+        Iterator &operator--();
+        Iterator operator--(int);
+        bool operator==(const Iterator &other) const;
+        bool operator!=(const Iterator &other) const;
+
+      private:
+        friend class FrozenSet;
+
+        Iterator(const FrozenSet *set, std::size_t slot)
+            : set(set), slot(slot) {}
+
+        const FrozenSet *set = nullptr;
+        // slot 0 is end()
+        std::size_t slot = 0;
+    };
+
+    [[nodiscard]] Iterator begin() const;
+    [[nodiscard]] Iterator end() const;
+
+    void swap(FrozenSet &other) noexcept;
+    friend void swap(FrozenSet &lhs, FrozenSet &rhs) noexcept {
+        lhs.swap(rhs);
+    }
+
+    // access
+    /**
+     * Search for a value, returns nullptr if not found.
+     */
+    [[nodiscard]] const T *search(const T &value) const noexcept;
+    template <typename K>
+        requires LookupKey<K, T, Compare>
+    [[nodiscard]] const T *search(const K &key) const noexcept;
+    [[nodiscard]] bool contains(const T &value) const noexcept;
+    template <typename K>
+        requires LookupKey<K, T, Compare>
+    [[nodiscard]] bool contains(const K &key) const noexcept;
+
+    // range queries
+    /**
+     * Returns an iterator to the first value not smaller than value, or end().
+     */
+    [[nodiscard]] Iterator lower_bound(const T &value) const noexcept;
+    /**
+     * Returns an iterator to the first value greater than value, or end().
+     */
+    [[nodiscard]] Iterator upper_bound(const T &value) const noexcept;
+    template <typename K>
+        requires LookupKey<K, T, Compare>
+    [[nodiscard]] Iterator lower_bound(const K &key) const noexcept;
+    template <typename K>
+        requires LookupKey<K, T, Compare>
+    [[nodiscard]] Iterator upper_bound(const K &key) const noexcept;
+
+    // info
+    [[nodiscard]] std::size_t size() const noexcept;
+    [[nodiscard]] bool empty() const noexcept;
+
+  private:
+    /**
+     * Slots ahead of the current one whose cache line gets prefetched. The
+     * line at slot k * PREFETCH_STRIDE holds the descendants of k a few
+     * levels down.
+     */
+    static constexpr std::size_t PREFETCH_STRIDE =
+        std::max<std::size_t>(FROZEN_SET_ALIGNMENT / sizeof(T), 1);
+    static constexpr std::size_t ALIGNMENT =
+        std::max(FROZEN_SET_ALIGNMENT, alignof(T));
+
+    /**
+     * Walks down the implicit tree, going right while below(value) holds,
+     * and returns the slot of the first value where it does not, or 0.
+     */
+    template <typename Below>
+    [[nodiscard]] std::size_t descend(Below below) const noexcept;
+    // in-order neighbours of a slot, 0 past either end
+    [[nodiscard]] std::size_t nextSlot(std::size_t slot) const noexcept;
+    [[nodiscard]] std::size_t prevSlot(std::size_t slot) const noexcept;
+    void clear() noexcept;
+
+    // slots 1 to count are constructed, slot 0 is never used
+    T *keys = nullptr;
+    std::size_t count = 0;
+    Compare comp;
+};
+
+#include "frozen/frozen_set.hpp"
+#include "frozen/iterator.hpp" // IWYU pragma: keep
+
+static_assert(std::bidirectional_iterator<FrozenSet<int>::Iterator>);
+static_assert(std::ranges::bidirectional_range<FrozenSet<int>>);
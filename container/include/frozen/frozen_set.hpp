@@ -0,0 +1,210 @@
+#pragma once
+
+#include "frozen/frozen_set.h"
+#include <bit>
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <vector>
+
+// The values are moved into the slots in sorted order, which is an in-order
+// walk of the implicit tree
+template <typename T, typename Compare>
+template <std::input_iterator InputIt, std::sentinel_for<InputIt> Sentinel>
+FrozenSet<T, Compare>::FrozenSet(InputIt first, Sentinel last, Compare comp)
+    : comp(std::move(comp)) {
+    std::vector<T> sorted;
+    for (; first != last; ++first) {
+        sorted.emplace_back(*first);
+    }
+    if (sorted.empty()) {
+        return;
+    }
+
+    keys = static_cast<T *>(::operator new((sorted.size() + 1) * sizeof(T),
+                                           std::align_val_t(ALIGNMENT)));
+    count = sorted.size();
+    std::size_t placed = 0;
+    try {
+        for (std::size_t slot = nextSlot(0); slot != 0;
+             slot = nextSlot(slot)) {
+            new (keys + slot) T(std::move(sorted[placed]));
+            ++placed;
+        }
+    } catch (...) {
+        for (std::size_t slot = nextSlot(0); placed > 0;
+             slot = nextSlot(slot), --placed) {
+            keys[slot].~T();
+        }
+        ::operator delete(keys, std::align_val_t(ALIGNMENT));
+        keys = nullptr;
+        count = 0;
+        throw;
+    }
+}
+
+template <typename T, typename Compare>
+FrozenSet<T, Compare>::FrozenSet(FrozenSet &&other) noexcept {
+    swap(other);
+}
+
+template <typename T, typename Compare>
+FrozenSet<T, Compare> &
+FrozenSet<T, Compare>::operator=(FrozenSet &&other) noexcept {
+    if (this != &other) {
+        clear();
+        swap(other);
+    }
+    return *this;
+}
+
+template <typename T, typename Compare>
+void FrozenSet<T, Compare>::swap(FrozenSet &other) noexcept {
+    using std::swap;
+    swap(keys, other.keys);
+    swap(count, other.count);
+    swap(comp, other.comp);
+}
+
+template <typename T, typename Compare>
+typename FrozenSet<T, Compare>::Iterator
+FrozenSet<T, Compare>::begin() const {
+    return Iterator(this, nextSlot(0));
+}
+
+template <typename T, typename Compare>
+typename FrozenSet<T, Compare>::Iterator FrozenSet<T, Compare>::end() const {
+    return Iterator(this, 0);
+}
+
+template <typename T, typename Compare>
+const T *FrozenSet<T, Compare>::search(const T &value) const noexcept {
+    return search<T>(value);
+}
+
+template <typename T, typename Compare>
+template <typename K>
+    requires LookupKey<K, T, Compare>
+const T *FrozenSet<T, Compare>::search(const K &key) const noexcept {
+    const std::size_t slot =
+        descend([&](const T &value) { return comp(value, key); });
+    if (slot != 0 && !comp(key, keys[slot])) {
+        return keys + slot;
+    }
+    return nullptr;
+}
+
+template <typename T, typename Compare>
+bool FrozenSet<T, Compare>::contains(const T &value) const noexcept {
+    return search<T>(value) != nullptr;
+}
+
+template <typename T, typename Compare>
+template <typename K>
+    requires LookupKey<K, T, Compare>
+bool FrozenSet<T, Compare>::contains(const K &key) const noexcept {
+    return search(key) != nullptr;
+}
+
+template <typename T, typename Compare>
+typename FrozenSet<T, Compare>::Iterator
+FrozenSet<T, Compare>::lower_bound(const T &value) const noexcept {
+    return lower_bound<T>(value);
+}
+
+template <typename T, typename Compare>
+template <typename K>
+    requires LookupKey<K, T, Compare>
+typename FrozenSet<T, Compare>::Iterator
+FrozenSet<T, Compare>::lower_bound(const K &key) const noexcept {
+    return Iterator(
+        this, descend([&](const T &value) { return comp(value, key); }));
+}
+
+template <typename T, typename Compare>
+typename FrozenSet<T, Compare>::Iterator
+FrozenSet<T, Compare>::upper_bound(const T &value) const noexcept {
+    return upper_bound<T>(value);
+}
+
+template <typename T, typename Compare>
+template <typename K>
+    requires LookupKey<K, T, Compare>
+typename FrozenSet<T, Compare>::Iterator
+FrozenSet<T, Compare>::upper_bound(const K &key) const noexcept {
+    return Iterator(
+        this, descend([&](const T &value) { return !comp(key, value); }));
+}
+
+template <typename T, typename Compare>
+std::size_t FrozenSet<T, Compare>::size() const noexcept {
+    return count;
+}
+
+template <typename T, typename Compare>
+bool FrozenSet<T, Compare>::empty() const noexcept {
+    return count == 0;
+}
+
+// Every step appends one bit to the slot, 1 for going right. The answer is
+// where the walk last went left, so the trailing right turns and that left
+// turn are shifted off again. A walk that only went right ends at slot 0.
+template <typename T, typename Compare>
+template <typename Below>
+std::size_t FrozenSet<T, Compare>::descend(Below below) const noexcept {
+    std::size_t slot = 1;
+    while (slot <= count) {
+#if defined(__GNUC__)
+        __builtin_prefetch(keys + slot * PREFETCH_STRIDE);
+#endif
+        slot = 2 * slot + static_cast<std::size_t>(below(keys[slot]));
+    }
+    return slot >> (std::countr_one(slot) + 1);
+}
+
+// Slot 0 acts as the position before the min, so nextSlot(0) is the min
+template <typename T, typename Compare>
+std::size_t FrozenSet<T, Compare>::nextSlot(std::size_t slot) const noexcept {
+    std::size_t child = slot == 0 ? 1 : 2 * slot + 1;
+    if (child <= count) {
+        while (2 * child <= count) {
+            child *= 2;
+        }
+        return child;
+    }
+    // Up past every right child, then once more
+    while ((slot & 1) != 0) {
+        slot >>= 1;
+    }
+    return slot >> 1;
+}
+
+// Slot 0 acts as the position after the max, so prevSlot(0) is the max
+template <typename T, typename Compare>
+std::size_t FrozenSet<T, Compare>::prevSlot(std::size_t slot) const noexcept {
+    std::size_t child = slot == 0 ? 1 : 2 * slot;
+    if (child <= count) {
+        while (2 * child + 1 <= count) {
+            child = 2 * child + 1;
+        }
+        return child;
+    }
+    // Up past every left child, then once more
+    while (slot != 0 && (slot & 1) == 0) {
+        slot >>= 1;
+    }
+    return slot >> 1;
+}
+
+template <typename T, typename Compare>
+void FrozenSet<T, Compare>::clear() noexcept {
+    if (keys == nullptr) {
+        return;
+    }
+    for (std::size_t slot = 1; slot <= count; ++slot) {
+        keys[slot].~T();
+    }
+    ::operator delete(keys, std::align_val_t(ALIGNMENT));
+    keys = nullptr;
+    count = 0;
+}
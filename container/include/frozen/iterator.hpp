@@ -0,0 +1,54 @@
+#pragma once
+
+#include "frozen/frozen_set.h"
+
+template <typename T, typename Compare>
+const T &FrozenSet<T, Compare>::Iterator::operator*() const {
+    return set->keys[slot];
+}
+
+template <typename T, typename Compare>
+const T *FrozenSet<T, Compare>::Iterator::operator->() const {
+    return set->keys + slot;
+}
+
+template <typename T, typename Compare>
+typename FrozenSet<T, Compare>::Iterator &
+FrozenSet<T, Compare>::Iterator::operator++() {
+    slot = set->nextSlot(slot);
+    return *this;
+}
+
+template <typename T, typename Compare>
+typename FrozenSet<T, Compare>::Iterator
+FrozenSet<T, Compare>::Iterator::operator++(int) {
+    Iterator temp = *this;
+    ++(*this);
+    return temp;
+}
+
+// Stepping back from end() lands on the max
+template <typename T, typename Compare>
+typename FrozenSet<T, Compare>::Iterator &
+FrozenSet<T, Compare>::Iterator::operator--() {
+    slot = set->prevSlot(slot);
+    return *this;
+}
+
+template <typename T, typename Compare>
+typename FrozenSet<T, Compare>::Iterator
+FrozenSet<T, Compare>::Iterator::operator--(int) {
+    Iterator temp = *this;
+    --(*this);
+    return temp;
+}
+
+template <typename T, typename Compare>
+bool FrozenSet<T, Compare>::Iterator::operator==(const Iterator &other) const {
+    return slot == other.slot;
+}
+
+template <typename T, typename Compare>
+bool FrozenSet<T, Compare>::Iterator::operator!=(const Iterator &other) const {
+    return !(*this == other);
+}
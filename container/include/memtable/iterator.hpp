@@ -0,0 +1,41 @@
+#pragma once
+
+#include "memtable/memtable_skiplist.h"
+
+template <typename T, typename Compare, bool HugePages>
+const T &MemtableSkipList<T, Compare, HugePages>::Iterator::operator*() const {
+    return node->value;
+}
+
+template <typename T, typename Compare, bool HugePages>
+const T *MemtableSkipList<T, Compare, HugePages>::Iterator::operator->() const {
+    return &node->value;
+}
+
+// the acquire load makes a node the writer just linked in readable
+template <typename T, typename Compare, bool HugePages>
+typename MemtableSkipList<T, Compare, HugePages>::Iterator &
+MemtableSkipList<T, Compare, HugePages>::Iterator::operator++() {
+    node = node->forward()[0].load(std::memory_order_acquire);
+    return *this;
+}
+
+template <typename T, typename Compare, bool HugePages>
+typename MemtableSkipList<T, Compare, HugePages>::Iterator
+MemtableSkipList<T, Compare, HugePages>::Iterator::operator++(int) {
+    Iterator temp = *this;
+    ++(*this);
+    return temp;
+}
+
+template <typename T, typename Compare, bool HugePages>
+bool MemtableSkipList<T, Compare, HugePages>::Iterator::operator==(
+    const Iterator &other) const {
+    return node == other.node;
+}
+
+template <typename T, typename Compare, bool HugePages>
+bool MemtableSkipList<T, Compare, HugePages>::Iterator::operator!=(
+    const Iterator &other) const {
+    return !(*this == other);
+}
@@ -0,0 +1,176 @@
+#pragma once
+
+#include "allocator/pool_allocator.h"
+#include "container.h"
+#include "skiplist/random_level.h"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <random>
+#include <ranges>
+#include <utility>
+
+/**
+ * Levels a MemtableSkipList node can have at most, enough for 2^32 values.
+ */
+constexpr int MEMTABLE_MAX_LEVEL = 32;
+
+/**
+ * Skip list for one writer thread and any number of reader threads, the
+ * memtable of LevelDB and RocksDB.
+ *
+ * Values are only ever inserted. The writer builds a node completely,
+ * including its forward pointers, and then publishes it level by level with
+ * release stores. Readers follow the forward pointers with acquire loads,
+ * so they see every node they reach fully built. Neither side takes a lock
+ * and readers never wait for the writer.
+ *
+ * Nodes are bump allocated from a NodeArena, one allocation per node with
+ * its forward pointers inline. Nothing is freed before the whole list is
+ * destroyed, which is when a memtable is retired after its values were
+ * flushed, and the arena then returns its chunks at once.
+ *
+ * insert must only be called from one thread at a time. Every other member
+ * can be called from any number of threads, also while insert runs. Values
+ * and iterators stay valid for the lifetime of the list.
+ */
+template <typename T, typename Compare = std::less<T>, bool HugePages = false>
+class MemtableSkipList {
+  private:
+    struct Node;
+    using Link = std::atomic<Node *>;
+
+  public:
+    MemtableSkipList() = default;
+    MemtableSkipList(const MemtableSkipList &) = delete;
+    MemtableSkipList(MemtableSkipList &&) = delete;
+    MemtableSkipList &operator=(const MemtableSkipList &) = delete;
+    MemtableSkipList &operator=(MemtableSkipList &&) = delete;
+    /**
+     * Destroys the values and frees the arena. No reader may use the list
+     * any more.
+     */
+    ~MemtableSkipList();
+
+    // iterator
+    /**
+     * Forward iterator along the lowest level. It sees values the writer
+     * inserts behind it while it moves on.
+     */
+    class Iterator {
+      public:
+        using iterator_category = std::forward_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = T;
+        using pointer = const T *;
+        using reference = const T &;
+
+        Iterator() = default;
+
+        reference operator*() const;
+        pointer operator->() const;
+
+        Iterator &operator++();
+        Iterator operator++(int);
+        bool operator==(const Iterator &other) const;
+        bool operator!=(const Iterator &other) const;
+
+      private:
+        friend class MemtableSkipList;
+
+        explicit Iterator(const Node *node) : node(node) {}
+
+        const Node *node = nullptr;
+    };
+
+    [[nodiscard]] Iterator begin() const;
+    [[nodiscard]] Iterator end() const;
+
+    // modifiers, writer thread only
+    /**
+     * Inserts the value, returns false if an equivalent value already
+     * existed.
+     */
+    bool insert(const T &value);
+    bool insert(T &&value);
+
+    // access, any thread
+    /**
+     * Search for a value, returns nullptr if not found.
+     */
+    [[nodiscard]] const T *search(const T &value) const;
+    template <typename K>
+        requires LookupKey<K, T, Compare>
+    [[nodiscard]] const T *search(const K &key) const;
+    [[nodiscard]] bool contains(const T &value) const;
+    template <typename K>
+        requires LookupKey<K, T, Compare>
+    [[nodiscard]] bool contains(const K &key) const;
+    /**
+     * Returns the min value, or nullptr if the list is empty.
+     */
+    [[nodiscard]] const T *min() const;
+    /**
+     * Returns the max value, or nullptr if the list is empty.
+     */
+    [[nodiscard]] const T *max() const;
+    /**
+     * Returns an iterator to the first value not smaller than value, or
+     * end().
+     */
+    [[nodiscard]] Iterator lower_bound(const T &value) const;
+    template <typename K>
+        requires LookupKey<K, T, Compare>
+    [[nodiscard]] Iterator lower_bound(const K &key) const;
+
+    // info
+    [[nodiscard]] std::size_t size() const noexcept;
+    [[nodiscard]] bool empty() const noexcept;
+
+  private:
+    // A node and its forward pointers are a single block of the arena, the
+    // pointers follow the value, one for every level of the node
+    struct Node {
+        T value;
+
+        template <typename... Args>
+        explicit Node(Args &&...args) : value(std::forward<Args>(args)...) {}
+
+        Link *forward() noexcept;
+        const Link *forward() const noexcept;
+    };
+
+    static constexpr std::size_t TOWER_OFFSET =
+        (sizeof(Node) + alignof(Link) - 1) / alignof(Link) * alignof(Link);
+    static constexpr std::size_t NODE_ALIGNMENT =
+        std::max(alignof(Node), alignof(Link));
+
+    template <typename V> bool insertValue(V &&value);
+    template <typename... Args> Node *createNode(int level, Args &&...args);
+    /**
+     * Walk down to the first node not smaller than key. The last node before
+     * it on every level is stored in preds when given, as its forward
+     * pointers.
+     */
+    template <typename K>
+    [[nodiscard]] Node *findGreaterOrEqual(const K &key, Link **preds) const;
+
+    // the forward pointers of the header, mutable since searches hand them
+    // out as the predecessors of the smallest values
+    mutable Link head[MEMTABLE_MAX_LEVEL] = {};
+    // levels that may hold nodes, only the writer raises it
+    std::atomic<int> levels{1};
+    std::atomic<std::size_t> count{0};
+    // only touched by the writer
+    NodeArena<HugePages> arena;
+    std::mt19937 gen;
+    Compare comp;
+};
+
+#include "memtable/memtable_skiplist.hpp"
+#include "memtable/iterator.hpp" // IWYU pragma: keep
+
+static_assert(std::forward_iterator<MemtableSkipList<int>::Iterator>);
+static_assert(std::ranges::forward_range<MemtableSkipList<int>>);
@@ -0,0 +1,211 @@
+#pragma once
+
+#include "memtable/memtable_skiplist.h"
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// The arena frees the memory of the nodes on its own, only the values may
+// have to be destroyed
+template <typename T, typename Compare, bool HugePages>
+MemtableSkipList<T, Compare, HugePages>::~MemtableSkipList() {
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+        Node *node = head[0].load(std::memory_order_relaxed);
+        while (node != nullptr) {
+            Node *next = node->forward()[0].load(std::memory_order_relaxed);
+            node->~Node();
+            node = next;
+        }
+    }
+}
+
+template <typename T, typename Compare, bool HugePages>
+bool MemtableSkipList<T, Compare, HugePages>::insert(const T &value) {
+    return insertValue(value);
+}
+
+template <typename T, typename Compare, bool HugePages>
+bool MemtableSkipList<T, Compare, HugePages>::insert(T &&value) {
+    return insertValue(std::move(value));
+}
+
+// Only this thread changes forward pointers, so it reads them relaxed. The
+// node points to its successors before the release store on the lowest
+// level makes it reachable, and a reader that reaches it on a higher level
+// first finds the same successors or newer ones.
+template <typename T, typename Compare, bool HugePages>
+template <typename V>
+bool MemtableSkipList<T, Compare, HugePages>::insertValue(V &&value) {
+    Link *preds[MEMTABLE_MAX_LEVEL];
+    Node *next = findGreaterOrEqual(value, preds);
+    if (next != nullptr && !comp(value, next->value)) {
+        return false;
+    }
+
+    const int level = geometricLevel(gen, MEMTABLE_MAX_LEVEL);
+    const int top = levels.load(std::memory_order_relaxed);
+    if (level > top) {
+        for (int i = top; i < level; ++i) {
+            preds[i] = head;
+        }
+        // a reader that sees the new levels still empty simply drops down
+        levels.store(level, std::memory_order_relaxed);
+    }
+
+    Node *node = createNode(level, std::forward<V>(value));
+    Link *tower = node->forward();
+    for (int i = 0; i < level; ++i) {
+        tower[i].store(preds[i][i].load(std::memory_order_relaxed),
+                       std::memory_order_relaxed);
+        preds[i][i].store(node, std::memory_order_release);
+    }
+    count.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+template <typename T, typename Compare, bool HugePages>
+const T *MemtableSkipList<T, Compare, HugePages>::search(const T &value) const {
+    return search<T>(value);
+}
+
+template <typename T, typename Compare, bool HugePages>
+template <typename K>
+    requires LookupKey<K, T, Compare>
+const T *MemtableSkipList<T, Compare, HugePages>::search(const K &key) const {
+    const Node *node = findGreaterOrEqual(key, nullptr);
+    return node != nullptr && !comp(key, node->value) ? &node->value
+                                                      : nullptr;
+}
+
+template <typename T, typename Compare, bool HugePages>
+bool MemtableSkipList<T, Compare, HugePages>::contains(const T &value) const {
+    return search<T>(value) != nullptr;
+}
+
+template <typename T, typename Compare, bool HugePages>
+template <typename K>
+    requires LookupKey<K, T, Compare>
+bool MemtableSkipList<T, Compare, HugePages>::contains(const K &key) const {
+    return search(key) != nullptr;
+}
+
+template <typename T, typename Compare, bool HugePages>
+const T *MemtableSkipList<T, Compare, HugePages>::min() const {
+    const Node *first = head[0].load(std::memory_order_acquire);
+    return first != nullptr ? &first->value : nullptr;
+}
+
+// go as far right as possible on every level
+template <typename T, typename Compare, bool HugePages>
+const T *MemtableSkipList<T, Compare, HugePages>::max() const {
+    const Link *tower = head;
+    const Node *last = nullptr;
+    for (int level = levels.load(std::memory_order_relaxed) - 1; level >= 0;
+         --level) {
+        const Node *next = tower[level].load(std::memory_order_acquire);
+        while (next != nullptr) {
+            last = next;
+            tower = next->forward();
+            next = tower[level].load(std::memory_order_acquire);
+        }
+    }
+    return last != nullptr ? &last->value : nullptr;
+}
+
+template <typename T, typename Compare, bool HugePages>
+typename MemtableSkipList<T, Compare, HugePages>::Iterator
+MemtableSkipList<T, Compare, HugePages>::lower_bound(const T &value) const {
+    return lower_bound<T>(value);
+}
+
+template <typename T, typename Compare, bool HugePages>
+template <typename K>
+    requires LookupKey<K, T, Compare>
+typename MemtableSkipList<T, Compare, HugePages>::Iterator
+MemtableSkipList<T, Compare, HugePages>::lower_bound(const K &key) const {
+    return Iterator(findGreaterOrEqual(key, nullptr));
+}
+
+template <typename T, typename Compare, bool HugePages>
+typename MemtableSkipList<T, Compare, HugePages>::Iterator
+MemtableSkipList<T, Compare, HugePages>::begin() const {
+    return Iterator(head[0].load(std::memory_order_acquire));
+}
+
+template <typename T, typename Compare, bool HugePages>
+typename MemtableSkipList<T, Compare, HugePages>::Iterator
+MemtableSkipList<T, Compare, HugePages>::end() const {
+    return Iterator();
+}
+
+template <typename T, typename Compare, bool HugePages>
+std::size_t MemtableSkipList<T, Compare, HugePages>::size() const noexcept {
+    return count.load(std::memory_order_relaxed);
+}
+
+template <typename T, typename Compare, bool HugePages>
+bool MemtableSkipList<T, Compare, HugePages>::empty() const noexcept {
+    return size() == 0;
+}
+
+template <typename T, typename Compare, bool HugePages>
+typename MemtableSkipList<T, Compare, HugePages>::Link *
+MemtableSkipList<T, Compare, HugePages>::Node::forward() noexcept {
+    return std::launder(reinterpret_cast<Link *>(
+        reinterpret_cast<std::byte *>(this) + TOWER_OFFSET));
+}
+
+template <typename T, typename Compare, bool HugePages>
+const typename MemtableSkipList<T, Compare, HugePages>::Link *
+MemtableSkipList<T, Compare, HugePages>::Node::forward() const noexcept {
+    return std::launder(reinterpret_cast<const Link *>(
+        reinterpret_cast<const std::byte *>(this) + TOWER_OFFSET));
+}
+
+template <typename T, typename Compare, bool HugePages>
+template <typename... Args>
+typename MemtableSkipList<T, Compare, HugePages>::Node *
+MemtableSkipList<T, Compare, HugePages>::createNode(int level,
+                                                    Args &&...args) {
+    const std::size_t bytes = TOWER_OFFSET + level * sizeof(Link);
+    void *memory = arena.allocate(bytes, NODE_ALIGNMENT);
+    Node *node = nullptr;
+    try {
+        node = new (memory) Node(std::forward<Args>(args)...);
+    } catch (...) {
+        arena.deallocate(memory, bytes, NODE_ALIGNMENT);
+        throw;
+    }
+    std::uninitialized_value_construct_n(
+        reinterpret_cast<Link *>(static_cast<std::byte *>(memory) +
+                                 TOWER_OFFSET),
+        level);
+    return node;
+}
+
+// The node the search stopped at on the level above is known not to be
+// smaller than key, so reaching it again on a lower level ends that level
+// without another comparison
+template <typename T, typename Compare, bool HugePages>
+template <typename K>
+typename MemtableSkipList<T, Compare, HugePages>::Node *
+MemtableSkipList<T, Compare, HugePages>::findGreaterOrEqual(
+    const K &key, Link **preds) const {
+    Link *tower = head;
+    Node *bound = nullptr;
+    for (int level = levels.load(std::memory_order_relaxed) - 1; level >= 0;
+         --level) {
+        Node *next = tower[level].load(std::memory_order_acquire);
+        while (next != bound && comp(next->value, key)) {
+            tower = next->forward();
+            next = tower[level].load(std::memory_order_acquire);
+        }
+        bound = next;
+        if (preds != nullptr) {
+            preds[level] = tower;
+        }
+    }
+    return bound;
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "compact_avl/node_storage.h"
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <type_traits>
+
+/**
+ * "mySetMap" in the first eight bytes of a mapped tree file.
+ */
+constexpr uint64_t MAPPED_NODES_MAGIC = 0x70614d7465537970;
+// 2 gave every node a parent index in the bits next to its balance
+constexpr uint32_t MAPPED_NODES_VERSION = 2;
+/**
+ * A mapped tree file grows and is mapped in whole chunks of this many bytes.
+ */
+constexpr std::size_t MAPPED_NODES_CHUNK = std::size_t{1} << 22;
+
+/**
+ * Fixed size header at the start of a mapped tree file, followed by the node
+ * array. Padded to 64 bytes so the nodes are aligned for any T.
+ */
+struct MappedNodesHeader {
+    uint64_t magic = MAPPED_NODES_MAGIC;
+    uint32_t version = MAPPED_NODES_VERSION;
+    // sizeof(Node) of the writer, a reader with another layout refuses it
+    uint32_t nodeSize = 0;
+    uint32_t count = 0;
+    uint32_t root = COMPACT_AVL_NIL;
+    uint64_t reserved[5] = {};
+};
+static_assert(sizeof(MappedNodesHeader) == 64);
+
+/**
+ * CompactNodeStorage that keeps the node array and the root index in a file
+ * mapped with MAP_SHARED, so every change goes straight to the page cache and
+ * other processes mapping the file see it. Nodes link to each other by index,
+ * which is their offset in the file, so the file works at any address.
+ *
+ * The file grows in MAPPED_NODES_CHUNK steps and is remapped in place where
+ * the kernel allows it. It never shrinks, clear() only resets the header.
+ * Changes are durable once sync() returns, a crash before that can leave the
+ * file in any state the page cache had written back so far.
+ *
+ * A default constructed storage has no file, is empty and cannot take nodes.
+ * Only available on Linux, elsewhere opening throws std::system_error.
+ */
+template <typename Node> class MappedNodeStorage {
+    static_assert(std::is_trivially_copyable_v<Node>,
+                  "nodes are written to the file as raw bytes");
+    static_assert(alignof(Node) <= sizeof(MappedNodesHeader),
+                  "nodes are stored right after the header");
+
+  public:
+    MappedNodeStorage() = default;
+    /**
+     * Opens the tree file at path, creating an empty one if it does not exist
+     * and readOnly is false. Throws std::system_error if the file cannot be
+     * opened or mapped and std::runtime_error if it is not a tree file with
+     * nodes of this layout.
+     */
+    MappedNodeStorage(const std::filesystem::path &path, bool readOnly);
+    MappedNodeStorage(const MappedNodeStorage &) = delete;
+    MappedNodeStorage(MappedNodeStorage &&other) noexcept;
+    MappedNodeStorage &operator=(const MappedNodeStorage &) = delete;
+    MappedNodeStorage &operator=(MappedNodeStorage &&other) noexcept;
+    ~MappedNodeStorage();
+
+    Node &operator[](uint32_t index) noexcept { return nodes()[index]; }
+    const Node &operator[](uint32_t index) const noexcept {
+        return nodes()[index];
+    }
+
+    [[nodiscard]] uint32_t size() const noexcept {
+        return data == nullptr ? 0 : header()->count;
+    }
+
+    /**
+     * Appends a node and returns its index, growing the file by a chunk if
+     * it is full. Throws std::system_error if the file cannot grow and
+     * std::length_error once every index short of COMPACT_AVL_NIL is taken.
+     */
+    template <typename... Args> uint32_t emplace(Args &&...args);
+    void pop() noexcept { --header()->count; }
+    /**
+     * Drops every node, the file keeps its size.
+     */
+    void clear() noexcept;
+    /**
+     * Grows the file to hold n nodes in total.
+     */
+    void reserve(std::size_t n);
+
+    uint32_t &root() noexcept {
+        return data == nullptr ? detachedRoot : header()->root;
+    }
+    [[nodiscard]] uint32_t root() const noexcept {
+        return data == nullptr ? detachedRoot : header()->root;
+    }
+
+    /**
+     * Nodes that fit into the file before it has to grow.
+     */
+    [[nodiscard]] std::size_t capacity() const noexcept;
+    [[nodiscard]] bool readOnly() const noexcept { return !writable; }
+    /**
+     * Writes the dirty pages of the file back to disk and waits for them,
+     * msync(MS_SYNC). Throws std::system_error if that fails.
+     */
+    void sync();
+
+  private:
+    MappedNodesHeader *header() const noexcept {
+        return reinterpret_cast<MappedNodesHeader *>(data);
+    }
+    Node *nodes() const noexcept {
+        return reinterpret_cast<Node *>(data + sizeof(MappedNodesHeader));
+    }
+    /**
+     * Grow the file and the mapping to whole chunks that hold n nodes.
+     */
+    void grow(std::size_t n);
+    void verify(const std::filesystem::path &path) const;
+    void release() noexcept;
+
+    std::byte *data = nullptr;
+    std::size_t length = 0;
+    int fd = -1;
+    bool writable = false;
+    uint32_t detachedRoot = COMPACT_AVL_NIL;
+};
+
+#include "mmap_avl/mapped_node_storage.hpp"
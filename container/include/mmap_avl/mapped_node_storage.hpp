@@ -0,0 +1,210 @@
+#pragma once
+
+#include "mmap_avl/mapped_node_storage.h"
+#include <algorithm>
+#include <cerrno>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// A new file is created with a single chunk and an empty header
+template <typename Node>
+MappedNodeStorage<Node>::MappedNodeStorage(const std::filesystem::path &path,
+                                           bool readOnly)
+    : writable(!readOnly) {
+#if defined(__linux__)
+    const int flags = readOnly ? O_RDONLY : O_RDWR | O_CREAT;
+    fd = open(path.c_str(), flags | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        throw std::system_error(errno, std::generic_category(),
+                                "cannot open " + path.string());
+    }
+
+    try {
+        struct stat info{};
+        if (fstat(fd, &info) != 0) {
+            throw std::system_error(errno, std::generic_category(),
+                                    "cannot stat " + path.string());
+        }
+        const auto size = static_cast<std::size_t>(info.st_size);
+        if (size == 0 && writable) {
+            grow(0);
+            MappedNodesHeader *created = new (data) MappedNodesHeader;
+            created->nodeSize = sizeof(Node);
+        } else if (size >= sizeof(MappedNodesHeader)) {
+            const int protection = writable ? PROT_READ | PROT_WRITE
+                                            : PROT_READ;
+            void *memory =
+                mmap(nullptr, size, protection, MAP_SHARED, fd, 0);
+            if (memory == MAP_FAILED) {
+                throw std::system_error(errno, std::generic_category(),
+                                        "cannot map " + path.string());
+            }
+            data = static_cast<std::byte *>(memory);
+            length = size;
+        }
+        verify(path);
+    } catch (...) {
+        release();
+        throw;
+    }
+#else
+    throw std::system_error(
+        std::make_error_code(std::errc::function_not_supported),
+        "cannot map " + path.string());
+#endif
+}
+
+template <typename Node>
+MappedNodeStorage<Node>::MappedNodeStorage(MappedNodeStorage &&other) noexcept
+    : data(std::exchange(other.data, nullptr)),
+      length(std::exchange(other.length, 0)),
+      fd(std::exchange(other.fd, -1)),
+      writable(std::exchange(other.writable, false)),
+      detachedRoot(std::exchange(other.detachedRoot, COMPACT_AVL_NIL)) {}
+
+template <typename Node>
+MappedNodeStorage<Node> &
+MappedNodeStorage<Node>::operator=(MappedNodeStorage &&other) noexcept {
+    if (this != &other) {
+        release();
+        data = std::exchange(other.data, nullptr);
+        length = std::exchange(other.length, 0);
+        fd = std::exchange(other.fd, -1);
+        writable = std::exchange(other.writable, false);
+        detachedRoot = std::exchange(other.detachedRoot, COMPACT_AVL_NIL);
+    }
+    return *this;
+}
+
+template <typename Node> MappedNodeStorage<Node>::~MappedNodeStorage() {
+    release();
+}
+
+// The node is built in place, its arguments never point into the mapping
+template <typename Node>
+template <typename... Args>
+uint32_t MappedNodeStorage<Node>::emplace(Args &&...args) {
+    const uint32_t index = size();
+    if (index >= COMPACT_AVL_NIL) {
+        throw std::length_error("MmapAVLTree is out of node indices");
+    }
+    if (index >= capacity()) {
+        grow(std::size_t{index} + 1);
+    }
+    new (&nodes()[index]) Node(std::forward<Args>(args)...);
+    ++header()->count;
+    return index;
+}
+
+template <typename Node> void MappedNodeStorage<Node>::clear() noexcept {
+    if (data == nullptr) {
+        detachedRoot = COMPACT_AVL_NIL;
+        return;
+    }
+    header()->count = 0;
+    header()->root = COMPACT_AVL_NIL;
+}
+
+template <typename Node> void MappedNodeStorage<Node>::reserve(std::size_t n) {
+    if (n > capacity()) {
+        grow(n);
+    }
+}
+
+template <typename Node>
+std::size_t MappedNodeStorage<Node>::capacity() const noexcept {
+    if (data == nullptr) {
+        return 0;
+    }
+    return (length - sizeof(MappedNodesHeader)) / sizeof(Node);
+}
+
+template <typename Node> void MappedNodeStorage<Node>::sync() {
+#if defined(__linux__)
+    if (data != nullptr && writable && msync(data, length, MS_SYNC) != 0) {
+        throw std::system_error(errno, std::generic_category(),
+                                "cannot sync the tree file");
+    }
+#endif
+}
+
+// The file is extended first, so a failed remap leaves a longer file behind
+// but the old mapping intact
+template <typename Node> void MappedNodeStorage<Node>::grow(std::size_t n) {
+#if defined(__linux__)
+    const std::size_t needed = sizeof(MappedNodesHeader) + n * sizeof(Node);
+    const std::size_t grown = std::max<std::size_t>(
+        (needed + MAPPED_NODES_CHUNK - 1) / MAPPED_NODES_CHUNK *
+            MAPPED_NODES_CHUNK,
+        MAPPED_NODES_CHUNK);
+    if (ftruncate(fd, static_cast<off_t>(grown)) != 0) {
+        throw std::system_error(errno, std::generic_category(),
+                                "cannot grow the tree file");
+    }
+    void *memory =
+        data == nullptr
+            ? mmap(nullptr, grown, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+            : mremap(data, length, grown, MREMAP_MAYMOVE);
+    if (memory == MAP_FAILED) {
+        throw std::system_error(errno, std::generic_category(),
+                                "cannot map the tree file");
+    }
+    data = static_cast<std::byte *>(memory);
+    length = grown;
+#else
+    (void)n;
+    throw std::system_error(
+        std::make_error_code(std::errc::function_not_supported),
+        "cannot map the tree file");
+#endif
+}
+
+template <typename Node>
+void MappedNodeStorage<Node>::verify(const std::filesystem::path &path) const {
+    const auto invalid = [&](const char *why) {
+        throw std::runtime_error(path.string() + ": " + why);
+    };
+
+    if (data == nullptr) {
+        invalid("too short for a tree file");
+    }
+    const MappedNodesHeader &stored = *header();
+    if (stored.magic != MAPPED_NODES_MAGIC) {
+        invalid("not a tree file");
+    }
+    if (stored.version != MAPPED_NODES_VERSION) {
+        invalid("unsupported tree file version");
+    }
+    if (stored.nodeSize != sizeof(Node)) {
+        invalid("tree file holds nodes of another size");
+    }
+    if (stored.count > capacity() ||
+        (stored.count == 0) != (stored.root == COMPACT_AVL_NIL) ||
+        (stored.count > 0 && stored.root >= stored.count)) {
+        invalid("tree file is damaged");
+    }
+}
+
+template <typename Node> void MappedNodeStorage<Node>::release() noexcept {
+#if defined(__linux__)
+    if (data != nullptr) {
+        munmap(data, length);
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+#endif
+    data = nullptr;
+    length = 0;
+    fd = -1;
+}
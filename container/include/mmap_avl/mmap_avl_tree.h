@@ -0,0 +1,88 @@
+#pragma once
+
+#include "compact_avl/compact_avl_tree.h"
+#include "container.h"
+#include "mmap_avl/mapped_node_storage.h"
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+
+/**
+ * AVL tree that lives in a file.
+ *
+ * This is a CompactAVLTree whose node array is a file mapped into memory, see
+ * MappedNodeStorage. The nodes link to each other by their index in the file
+ * instead of by address, so opening an existing tree only maps the file and
+ * the OS pages nodes in as lookups touch them. Any number of processes can
+ * open the same file read only and share its pages.
+ *
+ * The file records the node layout but not the comparator, a tree has to be
+ * reopened with the Compare it was built with. Values are stored as raw
+ * bytes, so T has to be trivially copyable. Changes reach the file through
+ * the page cache right away, sync() makes them durable. Opening a file that
+ * another process is changing gives undefined results.
+ *
+ * Read only trees throw std::logic_error from every modifier. Values must not
+ * be changed through the pointers they hand out either. A moved from tree has
+ * no file left and is empty.
+ */
+template <typename T, typename Compare = std::less<T>>
+    requires std::is_trivially_copyable_v<T>
+class MmapAVLTree : public CompactAVLTree<T, Compare, MappedNodeStorage> {
+    using Base = CompactAVLTree<T, Compare, MappedNodeStorage>;
+
+  public:
+    using typename Base::Iterator;
+
+    /**
+     * Opens the tree stored at path, creating an empty one if the file does
+     * not exist and readOnly is false. Throws like MappedNodeStorage.
+     */
+    explicit MmapAVLTree(const std::filesystem::path &path,
+                         bool readOnly = false);
+    MmapAVLTree(MmapAVLTree &&other) noexcept = default;
+    /**
+     * Closes the file of this tree, which keeps its contents, and takes over
+     * the one of other.
+     */
+    MmapAVLTree &operator=(MmapAVLTree &&other) noexcept;
+    ~MmapAVLTree() = default;
+
+    // modifiers
+    bool insert(const T &value);
+    bool insert(T &&value);
+    bool remove(const T &value);
+    template <typename K>
+        requires LookupKey<K, T, Compare>
+    bool remove(const K &key);
+    /**
+     * Removes every value, the file keeps its size.
+     */
+    void clear();
+    /**
+     * Grows the file to hold n values in total.
+     */
+    void reserve(std::size_t n);
+
+    // file
+    /**
+     * Writes every change so far back to disk and waits for it, msync. Does
+     * nothing on a read only tree.
+     */
+    void sync();
+    [[nodiscard]] bool readOnly() const noexcept;
+    /**
+     * Values that fit into the file before it grows by another chunk.
+     */
+    [[nodiscard]] std::size_t capacity() const noexcept;
+
+  private:
+    void requireWritable() const;
+};
+
+#include "mmap_avl/mmap_avl_tree.hpp"
+
+static_assert(std::ranges::bidirectional_range<MmapAVLTree<int>>);
+static_assert(MmapAVLTree<int>::NODE_SIZE == 16);
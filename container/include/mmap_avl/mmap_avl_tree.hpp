@@ -0,0 +1,93 @@
+#pragma once
+
+#include "mmap_avl/mmap_avl_tree.h"
+#include <stdexcept>
+#include <utility>
+
+template <typename T, typename Compare>
+    requires std::is_trivially_copyable_v<T>
+MmapAVLTree<T, Compare>::MmapAVLTree(const std::filesystem::path &path,
+                                     bool readOnly)
+    : Base(std::in_place, path, readOnly) {}
+
+// The base assignment would clear the file of this tree first
+template <typename T, typename Compare>
+    requires std::is_trivially_copyable_v<T>
+MmapAVLTree<T, Compare> &
+MmapAVLTree<T, Compare>::operator=(MmapAVLTree &&other) noexcept {
+    if (this != &other) {
+        MmapAVLTree closing(std::move(other));
+        this->swap(closing);
+    }
+    return *this;
+}
+
+template <typename T, typename Compare>
+    requires std::is_trivially_copyable_v<T>
+bool MmapAVLTree<T, Compare>::insert(const T &value) {
+    requireWritable();
+    return Base::insert(value);
+}
+
+template <typename T, typename Compare>
+    requires std::is_trivially_copyable_v<T>
+bool MmapAVLTree<T, Compare>::insert(T &&value) {
+    requireWritable();
+    return Base::insert(std::move(value));
+}
+
+template <typename T, typename Compare>
+    requires std::is_trivially_copyable_v<T>
+bool MmapAVLTree<T, Compare>::remove(const T &value) {
+    requireWritable();
+    return Base::remove(value);
+}
+
+template <typename T, typename Compare>
+    requires std::is_trivially_copyable_v<T>
+template <typename K>
+    requires LookupKey<K, T, Compare>
+bool MmapAVLTree<T, Compare>::remove(const K &key) {
+    requireWritable();
+    return Base::remove(key);
+}
+
+template <typename T, typename Compare>
+    requires std::is_trivially_copyable_v<T>
+void MmapAVLTree<T, Compare>::clear() {
+    requireWritable();
+    Base::clear();
+}
+
+template <typename T, typename Compare>
+    requires std::is_trivially_copyable_v<T>
+void MmapAVLTree<T, Compare>::reserve(std::size_t n) {
+    requireWritable();
+    Base::reserve(n);
+}
+
+template <typename T, typename Compare>
+    requires std::is_trivially_copyable_v<T>
+void MmapAVLTree<T, Compare>::sync() {
+    this->nodes.sync();
+}
+
+template <typename T, typename Compare>
+    requires std::is_trivially_copyable_v<T>
+bool MmapAVLTree<T, Compare>::readOnly() const noexcept {
+    return this->nodes.readOnly();
+}
+
+template <typename T, typename Compare>
+    requires std::is_trivially_copyable_v<T>
+std::size_t MmapAVLTree<T, Compare>::capacity() const noexcept {
+    return this->nodes.capacity();
+}
+
+template <typename T, typename Compare>
+    requires std::is_trivially_copyable_v<T>
+void MmapAVLTree<T, Compare>::requireWritable() const {
+    if (this->nodes.readOnly()) {
+        throw std::logic_error("MmapAVLTree is read only or closed");
+    }
+}
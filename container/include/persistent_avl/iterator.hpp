@@ -0,0 +1,91 @@
+#pragma once
+
+#include "persistent_avl/persistent_avl_tree.h"
+
+template <typename T, typename Compare>
+const T &PersistentAVLTree<T, Compare>::Iterator::operator*() const {
+    return stack[depth - 1]->value;
+}
+
+template <typename T, typename Compare>
+const T *PersistentAVLTree<T, Compare>::Iterator::operator->() const {
+    return &stack[depth - 1]->value;
+}
+
+// Without a right subtree the next value is the closest ancestor reached
+// from its left side
+template <typename T, typename Compare>
+typename PersistentAVLTree<T, Compare>::Iterator &
+PersistentAVLTree<T, Compare>::Iterator::operator++() {
+    const Node *right = stack[depth - 1]->right.get();
+    if (right != nullptr) {
+        descend(right, false);
+        return *this;
+    }
+
+    const Node *child = nullptr;
+    do {
+        child = stack[--depth];
+    } while (depth > 0 && stack[depth - 1]->right.get() == child);
+    return *this;
+}
+
+template <typename T, typename Compare>
+typename PersistentAVLTree<T, Compare>::Iterator
+PersistentAVLTree<T, Compare>::Iterator::operator++(int) {
+    Iterator temp = *this;
+    ++(*this);
+    return temp;
+}
+
+// Stepping back from end() lands on the max
+template <typename T, typename Compare>
+typename PersistentAVLTree<T, Compare>::Iterator &
+PersistentAVLTree<T, Compare>::Iterator::operator--() {
+    if (depth == 0) {
+        descend(root, true);
+        return *this;
+    }
+
+    const Node *left = stack[depth - 1]->left.get();
+    if (left != nullptr) {
+        descend(left, true);
+        return *this;
+    }
+
+    const Node *child = nullptr;
+    do {
+        child = stack[--depth];
+    } while (depth > 0 && stack[depth - 1]->left.get() == child);
+    return *this;
+}
+
+template <typename T, typename Compare>
+typename PersistentAVLTree<T, Compare>::Iterator
+PersistentAVLTree<T, Compare>::Iterator::operator--(int) {
+    Iterator temp = *this;
+    --(*this);
+    return temp;
+}
+
+template <typename T, typename Compare>
+bool PersistentAVLTree<T, Compare>::Iterator::operator==(
+    const Iterator &other) const {
+    return depth == other.depth &&
+           (depth == 0 || stack[depth - 1] == other.stack[depth - 1]);
+}
+
+template <typename T, typename Compare>
+bool PersistentAVLTree<T, Compare>::Iterator::operator!=(
+    const Iterator &other) const {
+    return !(*this == other);
+}
+
+template <typename T, typename Compare>
+void PersistentAVLTree<T, Compare>::Iterator::descend(const Node *node,
+                                                      bool right) {
+    while (node != nullptr) {
+        stack[depth++] = node;
+        node = right ? node->right.get() : node->left.get();
+    }
+}
@@ -0,0 +1,247 @@
+#pragma once
+
+#include "container.h"
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+
+/**
+ * Upper bound on the height of a PersistentAVLTree. An AVL tree of height 64
+ * has more than 10^13 nodes, more than fit in memory. Sizes the iterator
+ * stack.
+ */
+constexpr int PERSISTENT_AVL_MAX_HEIGHT = 64;
+
+/**
+ * AVL tree whose copies share their nodes, for point in time views of a set
+ * that keeps changing.
+ *
+ * Copying the tree, or taking a snapshot(), is O(1): the copy holds another
+ * reference to the same root. insert and remove then copy the O(log n) nodes
+ * on the path they change instead of modifying them, so neither tree ever
+ * sees the changes of the other. Nodes that only one tree can reach are
+ * still changed in place, a tree without copies costs little more than
+ * AVLTree. Nodes are reference counted and freed with the last tree that
+ * uses them.
+ *
+ * A single tree must not be used by several threads at once, but a snapshot
+ * taken by the writer can be handed to other threads, which read it without
+ * any synchronisation while the writer goes on.
+ *
+ * Values reachable from several trees must not be changed through the
+ * pointers returned by search, min and max.
+ */
+template <typename T, typename Compare = std::less<T>>
+class PersistentAVLTree {
+    static_assert(std::copy_constructible<T>,
+                  "PersistentAVLTree copies the values on shared paths");
+
+  private:
+    struct Node;
+    using NodePtr = std::shared_ptr<Node>;
+
+    struct Node {
+        T value;
+        NodePtr left;
+        NodePtr right;
+        int height = 1;
+
+        template <typename... Args>
+        explicit Node(std::in_place_t /*unused*/, Args &&...args)
+            : value(std::forward<Args>(args)...) {}
+    };
+
+  public:
+    PersistentAVLTree() = default;
+    /**
+     * Shares every node with other, O(1).
+     */
+    PersistentAVLTree(const PersistentAVLTree &other) = default;
+    PersistentAVLTree(PersistentAVLTree &&other) noexcept;
+    PersistentAVLTree &operator=(const PersistentAVLTree &other) = default;
+    PersistentAVLTree &operator=(PersistentAVLTree &&other) noexcept;
+    ~PersistentAVLTree() = default;
+
+    // iterator
+    /**
+     * Bidirectional in-order iterator over the values, which are shared and
+     * therefore const. Keeps the path from the root on a fixed size stack.
+     * It stays valid as long as the tree it came from is neither changed
+     * nor destroyed.
+     */
+    class Iterator {
+      public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = T;
+        using pointer = const T *;
+        using reference = const T &;
+
+        Iterator() = default;
+
+        reference operator*() const;
+        pointer operator->() const;
+
+        Iterator &operator++();
+        Iterator operator++(int);
+        Iterator &operator--();
+        Iterator operator--(int);
+        bool operator==(const Iterator &other) const;
+        bool operator!=(const Iterator &other) const;
+
+      private:
+        friend class PersistentAVLTree;
+
+        explicit Iterator(const Node *root) : root(root) {}
+        // push node and then follow the left (or right) links to the end
+        void descend(const Node *node, bool right);
+
+        const Node *root = nullptr;
+        const Node *stack[PERSISTENT_AVL_MAX_HEIGHT] = {};
+        int depth = 0;
+    };
+
+    [[nodiscard]] Iterator begin() const;
+    [[nodiscard]] Iterator end() const;
+
+    /**
+     * Returns a copy of the current contents in O(1), see the class comment.
+     * Later changes to this tree do not show up in it, and changes to the
+     * snapshot do not show up here.
+     */
+    [[nodiscard]] PersistentAVLTree snapshot() const;
+
+    // modifiers
+    /**
+     * Inserts the value, returns false if an equivalent value already
+     * existed.
+     */
+    bool insert(const T &value);
+    bool insert(T &&value);
+    /**
+     * Removes an equivalent value, returns false if there was none.
+     */
+    bool remove(const T &value);
+    template <typename K>
+        requires LookupKey<K, T, Compare>
+    bool remove(const K &key);
+    /**
+     * Drops this tree's reference to its nodes, copies keep theirs.
+     */
+    void clear() noexcept;
+    void swap(PersistentAVLTree &other) noexcept;
+    friend void swap(PersistentAVLTree &lhs, PersistentAVLTree &rhs) noexcept {
+        lhs.swap(rhs);
+    }
+
+    // access
+    /**
+     * Search for a value, returns nullptr if not found.
+     */
+    [[nodiscard]] T *search(const T &value) const noexcept;
+    template <typename K>
+        requires LookupKey<K, T, Compare>
+    [[nodiscard]] T *search(const K &key) const noexcept;
+    /**
+     * Returns the max value, or nullptr if the tree is empty.
+     */
+    [[nodiscard]] T *max() const noexcept;
+    /**
+     * Returns the min value, or nullptr if the tree is empty.
+     */
+    [[nodiscard]] T *min() const noexcept;
+    [[nodiscard]] bool contains(const T &value) const noexcept;
+    template <typename K>
+        requires LookupKey<K, T, Compare>
+    [[nodiscard]] bool contains(const K &key) const noexcept;
+
+    // range queries
+    /**
+     * Returns an iterator to the first value not smaller than value, or end().
+     */
+    [[nodiscard]] Iterator lower_bound(const T &value) const noexcept;
+    /**
+     * Returns an iterator to the first value greater than value, or end().
+     */
+    [[nodiscard]] Iterator upper_bound(const T &value) const noexcept;
+    /**
+     * Returns the range of values equivalent to value, which is empty or
+     * holds a single value.
+     */
+    [[nodiscard]] std::pair<Iterator, Iterator>
+    equal_range(const T &value) const noexcept;
+    /**
+     * Calls fn with every value in [lo, hi) in order, O(log n + k). If fn
+     * returns a bool, returning false stops the scan.
+     */
+    template <typename F>
+    void forEachInRange(const T &lo, const T &hi, F &&fn) const;
+    template <typename K>
+        requires LookupKey<K, T, Compare>
+    [[nodiscard]] Iterator lower_bound(const K &key) const noexcept;
+    template <typename K>
+        requires LookupKey<K, T, Compare>
+    [[nodiscard]] Iterator upper_bound(const K &key) const noexcept;
+    template <typename K>
+        requires LookupKey<K, T, Compare>
+    [[nodiscard]] std::pair<Iterator, Iterator>
+    equal_range(const K &key) const noexcept;
+    template <typename K, typename F>
+        requires LookupKey<K, T, Compare>
+    void forEachInRange(const K &lo, const K &hi, F &&fn) const;
+
+    // info
+    [[nodiscard]] int height() const noexcept;
+    [[nodiscard]] std::size_t size() const noexcept;
+    [[nodiscard]] bool empty() const noexcept;
+
+  private:
+    template <typename K>
+    [[nodiscard]] Node *searchNode(const K &key) const noexcept;
+    template <typename V> bool insertValue(V &&value);
+    /**
+     * Make the node in slot one that only this tree can reach, copying it
+     * if it is shared, and return it.
+     */
+    static Node &own(NodePtr &slot);
+    /**
+     * Let change modify the left (right) child link of the node in slot. A
+     * shared node is only copied once change returned true, so a change that
+     * fails leaves every node as it was.
+     */
+    template <typename F>
+    static bool changeChild(NodePtr &slot, bool right, F &&change);
+    // these return false if the value already is (the key is not) in the
+    // subtree
+    template <typename V> bool insertAt(NodePtr &slot, V &&value);
+    template <typename K> bool removeAt(NodePtr &slot, const K &key);
+    // takes the min value out of the subtree
+    static T takeMin(NodePtr &slot);
+    /**
+     * Restore the balance of an owned node whose subtrees differ in height
+     * by at most two.
+     */
+    static void rebalance(NodePtr &slot);
+    static void rotateLeft(NodePtr &slot);
+    static void rotateRight(NodePtr &slot);
+    static void updateHeight(Node &node) noexcept;
+    [[nodiscard]] static int height(const NodePtr &node) noexcept;
+
+    NodePtr root;
+    std::size_t count = 0;
+    Compare comp;
+};
+
+#include "persistent_avl/iterator.hpp"            // IWYU pragma: keep
+#include "persistent_avl/persistent_avl_tree.hpp" // IWYU pragma: keep
+
+static_assert(Dontainer<PersistentAVLTree<int>, int>);
+static_assert(RangeDontainer<PersistentAVLTree<int>, int>);
+static_assert(std::bidirectional_iterator<PersistentAVLTree<int>::Iterator>);
+static_assert(TransparentDontainer<PersistentAVLTree<std::string, std::less<>>,
+                                   std::string, std::string_view>);
@@ -0,0 +1,426 @@
+#pragma once
+
+#include "persistent_avl/persistent_avl_tree.h"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+template <typename T, typename Compare>
+PersistentAVLTree<T, Compare>::PersistentAVLTree(
+    PersistentAVLTree &&other) noexcept {
+    swap(other);
+}
+
+template <typename T, typename Compare>
+PersistentAVLTree<T, Compare> &
+PersistentAVLTree<T, Compare>::operator=(PersistentAVLTree &&other) noexcept {
+    if (this != &other) {
+        clear();
+        swap(other);
+    }
+    return *this;
+}
+
+template <typename T, typename Compare>
+void PersistentAVLTree<T, Compare>::swap(PersistentAVLTree &other) noexcept {
+    using std::swap;
+    swap(root, other.root);
+    swap(count, other.count);
+    swap(comp, other.comp);
+}
+
+template <typename T, typename Compare>
+typename PersistentAVLTree<T, Compare>::Iterator
+PersistentAVLTree<T, Compare>::begin() const {
+    Iterator it(root.get());
+    it.descend(root.get(), false);
+    return it;
+}
+
+template <typename T, typename Compare>
+typename PersistentAVLTree<T, Compare>::Iterator
+PersistentAVLTree<T, Compare>::end() const {
+    return Iterator(root.get());
+}
+
+template <typename T, typename Compare>
+PersistentAVLTree<T, Compare> PersistentAVLTree<T, Compare>::snapshot() const {
+    return *this;
+}
+
+template <typename T, typename Compare>
+bool PersistentAVLTree<T, Compare>::insert(const T &value) {
+    return insertValue(value);
+}
+
+template <typename T, typename Compare>
+bool PersistentAVLTree<T, Compare>::insert(T &&value) {
+    return insertValue(std::move(value));
+}
+
+template <typename T, typename Compare>
+template <typename V>
+bool PersistentAVLTree<T, Compare>::insertValue(V &&value) {
+    return insertAt(root, std::forward<V>(value));
+}
+
+template <typename T, typename Compare>
+template <typename V>
+bool PersistentAVLTree<T, Compare>::insertAt(NodePtr &slot, V &&value) {
+    if (slot == nullptr) {
+        slot = std::make_shared<Node>(std::in_place, std::forward<V>(value));
+        ++count;
+        return true;
+    }
+
+    bool right = false;
+    if (comp(value, slot->value)) {
+        right = false;
+    } else if (comp(slot->value, value)) {
+        right = true;
+    } else {
+        return false;
+    }
+    if (!changeChild(slot, right, [&](NodePtr &child) {
+            return insertAt(child, std::forward<V>(value));
+        })) {
+        return false;
+    }
+    rebalance(slot);
+    return true;
+}
+
+template <typename T, typename Compare>
+bool PersistentAVLTree<T, Compare>::remove(const T &value) {
+    return remove<T>(value);
+}
+
+template <typename T, typename Compare>
+template <typename K>
+    requires LookupKey<K, T, Compare>
+bool PersistentAVLTree<T, Compare>::remove(const K &key) {
+    if (!removeAt(root, key)) {
+        return false;
+    }
+    --count;
+    return true;
+}
+
+// The node holding the key is only copied if it has two children and takes
+// over the value of its successor, otherwise its only child replaces it
+template <typename T, typename Compare>
+template <typename K>
+bool PersistentAVLTree<T, Compare>::removeAt(NodePtr &slot, const K &key) {
+    if (slot == nullptr) {
+        return false;
+    }
+
+    const bool left = comp(key, slot->value);
+    if (left || comp(slot->value, key)) {
+        if (!changeChild(slot, !left, [&](NodePtr &child) {
+                return removeAt(child, key);
+            })) {
+            return false;
+        }
+    } else if (slot->left == nullptr) {
+        slot = slot->right;
+        return true;
+    } else if (slot->right == nullptr) {
+        slot = slot->left;
+        return true;
+    } else {
+        Node &node = own(slot);
+        node.value = takeMin(node.right);
+    }
+    rebalance(slot);
+    return true;
+}
+
+// A value only this tree can reach is moved out, a shared one is copied
+template <typename T, typename Compare>
+T PersistentAVLTree<T, Compare>::takeMin(NodePtr &slot) {
+    if (slot->left != nullptr) {
+        T value = takeMin(own(slot).left);
+        rebalance(slot);
+        return value;
+    }
+
+    if (slot.use_count() == 1) {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        T value = std::move(slot->value);
+        slot = slot->right;
+        return value;
+    }
+    T value = slot->value;
+    slot = slot->right;
+    return value;
+}
+
+template <typename T, typename Compare>
+void PersistentAVLTree<T, Compare>::clear() noexcept {
+    root.reset();
+    count = 0;
+}
+
+template <typename T, typename Compare>
+T *PersistentAVLTree<T, Compare>::search(const T &value) const noexcept {
+    return search<T>(value);
+}
+
+template <typename T, typename Compare>
+template <typename K>
+    requires LookupKey<K, T, Compare>
+T *PersistentAVLTree<T, Compare>::search(const K &key) const noexcept {
+    Node *found = searchNode(key);
+    return found != nullptr ? &found->value : nullptr;
+}
+
+template <typename T, typename Compare>
+T *PersistentAVLTree<T, Compare>::max() const noexcept {
+    Node *node = root.get();
+    if (node == nullptr) {
+        return nullptr;
+    }
+    while (node->right != nullptr) {
+        node = node->right.get();
+    }
+    return &node->value;
+}
+
+template <typename T, typename Compare>
+T *PersistentAVLTree<T, Compare>::min() const noexcept {
+    Node *node = root.get();
+    if (node == nullptr) {
+        return nullptr;
+    }
+    while (node->left != nullptr) {
+        node = node->left.get();
+    }
+    return &node->value;
+}
+
+template <typename T, typename Compare>
+bool PersistentAVLTree<T, Compare>::contains(const T &value) const noexcept {
+    return searchNode(value) != nullptr;
+}
+
+template <typename T, typename Compare>
+template <typename K>
+    requires LookupKey<K, T, Compare>
+bool PersistentAVLTree<T, Compare>::contains(const K &key) const noexcept {
+    return searchNode(key) != nullptr;
+}
+
+template <typename T, typename Compare>
+typename PersistentAVLTree<T, Compare>::Iterator
+PersistentAVLTree<T, Compare>::lower_bound(const T &value) const noexcept {
+    return lower_bound<T>(value);
+}
+
+// The whole search path goes on the iterator stack, which is then cut back to
+// the last node that was not smaller than key
+template <typename T, typename Compare>
+template <typename K>
+    requires LookupKey<K, T, Compare>
+typename PersistentAVLTree<T, Compare>::Iterator
+PersistentAVLTree<T, Compare>::lower_bound(const K &key) const noexcept {
+    Iterator it(root.get());
+    int bound = 0;
+    const Node *node = root.get();
+    while (node != nullptr) {
+        it.stack[it.depth++] = node;
+        if (comp(node->value, key)) {
+            node = node->right.get();
+        } else {
+            bound = it.depth;
+            node = node->left.get();
+        }
+    }
+    it.depth = bound;
+    return it;
+}
+
+template <typename T, typename Compare>
+typename PersistentAVLTree<T, Compare>::Iterator
+PersistentAVLTree<T, Compare>::upper_bound(const T &value) const noexcept {
+    return upper_bound<T>(value);
+}
+
+template <typename T, typename Compare>
+template <typename K>
+    requires LookupKey<K, T, Compare>
+typename PersistentAVLTree<T, Compare>::Iterator
+PersistentAVLTree<T, Compare>::upper_bound(const K &key) const noexcept {
+    return equal_range(key).second;
+}
+
+template <typename T, typename Compare>
+std::pair<typename PersistentAVLTree<T, Compare>::Iterator,
+          typename PersistentAVLTree<T, Compare>::Iterator>
+PersistentAVLTree<T, Compare>::equal_range(const T &value) const noexcept {
+    return equal_range<T>(value);
+}
+
+template <typename T, typename Compare>
+template <typename K>
+    requires LookupKey<K, T, Compare>
+std::pair<typename PersistentAVLTree<T, Compare>::Iterator,
+          typename PersistentAVLTree<T, Compare>::Iterator>
+PersistentAVLTree<T, Compare>::equal_range(const K &key) const noexcept {
+    Iterator lower = lower_bound(key);
+    if (lower != end() && !comp(key, *lower)) {
+        return {lower, std::next(lower)};
+    }
+    return {lower, lower};
+}
+
+template <typename T, typename Compare>
+template <typename F>
+void PersistentAVLTree<T, Compare>::forEachInRange(const T &lo, const T &hi,
+                                                   F &&fn) const {
+    forEachInRange<T>(lo, hi, std::forward<F>(fn));
+}
+
+template <typename T, typename Compare>
+template <typename K, typename F>
+    requires LookupKey<K, T, Compare>
+void PersistentAVLTree<T, Compare>::forEachInRange(const K &lo, const K &hi,
+                                                   F &&fn) const {
+    for (Iterator it = lower_bound(lo); it != end() && comp(*it, hi); ++it) {
+        if constexpr (std::is_same_v<std::invoke_result_t<F &, const T &>,
+                                     bool>) {
+            if (!fn(*it)) {
+                return;
+            }
+        } else {
+            fn(*it);
+        }
+    }
+}
+
+template <typename T, typename Compare>
+int PersistentAVLTree<T, Compare>::height() const noexcept {
+    return height(root);
+}
+
+template <typename T, typename Compare>
+std::size_t PersistentAVLTree<T, Compare>::size() const noexcept {
+    return count;
+}
+
+template <typename T, typename Compare>
+bool PersistentAVLTree<T, Compare>::empty() const noexcept {
+    return count == 0;
+}
+
+template <typename T, typename Compare>
+template <typename K>
+typename PersistentAVLTree<T, Compare>::Node *
+PersistentAVLTree<T, Compare>::searchNode(const K &key) const noexcept {
+    Node *node = root.get();
+    while (node != nullptr) {
+        if (comp(key, node->value)) {
+            node = node->left.get();
+        } else if (comp(node->value, key)) {
+            node = node->right.get();
+        } else {
+            return node;
+        }
+    }
+    return nullptr;
+}
+
+// Only the tree can hold the last reference to a node it reached from an
+// owned parent, so no other thread can take a new one while it is changed.
+// The acquire fence pairs with the release in the reference count drop of
+// the last other owner, whose reads then happen before the changes.
+template <typename T, typename Compare>
+typename PersistentAVLTree<T, Compare>::Node &
+PersistentAVLTree<T, Compare>::own(NodePtr &slot) {
+    if (slot.use_count() == 1) {
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } else {
+        slot = std::make_shared<Node>(*slot);
+    }
+    return *slot;
+}
+
+// Below a shared node the change works on a reference of its own to the
+// child, which makes the whole subtree count as shared. It is copied on the
+// way back up, where the copy takes the changed child.
+template <typename T, typename Compare>
+template <typename F>
+bool PersistentAVLTree<T, Compare>::changeChild(NodePtr &slot, bool right,
+                                                F &&change) {
+    if (slot.use_count() == 1) {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return change(right ? slot->right : slot->left);
+    }
+
+    NodePtr child = right ? slot->right : slot->left;
+    if (!change(child)) {
+        return false;
+    }
+    Node &node = own(slot);
+    (right ? node.right : node.left) = std::move(child);
+    return true;
+}
+
+template <typename T, typename Compare>
+void PersistentAVLTree<T, Compare>::rebalance(NodePtr &slot) {
+    Node &node = *slot;
+    const int balance = height(node.right) - height(node.left);
+    if (balance > 1) {
+        if (height(node.right->left) > height(node.right->right)) {
+            own(node.right);
+            rotateRight(node.right);
+        }
+        rotateLeft(slot);
+    } else if (balance < -1) {
+        if (height(node.left->right) > height(node.left->left)) {
+            own(node.left);
+            rotateLeft(node.left);
+        }
+        rotateRight(slot);
+    } else {
+        updateHeight(node);
+    }
+}
+
+// The pivot is owned before any link changes, so a failed copy leaves the
+// tree as it was
+template <typename T, typename Compare>
+void PersistentAVLTree<T, Compare>::rotateLeft(NodePtr &slot) {
+    own(slot->right);
+    NodePtr pivot = std::move(slot->right);
+    slot->right = std::move(pivot->left);
+    updateHeight(*slot);
+    pivot->left = std::move(slot);
+    updateHeight(*pivot);
+    slot = std::move(pivot);
+}
+
+template <typename T, typename Compare>
+void PersistentAVLTree<T, Compare>::rotateRight(NodePtr &slot) {
+    own(slot->left);
+    NodePtr pivot = std::move(slot->left);
+    slot->left = std::move(pivot->right);
+    updateHeight(*slot);
+    pivot->right = std::move(slot);
+    updateHeight(*pivot);
+    slot = std::move(pivot);
+}
+
+template <typename T, typename Compare>
+void PersistentAVLTree<T, Compare>::updateHeight(Node &node) noexcept {
+    node.height = 1 + std::max(height(node.left), height(node.right));
+}
+
+template <typename T, typename Compare>
+int PersistentAVLTree<T, Compare>::height(const NodePtr &node) noexcept {
+    return node != nullptr ? node->height : 0;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "skiplist/skiplist.h"
+
+template <typename T, typename Compare, typename Stats>
+T &SkipList<T, Compare, Stats>::Iterator::operator*() const {
+    return node->value;
+}
+
+template <typename T, typename Compare, typename Stats>
+T *SkipList<T, Compare, Stats>::Iterator::operator->() const {
+    return &node->value;
+}
+
+// every node is on the lowest lane, so that lane visits all of them in order
+template <typename T, typename Compare, typename Stats>
+typename SkipList<T, Compare, Stats>::Iterator &
+SkipList<T, Compare, Stats>::Iterator::operator++() {
+    node = node->forward()[0].next;
+    return *this;
+}
+
+template <typename T, typename Compare, typename Stats>
+typename SkipList<T, Compare, Stats>::Iterator
+SkipList<T, Compare, Stats>::Iterator::operator++(int) {
+    Iterator temp = *this;
+    ++(*this);
+    return temp;
+}
+
+template <typename T, typename Compare, typename Stats>
+bool SkipList<T, Compare, Stats>::Iterator::operator==(
+    const Iterator &other) const {
+    return node == other.node;
+}
+
+template <typename T, typename Compare, typename Stats>
+bool SkipList<T, Compare, Stats>::Iterator::operator!=(
+    const Iterator &other) const {
+    return !(*this == other);
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+
+/**
+ * Level of a new skip list node, drawn from gen and capped at maxLevel.
+ * Every bit of a random word is a coin flip, so a node reaches the next level
+ * with probability 1/2, and one call to gen decides all levels.
+ */
+template <typename Gen> int geometricLevel(Gen &gen, int maxLevel) {
+    return std::min(1 + std::countr_one(static_cast<uint32_t>(gen())),
+                    maxLevel);
+}
@@ -1,54 +1,276 @@
 #pragma once
 
 #include "container.h"
+#include "snapshot/snapshot_file.h"
+#include "stats.h"
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <filesystem>
+#include <iterator>
+#include <new>
 #include <random>
+#include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 constexpr int DEFAULT_MAX_LEVEL = 20;
+// highest level a list can be built with, larger maxLevels are capped. The
+// header, the tails and the predecessors of an update are arrays this long
+constexpr int SKIPLIST_MAX_LEVEL = 32;
+// searches containsMany and searchMany interleave
+constexpr size_t SKIPLIST_LOOKUP_GROUP = 16;
+// below this size a list mostly sits in cache, and containsMany and
+// searchMany do plain searches since there are few misses to overlap
+constexpr size_t SKIPLIST_LOOKUP_GROUP_MIN_SIZE = 1 << 16;
+
+template <typename T, typename Compare = std::less<T>,
+          typename Stats = NoStats>
+class SkipList {
+    static_assert(StatsPolicy<Stats>);
+
+  private:
+    struct Node;
 
-template <typename T, typename Compare = std::less<T>> class SkipList {
   public:
-    // this one (or the maxLevel) even necessary?
+    // this one (or the maxLevel) even necessary? The default is a completely
+    // arbitrary value, log(1,000,000) =~ 20, anything above
+    // SKIPLIST_MAX_LEVEL is capped
     explicit SkipList(int maxLevel = DEFAULT_MAX_LEVEL)
-        : _maxLevel(maxLevel) {}; // completely arbitrary value,
-                                  // log(1,000,000) =~ 20
+        : _maxLevel(std::clamp(maxLevel, 1, SKIPLIST_MAX_LEVEL)) {}
 
     SkipList(const SkipList &) = delete;
-    SkipList(SkipList &&) = delete;
+    // moving hands over the nodes, the moved-from list is left empty
+    SkipList(SkipList &&other) noexcept;
     SkipList &operator=(const SkipList &) = delete;
-    SkipList &operator=(SkipList &&) = delete;
-    ~SkipList() = default;
+    SkipList &operator=(SkipList &&other) noexcept;
+    ~SkipList() { clear(); }
+
+    // forward iterator, walks the lowest lane in order
+    class Iterator {
+      public:
+        using iterator_category = std::forward_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = T;
+        using pointer = T *;
+        using reference = T &;
+
+        Iterator() = default;
+        explicit Iterator(Node *node) : node(node) {}
+
+        reference operator*() const;
+        pointer operator->() const;
+
+        Iterator &operator++();
+        Iterator operator++(int);
+        bool operator==(const Iterator &other) const;
+        bool operator!=(const Iterator &other) const;
+
+      private:
+        Node *node = nullptr;
+    };
+
+    [[nodiscard]] Iterator begin() const;
+    [[nodiscard]] Iterator end() const;
 
-    bool insert(T value);
+    // values beyond the current min or max are linked in next to the header
+    // or the tail without walking the express lanes
+    bool insert(const T &value);
+    bool insert(T &&value);
+    // construct the value in place, dropped again if it already exists
+    template <typename... Args> bool emplace(Args &&...args);
     bool remove(const T &value);
+    // insert or remove a whole batch, returns how many values were inserted
+    // or removed. The batch is sorted and merged in one pass along the list:
+    // every value starts its search from the predecessors of the value before
+    // instead of from the header
+    template <std::ranges::input_range R>
+        requires std::constructible_from<T, std::ranges::range_reference_t<R>>
+    size_t insertBatch(R &&values);
+    template <std::ranges::input_range R>
+        requires std::constructible_from<T, std::ranges::range_reference_t<R>>
+    size_t removeBatch(R &&values);
+    // write the values in order to a snapshot file with a header and a
+    // checksum, see writeSnapshot
+    void save(const std::filesystem::path &path) const
+        requires std::is_trivially_copyable_v<T>;
+    // replace the contents with the values of a file written by save. The
+    // sorted values are appended straight out of the mapped file in O(n).
+    // Throws like SnapshotMapping and leaves the list untouched if the file
+    // cannot be read or is damaged
+    void load(const std::filesystem::path &path)
+        requires std::is_trivially_copyable_v<T>;
     T *search(const T &value) const;
     T *max() const;
     T *min() const;
     bool contains(const T &value) const;
+    // look up a batch of keys, found needs room for one entry per key.
+    // Returns how many were found. Up to SKIPLIST_LOOKUP_GROUP searches run
+    // interleaved, each takes one step in turn and prefetches what it reads
+    // next, so their cache misses overlap instead of stalling one by one
+    size_t containsMany(std::span<const T> keys, std::span<bool> found) const;
+    // same as containsMany, but stores a pointer to every value found and
+    // nullptr for the others
+    void searchMany(std::span<const T> keys, std::span<T *> results) const;
     [[nodiscard]] size_t size() const;
     void clear();
     [[nodiscard]] bool empty() const;
+    void swap(SkipList &other) noexcept;
+    friend void swap(SkipList &lhs, SkipList &rhs) noexcept { lhs.swap(rhs); }
+    // what the list has counted so far, see StatsPolicy. The default NoStats
+    // counts nothing and its hooks compile away
+    [[nodiscard]] const Stats &stats() const noexcept { return _stats; }
+    Stats &stats() noexcept { return _stats; }
+
+    // range queries, one descent through the express lanes each
+    // first value not smaller than value, or end()
+    [[nodiscard]] Iterator lower_bound(const T &value) const;
+    // first value greater than value, or end()
+    [[nodiscard]] Iterator upper_bound(const T &value) const;
+    // the values equivalent to value, empty or a single one
+    [[nodiscard]] std::pair<Iterator, Iterator>
+    equal_range(const T &value) const;
+    // call fn with every value in [lo, hi) in order, O(log n + k). If fn
+    // returns a bool, returning false stops the scan
+    template <typename F>
+    void forEachInRange(const T &lo, const T &hi, F &&fn) const;
+
+    // positional access, every link knows how many values it skips, so
+    // these descend the express lanes like a search, O(log n)
+    // number of values smaller than value
+    [[nodiscard]] size_t rank(const T &value) const;
+    // the k-th smallest value (0 based), nullptr if k is not smaller than
+    // the size
+    [[nodiscard]] T *select(size_t k) const;
+    // the count values starting at position k, fewer at the end of the
+    // list. Both ends are found by a descent, O(log n + count) to iterate
+    [[nodiscard]] std::ranges::subrange<Iterator> slice(size_t k,
+                                                        size_t count) const;
+
+    // heterogeneous lookup, only available with a transparent comparator
+    template <typename K>
+        requires LookupKey<K, T, Compare>
+    bool remove(const K &key);
+    template <typename K>
+        requires LookupKey<K, T, Compare>
+    T *search(const K &key) const;
+    template <typename K>
+        requires LookupKey<K, T, Compare>
+    bool contains(const K &key) const;
+    template <typename K>
+        requires LookupKey<K, T, Compare>
+    [[nodiscard]] Iterator lower_bound(const K &key) const;
+    template <typename K>
+        requires LookupKey<K, T, Compare>
+    [[nodiscard]] Iterator upper_bound(const K &key) const;
+    template <typename K>
+        requires LookupKey<K, T, Compare>
+    [[nodiscard]] std::pair<Iterator, Iterator> equal_range(const K &key) const;
+    template <typename K, typename F>
+        requires LookupKey<K, T, Compare>
+    void forEachInRange(const K &lo, const K &hi, F &&fn) const;
+    template <typename K>
+        requires LookupKey<K, T, Compare>
+    [[nodiscard]] size_t rank(const K &key) const;
 
   private:
+    // A link of a lane: the next node and its width, how many steps along
+    // the lowest lane it skips. The end of a lane counts as the position
+    // after the last node, so the widths of a lane always add up to size + 1
+    struct Hop {
+        Node *next = nullptr;
+        size_t width = 1;
+    };
+
+    // A node and its forward links are a single allocation, the links
+    // follow the value, one for every level of the node. Comparing a node
+    // and moving on from it usually touches a single cache line
     struct Node {
         T value;
-        std::vector<Node *> forward;
 
-        Node(const T &val, int level) : value(val), forward(level, nullptr) {}
+        template <typename... Args>
+        explicit Node(Args &&...args) : value(std::forward<Args>(args)...) {}
+
+        Hop *forward() noexcept;
     };
 
+    // the forward links of a node or of the header, a predecessor during
+    // an update is the tower it has to be linked in after
+    using Link = Hop *;
+
+    // where the tower starts behind a node, and how nodes are aligned
+    static constexpr size_t TOWER_OFFSET =
+        (sizeof(Node) + alignof(Hop) - 1) / alignof(Hop) * alignof(Hop);
+    static constexpr std::align_val_t NODE_ALIGNMENT{
+        std::max(alignof(Node), alignof(Hop))};
+
+    // the node a tower belongs to, never call this with the header
+    static Node *owner(Link tower) noexcept;
+
     int randomLevel();
-    Node *createNode(const T &value, int level);
+    template <typename... Args> Node *createNode(int level, Args &&...args);
+    static void destroyNode(Node *node) noexcept;
+    // shared by both inserts, returns false if the value already existed
+    template <typename V> bool insertValue(V &&value);
+    // fill update with the predecessors of value on every level, returns the
+    // node holding an equivalent value if there is one
+    Node *findInsertPosition(const T &value, Link *update);
+    // link a new node in after the predecessors found by findPredecessor,
+    // splitting the widths of the links it is put into
+    void linkNode(Node *node, int nodeLevel, Link *update);
+    // unlink a node from every lane, update holds its predecessors
+    void unlinkNode(Node *node, Link *update);
+    // move the predecessors in update forward to those of value, which must
+    // not be smaller than the value they were found for. Returns the
+    // predecessor on the lowest lane
+    Link advancePredecessors(const T &value, Link *update);
+    // append strictly increasing values behind the current max, each one is
+    // linked in after the tails of its lanes
+    template <typename InputIt, typename Sentinel>
+    void appendSorted(InputIt first, Sentinel last);
+    // copy a range into a vector, sorted and without duplicates
+    template <typename InputIt, typename Sentinel>
+    std::vector<T> sortedValues(InputIt first, Sentinel last) const;
+    // the interleaved searches behind containsMany and searchMany, calls
+    // visit(i, node) with the node holding keys[i], or nullptr
+    template <typename Visit>
+    void lookupMany(std::span<const T> keys, Visit visit) const;
+    // walk the express lanes down to the last node before key, remembering
+    // the last node visited on every level in update when it is given.
+    // update needs room for SKIPLIST_MAX_LEVEL entries
+    template <typename K>
+    Link findPredecessor(const K &key, Link *update) const;
+    // the node at position index (0 based), nullptr past the end
+    Node *nodeAt(size_t index) const;
+    // comp(lhs, rhs), counted as a comparison
+    template <typename L, typename R>
+    [[nodiscard]] bool compare(const L &lhs, const R &rhs) const;
 
-    const int _maxLevel;
+    int _maxLevel;
     int _currentLevel = 0;
     size_t _size = 0;
-    Node *_header;
+    // the header is a tower without a node, mutable since the const
+    // searches hand it out as the predecessor of the smallest values
+    mutable Hop _header[SKIPLIST_MAX_LEVEL] = {};
+    // last node of every lane, nullptr while the lane is empty
+    Node *_tail[SKIPLIST_MAX_LEVEL] = {};
     mutable std::mt19937 _gen;
     mutable std::uniform_real_distribution<> _dist;
     Compare comp;
+    // counters stay with the list, moves and swaps do not exchange them
+    [[no_unique_address]] mutable Stats _stats;
 };
 
 #include "skiplist/skiplist.hpp"
+#include "skiplist/iterator.hpp" // IWYU pragma: keep
 
 static_assert(Dontainer<SkipList<int>, int>);
+static_assert(RangeDontainer<SkipList<int>, int>);
+static_assert(std::ranges::forward_range<SkipList<int>>);
+static_assert(std::forward_iterator<SkipList<int>::Iterator>);
+static_assert(TransparentDontainer<SkipList<std::string, std::less<>>,
+                                   std::string, std::string_view>);
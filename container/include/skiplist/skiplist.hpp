@@ -1,209 +1,670 @@
 #pragma once
 
 #include "skiplist/skiplist.h"
+#include <algorithm>
+#include <filesystem>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <ranges>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 constexpr float LEVEL_UP_CHANCE = 0.5;
 
+template <typename T, typename Compare, typename Stats>
+SkipList<T, Compare, Stats>::SkipList(SkipList &&other) noexcept
+    : _maxLevel(other._maxLevel) {
+    swap(other);
+}
+
+template <typename T, typename Compare, typename Stats>
+SkipList<T, Compare, Stats> &
+SkipList<T, Compare, Stats>::operator=(SkipList &&other) noexcept {
+    if (this != &other) {
+        clear();
+        swap(other);
+    }
+    return *this;
+}
+
 // Insert a value into the skiplist
 // return true if successfully inserted, false otherwise
-template <typename T, typename Compare>
-bool SkipList<T, Compare>::insert(T value) {
-    // to keep track of pointers from nodes to update
-    std::vector<Node *> update(_maxLevel, nullptr);
-    Node *current = _header;
+template <typename T, typename Compare, typename Stats>
+bool SkipList<T, Compare, Stats>::insert(const T &value) {
+    return insertValue(value);
+}
 
-    // start at highest express lane, go down a level when next node is
-    // higher than node we are looking for
-    for (int level = _currentLevel - 1; level >= 0; --level) {
-        bool lessThan = comp(current->forward[level]->value, value);
-        while (current->forward[level] && lessThan) {
-            current = current->forward[level];
-        }
-    }
+// Same as above, but the value is moved into the new node
+template <typename T, typename Compare, typename Stats>
+bool SkipList<T, Compare, Stats>::insert(T &&value) {
+    return insertValue(std::move(value));
+}
 
-    current = current->forward[0];
+template <typename T, typename Compare, typename Stats>
+template <typename V>
+bool SkipList<T, Compare, Stats>::insertValue(V &&value) {
+    // to keep track of pointers from nodes to update
+    Link update[SKIPLIST_MAX_LEVEL];
 
     // if node with value already exists, dont insert
-    bool equal = !comp(value, current->value) && !comp(current->value, value);
-    if (current && equal) {
+    if (findInsertPosition(value, update) != nullptr) {
         return false;
     }
 
     // get level of node for express lanes
     int nodeLevel = randomLevel();
+    Node *node = createNode(nodeLevel, std::forward<V>(value));
+    linkNode(node, nodeLevel, update);
+    return true;
+}
+
+// new values at either end have the header or the tail as predecessors on
+// every level, everything else walks the express lanes
+template <typename T, typename Compare, typename Stats>
+typename SkipList<T, Compare, Stats>::Node *
+SkipList<T, Compare, Stats>::findInsertPosition(const T &value,
+                                                Link *update) {
+    if (_size > 0 && compare(_tail[0]->value, value)) {
+        _stats.search(1);
+        for (int i = 0; i < _currentLevel; ++i) {
+            update[i] = _tail[i]->forward();
+        }
+        return nullptr;
+    }
+    if (_size > 0 && compare(value, _header[0].next->value)) {
+        _stats.search(1);
+        std::fill(update, update + _currentLevel, Link{_header});
+        return nullptr;
+    }
 
+    Node *current = findPredecessor(value, update)[0].next;
+    if (current && !compare(value, current->value) &&
+        !compare(current->value, value)) {
+        return current;
+    }
+    return nullptr;
+}
+
+// The node has to be built before its value can be compared, it is deleted
+// again if the value turns out to exist already
+template <typename T, typename Compare, typename Stats>
+template <typename... Args>
+bool SkipList<T, Compare, Stats>::emplace(Args &&...args) {
+    int nodeLevel = randomLevel();
+    Node *newNode = createNode(nodeLevel, std::forward<Args>(args)...);
+
+    Link update[SKIPLIST_MAX_LEVEL];
+    if (findInsertPosition(newNode->value, update) != nullptr) {
+        destroyNode(newNode);
+        return false;
+    }
+
+    linkNode(newNode, nodeLevel, update);
+    return true;
+}
+
+// The predecessor on a lane is found on the lane below by following that
+// lane from the predecessor one level up, which sums up how far ahead of it
+// the new node is. Links above the node's level now skip one more value.
+template <typename T, typename Compare, typename Stats>
+void SkipList<T, Compare, Stats>::linkNode(Node *node, int nodeLevel,
+                                           Link *update) {
     // if not enough express lanes exist for the generated level, create them
     if (nodeLevel > _currentLevel) {
         for (int i = _currentLevel; i < nodeLevel; ++i) {
             update[i] = _header;
+            _header[i] = Hop{nullptr, _size + 1};
         }
         _currentLevel = nodeLevel;
     }
 
-    Node *newNode = createNode(value, nodeLevel);
-
+    Link forward = node->forward();
+    // steps from update[i] to the new node
+    size_t distance = 1;
     for (int i = 0; i < nodeLevel; ++i) {
-        // set outgoing pointers to next point in lane
-        newNode->forward[i] = update[i]->forward[i];
+        for (Link below = update[i]; i > 0 && below != update[i - 1];) {
+            distance += below[i - 1].width;
+            below = below[i - 1].next->forward();
+        }
+
+        // set outgoing links to the next node in the lane
+        Hop &incoming = update[i][i];
+        forward[i] = Hop{incoming.next, incoming.width + 1 - distance};
 
-        // set incoming pointers from the memorized update list
-        update[i]->forward[i] = newNode;
+        // set incoming links from the memorized update list
+        incoming = Hop{node, distance};
+
+        if (forward[i].next == nullptr) {
+            _tail[i] = node;
+        }
+    }
+    for (int i = nodeLevel; i < _currentLevel; ++i) {
+        ++update[i][i].width;
     }
 
     ++_size;
-    return true;
 }
 
 // Remove a value from the skiplist
 // return true if successfully removed, false otherwise
-template <typename T, typename Compare>
-bool SkipList<T, Compare>::remove(const T &value) {
-    std::vector<Node *> update(_maxLevel, nullptr);
-    Node *current = _header;
-
-    // start at highest express lane, go down a level when next node is
-    // higher than node we are looking for
-    for (int level = _currentLevel - 1; level >= 0; --level) {
-        bool lessThan = comp(current->forward[level]->value, value);
-        while (current->forward[level] && lessThan) {
-            current = current->forward[level];
-        }
-    }
+template <typename T, typename Compare, typename Stats>
+bool SkipList<T, Compare, Stats>::remove(const T &value) {
+    return remove<T>(value);
+}
 
-    current = current->forward[0];
+template <typename T, typename Compare, typename Stats>
+template <typename K>
+    requires LookupKey<K, T, Compare>
+bool SkipList<T, Compare, Stats>::remove(const K &key) {
+    Link update[SKIPLIST_MAX_LEVEL];
+    Node *current = findPredecessor(key, update)[0].next;
 
     // if value doesnt exist, return false
-    if ((current == nullptr) || comp(value, current->value) ||
-        comp(current->value, value)) {
+    if ((current == nullptr) || compare(key, current->value) ||
+        compare(current->value, key)) {
         return false;
     }
 
-    // update forward pointers to point at next item on each express lane
+    unlinkNode(current, update);
+    return true;
+}
+
+template <typename T, typename Compare, typename Stats>
+void SkipList<T, Compare, Stats>::unlinkNode(Node *node, Link *update) {
+    // update forward links to point at next item on each express lane, the
+    // links passing over the node above its level skip one value less
+    Link forward = node->forward();
     for (int i = 0; i < _currentLevel; ++i) {
-        // check if there are no more pointers at this level or further
-        if (update[i]->forward[i] != current) {
-            break;
+        if (update[i][i].next != node) {
+            --update[i][i].width;
+            continue;
+        }
+        update[i][i] = Hop{forward[i].next,
+                           update[i][i].width + forward[i].width - 1};
+
+        if (_tail[i] == node) {
+            _tail[i] = update[i] == _header ? nullptr : owner(update[i]);
         }
-        update[i]->forward[i] = current->forward[i];
     }
 
-    delete current;
+    destroyNode(node);
     --_size;
 
     // update current level if necessary (deleted a node of the highest express
     // lane)
-    while (_currentLevel > 1 &&
-           _header->forward[_currentLevel - 1] == nullptr) {
+    while (_currentLevel > 1 && _header[_currentLevel - 1].next == nullptr) {
         --_currentLevel;
     }
+}
 
-    return true;
+// a new node is the predecessor of every later value on its lanes, so it
+// takes over those entries of update
+template <typename T, typename Compare, typename Stats>
+template <std::ranges::input_range R>
+    requires std::constructible_from<T, std::ranges::range_reference_t<R>>
+size_t SkipList<T, Compare, Stats>::insertBatch(R &&values) {
+    std::vector<T> batch =
+        sortedValues(std::ranges::begin(values), std::ranges::end(values));
+    Link update[SKIPLIST_MAX_LEVEL];
+    std::fill(std::begin(update), std::end(update), Link{_header});
+    size_t inserted = 0;
+
+    for (T &value : batch) {
+        Node *next = advancePredecessors(value, update)[0].next;
+        if (next != nullptr && !compare(value, next->value)) {
+            continue;
+        }
+
+        int nodeLevel = randomLevel();
+        Node *node = createNode(nodeLevel, std::move(value));
+        linkNode(node, nodeLevel, update);
+        std::fill(update, update + nodeLevel, node->forward());
+        ++inserted;
+    }
+    return inserted;
 }
 
-// Search the skiplist for a value
-// return the node if the value exists, else return a nullpointer
-template <typename T, typename Compare>
-T *SkipList<T, Compare>::search(const T &value) const {
-    Node *current = _header;
+template <typename T, typename Compare, typename Stats>
+template <std::ranges::input_range R>
+    requires std::constructible_from<T, std::ranges::range_reference_t<R>>
+size_t SkipList<T, Compare, Stats>::removeBatch(R &&values) {
+    std::vector<T> batch =
+        sortedValues(std::ranges::begin(values), std::ranges::end(values));
+    Link update[SKIPLIST_MAX_LEVEL];
+    std::fill(std::begin(update), std::end(update), Link{_header});
+    size_t removed = 0;
+
+    for (const T &value : batch) {
+        Node *current = advancePredecessors(value, update)[0].next;
+        if (current == nullptr || compare(value, current->value)) {
+            continue;
+        }
+        unlinkNode(current, update);
+        ++removed;
+    }
+    return removed;
+}
 
-    // start at highest express lane, go down a level when next node is
-    // higher than node we are looking for
+// On every lane the search resumes from whichever is further along: the old
+// predecessor on that lane or the new one found on the lane above
+template <typename T, typename Compare, typename Stats>
+typename SkipList<T, Compare, Stats>::Link
+SkipList<T, Compare, Stats>::advancePredecessors(const T &value,
+                                                 Link *update) {
+    Link current = _header;
     for (int level = _currentLevel - 1; level >= 0; --level) {
-        bool lessThan = comp(current->forward[level]->value, value);
-        while (current->forward[level] && lessThan) {
-            current = current->forward[level];
+        Link finger = update[level];
+        if (current == _header ||
+            (finger != _header &&
+             compare(owner(current)->value, owner(finger)->value))) {
+            current = finger;
         }
+        while (current[level].next &&
+               compare(current[level].next->value, value)) {
+            current = current[level].next->forward();
+        }
+        update[level] = current;
     }
+    return current;
+}
+
+template <typename T, typename Compare, typename Stats>
+void SkipList<T, Compare, Stats>::save(const std::filesystem::path &path) const
+    requires std::is_trivially_copyable_v<T>
+{
+    writeSnapshot<T>(path, begin(), _size);
+}
+
+// a file that is not strictly increasing, e.g. one written with another
+// comparator, still loads, it just takes the sorting batch insert
+template <typename T, typename Compare, typename Stats>
+void SkipList<T, Compare, Stats>::load(const std::filesystem::path &path)
+    requires std::is_trivially_copyable_v<T>
+{
+    SnapshotMapping<T> snapshot(path);
+    std::span<const T> values = snapshot.values();
+    clear();
+
+    const auto outOfOrder = [this](const T &lhs, const T &rhs) {
+        return !compare(lhs, rhs);
+    };
+    if (std::ranges::adjacent_find(values, outOfOrder) == values.end()) {
+        appendSorted(values.begin(), values.end());
+    } else {
+        insertBatch(values);
+    }
+}
+
+template <typename T, typename Compare, typename Stats>
+template <typename InputIt, typename Sentinel>
+void SkipList<T, Compare, Stats>::appendSorted(InputIt first, Sentinel last) {
+    Link update[SKIPLIST_MAX_LEVEL];
+    std::fill(std::begin(update), std::end(update), Link{_header});
+    for (int i = 0; i < _currentLevel; ++i) {
+        if (_tail[i] != nullptr) {
+            update[i] = _tail[i]->forward();
+        }
+    }
+
+    for (; first != last; ++first) {
+        int nodeLevel = randomLevel();
+        Node *node = createNode(nodeLevel, *first);
+        linkNode(node, nodeLevel, update);
+        std::fill(update, update + nodeLevel, node->forward());
+    }
+}
+
+template <typename T, typename Compare, typename Stats>
+template <typename InputIt, typename Sentinel>
+std::vector<T> SkipList<T, Compare, Stats>::sortedValues(InputIt first,
+                                                         Sentinel last) const {
+    std::vector<T> values;
+    for (; first != last; ++first) {
+        values.emplace_back(*first);
+    }
+    const auto less = [this](const T &lhs, const T &rhs) {
+        return compare(lhs, rhs);
+    };
+    std::sort(values.begin(), values.end(), less);
+    values.erase(std::unique(values.begin(), values.end(),
+                             [&less](const T &lhs, const T &rhs) {
+                                 return !less(lhs, rhs) && !less(rhs, lhs);
+                             }),
+                 values.end());
+    return values;
+}
+
+// Search the skiplist for a value
+// return the node if the value exists, else return a nullpointer
+template <typename T, typename Compare, typename Stats>
+T *SkipList<T, Compare, Stats>::search(const T &value) const {
+    return search<T>(value);
+}
 
-    current = current->forward[0];
+template <typename T, typename Compare, typename Stats>
+template <typename K>
+    requires LookupKey<K, T, Compare>
+T *SkipList<T, Compare, Stats>::search(const K &key) const {
+    Node *current = findPredecessor(key, nullptr)[0].next;
 
     // Check if the found node equals the value
-    bool equal = !comp(value, current->value) && !comp(current->value, value);
-    if (current && equal) {
+    if (current && !compare(key, current->value) &&
+        !compare(current->value, key)) {
         return &current->value;
     }
 
     return nullptr;
 }
 
-// go all the way to the lowest layer of skiplist,
-// then run through until you reach a node that has no pointers out
-// return value of last node
-template <typename T, typename Compare> T *SkipList<T, Compare>::max() const {
-    Node *x = _header;
-    // Traverse as far as possible on level 0
-    while (x->forward[0] != nullptr) {
-        x = x->forward[0];
-    }
-
-    // If list is empty, x == _header, and x->forward[0] == nullptr
-    return (x == _header) ? nullptr : &x->value;
+// the tail of the lowest lane is the last node
+template <typename T, typename Compare, typename Stats>
+T *SkipList<T, Compare, Stats>::max() const {
+    Node *x = _tail[0];
+    return x ? &x->value : nullptr;
 }
 
 // return the element after the dummy header
-template <typename T, typename Compare> T *SkipList<T, Compare>::min() const {
-    Node *x = _header->forward[0];
+template <typename T, typename Compare, typename Stats>
+T *SkipList<T, Compare, Stats>::min() const {
+    Node *x = _header[0].next;
     return x ? &x->value : nullptr;
 }
 
 // Look if a value exists in the skiplist
 // return true if it exists, else return false
-template <typename T, typename Compare>
-bool SkipList<T, Compare>::contains(const T &value) const {
-    Node *current = _header;
+template <typename T, typename Compare, typename Stats>
+bool SkipList<T, Compare, Stats>::contains(const T &value) const {
+    return contains<T>(value);
+}
+
+template <typename T, typename Compare, typename Stats>
+template <typename K>
+    requires LookupKey<K, T, Compare>
+bool SkipList<T, Compare, Stats>::contains(const K &key) const {
+    // next node is the one we are looking for
+    Node *current = findPredecessor(key, nullptr)[0].next;
+
+    return current && !compare(key, current->value) &&
+           !compare(current->value, key);
+}
+
+template <typename T, typename Compare, typename Stats>
+size_t SkipList<T, Compare, Stats>::containsMany(std::span<const T> keys,
+                                                 std::span<bool> found) const {
+    size_t hits = 0;
+    lookupMany(keys, [&](size_t i, Node *node) {
+        found[i] = node != nullptr;
+        hits += node != nullptr ? 1 : 0;
+    });
+    return hits;
+}
+
+template <typename T, typename Compare, typename Stats>
+void SkipList<T, Compare, Stats>::searchMany(std::span<const T> keys,
+                                             std::span<T *> results) const {
+    lookupMany(keys, [&](size_t i, Node *node) {
+        results[i] = node != nullptr ? &node->value : nullptr;
+    });
+}
+
+// A turn compares against the candidate prefetched in the last turn, then
+// loads and prefetches the next one, either further along the lane or on
+// the lane below. The other searches of the group run in between.
+template <typename T, typename Compare, typename Stats>
+template <typename Visit>
+void SkipList<T, Compare, Stats>::lookupMany(std::span<const T> keys,
+                                             Visit visit) const {
+    struct Search {
+        Link current;
+        Node *candidate;
+        int level;
+        bool done;
+    };
+
+    if (_size < SKIPLIST_LOOKUP_GROUP_MIN_SIZE) {
+        for (size_t i = 0; i < keys.size(); ++i) {
+            Node *node = findPredecessor(keys[i], nullptr)[0].next;
+            const bool found =
+                node != nullptr && !compare(keys[i], node->value);
+            visit(i, found ? node : nullptr);
+        }
+        return;
+    }
+
+    Search searches[SKIPLIST_LOOKUP_GROUP];
+    for (size_t base = 0; base < keys.size(); base += SKIPLIST_LOOKUP_GROUP) {
+        const size_t group =
+            std::min(SKIPLIST_LOOKUP_GROUP, keys.size() - base);
+        for (size_t i = 0; i < group; ++i) {
+            if (_currentLevel == 0) {
+                searches[i] = {_header, nullptr, 0, true};
+                visit(base + i, nullptr);
+                continue;
+            }
+            const int level = _currentLevel - 1;
+            searches[i] = {_header, _header[level].next, level, false};
+        }
+
+        for (size_t active = group; active > 0;) {
+            active = 0;
+            for (size_t i = 0; i < group; ++i) {
+                Search &search = searches[i];
+                if (search.done) {
+                    continue;
+                }
+                ++active;
+
+                const T &key = keys[base + i];
+                Node *candidate = search.candidate;
+                if (candidate != nullptr && compare(candidate->value, key)) {
+                    search.current = candidate->forward();
+                    search.candidate = search.current[search.level].next;
+#if defined(__GNUC__)
+                    __builtin_prefetch(search.candidate);
+#endif
+                } else if (search.level > 0) {
+                    --search.level;
+                    search.candidate = search.current[search.level].next;
+#if defined(__GNUC__)
+                    __builtin_prefetch(search.candidate);
+#endif
+                } else {
+                    const bool found =
+                        candidate != nullptr && !compare(key, candidate->value);
+                    visit(base + i, found ? candidate : nullptr);
+                    search.done = true;
+                }
+            }
+        }
+    }
+}
+
+template <typename T, typename Compare, typename Stats>
+typename SkipList<T, Compare, Stats>::Iterator
+SkipList<T, Compare, Stats>::lower_bound(const T &value) const {
+    return lower_bound<T>(value);
+}
+
+// the node after the predecessor is the first one not smaller than key
+template <typename T, typename Compare, typename Stats>
+template <typename K>
+    requires LookupKey<K, T, Compare>
+typename SkipList<T, Compare, Stats>::Iterator
+SkipList<T, Compare, Stats>::lower_bound(const K &key) const {
+    return Iterator(findPredecessor(key, nullptr)[0].next);
+}
+
+template <typename T, typename Compare, typename Stats>
+typename SkipList<T, Compare, Stats>::Iterator
+SkipList<T, Compare, Stats>::upper_bound(const T &value) const {
+    return upper_bound<T>(value);
+}
+
+template <typename T, typename Compare, typename Stats>
+template <typename K>
+    requires LookupKey<K, T, Compare>
+typename SkipList<T, Compare, Stats>::Iterator
+SkipList<T, Compare, Stats>::upper_bound(const K &key) const {
+    return equal_range(key).second;
+}
+
+template <typename T, typename Compare, typename Stats>
+std::pair<typename SkipList<T, Compare, Stats>::Iterator,
+          typename SkipList<T, Compare, Stats>::Iterator>
+SkipList<T, Compare, Stats>::equal_range(const T &value) const {
+    return equal_range<T>(value);
+}
+
+// values are unique, so the upper bound is the lower bound or the node
+// right after it
+template <typename T, typename Compare, typename Stats>
+template <typename K>
+    requires LookupKey<K, T, Compare>
+std::pair<typename SkipList<T, Compare, Stats>::Iterator,
+          typename SkipList<T, Compare, Stats>::Iterator>
+SkipList<T, Compare, Stats>::equal_range(const K &key) const {
+    Iterator lower = lower_bound(key);
+    if (lower != end() && !compare(key, *lower)) {
+        return {lower, std::next(lower)};
+    }
+    return {lower, lower};
+}
+
+template <typename T, typename Compare, typename Stats>
+template <typename F>
+void SkipList<T, Compare, Stats>::forEachInRange(const T &lo, const T &hi,
+                                                 F &&fn) const {
+    forEachInRange<T>(lo, hi, std::forward<F>(fn));
+}
+
+// descend once to lo, then follow the lowest lane until hi
+template <typename T, typename Compare, typename Stats>
+template <typename K, typename F>
+    requires LookupKey<K, T, Compare>
+void SkipList<T, Compare, Stats>::forEachInRange(const K &lo, const K &hi,
+                                                 F &&fn) const {
+    for (Iterator it = lower_bound(lo); it != end() && compare(*it, hi); ++it) {
+        if constexpr (std::is_same_v<std::invoke_result_t<F &, T &>, bool>) {
+            if (!fn(*it)) {
+                return;
+            }
+        } else {
+            fn(*it);
+        }
+    }
+}
+
+template <typename T, typename Compare, typename Stats>
+size_t SkipList<T, Compare, Stats>::rank(const T &value) const {
+    return rank<T>(value);
+}
+
+// the same descent as findPredecessor, adding up the widths of the links it
+// follows. The predecessor's position is the number of smaller values
+template <typename T, typename Compare, typename Stats>
+template <typename K>
+    requires LookupKey<K, T, Compare>
+size_t SkipList<T, Compare, Stats>::rank(const K &key) const {
+    Link current = _header;
+    Node *bound = nullptr;
+    size_t position = 0;
+    int visited = 0;
 
-    // start at highest express lane, go down a level when next node is
-    // higher than node we are looking for
     for (int level = _currentLevel - 1; level >= 0; --level) {
-        bool lessThan = comp(current->forward[level]->value, value);
-        while (current->forward[level] && lessThan) {
-            current = current->forward[level];
+        Node *next = current[level].next;
+        while (next != bound && (++visited, compare(next->value, key))) {
+            position += current[level].width;
+            current = next->forward();
+            next = current[level].next;
         }
+        bound = next;
     }
 
-    // next node is the one we are looking for
-    current = current->forward[0];
+    _stats.search(visited);
+    return position;
+}
 
-    bool equal = !comp(value, current->value) && !comp(current->value, value);
-    return current && equal;
+template <typename T, typename Compare, typename Stats>
+T *SkipList<T, Compare, Stats>::select(size_t k) const {
+    Node *node = nodeAt(k);
+    return node != nullptr ? &node->value : nullptr;
+}
+
+template <typename T, typename Compare, typename Stats>
+std::ranges::subrange<typename SkipList<T, Compare, Stats>::Iterator>
+SkipList<T, Compare, Stats>::slice(size_t k, size_t count) const {
+    if (k >= _size) {
+        return {end(), end()};
+    }
+    Iterator last = count < _size - k ? Iterator(nodeAt(k + count)) : end();
+    return {Iterator(nodeAt(k)), last};
 }
 
 // Clear the whole skiplist of its nodes and reset the headers' pointers
-template <typename T, typename Compare> void SkipList<T, Compare>::clear() {
-    Node *current = _header->forward[0];
+template <typename T, typename Compare, typename Stats>
+void SkipList<T, Compare, Stats>::clear() {
+    Node *current = _header[0].next;
 
     // delete all nodes by traversing lvl 0
     while (current != nullptr) {
-        Node *next = current->forward[0];
-        delete current;
+        Node *next = current->forward()[0].next;
+        destroyNode(current);
         current = next;
     }
 
-    // reset header pointers
-    for (auto &ptr : _header->forward) {
-        ptr = nullptr;
-    }
+    // reset header links
+    std::fill(std::begin(_header), std::end(_header), Hop{});
+    std::fill(std::begin(_tail), std::end(_tail), nullptr);
 
     _size = 0;
     _currentLevel = 1;
 }
 
+// exchange all nodes and settings with another skiplist
+template <typename T, typename Compare, typename Stats>
+void SkipList<T, Compare, Stats>::swap(SkipList &other) noexcept {
+    using std::swap;
+    swap(_maxLevel, other._maxLevel);
+    swap(_currentLevel, other._currentLevel);
+    swap(_size, other._size);
+    swap(_header, other._header);
+    swap(_tail, other._tail);
+    swap(_gen, other._gen);
+    swap(_dist, other._dist);
+    swap(comp, other.comp);
+}
+
+template <typename T, typename Compare, typename Stats>
+typename SkipList<T, Compare, Stats>::Iterator
+SkipList<T, Compare, Stats>::begin() const {
+    return Iterator(_header[0].next);
+}
+
+template <typename T, typename Compare, typename Stats>
+typename SkipList<T, Compare, Stats>::Iterator
+SkipList<T, Compare, Stats>::end() const {
+    return Iterator(nullptr);
+}
+
 // check if there are elements in the skiplist (besides header)
-template <typename T, typename Compare>
-bool SkipList<T, Compare>::empty() const {
+template <typename T, typename Compare, typename Stats>
+bool SkipList<T, Compare, Stats>::empty() const {
     return _size == 0; // no need for generic compare function
 }
 
 // return the number of elements in the skiplist
-template <typename T, typename Compare>
-size_t SkipList<T, Compare>::size() const {
+template <typename T, typename Compare, typename Stats>
+size_t SkipList<T, Compare, Stats>::size() const {
     return _size;
 }
 
 // flip a coin, if heads, increment by one and flip again
 // if tails, stop and return
-template <typename T, typename Compare>
-int SkipList<T, Compare>::randomLevel() {
+template <typename T, typename Compare, typename Stats>
+int SkipList<T, Compare, Stats>::randomLevel() {
     int level = 1;
     while (_dist(_gen) < LEVEL_UP_CHANCE && level < _maxLevel) {
         ++level;
@@ -212,8 +673,101 @@ int SkipList<T, Compare>::randomLevel() {
 }
 
 // create a node with a value and its level (how many express lanes it covers)
-template <typename T, typename Compare>
-typename SkipList<T, Compare>::Node *
-SkipList<T, Compare>::createNode(const T &value, int level) {
-    return new Node(value, level);
+template <typename T, typename Compare, typename Stats>
+template <typename... Args>
+typename SkipList<T, Compare, Stats>::Node *
+SkipList<T, Compare, Stats>::createNode(int level, Args &&...args) {
+    void *memory =
+        ::operator new(TOWER_OFFSET + level * sizeof(Hop), NODE_ALIGNMENT);
+    Node *node = nullptr;
+    try {
+        node = new (memory) Node(std::forward<Args>(args)...);
+    } catch (...) {
+        ::operator delete(memory, NODE_ALIGNMENT);
+        throw;
+    }
+    std::uninitialized_fill_n(
+        reinterpret_cast<Hop *>(static_cast<std::byte *>(memory) +
+                                TOWER_OFFSET),
+        level, Hop{});
+    _stats.allocation();
+    _stats.level(level);
+    return node;
+}
+
+// the tower holds plain links, only the value needs destroying
+template <typename T, typename Compare, typename Stats>
+void SkipList<T, Compare, Stats>::destroyNode(Node *node) noexcept {
+    node->~Node();
+    ::operator delete(node, NODE_ALIGNMENT);
+}
+
+template <typename T, typename Compare, typename Stats>
+typename SkipList<T, Compare, Stats>::Link
+SkipList<T, Compare, Stats>::Node::forward() noexcept {
+    return std::launder(reinterpret_cast<Hop *>(
+        reinterpret_cast<std::byte *>(this) + TOWER_OFFSET));
+}
+
+template <typename T, typename Compare, typename Stats>
+typename SkipList<T, Compare, Stats>::Node *
+SkipList<T, Compare, Stats>::owner(Link tower) noexcept {
+    return std::launder(reinterpret_cast<Node *>(
+        reinterpret_cast<std::byte *>(tower) - TOWER_OFFSET));
+}
+
+// follow every link that does not overshoot the position, no comparisons
+// needed. The header is position 0, the first node position 1
+template <typename T, typename Compare, typename Stats>
+typename SkipList<T, Compare, Stats>::Node *
+SkipList<T, Compare, Stats>::nodeAt(size_t index) const {
+    if (index >= _size) {
+        return nullptr;
+    }
+
+    Link current = _header;
+    size_t position = 0;
+    for (int level = _currentLevel - 1; position <= index; --level) {
+        while (position + current[level].width <= index + 1) {
+            position += current[level].width;
+            current = current[level].next->forward();
+        }
+    }
+    return owner(current);
+}
+
+template <typename T, typename Compare, typename Stats>
+template <typename L, typename R>
+bool SkipList<T, Compare, Stats>::compare(const L &lhs, const R &rhs) const {
+    _stats.comparison();
+    return comp(lhs, rhs);
+}
+
+// start at highest express lane, go down a level when next node is
+// higher than node we are looking for. That node is often the next one on
+// the lane below as well, it is not compared a second time
+template <typename T, typename Compare, typename Stats>
+template <typename K>
+typename SkipList<T, Compare, Stats>::Link
+SkipList<T, Compare, Stats>::findPredecessor(const K &key,
+                                             Link *update) const {
+    Link current = _header;
+    // first node known not to be smaller than key, nullptr is the end
+    Node *bound = nullptr;
+    int visited = 0;
+
+    for (int level = _currentLevel - 1; level >= 0; --level) {
+        Node *next = current[level].next;
+        while (next != bound && (++visited, compare(next->value, key))) {
+            current = next->forward();
+            next = current[level].next;
+        }
+        bound = next;
+        if (update != nullptr) {
+            update[level] = current;
+        }
+    }
+
+    _stats.search(visited);
+    return current;
 }
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <type_traits>
+
+/**
+ * "mySetSnp" in the first eight bytes of a snapshot file.
+ */
+constexpr uint64_t SNAPSHOT_MAGIC = 0x706e537465537970;
+constexpr uint32_t SNAPSHOT_VERSION = 1;
+
+/**
+ * Fixed size header at the start of a snapshot file. The values follow right
+ * after it in increasing order, as raw bytes in the byte order of the machine
+ * that wrote them. The header is padded to 64 bytes so the values of a
+ * mapped file are aligned for any T.
+ */
+struct SnapshotHeader {
+    uint64_t magic = SNAPSHOT_MAGIC;
+    uint32_t version = SNAPSHOT_VERSION;
+    // sizeof(T) of the writer, a reader with another layout refuses the file
+    uint32_t valueSize = 0;
+    uint64_t count = 0;
+    // SnapshotChecksum of the value bytes
+    uint64_t checksum = 0;
+    uint64_t reserved[4] = {};
+};
+static_assert(sizeof(SnapshotHeader) == 64);
+
+/**
+ * Streaming 64 bit checksum over the value bytes. Works on whole 8 byte
+ * words, so it keeps up with a disk, and gives the same result no matter
+ * how the bytes are split between calls to update. Meant to catch truncated
+ * and damaged files, not tampering.
+ */
+class SnapshotChecksum {
+  public:
+    void update(const std::byte *data, std::size_t size) noexcept;
+    [[nodiscard]] uint64_t finish() const noexcept;
+
+  private:
+    void mix(uint64_t word) noexcept;
+
+    uint64_t state = 0x9e3779b97f4a7c15;
+    uint64_t length = 0;
+    // bytes of a word that is not complete yet
+    std::byte pending[8] = {};
+    unsigned pendingBytes = 0;
+};
+
+/**
+ * Writes the count values starting at first, which have to be strictly
+ * increasing, into a snapshot file. The file is written next to path under a
+ * temporary name, flushed to disk and then renamed over path, so readers
+ * never see a half written snapshot. Throws std::system_error if the file
+ * cannot be written.
+ */
+template <typename T, typename InputIt>
+    requires std::is_trivially_copyable_v<T>
+void writeSnapshot(const std::filesystem::path &path, InputIt first,
+                   std::size_t count);
+
+/**
+ * Read only view of a snapshot file, mapped into memory where the platform
+ * allows it and read in one go otherwise. The header and the checksum are
+ * verified on construction, which throws std::system_error if the file
+ * cannot be read and std::runtime_error if it is not a valid snapshot of
+ * values of type T.
+ */
+template <typename T>
+    requires std::is_trivially_copyable_v<T>
+class SnapshotMapping {
+  public:
+    explicit SnapshotMapping(const std::filesystem::path &path);
+    SnapshotMapping(const SnapshotMapping &) = delete;
+    SnapshotMapping &operator=(const SnapshotMapping &) = delete;
+    ~SnapshotMapping();
+
+    /**
+     * The values of the file in the order they were written.
+     */
+    [[nodiscard]] std::span<const T> values() const noexcept;
+
+  private:
+    void verify(const std::filesystem::path &path) const;
+    void release() noexcept;
+
+    std::byte *data = nullptr;
+    std::size_t length = 0;
+    bool mapped = false;
+};
+
+#include "snapshot/snapshot_file.hpp"
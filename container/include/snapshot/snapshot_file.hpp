@@ -0,0 +1,275 @@
+#pragma once
+
+#include "snapshot/snapshot_file.h"
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * Bytes a snapshot writer collects before it hands them to the file.
+ */
+constexpr std::size_t SNAPSHOT_WRITE_BUFFER = 1 << 20;
+
+// Words are read in native byte order, like the values themselves
+inline void SnapshotChecksum::update(const std::byte *data,
+                                     std::size_t size) noexcept {
+    length += size;
+    if (pendingBytes > 0) {
+        const std::size_t take = std::min<std::size_t>(8 - pendingBytes, size);
+        std::memcpy(pending + pendingBytes, data, take);
+        pendingBytes += static_cast<unsigned>(take);
+        data += take;
+        size -= take;
+        if (pendingBytes < 8) {
+            return;
+        }
+        uint64_t word = 0;
+        std::memcpy(&word, pending, 8);
+        mix(word);
+        pendingBytes = 0;
+    }
+
+    for (; size >= 8; data += 8, size -= 8) {
+        uint64_t word = 0;
+        std::memcpy(&word, data, 8);
+        mix(word);
+    }
+
+    std::memcpy(pending, data, size);
+    pendingBytes = static_cast<unsigned>(size);
+}
+
+inline uint64_t SnapshotChecksum::finish() const noexcept {
+    SnapshotChecksum last = *this;
+    uint64_t tail = 0;
+    std::memcpy(&tail, pending, pendingBytes);
+    last.mix(tail ^ (length << 3));
+    uint64_t hash = last.state;
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccd;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+// One round of xxHash64
+inline void SnapshotChecksum::mix(uint64_t word) noexcept {
+    state += word * 0xc2b2ae3d27d4eb4f;
+    state = std::rotl(state, 31);
+    state *= 0x9e3779b185ebca87;
+}
+
+// The header goes in last, once the checksum is known, so a file cut short
+// while writing is never mistaken for a valid snapshot
+template <typename T, typename InputIt>
+    requires std::is_trivially_copyable_v<T>
+void writeSnapshot(const std::filesystem::path &path, InputIt first,
+                   std::size_t count) {
+    std::filesystem::path temporary = path;
+    temporary += ".tmp";
+
+    // path::c_str() is a wide string on Windows
+#if defined(_WIN32)
+    std::FILE *opened = _wfopen(temporary.c_str(), L"wb");
+#else
+    std::FILE *opened = std::fopen(temporary.c_str(), "wb");
+#endif
+    std::unique_ptr<std::FILE, int (*)(std::FILE *)> file(opened, &std::fclose);
+    const auto fail = [&](const char *what) {
+        const int error = errno;
+        file.reset();
+        std::filesystem::remove(temporary);
+        throw std::system_error(error, std::generic_category(),
+                                std::string(what) + " " + temporary.string());
+    };
+    if (!file) {
+        fail("cannot create");
+    }
+
+    SnapshotHeader header;
+    header.valueSize = sizeof(T);
+    header.count = count;
+    if (std::fseek(file.get(), sizeof(SnapshotHeader), SEEK_SET) != 0) {
+        fail("cannot seek in");
+    }
+
+    SnapshotChecksum checksum;
+    std::vector<T> buffer;
+    buffer.reserve(std::max<std::size_t>(SNAPSHOT_WRITE_BUFFER / sizeof(T), 1));
+    for (std::size_t written = 0; written < count;) {
+        buffer.clear();
+        for (; buffer.size() < buffer.capacity() && written < count;
+             ++written, ++first) {
+            buffer.push_back(*first);
+        }
+
+        const auto *bytes = reinterpret_cast<const std::byte *>(buffer.data());
+        checksum.update(bytes, buffer.size() * sizeof(T));
+        if (std::fwrite(buffer.data(), sizeof(T), buffer.size(), file.get()) !=
+            buffer.size()) {
+            fail("cannot write");
+        }
+    }
+
+    header.checksum = checksum.finish();
+    if (std::fseek(file.get(), 0, SEEK_SET) != 0 ||
+        std::fwrite(&header, sizeof(header), 1, file.get()) != 1 ||
+        std::fflush(file.get()) != 0) {
+        fail("cannot write");
+    }
+#if defined(__linux__)
+    if (fsync(fileno(file.get())) != 0) {
+        fail("cannot flush");
+    }
+#endif
+    if (std::fclose(file.release()) != 0) {
+        fail("cannot close");
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporary, path, error);
+    if (error) {
+        std::filesystem::remove(temporary);
+        throw std::system_error(error, "cannot replace " + path.string());
+    }
+}
+
+template <typename T>
+    requires std::is_trivially_copyable_v<T>
+SnapshotMapping<T>::SnapshotMapping(const std::filesystem::path &path) {
+    static_assert(alignof(T) <= sizeof(SnapshotHeader),
+                  "values are stored right after the header");
+
+#if defined(__linux__)
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::system_error(errno, std::generic_category(),
+                                "cannot open " + path.string());
+    }
+    struct stat info{};
+    if (fstat(fd, &info) != 0) {
+        const int error = errno;
+        close(fd);
+        throw std::system_error(error, std::generic_category(),
+                                "cannot stat " + path.string());
+    }
+    length = static_cast<std::size_t>(info.st_size);
+    if (length > 0) {
+        void *memory = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        const int error = errno;
+        close(fd);
+        if (memory == MAP_FAILED) {
+            throw std::system_error(error, std::generic_category(),
+                                    "cannot map " + path.string());
+        }
+        // The values are read once from front to back
+        madvise(memory, length, MADV_SEQUENTIAL);
+        data = static_cast<std::byte *>(memory);
+        mapped = true;
+    } else {
+        close(fd);
+    }
+#else
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        throw std::system_error(errno, std::generic_category(),
+                                "cannot open " + path.string());
+    }
+    length = static_cast<std::size_t>(file.tellg());
+    data = static_cast<std::byte *>(
+        ::operator new(length, std::align_val_t(sizeof(SnapshotHeader))));
+    file.seekg(0);
+    if (!file.read(reinterpret_cast<char *>(data),
+                   static_cast<std::streamsize>(length))) {
+        ::operator delete(data, std::align_val_t(sizeof(SnapshotHeader)));
+        throw std::system_error(errno, std::generic_category(),
+                                "cannot read " + path.string());
+    }
+#endif
+
+    try {
+        verify(path);
+    } catch (...) {
+        release();
+        throw;
+    }
+}
+
+template <typename T>
+    requires std::is_trivially_copyable_v<T>
+SnapshotMapping<T>::~SnapshotMapping() {
+    release();
+}
+
+template <typename T>
+    requires std::is_trivially_copyable_v<T>
+void SnapshotMapping<T>::release() noexcept {
+    if (data == nullptr) {
+        return;
+    }
+#if defined(__linux__)
+    if (mapped) {
+        munmap(data, length);
+    }
+#else
+    ::operator delete(data, std::align_val_t(sizeof(SnapshotHeader)));
+#endif
+    data = nullptr;
+}
+
+template <typename T>
+    requires std::is_trivially_copyable_v<T>
+std::span<const T> SnapshotMapping<T>::values() const noexcept {
+    SnapshotHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    return {reinterpret_cast<const T *>(data + sizeof(SnapshotHeader)),
+            static_cast<std::size_t>(header.count)};
+}
+
+template <typename T>
+    requires std::is_trivially_copyable_v<T>
+void SnapshotMapping<T>::verify(const std::filesystem::path &path) const {
+    const auto invalid = [&](const char *why) {
+        throw std::runtime_error(path.string() + ": " + why);
+    };
+
+    SnapshotHeader header;
+    if (length < sizeof(header)) {
+        invalid("too short for a snapshot");
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (header.magic != SNAPSHOT_MAGIC) {
+        invalid("not a snapshot file");
+    }
+    if (header.version != SNAPSHOT_VERSION) {
+        invalid("unsupported snapshot version");
+    }
+    if (header.valueSize != sizeof(T)) {
+        invalid("snapshot holds values of another size");
+    }
+    if ((length - sizeof(header)) / sizeof(T) != header.count ||
+        (length - sizeof(header)) % sizeof(T) != 0) {
+        invalid("snapshot is truncated");
+    }
+
+    SnapshotChecksum checksum;
+    checksum.update(data + sizeof(header), length - sizeof(header));
+    if (checksum.finish() != header.checksum) {
+        invalid("snapshot checksum mismatch");
+    }
+}
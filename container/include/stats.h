@@ -0,0 +1,166 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <type_traits>
+
+/**
+ * Buckets of the depth and level histograms, the last one also counts
+ * everything beyond it.
+ */
+constexpr std::size_t STATS_HISTOGRAM_SIZE = 64;
+
+/**
+ * The hooks a container calls on its Stats policy while it works. Every hook
+ * is called on the hot path, so a policy that records nothing has to compile
+ * to nothing, see NoStats.
+ *
+ * - comparison(): one call of the comparator
+ * - leftRotation(), rightRotation(), doubleRotation(): one rebalancing step
+ *   of a tree, a double rotation counts once and not as two single ones
+ * - allocation(): one node allocated
+ * - search(depth): a search for a single key ended after visiting depth
+ *   nodes
+ * - level(level): a skip list drew level for a new node
+ */
+template <typename S>
+concept StatsPolicy =
+    std::default_initializable<S> && requires(S stats, int depth) {
+        stats.comparison();
+        stats.leftRotation();
+        stats.rightRotation();
+        stats.doubleRotation();
+        stats.allocation();
+        stats.search(depth);
+        stats.level(depth);
+    };
+
+/**
+ * Default Stats policy of the containers, it records nothing and takes no
+ * space.
+ */
+struct NoStats {
+    void comparison() noexcept {}
+    void leftRotation() noexcept {}
+    void rightRotation() noexcept {}
+    void doubleRotation() noexcept {}
+    void allocation() noexcept {}
+    void search(int /*depth*/) noexcept {}
+    void level(int /*level*/) noexcept {}
+};
+static_assert(std::is_empty_v<NoStats>);
+
+/**
+ * Plain copy of the numbers a CountingStats has collected so far, ready to be
+ * exported. Histogram bucket i counts the searches that visited i nodes and
+ * the skip list nodes that got level i.
+ */
+struct StatsSnapshot {
+    uint64_t comparisons = 0;
+    uint64_t leftRotations = 0;
+    uint64_t rightRotations = 0;
+    uint64_t doubleRotations = 0;
+    uint64_t allocations = 0;
+    std::array<uint64_t, STATS_HISTOGRAM_SIZE> searchDepths = {};
+    std::array<uint64_t, STATS_HISTOGRAM_SIZE> levels = {};
+
+    [[nodiscard]] uint64_t rotations() const noexcept {
+        return leftRotations + rightRotations + doubleRotations;
+    }
+    [[nodiscard]] uint64_t searches() const noexcept;
+};
+
+/**
+ * Stats policy that counts every event. The counters are bumped with relaxed
+ * loads and stores instead of atomic increments, which keeps them cheap and
+ * race free when several threads read one container, at the price of losing
+ * a count now and then while they do.
+ */
+class CountingStats {
+  public:
+    CountingStats() = default;
+    CountingStats(const CountingStats &) = delete;
+    CountingStats &operator=(const CountingStats &) = delete;
+
+    void comparison() noexcept { bump(comparisons); }
+    void leftRotation() noexcept { bump(leftRotations); }
+    void rightRotation() noexcept { bump(rightRotations); }
+    void doubleRotation() noexcept { bump(doubleRotations); }
+    void allocation() noexcept { bump(allocations); }
+    void search(int depth) noexcept { bump(searchDepths[bucket(depth)]); }
+    void level(int level) noexcept { bump(levels[bucket(level)]); }
+
+    /**
+     * Reads all counters, each one on its own, so the numbers of a container
+     * that is in use do not have to add up exactly.
+     */
+    [[nodiscard]] StatsSnapshot snapshot() const noexcept;
+    /**
+     * Sets every counter back to zero.
+     */
+    void reset() noexcept;
+
+  private:
+    using Counter = std::atomic<uint64_t>;
+
+    static void bump(Counter &counter) noexcept {
+        counter.store(counter.load(std::memory_order_relaxed) + 1,
+                      std::memory_order_relaxed);
+    }
+    static std::size_t bucket(int value) noexcept {
+        return value < 0 ? 0
+                         : std::min(static_cast<std::size_t>(value),
+                                    STATS_HISTOGRAM_SIZE - 1);
+    }
+
+    Counter comparisons{0};
+    Counter leftRotations{0};
+    Counter rightRotations{0};
+    Counter doubleRotations{0};
+    Counter allocations{0};
+    std::array<Counter, STATS_HISTOGRAM_SIZE> searchDepths{};
+    std::array<Counter, STATS_HISTOGRAM_SIZE> levels{};
+};
+static_assert(StatsPolicy<NoStats>);
+static_assert(StatsPolicy<CountingStats>);
+
+inline uint64_t StatsSnapshot::searches() const noexcept {
+    uint64_t total = 0;
+    for (uint64_t count : searchDepths) {
+        total += count;
+    }
+    return total;
+}
+
+inline StatsSnapshot CountingStats::snapshot() const noexcept {
+    const auto read = [](const Counter &counter) {
+        return counter.load(std::memory_order_relaxed);
+    };
+    StatsSnapshot result;
+    result.comparisons = read(comparisons);
+    result.leftRotations = read(leftRotations);
+    result.rightRotations = read(rightRotations);
+    result.doubleRotations = read(doubleRotations);
+    result.allocations = read(allocations);
+    for (std::size_t i = 0; i < STATS_HISTOGRAM_SIZE; ++i) {
+        result.searchDepths[i] = read(searchDepths[i]);
+        result.levels[i] = read(levels[i]);
+    }
+    return result;
+}
+
+inline void CountingStats::reset() noexcept {
+    for (Counter *counter : {&comparisons, &leftRotations, &rightRotations,
+                             &doubleRotations, &allocations}) {
+        counter->store(0, std::memory_order_relaxed);
+    }
+    for (std::size_t i = 0; i < STATS_HISTOGRAM_SIZE; ++i) {
+        searchDepths[i].store(0, std::memory_order_relaxed);
+        levels[i].store(0, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "unrolled_skiplist/unrolled_skiplist.h"
+
+template <typename T, typename Compare, std::size_t BlockSize>
+T &UnrolledSkipList<T, Compare, BlockSize>::Iterator::operator*() const {
+    return block->keys()[index];
+}
+
+template <typename T, typename Compare, std::size_t BlockSize>
+T *UnrolledSkipList<T, Compare, BlockSize>::Iterator::operator->() const {
+    return &block->keys()[index];
+}
+
+// Blocks are never empty, so the next block always has a first value
+template <typename T, typename Compare, std::size_t BlockSize>
+typename UnrolledSkipList<T, Compare, BlockSize>::Iterator &
+UnrolledSkipList<T, Compare, BlockSize>::Iterator::operator++() {
+    if (++index == block->count) {
+        block = block->forward()[0];
+        index = 0;
+    }
+    return *this;
+}
+
+template <typename T, typename Compare, std::size_t BlockSize>
+typename UnrolledSkipList<T, Compare, BlockSize>::Iterator
+UnrolledSkipList<T, Compare, BlockSize>::Iterator::operator++(int) {
+    Iterator temp = *this;
+    ++(*this);
+    return temp;
+}
+
+template <typename T, typename Compare, std::size_t BlockSize>
+bool UnrolledSkipList<T, Compare, BlockSize>::Iterator::operator==(
+    const Iterator &other) const {
+    return block == other.block && index == other.index;
+}
+
+template <typename T, typename Compare, std::size_t BlockSize>
+bool UnrolledSkipList<T, Compare, BlockSize>::Iterator::operator!=(
+    const Iterator &other) const {
+    return !(*this == other);
+}
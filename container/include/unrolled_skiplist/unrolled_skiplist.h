@@ -0,0 +1,276 @@
+#pragma once
+
+#include "btree/sorted_keys.h"
+#include "container.h"
+#include "skiplist/random_level.h"
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <new>
+#include <random>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+/**
+ * Bytes of values stored per block by default, four cache lines like a
+ * BTreeSet node: 64 ints or 32 pointers.
+ */
+constexpr std::size_t UNROLLED_SKIPLIST_BLOCK_SIZE = 256;
+
+/**
+ * Levels a block of an UnrolledSkipList can have at most, enough for 2^32
+ * blocks.
+ */
+constexpr int UNROLLED_SKIPLIST_MAX_LEVEL = 32;
+
+/**
+ * Skip list whose lowest lane is unrolled: every entry of it is a block
+ * holding up to BlockSize bytes of sorted values, and the express lanes
+ * index the blocks by their first value.
+ *
+ * A lookup descends the express lanes to the last block whose first value
+ * is not greater than the key and finishes inside that block, with the same
+ * SIMD or binary search as a BTreeSet node (see countLess). Scans read the
+ * values of a block back to back, and there is one tower per block instead
+ * of one per value.
+ *
+ * A full block is split in half into a new block with its own tower. A
+ * block that drops below a quarter of its capacity takes values from the
+ * next block, or absorbs it when both fit into one. Only the last block may
+ * hold fewer, and no block is ever empty.
+ */
+template <typename T, typename Compare = std::less<T>,
+          std::size_t BlockSize = UNROLLED_SKIPLIST_BLOCK_SIZE>
+class UnrolledSkipList {
+  private:
+    /**
+     * Values per block, at least four so a split leaves both halves with
+     * two values and the minimum fill stays at one or more.
+     */
+    static constexpr std::size_t CAPACITY =
+        std::max<std::size_t>(BlockSize / sizeof(T), 4);
+    // Fewest values a block other than the last one holds
+    static constexpr std::size_t MIN_FILL = CAPACITY / 4;
+
+    // A block and its forward pointers are a single allocation, the pointers
+    // follow the values, one for every level of the block
+    struct Block {
+        std::size_t count = 0;
+        // Raw storage, only the first count values are constructed
+        alignas(T) std::byte storage[CAPACITY * sizeof(T)];
+
+        T *keys() noexcept {
+            return std::launder(reinterpret_cast<T *>(storage));
+        }
+        const T *keys() const noexcept {
+            return std::launder(reinterpret_cast<const T *>(storage));
+        }
+        Block **forward() noexcept;
+    };
+
+    // the forward pointers of a block or of the header, a predecessor
+    // during an update is the tower it has to be linked in after
+    using Link = Block **;
+
+  public:
+    UnrolledSkipList() = default;
+    UnrolledSkipList(const UnrolledSkipList &) = delete;
+    /**
+     * Takes over the blocks of other without copying, other is left empty.
+     */
+    UnrolledSkipList(UnrolledSkipList &&other) noexcept;
+    UnrolledSkipList &operator=(const UnrolledSkipList &) = delete;
+    UnrolledSkipList &operator=(UnrolledSkipList &&other) noexcept;
+    ~UnrolledSkipList() { clear(); }
+
+    // iterator
+    /**
+     * Forward in-order iterator, a block and a position in it. The end
+     * iterator has no block.
+     */
+    class Iterator {
+      public:
+        using iterator_category = std::forward_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = T;
+        using pointer = T *;
+        using reference = T &;
+
+        Iterator() = default;
+        Iterator(Block *block, std::size_t index)
+            : block(block), index(index) {}
+
+        reference operator*() const;
+        pointer operator->() const;
+
+        Iterator &operator++();
+        Iterator operator++(int);
+        bool operator==(const Iterator &other) const;
+        bool operator!=(const Iterator &other) const;
+
+      private:
+        Block *block = nullptr;
+        std::size_t index = 0;
+    };
+
+    [[nodiscard]] Iterator begin() const;
+    [[nodiscard]] Iterator end() const;
+
+    // modifiers
+    /**
+     * Inserts the value, returns false if an equivalent value already
+     * existed.
+     */
+    bool insert(const T &value);
+    bool insert(T &&value);
+    /**
+     * Removes an equivalent value, returns false if there was none.
+     */
+    bool remove(const T &value);
+    template <typename K>
+        requires LookupKey<K, T, Compare>
+    bool remove(const K &key);
+    void clear() noexcept;
+    /**
+     * Exchanges the contents of two lists in O(1).
+     */
+    void swap(UnrolledSkipList &other) noexcept;
+    friend void swap(UnrolledSkipList &lhs, UnrolledSkipList &rhs) noexcept {
+        lhs.swap(rhs);
+    }
+
+    // access
+    /**
+     * Search for a value, returns nullptr if not found.
+     */
+    [[nodiscard]] T *search(const T &value) const;
+    template <typename K>
+        requires LookupKey<K, T, Compare>
+    [[nodiscard]] T *search(const K &key) const;
+    /**
+     * Returns the max value, or nullptr if the list is empty.
+     */
+    [[nodiscard]] T *max() const noexcept;
+    /**
+     * Returns the min value, or nullptr if the list is empty.
+     */
+    [[nodiscard]] T *min() const noexcept;
+    [[nodiscard]] bool contains(const T &value) const;
+    template <typename K>
+        requires LookupKey<K, T, Compare>
+    [[nodiscard]] bool contains(const K &key) const;
+
+    // range queries
+    /**
+     * Returns an iterator to the first value not smaller than value, or end().
+     */
+    [[nodiscard]] Iterator lower_bound(const T &value) const;
+    /**
+     * Returns an iterator to the first value greater than value, or end().
+     */
+    [[nodiscard]] Iterator upper_bound(const T &value) const;
+    /**
+     * Returns the range of values equivalent to value, which is empty or
+     * holds a single value.
+     */
+    [[nodiscard]] std::pair<Iterator, Iterator>
+    equal_range(const T &value) const;
+    /**
+     * Calls fn with every value in [lo, hi) in order, O(log n + k). If fn
+     * returns a bool, returning false stops the scan.
+     */
+    template <typename F>
+    void forEachInRange(const T &lo, const T &hi, F &&fn) const;
+    template <typename K>
+        requires LookupKey<K, T, Compare>
+    [[nodiscard]] Iterator lower_bound(const K &key) const;
+    template <typename K>
+        requires LookupKey<K, T, Compare>
+    [[nodiscard]] Iterator upper_bound(const K &key) const;
+    template <typename K>
+        requires LookupKey<K, T, Compare>
+    [[nodiscard]] std::pair<Iterator, Iterator>
+    equal_range(const K &key) const;
+    template <typename K, typename F>
+        requires LookupKey<K, T, Compare>
+    void forEachInRange(const K &lo, const K &hi, F &&fn) const;
+
+    // info
+    /**
+     * Get the number of blocks the values are spread over.
+     */
+    [[nodiscard]] std::size_t blocks() const noexcept;
+    [[nodiscard]] std::size_t size() const noexcept;
+    [[nodiscard]] bool empty() const noexcept;
+
+  private:
+    // where the tower starts behind a block, and how blocks are aligned
+    static constexpr std::size_t TOWER_OFFSET =
+        (sizeof(Block) + alignof(Block *) - 1) / alignof(Block *) *
+        alignof(Block *);
+    static constexpr std::align_val_t BLOCK_ALIGNMENT{
+        std::max(alignof(Block), alignof(Block *))};
+
+    // the block a tower belongs to, never call this with the header
+    static Block *owner(Link tower) noexcept;
+    static Block *createBlock(int level);
+    /**
+     * Destroy the values left in a block and free it.
+     */
+    static void destroyBlock(Block *block) noexcept;
+
+    // search
+    /**
+     * Walk the express lanes down to the last block whose first value is
+     * not greater than key, or to the last block in front of `before` when
+     * it is given. Returns its tower, the header if there is none, and
+     * stores the last tower visited on every level in update when given.
+     */
+    template <typename K>
+    Link findBlock(const K &key, Link *update,
+                   const Block *before = nullptr) const;
+
+    // modifiers
+    template <typename V> bool insertValue(V &&value);
+    /**
+     * Move the upper half of a full block into a new block linked in right
+     * after it, update holds the predecessors of that position. Returns the
+     * new block.
+     */
+    Block *splitBlock(Block *block, Link *update);
+    /**
+     * Refill a block that dropped below MIN_FILL from the block after it,
+     * merging the two if they fit into one.
+     */
+    void refillBlock(Block *block, Block *next);
+    void linkBlock(Block *block, int level, Link *update);
+    /**
+     * Unlink a block from every lane and destroy it, update holds its
+     * predecessors.
+     */
+    void unlinkBlock(Block *block, Link *update) noexcept;
+
+    // levels in use, the lanes above are empty
+    int levels = 1;
+    std::size_t count = 0;
+    std::size_t blockCount = 0;
+    // the header is a tower without a block, mutable since the const
+    // searches hand it out as the predecessor of the smallest values
+    mutable Block *head[UNROLLED_SKIPLIST_MAX_LEVEL] = {};
+    Block *last = nullptr;
+    std::mt19937 gen;
+    Compare comp;
+};
+
+#include "unrolled_skiplist/unrolled_skiplist.hpp"
+#include "unrolled_skiplist/iterator.hpp" // IWYU pragma: keep
+
+static_assert(Dontainer<UnrolledSkipList<int>, int>);
+static_assert(RangeDontainer<UnrolledSkipList<int>, int>);
+static_assert(std::forward_iterator<UnrolledSkipList<int>::Iterator>);
+static_assert(TransparentDontainer<UnrolledSkipList<std::string, std::less<>>,
+                                   std::string, std::string_view>);
@@ -0,0 +1,439 @@
+#pragma once
+
+#include "unrolled_skiplist/unrolled_skiplist.h"
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+template <typename T, typename Compare, std::size_t BlockSize>
+UnrolledSkipList<T, Compare, BlockSize>::UnrolledSkipList(
+    UnrolledSkipList &&other) noexcept {
+    swap(other);
+}
+
+template <typename T, typename Compare, std::size_t BlockSize>
+UnrolledSkipList<T, Compare, BlockSize> &
+UnrolledSkipList<T, Compare, BlockSize>::operator=(
+    UnrolledSkipList &&other) noexcept {
+    if (this != &other) {
+        clear();
+        swap(other);
+    }
+    return *this;
+}
+
+template <typename T, typename Compare, std::size_t BlockSize>
+void UnrolledSkipList<T, Compare, BlockSize>::swap(
+    UnrolledSkipList &other) noexcept {
+    using std::swap;
+    swap(levels, other.levels);
+    swap(count, other.count);
+    swap(blockCount, other.blockCount);
+    swap(head, other.head);
+    swap(last, other.last);
+    swap(gen, other.gen);
+    swap(comp, other.comp);
+}
+
+template <typename T, typename Compare, std::size_t BlockSize>
+bool UnrolledSkipList<T, Compare, BlockSize>::insert(const T &value) {
+    return insertValue(value);
+}
+
+template <typename T, typename Compare, std::size_t BlockSize>
+bool UnrolledSkipList<T, Compare, BlockSize>::insert(T &&value) {
+    return insertValue(std::move(value));
+}
+
+// Values smaller than the min go to the front of the first block. Only a
+// full block splits, and the value is placed once there is room for it.
+template <typename T, typename Compare, std::size_t BlockSize>
+template <typename V>
+bool UnrolledSkipList<T, Compare, BlockSize>::insertValue(V &&value) {
+    Link update[UNROLLED_SKIPLIST_MAX_LEVEL];
+    if (head[0] == nullptr) {
+        std::fill(std::begin(update), std::end(update), Link{head});
+        const int level = geometricLevel(gen, UNROLLED_SKIPLIST_MAX_LEVEL);
+        Block *block = createBlock(level);
+        try {
+            insertSortedKey(block, 0, std::forward<V>(value));
+        } catch (...) {
+            destroyBlock(block);
+            throw;
+        }
+        linkBlock(block, level, update);
+        ++count;
+        return true;
+    }
+
+    Link tower = findBlock(value, update);
+    if (tower == head) {
+        tower = findBlock(head[0]->keys()[0], update);
+    }
+    Block *block = owner(tower);
+    std::size_t pos = sortedLowerBound(block, value, comp);
+    if (pos < block->count && equivalent(value, block->keys()[pos], comp)) {
+        return false;
+    }
+
+    if (block->count == CAPACITY) {
+        Block *right = splitBlock(block, update);
+        if (pos > block->count) {
+            pos -= block->count;
+            block = right;
+        }
+    }
+    insertSortedKey(block, pos, std::forward<V>(value));
+    ++count;
+    return true;
+}
+
+// The new block goes right after the full one, so update, which holds the
+// predecessors of a value in the full block, is where it is linked in
+template <typename T, typename Compare, std::size_t BlockSize>
+typename UnrolledSkipList<T, Compare, BlockSize>::Block *
+UnrolledSkipList<T, Compare, BlockSize>::splitBlock(Block *block,
+                                                    Link *update) {
+    const int level = geometricLevel(gen, UNROLLED_SKIPLIST_MAX_LEVEL);
+    Block *right = createBlock(level);
+    moveSortedKeys(block, CAPACITY / 2, right);
+    linkBlock(right, level, update);
+    return right;
+}
+
+template <typename T, typename Compare, std::size_t BlockSize>
+void UnrolledSkipList<T, Compare, BlockSize>::linkBlock(Block *block,
+                                                        int level,
+                                                        Link *update) {
+    // if not enough express lanes exist for the generated level, create them
+    if (level > levels) {
+        for (int i = levels; i < level; ++i) {
+            update[i] = head;
+        }
+        levels = level;
+    }
+
+    Link forward = block->forward();
+    for (int i = 0; i < level; ++i) {
+        forward[i] = update[i][i];
+        update[i][i] = block;
+    }
+    if (forward[0] == nullptr) {
+        last = block;
+    }
+    ++blockCount;
+}
+
+template <typename T, typename Compare, std::size_t BlockSize>
+bool UnrolledSkipList<T, Compare, BlockSize>::remove(const T &value) {
+    return remove<T>(value);
+}
+
+// A block about to lose its only value is unlinked first, its first value
+// is what finds its predecessors
+template <typename T, typename Compare, std::size_t BlockSize>
+template <typename K>
+    requires LookupKey<K, T, Compare>
+bool UnrolledSkipList<T, Compare, BlockSize>::remove(const K &key) {
+    Link tower = findBlock(key, nullptr);
+    if (tower == head) {
+        return false;
+    }
+    Block *block = owner(tower);
+    const std::size_t pos = sortedLowerBound(block, key, comp);
+    if (pos == block->count || !equivalent(key, block->keys()[pos], comp)) {
+        return false;
+    }
+
+    --count;
+    if (block->count == 1) {
+        Link update[UNROLLED_SKIPLIST_MAX_LEVEL];
+        findBlock(block->keys()[0], update, block);
+        unlinkBlock(block, update);
+        return true;
+    }
+
+    eraseSortedKey(block, pos);
+    Block *next = block->forward()[0];
+    if (block->count < MIN_FILL && next != nullptr) {
+        refillBlock(block, next);
+    }
+    return true;
+}
+
+// Values taken from the front of the next block only raise its first value,
+// which stays below the first value of the block after it
+template <typename T, typename Compare, std::size_t BlockSize>
+void UnrolledSkipList<T, Compare, BlockSize>::refillBlock(Block *block,
+                                                          Block *next) {
+    if (block->count + next->count <= CAPACITY) {
+        Link update[UNROLLED_SKIPLIST_MAX_LEVEL];
+        findBlock(next->keys()[0], update, next);
+        moveSortedKeys(next, 0, block);
+        unlinkBlock(next, update);
+        return;
+    }
+
+    const std::size_t take = (next->count - block->count) / 2;
+    T *keys = next->keys();
+    std::uninitialized_move(keys, keys + take, block->keys() + block->count);
+    std::move(keys + take, keys + next->count, keys);
+    std::destroy(keys + next->count - take, keys + next->count);
+    block->count += take;
+    next->count -= take;
+}
+
+template <typename T, typename Compare, std::size_t BlockSize>
+void UnrolledSkipList<T, Compare, BlockSize>::unlinkBlock(
+    Block *block, Link *update) noexcept {
+    Link forward = block->forward();
+    for (int i = 0; i < levels; ++i) {
+        // the block is on no lane from here on up
+        if (update[i][i] != block) {
+            break;
+        }
+        update[i][i] = forward[i];
+    }
+    if (last == block) {
+        last = update[0] == head ? nullptr : owner(update[0]);
+    }
+    destroyBlock(block);
+    --blockCount;
+
+    while (levels > 1 && head[levels - 1] == nullptr) {
+        --levels;
+    }
+}
+
+template <typename T, typename Compare, std::size_t BlockSize>
+void UnrolledSkipList<T, Compare, BlockSize>::clear() noexcept {
+    Block *block = head[0];
+    while (block != nullptr) {
+        Block *next = block->forward()[0];
+        destroyBlock(block);
+        block = next;
+    }
+    std::fill(std::begin(head), std::end(head), nullptr);
+    last = nullptr;
+    count = 0;
+    blockCount = 0;
+    levels = 1;
+}
+
+template <typename T, typename Compare, std::size_t BlockSize>
+T *UnrolledSkipList<T, Compare, BlockSize>::search(const T &value) const {
+    return search<T>(value);
+}
+
+template <typename T, typename Compare, std::size_t BlockSize>
+template <typename K>
+    requires LookupKey<K, T, Compare>
+T *UnrolledSkipList<T, Compare, BlockSize>::search(const K &key) const {
+    Link tower = findBlock(key, nullptr);
+    if (tower == head) {
+        return nullptr;
+    }
+    Block *block = owner(tower);
+    const std::size_t pos = sortedLowerBound(block, key, comp);
+    if (pos < block->count && equivalent(key, block->keys()[pos], comp)) {
+        return &block->keys()[pos];
+    }
+    return nullptr;
+}
+
+template <typename T, typename Compare, std::size_t BlockSize>
+T *UnrolledSkipList<T, Compare, BlockSize>::max() const noexcept {
+    return last ? &last->keys()[last->count - 1] : nullptr;
+}
+
+template <typename T, typename Compare, std::size_t BlockSize>
+T *UnrolledSkipList<T, Compare, BlockSize>::min() const noexcept {
+    return head[0] ? &head[0]->keys()[0] : nullptr;
+}
+
+template <typename T, typename Compare, std::size_t BlockSize>
+bool UnrolledSkipList<T, Compare, BlockSize>::contains(const T &value) const {
+    return search<T>(value) != nullptr;
+}
+
+template <typename T, typename Compare, std::size_t BlockSize>
+template <typename K>
+    requires LookupKey<K, T, Compare>
+bool UnrolledSkipList<T, Compare, BlockSize>::contains(const K &key) const {
+    return search(key) != nullptr;
+}
+
+template <typename T, typename Compare, std::size_t BlockSize>
+typename UnrolledSkipList<T, Compare, BlockSize>::Iterator
+UnrolledSkipList<T, Compare, BlockSize>::lower_bound(const T &value) const {
+    return lower_bound<T>(value);
+}
+
+// The block holds every greater value up to the first value of the next
+// block, if all of its values are smaller the bound starts the next block
+template <typename T, typename Compare, std::size_t BlockSize>
+template <typename K>
+    requires LookupKey<K, T, Compare>
+typename UnrolledSkipList<T, Compare, BlockSize>::Iterator
+UnrolledSkipList<T, Compare, BlockSize>::lower_bound(const K &key) const {
+    Link tower = findBlock(key, nullptr);
+    if (tower == head) {
+        return begin();
+    }
+    Block *block = owner(tower);
+    const std::size_t pos = sortedLowerBound(block, key, comp);
+    if (pos == block->count) {
+        return Iterator(tower[0], 0);
+    }
+    return Iterator(block, pos);
+}
+
+template <typename T, typename Compare, std::size_t BlockSize>
+typename UnrolledSkipList<T, Compare, BlockSize>::Iterator
+UnrolledSkipList<T, Compare, BlockSize>::upper_bound(const T &value) const {
+    return upper_bound<T>(value);
+}
+
+template <typename T, typename Compare, std::size_t BlockSize>
+template <typename K>
+    requires LookupKey<K, T, Compare>
+typename UnrolledSkipList<T, Compare, BlockSize>::Iterator
+UnrolledSkipList<T, Compare, BlockSize>::upper_bound(const K &key) const {
+    return equal_range(key).second;
+}
+
+template <typename T, typename Compare, std::size_t BlockSize>
+std::pair<typename UnrolledSkipList<T, Compare, BlockSize>::Iterator,
+          typename UnrolledSkipList<T, Compare, BlockSize>::Iterator>
+UnrolledSkipList<T, Compare, BlockSize>::equal_range(const T &value) const {
+    return equal_range<T>(value);
+}
+
+template <typename T, typename Compare, std::size_t BlockSize>
+template <typename K>
+    requires LookupKey<K, T, Compare>
+std::pair<typename UnrolledSkipList<T, Compare, BlockSize>::Iterator,
+          typename UnrolledSkipList<T, Compare, BlockSize>::Iterator>
+UnrolledSkipList<T, Compare, BlockSize>::equal_range(const K &key) const {
+    Iterator lower = lower_bound(key);
+    if (lower != end() && !comp(key, *lower)) {
+        return {lower, std::next(lower)};
+    }
+    return {lower, lower};
+}
+
+template <typename T, typename Compare, std::size_t BlockSize>
+template <typename F>
+void UnrolledSkipList<T, Compare, BlockSize>::forEachInRange(const T &lo,
+                                                             const T &hi,
+                                                             F &&fn) const {
+    forEachInRange<T>(lo, hi, std::forward<F>(fn));
+}
+
+// descend once to lo, then read the blocks front to back until hi
+template <typename T, typename Compare, std::size_t BlockSize>
+template <typename K, typename F>
+    requires LookupKey<K, T, Compare>
+void UnrolledSkipList<T, Compare, BlockSize>::forEachInRange(const K &lo,
+                                                             const K &hi,
+                                                             F &&fn) const {
+    for (Iterator it = lower_bound(lo); it != end() && comp(*it, hi); ++it) {
+        if constexpr (std::is_same_v<std::invoke_result_t<F &, T &>, bool>) {
+            if (!fn(*it)) {
+                return;
+            }
+        } else {
+            fn(*it);
+        }
+    }
+}
+
+template <typename T, typename Compare, std::size_t BlockSize>
+std::size_t UnrolledSkipList<T, Compare, BlockSize>::blocks() const noexcept {
+    return blockCount;
+}
+
+template <typename T, typename Compare, std::size_t BlockSize>
+std::size_t UnrolledSkipList<T, Compare, BlockSize>::size() const noexcept {
+    return count;
+}
+
+template <typename T, typename Compare, std::size_t BlockSize>
+bool UnrolledSkipList<T, Compare, BlockSize>::empty() const noexcept {
+    return count == 0;
+}
+
+template <typename T, typename Compare, std::size_t BlockSize>
+typename UnrolledSkipList<T, Compare, BlockSize>::Iterator
+UnrolledSkipList<T, Compare, BlockSize>::begin() const {
+    return Iterator(head[0], 0);
+}
+
+template <typename T, typename Compare, std::size_t BlockSize>
+typename UnrolledSkipList<T, Compare, BlockSize>::Iterator
+UnrolledSkipList<T, Compare, BlockSize>::end() const {
+    return Iterator(nullptr, 0);
+}
+
+template <typename T, typename Compare, std::size_t BlockSize>
+typename UnrolledSkipList<T, Compare, BlockSize>::Link
+UnrolledSkipList<T, Compare, BlockSize>::Block::forward() noexcept {
+    return std::launder(reinterpret_cast<Block **>(
+        reinterpret_cast<std::byte *>(this) + TOWER_OFFSET));
+}
+
+template <typename T, typename Compare, std::size_t BlockSize>
+typename UnrolledSkipList<T, Compare, BlockSize>::Block *
+UnrolledSkipList<T, Compare, BlockSize>::owner(Link tower) noexcept {
+    return std::launder(reinterpret_cast<Block *>(
+        reinterpret_cast<std::byte *>(tower) - TOWER_OFFSET));
+}
+
+template <typename T, typename Compare, std::size_t BlockSize>
+typename UnrolledSkipList<T, Compare, BlockSize>::Block *
+UnrolledSkipList<T, Compare, BlockSize>::createBlock(int level) {
+    void *memory = ::operator new(TOWER_OFFSET + level * sizeof(Block *),
+                                  BLOCK_ALIGNMENT);
+    Block *block = new (memory) Block();
+    std::uninitialized_fill_n(
+        reinterpret_cast<Block **>(static_cast<std::byte *>(memory) +
+                                   TOWER_OFFSET),
+        level, nullptr);
+    return block;
+}
+
+template <typename T, typename Compare, std::size_t BlockSize>
+void UnrolledSkipList<T, Compare, BlockSize>::destroyBlock(
+    Block *block) noexcept {
+    std::destroy(block->keys(), block->keys() + block->count);
+    block->~Block();
+    ::operator delete(block, BLOCK_ALIGNMENT);
+}
+
+// The block the walk stopped at on the level above starts after key, so
+// reaching it again on a lower level ends that level without a comparison
+template <typename T, typename Compare, std::size_t BlockSize>
+template <typename K>
+typename UnrolledSkipList<T, Compare, BlockSize>::Link
+UnrolledSkipList<T, Compare, BlockSize>::findBlock(const K &key, Link *update,
+                                                   const Block *before) const {
+    Link current = head;
+    const Block *bound = nullptr;
+    for (int level = levels - 1; level >= 0; --level) {
+        Block *next = current[level];
+        while (next != bound && next != before &&
+               !comp(key, next->keys()[0])) {
+            current = next->forward();
+            next = current[level];
+        }
+        bound = next;
+        if (update != nullptr) {
+            update[level] = current;
+        }
+    }
+    return current;
+}
@@ -1,7 +1,24 @@
 // NOLINTBEGIN
 #include "avl_tree/avl_tree.h"
+#include <algorithm>
 #include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <functional>
 #include <gtest/gtest.h>
+#include <iterator>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <ranges>
+#include <set>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <vector>
 
 TEST(AvlTree, Initalization) {
     AVLTree<int> tree;
@@ -337,4 +354,905 @@ TEST(AvlTree, MinMaxAfterSkewedInsertion) {
     EXPECT_EQ(*tree.min(), 1);
     EXPECT_EQ(*tree.max(), 100);
 }
+
+TEST(AvlTree, RandomizedAgainstStdSet) {
+    AVLTree<int> tree;
+    std::set<int> reference;
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> dist(0, 2000);
+
+    for (int i = 0; i < 20000; ++i) {
+        const int value = dist(gen);
+        if (i % 3 == 0) {
+            EXPECT_EQ(tree.remove(value), reference.erase(value) == 1);
+        } else {
+            EXPECT_EQ(tree.insert(value), reference.insert(value).second);
+        }
+    }
+
+    EXPECT_EQ(tree.size(), reference.size());
+    EXPECT_LE(tree.height(),
+              static_cast<int>(1.45 * std::log2(reference.size() + 2)));
+    EXPECT_TRUE(std::equal(tree.begin(), tree.end(), reference.begin(),
+                           reference.end()));
+}
+
+TEST(AvlTree, DeepTreeRemoval) {
+    AVLTree<int> tree;
+    const int count = 100000;
+
+    for (int i = 0; i < count; ++i)
+        tree.insert(i);
+    for (int i = 0; i < count; i += 3)
+        EXPECT_TRUE(tree.remove(i));
+
+    EXPECT_EQ(tree.size(), static_cast<size_t>(count - (count + 2) / 3));
+    EXPECT_LE(tree.height(), static_cast<int>(1.45 * std::log2(count)));
+    EXPECT_EQ(*tree.min(), 1);
+    EXPECT_EQ(*tree.max(), count - 2);
+}
+
+TEST(AvlTree, ReverseIteration) {
+    AVLTree<int> tree;
+    for (int i = 1; i <= 50; ++i)
+        tree.insert(i);
+
+    std::vector<int> result(tree.rbegin(), tree.rend());
+
+    ASSERT_EQ(result.size(), 50u);
+    EXPECT_EQ(result.front(), 50);
+    EXPECT_EQ(result.back(), 1);
+    EXPECT_TRUE(std::is_sorted(result.rbegin(), result.rend()));
+}
+
+TEST(AvlTree, BidirectionalIteration) {
+    AVLTree<int> tree;
+    for (int i : {5, 3, 8, 1, 4, 7, 9})
+        tree.insert(i);
+
+    auto it = tree.end();
+    EXPECT_EQ(*--it, 9);
+    EXPECT_EQ(*it--, 9);
+    EXPECT_EQ(*it, 8);
+    ++it;
+    EXPECT_EQ(*it, 9);
+    EXPECT_EQ(++it, tree.end());
+    EXPECT_EQ(std::distance(tree.begin(), tree.end()), 7);
+}
+
+TEST(AvlTree, IterationAfterRemoval) {
+    AVLTree<int> tree;
+    std::set<int> reference;
+    for (int i = 0; i < 300; ++i) {
+        tree.insert((i * 7) % 300);
+        reference.insert((i * 7) % 300);
+    }
+    for (int i = 0; i < 300; i += 4) {
+        tree.remove(i);
+        reference.erase(i);
+    }
+
+    EXPECT_TRUE(std::ranges::equal(tree, reference));
+    EXPECT_TRUE(std::equal(tree.rbegin(), tree.rend(), reference.rbegin(),
+                           reference.rend()));
+}
+
+TEST(AvlTree, EmptyIteration) {
+    AVLTree<int> tree;
+
+    EXPECT_EQ(tree.begin(), tree.end());
+    EXPECT_EQ(tree.rbegin(), tree.rend());
+}
+
+TEST(AvlTree, SelectAndRank) {
+    AVLTree<int> tree;
+    for (int i = 0; i < 100; ++i)
+        tree.insert(i * 2);
+
+    for (size_t k = 0; k < 100; ++k) {
+        ASSERT_NE(tree.select(k), nullptr);
+        EXPECT_EQ(*tree.select(k), static_cast<int>(k) * 2);
+        EXPECT_EQ(tree.rank(static_cast<int>(k) * 2), k);
+        EXPECT_EQ(tree.rank(static_cast<int>(k) * 2 + 1), k + 1);
+    }
+    EXPECT_EQ(tree.select(100), nullptr);
+    EXPECT_EQ(tree.rank(-1), 0u);
+}
+
+TEST(AvlTree, OrderStatisticsAfterRemoval) {
+    AVLTree<int> tree;
+    std::set<int> reference;
+    for (int i = 0; i < 500; ++i) {
+        tree.insert((i * 37) % 500);
+        reference.insert((i * 37) % 500);
+    }
+    for (int i = 0; i < 500; i += 3) {
+        tree.remove(i);
+        reference.erase(i);
+    }
+
+    EXPECT_EQ(tree.size(), reference.size());
+    size_t k = 0;
+    for (int value : reference) {
+        EXPECT_EQ(*tree.select(k), value);
+        EXPECT_EQ(tree.rank(value), k);
+        ++k;
+    }
+}
+
+TEST(AvlTree, CountRange) {
+    AVLTree<int> tree;
+    for (int i = 0; i < 10; ++i)
+        tree.insert(i);
+
+    EXPECT_EQ(tree.countRange(2, 5), 3u);
+    EXPECT_EQ(tree.countRange(-10, 100), 10u);
+    EXPECT_EQ(tree.countRange(5, 5), 0u);
+    EXPECT_EQ(tree.countRange(7, 3), 0u);
+}
+
+TEST(AvlTree, BuildFromSortedRange) {
+    std::vector<int> values(1000);
+    for (int i = 0; i < 1000; ++i)
+        values[i] = i * 3;
+
+    AVLTree<int> tree(values.begin(), values.end());
+
+    EXPECT_EQ(tree.size(), 1000u);
+    EXPECT_EQ(tree.height(), 10);
+    EXPECT_TRUE(std::ranges::equal(tree, values));
+    EXPECT_EQ(*tree.select(500), 1500);
+
+    // The built tree stays a regular AVL tree
+    EXPECT_TRUE(tree.insert(1));
+    EXPECT_TRUE(tree.remove(0));
+    EXPECT_EQ(*tree.min(), 1);
+    EXPECT_EQ(*tree.max(), 2997);
+}
+
+TEST(AvlTree, BuildFromUnsortedRange) {
+    AVLTree<int> tree = {5, 3, 9, 3, 1, 5, 7};
+
+    std::vector<int> expected = {1, 3, 5, 7, 9};
+    EXPECT_EQ(tree.size(), 5u);
+    EXPECT_EQ(tree.height(), 3);
+    EXPECT_TRUE(std::ranges::equal(tree, expected));
+    EXPECT_EQ(*--tree.end(), 9);
+}
+
+TEST(AvlTree, AssignReplacesContents) {
+    PooledAVLTree<std::string> tree;
+    tree.insert("old");
+
+    std::vector<std::string> values = {"a", "b", "c", "d"};
+    tree.assign(values.begin(), values.end());
+
+    EXPECT_EQ(tree.size(), 4u);
+    EXPECT_FALSE(tree.contains("old"));
+    EXPECT_TRUE(std::ranges::equal(tree, values));
+
+    tree.assign(values.begin(), values.begin());
+    EXPECT_TRUE(tree.empty());
+}
+
+TEST(AvlTree, SplitAndJoin) {
+    AVLTree<int> tree;
+    for (int i = 0; i < 1000; ++i)
+        tree.insert(i);
+
+    AVLTree<int> greater;
+    greater.insert(-1);
+    EXPECT_TRUE(tree.split(600, greater));
+
+    EXPECT_EQ(tree.size(), 600u);
+    EXPECT_EQ(greater.size(), 399u);
+    EXPECT_EQ(*tree.max(), 599);
+    EXPECT_EQ(*greater.min(), 601);
+    EXPECT_LE(tree.height(), static_cast<int>(1.45 * std::log2(600)));
+    EXPECT_LE(greater.height(), static_cast<int>(1.45 * std::log2(399)));
+
+    tree.join(600, std::move(greater));
+    EXPECT_TRUE(greater.empty());
+    EXPECT_EQ(tree.size(), 1000u);
+    EXPECT_EQ(*tree.select(600), 600);
+    EXPECT_LE(tree.height(), static_cast<int>(1.45 * std::log2(1000)));
+
+    std::vector<int> expected(1000);
+    for (int i = 0; i < 1000; ++i)
+        expected[i] = i;
+    EXPECT_TRUE(std::ranges::equal(tree, expected));
+    EXPECT_TRUE(std::equal(tree.rbegin(), tree.rend(), expected.rbegin(),
+                           expected.rend()));
+}
+
+TEST(AvlTree, JoinUnevenHeights) {
+    AVLTree<int> small = {1, 2};
+    std::vector<int> values;
+    for (int i = 10; i < 5000; ++i)
+        values.push_back(i);
+    AVLTree<int> large(values.begin(), values.end());
+
+    small.join(5, std::move(large));
+
+    EXPECT_EQ(small.size(), 4993u);
+    EXPECT_EQ(*small.select(2), 5);
+    EXPECT_LE(small.height(), static_cast<int>(1.45 * std::log2(4993)));
+}
+
+namespace {
+template <typename Tree>
+void checkSetAlgebra(int count) {
+    std::set<int> lhsValues;
+    std::set<int> rhsValues;
+    std::mt19937 gen(7);
+    std::uniform_int_distribution<int> dist(0, count * 2);
+    Tree lhs;
+    Tree rhs;
+    for (int i = 0; i < count; ++i) {
+        int a = dist(gen);
+        int b = dist(gen);
+        lhs.insert(a);
+        lhsValues.insert(a);
+        rhs.insert(b);
+        rhsValues.insert(b);
+    }
+
+    std::vector<int> expected;
+    Tree unionTree(lhsValues.begin(), lhsValues.end());
+    Tree other(rhsValues.begin(), rhsValues.end());
+    unionTree.setUnion(std::move(other));
+    std::set_union(lhsValues.begin(), lhsValues.end(), rhsValues.begin(),
+                   rhsValues.end(), std::back_inserter(expected));
+    EXPECT_TRUE(other.empty());
+    EXPECT_EQ(unionTree.size(), expected.size());
+    EXPECT_TRUE(std::ranges::equal(unionTree, expected));
+    EXPECT_LE(unionTree.height(),
+              static_cast<int>(1.45 * std::log2(expected.size() + 2)));
+
+    expected.clear();
+    Tree intersection(lhsValues.begin(), lhsValues.end());
+    intersection.setIntersection(Tree(rhsValues.begin(), rhsValues.end()));
+    std::set_intersection(lhsValues.begin(), lhsValues.end(),
+                          rhsValues.begin(), rhsValues.end(),
+                          std::back_inserter(expected));
+    EXPECT_EQ(intersection.size(), expected.size());
+    EXPECT_TRUE(std::ranges::equal(intersection, expected));
+
+    expected.clear();
+    lhs.setDifference(std::move(rhs));
+    std::set_difference(lhsValues.begin(), lhsValues.end(), rhsValues.begin(),
+                        rhsValues.end(), std::back_inserter(expected));
+    EXPECT_EQ(lhs.size(), expected.size());
+    EXPECT_TRUE(std::ranges::equal(lhs, expected));
+    EXPECT_TRUE(std::equal(lhs.rbegin(), lhs.rend(), expected.rbegin(),
+                           expected.rend()));
+}
+} // namespace
+
+TEST(AvlTree, SetAlgebraSmall) { checkSetAlgebra<AVLTree<int>>(200); }
+
+TEST(AvlTree, SetAlgebraParallel) { checkSetAlgebra<AVLTree<int>>(100000); }
+
+TEST(AvlTree, SetAlgebraPooled) { checkSetAlgebra<PooledAVLTree<int>>(5000); }
+
+TEST(AvlTree, HeterogeneousLookup) {
+    AVLTree<std::string, std::less<>> tree;
+    tree.insert("apple");
+    tree.insert("banana");
+    tree.insert("cherry");
+
+    std::string_view key = "banana";
+    ASSERT_NE(tree.search(key), nullptr);
+    EXPECT_EQ(*tree.search(key), "banana");
+    EXPECT_TRUE(tree.contains("cherry"));
+    EXPECT_FALSE(tree.contains(std::string_view("durian")));
+
+    EXPECT_TRUE(tree.remove(key));
+    EXPECT_FALSE(tree.remove("banana"));
+    EXPECT_EQ(tree.size(), 2u);
+}
+
+TEST(AvlTree, MoveOnlyValues) {
+    AVLTree<std::unique_ptr<int>> tree;
+
+    EXPECT_TRUE(tree.insert(std::make_unique<int>(1)));
+    EXPECT_TRUE(tree.emplace(new int(2)));
+    EXPECT_EQ(tree.size(), 2u);
+}
+
+namespace {
+struct CopyCounter {
+    static inline int copies = 0;
+    int key;
+
+    explicit CopyCounter(int key) : key(key) {}
+    CopyCounter(const CopyCounter &other) : key(other.key) { ++copies; }
+    CopyCounter(CopyCounter &&other) noexcept = default;
+    CopyCounter &operator=(const CopyCounter &) = default;
+    CopyCounter &operator=(CopyCounter &&) noexcept = default;
+    ~CopyCounter() = default;
+
+    bool operator<(const CopyCounter &other) const { return key < other.key; }
+};
+} // namespace
+
+TEST(AvlTree, InsertWithoutCopies) {
+    AVLTree<CopyCounter> tree;
+    CopyCounter::copies = 0;
+
+    tree.insert(CopyCounter(1));
+    tree.emplace(2);
+    CopyCounter value(3);
+    tree.insert(std::move(value));
+    EXPECT_EQ(CopyCounter::copies, 0);
+
+    CopyCounter other(4);
+    tree.insert(other);
+    EXPECT_EQ(CopyCounter::copies, 1);
+
+    // a rejected copy insert does not copy at all
+    EXPECT_FALSE(tree.insert(other));
+    EXPECT_EQ(CopyCounter::copies, 1);
+}
+
+TEST(AvlTree, MoveAndSwap) {
+    AVLTree<int> tree;
+    for (int i = 0; i < 100; ++i)
+        tree.insert(i);
+
+    AVLTree<int> moved(std::move(tree));
+    EXPECT_EQ(moved.size(), 100u);
+    EXPECT_TRUE(tree.empty());
+    tree.insert(500);
+    EXPECT_TRUE(tree.contains(500));
+
+    AVLTree<int> assigned = {-1};
+    assigned = std::move(moved);
+    EXPECT_EQ(assigned.size(), 100u);
+    EXPECT_FALSE(assigned.contains(-1));
+    EXPECT_EQ(*--assigned.end(), 99);
+
+    swap(assigned, tree);
+    EXPECT_EQ(tree.size(), 100u);
+    EXPECT_EQ(assigned.size(), 1u);
+}
+
+TEST(AvlTree, PooledMoveKeepsArenaPrivate) {
+    PooledAVLTree<std::string> tree;
+    for (int i = 0; i < 100; ++i)
+        tree.insert(std::to_string(i));
+
+    PooledAVLTree<std::string> moved(std::move(tree));
+    // clearing the moved-from tree must not release the nodes it handed off
+    tree.clear();
+    tree.insert("x");
+
+    EXPECT_EQ(moved.size(), 100u);
+    EXPECT_TRUE(moved.contains("42"));
+
+    PooledAVLTree<std::string> assigned;
+    assigned.insert("y");
+    assigned = std::move(moved);
+    moved.clear();
+    EXPECT_EQ(assigned.size(), 100u);
+    EXPECT_TRUE(assigned.contains("99"));
+}
+
+// Every default constructed allocator differs from all others and stays with
+// its tree on move assignment, so moving has to copy the values over
+template <typename T> struct SeparateAllocator {
+    using value_type = T;
+    using propagate_on_container_move_assignment = std::false_type;
+    using is_always_equal = std::false_type;
+
+    SeparateAllocator() : id(nextId()) {}
+    template <typename U>
+    SeparateAllocator(const SeparateAllocator<U> &other) : id(other.id) {}
+
+    T *allocate(size_t n) { return std::allocator<T>{}.allocate(n); }
+    void deallocate(T *p, size_t n) { std::allocator<T>{}.deallocate(p, n); }
+    bool operator==(const SeparateAllocator &other) const {
+        return id == other.id;
+    }
+
+    static int nextId() {
+        static int ids = 0;
+        return ++ids;
+    }
+
+    int id;
+};
+
+TEST(AvlTree, MoveAssignBetweenSeparateAllocators) {
+    using Tree =
+        AVLTree<std::string, std::less<>, SeparateAllocator<std::string>>;
+    static_assert(!std::is_nothrow_move_assignable_v<Tree>);
+
+    Tree tree;
+    for (int i = 0; i < 100; ++i)
+        tree.insert(std::to_string(i));
+
+    Tree assigned;
+    assigned.insert("x");
+    assigned = std::move(tree);
+    EXPECT_TRUE(tree.empty());
+    EXPECT_EQ(assigned.size(), 100u);
+    EXPECT_FALSE(assigned.contains("x"));
+    EXPECT_TRUE(assigned.contains("42"));
+    EXPECT_TRUE(std::ranges::is_sorted(assigned));
+}
+
+TEST(AvlTree, PooledInsertRemove) {
+    PooledAVLTree<int> tree;
+
+    for (int i = 0; i < 1000; ++i)
+        EXPECT_TRUE(tree.insert(i));
+    for (int i = 0; i < 1000; i += 2)
+        EXPECT_TRUE(tree.remove(i));
+
+    EXPECT_EQ(tree.size(), 500u);
+    EXPECT_FALSE(tree.contains(0));
+    EXPECT_TRUE(tree.contains(1));
+}
+
+TEST(AvlTree, PooledClearAndReuse) {
+    PooledAVLTree<std::string> tree;
+
+    for (int i = 0; i < 100; ++i)
+        tree.insert(std::to_string(i));
+    tree.clear();
+
+    EXPECT_TRUE(tree.empty());
+    EXPECT_EQ(tree.min(), nullptr);
+
+    tree.insert("a");
+    tree.insert("b");
+    EXPECT_EQ(tree.size(), 2u);
+    EXPECT_EQ(*tree.max(), "b");
+}
+
+struct CountingLess {
+    static inline size_t comparisons = 0;
+
+    bool operator()(int lhs, int rhs) const {
+        ++comparisons;
+        return lhs < rhs;
+    }
+};
+
+TEST(AvlTree, AppendsUseFingers) {
+    AVLTree<int, CountingLess> tree;
+    const int count = 10000;
+
+    CountingLess::comparisons = 0;
+    for (int i = 0; i < count; ++i)
+        tree.insert(i);
+    for (int i = -1; i >= -count; --i)
+        tree.insert(i);
+
+    // One comparison against the max, one more against the min
+    EXPECT_LE(CountingLess::comparisons, static_cast<size_t>(3 * count));
+    EXPECT_EQ(tree.size(), static_cast<size_t>(2 * count));
+    EXPECT_EQ(*tree.min(), -count);
+    EXPECT_EQ(*tree.max(), count - 1);
+    EXPECT_LE(tree.height(), static_cast<int>(1.45 * std::log2(2 * count)));
+    EXPECT_TRUE(std::is_sorted(tree.begin(), tree.end()));
+}
+
+TEST(AvlTree, FingersFollowRemoval) {
+    AVLTree<int> tree{1, 2, 3, 4, 5};
+
+    tree.remove(1);
+    tree.remove(5);
+    EXPECT_EQ(*tree.min(), 2);
+    EXPECT_EQ(*tree.max(), 4);
+    EXPECT_EQ(*std::prev(tree.end()), 4);
+
+    tree.insert(0);
+    tree.insert(9);
+    EXPECT_EQ(*tree.begin(), 0);
+    EXPECT_EQ(*tree.rbegin(), 9);
+
+    tree.remove(0);
+    tree.remove(2);
+    tree.remove(3);
+    tree.remove(4);
+    tree.remove(9);
+    EXPECT_EQ(tree.min(), nullptr);
+    EXPECT_EQ(tree.max(), nullptr);
+    EXPECT_EQ(tree.begin(), tree.end());
+}
+
+TEST(AvlTree, InsertHint) {
+    AVLTree<int, CountingLess> tree;
+
+    auto it = tree.end();
+    for (int i = 0; i < 1000; i += 2)
+        it = std::next(tree.insertHint(tree.end(), i));
+    EXPECT_EQ(it, tree.end());
+
+    // Fill the gaps from the back, every value goes right before the hint
+    CountingLess::comparisons = 0;
+    it = tree.end();
+    for (int i = 999; i > 0; i -= 2) {
+        it = tree.insertHint(it, i);
+        EXPECT_EQ(*it, i);
+        --it;
+    }
+    EXPECT_LE(CountingLess::comparisons, 500u * 2);
+    EXPECT_EQ(tree.size(), 1000u);
+    EXPECT_TRUE(std::ranges::equal(tree, std::views::iota(0, 1000)));
+}
+
+TEST(AvlTree, InsertHintMisplaced) {
+    AVLTree<int> tree{10, 20, 30};
+
+    // A wrong hint still inserts in the right place
+    auto it = tree.insertHint(tree.begin(), 25);
+    EXPECT_EQ(*it, 25);
+    it = tree.insertHint(tree.end(), 5);
+    EXPECT_EQ(*it, 5);
+
+    // Duplicates hand back the existing value
+    it = tree.insertHint(tree.end(), 30);
+    EXPECT_EQ(*it, 30);
+    EXPECT_EQ(std::next(it), tree.end());
+    it = tree.insertHint(tree.begin(), 20);
+    EXPECT_EQ(*it, 20);
+
+    EXPECT_EQ(tree.size(), 5u);
+    EXPECT_TRUE(std::ranges::equal(tree, std::vector<int>{5, 10, 20, 25, 30}));
+}
+
+TEST(AvlTree, InsertHintRandomized) {
+    AVLTree<int> tree;
+    std::set<int> reference;
+    std::mt19937 gen(7);
+    std::uniform_int_distribution<int> dist(0, 5000);
+
+    for (int i = 0; i < 5000; ++i) {
+        const int value = dist(gen);
+        auto hint = reference.lower_bound(value);
+        auto treeHint = tree.begin();
+        std::advance(treeHint, std::distance(reference.begin(), hint));
+        if (i % 2 == 0)
+            treeHint = tree.begin();
+
+        auto it = tree.insertHint(treeHint, value);
+        reference.insert(value);
+        EXPECT_EQ(*it, value);
+    }
+
+    EXPECT_EQ(tree.size(), reference.size());
+    EXPECT_TRUE(std::ranges::equal(tree, reference));
+    EXPECT_EQ(*tree.min(), *reference.begin());
+    EXPECT_EQ(*tree.max(), *reference.rbegin());
+}
+
+TEST(AvlTree, FingersAfterBulkOperations) {
+    AVLTree<int> tree{1, 2, 3, 4, 5, 6, 7, 8};
+    AVLTree<int> greater;
+
+    tree.split(4, greater);
+    EXPECT_EQ(*tree.max(), 3);
+    EXPECT_EQ(*greater.min(), 5);
+
+    tree.join(4, std::move(greater));
+    EXPECT_EQ(*tree.max(), 8);
+    EXPECT_EQ(greater.max(), nullptr);
+
+    tree.setUnion(AVLTree<int>{0, 20});
+    EXPECT_EQ(*tree.min(), 0);
+    EXPECT_EQ(*tree.max(), 20);
+
+    AVLTree<int> other = std::move(tree);
+    EXPECT_EQ(tree.min(), nullptr);
+    EXPECT_EQ(*other.max(), 20);
+    other.insert(21);
+    EXPECT_EQ(*other.rbegin(), 21);
+}
+
+TEST(AvlTree, BoundsAgainstStdSet) {
+    AVLTree<int> container;
+    std::set<int> reference;
+    std::mt19937 gen(11);
+    std::uniform_int_distribution<int> dist(0, 3000);
+
+    for (int i = 0; i < 1000; ++i) {
+        const int value = dist(gen);
+        container.insert(value);
+        reference.insert(value);
+    }
+
+    for (int i = -1; i <= 3001; ++i) {
+        auto lower = container.lower_bound(i);
+        auto upper = container.upper_bound(i);
+        auto expectedLower = reference.lower_bound(i);
+        auto expectedUpper = reference.upper_bound(i);
+
+        ASSERT_EQ(lower == container.end(), expectedLower == reference.end());
+        if (lower != container.end()) {
+            EXPECT_EQ(*lower, *expectedLower);
+        }
+        ASSERT_EQ(upper == container.end(), expectedUpper == reference.end());
+        if (upper != container.end()) {
+            EXPECT_EQ(*upper, *expectedUpper);
+        }
+
+        auto [first, last] = container.equal_range(i);
+        EXPECT_EQ(std::distance(first, last),
+                  static_cast<std::ptrdiff_t>(reference.count(i)));
+    }
+}
+
+TEST(AvlTree, ForEachInRange) {
+    AVLTree<int> container;
+    for (int i = 0; i < 100; i += 3)
+        container.insert(i);
+
+    std::vector<int> visited;
+    container.forEachInRange(10, 30, [&](int value) {
+        visited.push_back(value);
+    });
+    EXPECT_EQ(visited, (std::vector<int>{12, 15, 18, 21, 24, 27}));
+
+    // hi is exclusive, an empty or inverted range visits nothing
+    visited.clear();
+    container.forEachInRange(12, 12, [&](int value) {
+        visited.push_back(value);
+    });
+    container.forEachInRange(50, 10, [&](int value) {
+        visited.push_back(value);
+    });
+    EXPECT_TRUE(visited.empty());
+
+    // returning false stops the scan
+    container.forEachInRange(0, 100, [&](int value) {
+        visited.push_back(value);
+        return visited.size() < 4;
+    });
+    EXPECT_EQ(visited, (std::vector<int>{0, 3, 6, 9}));
+}
+
+TEST(AvlTree, HeterogeneousRangeQueries) {
+    AVLTree<std::string, std::less<>> container;
+    for (const char *word : {"apple", "banana", "cherry", "date"})
+        container.insert(word);
+
+    EXPECT_EQ(*container.lower_bound(std::string_view("b")), "banana");
+    EXPECT_EQ(*container.upper_bound(std::string_view("banana")), "cherry");
+
+    std::vector<std::string> visited;
+    container.forEachInRange(std::string_view("b"), std::string_view("d"),
+                             [&](const std::string &value) {
+                                 visited.push_back(value);
+                             });
+    EXPECT_EQ(visited, (std::vector<std::string>{"banana", "cherry"}));
+}
+TEST(AvlTree, BatchInsertAndRemove) {
+    AVLTree<int> tree;
+    std::set<int> reference;
+    std::mt19937 gen(11);
+
+    // batches large enough to be merged on several threads, with duplicates
+    // inside the batch and against the tree
+    for (int round = 0; round < 6; ++round) {
+        std::uniform_int_distribution<int> dist(0, 200000);
+        std::vector<int> batch(40000);
+        for (int &value : batch)
+            value = dist(gen);
+
+        size_t expected = 0;
+        if (round % 3 == 2) {
+            for (int value : batch)
+                expected += reference.erase(value);
+            EXPECT_EQ(tree.removeBatch(batch), expected);
+        } else {
+            for (int value : batch)
+                expected += reference.insert(value).second ? 1 : 0;
+            EXPECT_EQ(tree.insertBatch(batch), expected);
+        }
+
+        ASSERT_EQ(tree.size(), reference.size());
+        ASSERT_TRUE(std::ranges::equal(tree, reference));
+        EXPECT_EQ(*tree.min(), *reference.begin());
+        EXPECT_EQ(*tree.max(), *reference.rbegin());
+        EXPECT_LE(tree.height(),
+                  static_cast<int>(1.45 * std::log2(reference.size() + 2)));
+    }
+
+    // small batches and plain inserts still line up with the fingers
+    EXPECT_EQ(tree.insertBatch(std::vector<int>{-5, 300000, -5}), 2u);
+    EXPECT_EQ(*tree.min(), -5);
+    EXPECT_EQ(*tree.max(), 300000);
+    EXPECT_EQ(tree.insertBatch(std::vector<int>{}), 0u);
+    EXPECT_EQ(tree.removeBatch(std::vector<int>{-5, -6}), 1u);
+    EXPECT_TRUE(tree.insert(-7));
+    EXPECT_EQ(*tree.min(), -7);
+
+    const size_t remaining = tree.size();
+    EXPECT_EQ(tree.removeBatch(std::views::iota(-10, 300001)), remaining);
+    EXPECT_TRUE(tree.empty());
+    EXPECT_EQ(tree.min(), nullptr);
+}
+
+TEST(AvlTree, BatchKeepsExistingValues) {
+    PooledAVLTree<std::string> tree;
+    tree.insert("b");
+    const std::string *existing = tree.search("b");
+
+    std::vector<std::string> batch{"c", "b", "a", "c"};
+    EXPECT_EQ(tree.insertBatch(std::move(batch)), 2u);
+    EXPECT_EQ(tree.search("b"), existing);
+    EXPECT_TRUE(std::ranges::equal(tree, std::vector<std::string>{"a", "b",
+                                                                  "c"}));
+
+    EXPECT_EQ(tree.removeBatch(std::vector<std::string>{"a", "c", "d"}), 2u);
+    EXPECT_EQ(tree.size(), 1u);
+}
+
+TEST(AvlTree, ContainsMany) {
+    AVLTree<int> tree;
+    std::vector<int> keys(1000);
+    std::iota(keys.begin(), keys.end(), -500);
+    std::vector<int *> results(keys.size());
+    auto found = std::make_unique<bool[]>(keys.size());
+    std::span<bool> flags(found.get(), keys.size());
+    std::ranges::fill(flags, true);
+
+    // an empty container finds nothing
+    EXPECT_EQ(tree.containsMany(keys, flags), 0u);
+    EXPECT_TRUE(std::ranges::none_of(flags, std::identity{}));
+
+    // large enough for the interleaved searches, with a key count that is
+    // not a multiple of the group size
+    std::mt19937 gen(5);
+    std::uniform_int_distribution<int> dist(0, 2 * 200000);
+    std::vector<int> values(200000);
+    for (int &value : values)
+        value = dist(gen);
+    tree.insertBatch(values);
+    keys.resize(10007);
+    for (int &key : keys)
+        key = dist(gen);
+    results.assign(keys.size(), nullptr);
+    found = std::make_unique<bool[]>(keys.size());
+    flags = std::span<bool>(found.get(), keys.size());
+
+    size_t expected = 0;
+    for (int key : keys)
+        expected += tree.contains(key) ? 1 : 0;
+    EXPECT_EQ(tree.containsMany(keys, flags), expected);
+    tree.searchMany(keys, results);
+    for (size_t i = 0; i < keys.size(); ++i) {
+        ASSERT_EQ(flags[i], tree.contains(keys[i]));
+        ASSERT_EQ(results[i], tree.search(keys[i]));
+    }
+}
+
+TEST(AvlTree, SnapshotRoundTrip) {
+    const std::filesystem::path path =
+        std::filesystem::temp_directory_path() / "avl_tree_snapshot.bin";
+    AVLTree<int> tree;
+    std::set<int> reference;
+    std::mt19937 gen(9);
+    std::uniform_int_distribution<int> dist(-100000, 100000);
+    for (int i = 0; i < 50000; ++i) {
+        const int value = dist(gen);
+        tree.insert(value);
+        reference.insert(value);
+    }
+    tree.save(path);
+
+    AVLTree<int> loaded;
+    loaded.insert(7);
+    loaded.load(path);
+    EXPECT_EQ(loaded.size(), reference.size());
+    EXPECT_TRUE(std::ranges::equal(loaded, reference));
+    EXPECT_TRUE(loaded.insert(200001));
+    EXPECT_TRUE(loaded.remove(*reference.begin()));
+
+    // an empty snapshot empties the target
+    AVLTree<int> empty;
+    empty.save(path);
+    loaded.load(path);
+    EXPECT_TRUE(loaded.empty());
+    EXPECT_EQ(loaded.begin(), loaded.end());
+
+    // a file written with another order still loads
+    AVLTree<int, std::greater<int>> descending;
+    for (int value : reference)
+        descending.insert(value);
+    descending.save(path);
+    loaded.load(path);
+    EXPECT_TRUE(std::ranges::equal(loaded, reference));
+
+    std::filesystem::remove(path);
+}
+
+TEST(AvlTree, SnapshotRejectsDamagedFiles) {
+    const std::filesystem::path path =
+        std::filesystem::temp_directory_path() / "avl_tree_damaged.bin";
+    AVLTree<int> tree;
+    for (int i = 0; i < 1000; ++i)
+        tree.insert(i);
+    tree.save(path);
+
+    AVLTree<int> loaded;
+    loaded.insert(-1);
+    {
+        std::fstream file(path, std::ios::in | std::ios::out |
+                                    std::ios::binary);
+        file.seekp(100);
+        file.put('\x7f');
+    }
+    EXPECT_THROW(loaded.load(path), std::runtime_error);
+    // a failed load leaves the contents alone
+    EXPECT_EQ(loaded.size(), 1u);
+    EXPECT_TRUE(loaded.contains(-1));
+
+    tree.save(path);
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 4);
+    EXPECT_THROW(loaded.load(path), std::runtime_error);
+
+    tree.save(path);
+    AVLTree<long long> wider;
+    EXPECT_THROW(wider.load(path), std::runtime_error);
+
+    std::filesystem::remove(path);
+    EXPECT_THROW(loaded.load(path), std::system_error);
+    EXPECT_TRUE(loaded.contains(-1));
+}
+
+TEST(AvlTree, CountingStats) {
+    using CountedTree =
+        AVLTree<int, std::less<int>, std::allocator<int>, CountingStats>;
+    CountedTree tree;
+    EXPECT_EQ(tree.stats().snapshot().comparisons, 0u);
+
+    // 3, 2, 1 needs one single right rotation, 1, 3, 2 one double rotation
+    for (int value : {3, 2, 1})
+        tree.insert(value);
+    StatsSnapshot stats = tree.stats().snapshot();
+    EXPECT_EQ(stats.rightRotations, 1u);
+    EXPECT_EQ(stats.rotations(), 1u);
+    tree.clear();
+    for (int value : {1, 3, 2})
+        tree.insert(value);
+    stats = tree.stats().snapshot();
+    EXPECT_EQ(stats.doubleRotations, 1u);
+    EXPECT_EQ(stats.rotations(), 2u);
+    EXPECT_EQ(stats.allocations, 6u);
+    EXPECT_EQ(stats.searches(), 6u);
+    EXPECT_FALSE(tree.insert(2));
+    EXPECT_EQ(tree.stats().snapshot().allocations, 6u);
+
+    // a perfect tree of 7 nodes has one value at depth 1, two at 2 and four
+    // at 3, a miss below a leaf visits 3 nodes as well
+    tree.stats().reset();
+    std::vector<int> values(7);
+    std::iota(values.begin(), values.end(), 1);
+    tree.assign(values.begin(), values.end());
+    stats = tree.stats().snapshot();
+    EXPECT_EQ(stats.allocations, 7u);
+    EXPECT_EQ(stats.rotations(), 0u);
+
+    tree.stats().reset();
+    for (int value = 1; value <= 8; ++value)
+        EXPECT_EQ(tree.contains(value), value < 8);
+    stats = tree.stats().snapshot();
+    EXPECT_EQ(stats.searchDepths[1], 1u);
+    EXPECT_EQ(stats.searchDepths[2], 2u);
+    EXPECT_EQ(stats.searchDepths[3], 5u);
+    EXPECT_EQ(stats.searches(), 8u);
+    // a step to the left takes one comparison, a step to the right and a
+    // hit take two
+    EXPECT_EQ(stats.comparisons, 35u);
+
+    // a lookup through a const tree is counted as well
+    const CountedTree &constTree = tree;
+    EXPECT_NE(constTree.search(4), nullptr);
+    EXPECT_EQ(tree.stats().snapshot().searchDepths[1], 2u);
+}
+
 // NOLINTEND
@@ -0,0 +1,89 @@
+// NOLINTBEGIN
+#include "btree/btree.h"
+#include "ordered_set_tests.h"
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <gtest/gtest.h>
+#include <ranges>
+#include <vector>
+
+// Three keys per node, so a few values already need several levels
+template <typename T> using TinyBTree = BTreeSet<T, std::less<T>, 1>;
+
+struct BTreeSetTraits {
+    template <typename T, typename Compare = std::less<T>>
+    using Set = BTreeSet<T, Compare>;
+    template <typename T> using Small = TinyBTree<T>;
+    template <typename S> static bool isReset(const S &tree) {
+        return tree.height() == 0;
+    }
+};
+
+INSTANTIATE_TYPED_TEST_SUITE_P(BTreeSet, OrderedSetTest, BTreeSetTraits);
+
+TEST(BTreeSet, SortedInsertion) {
+    BTreeSet<int> tree;
+    const int count = 1000000;
+
+    for (int i = 0; i < count; ++i)
+        tree.insert(i);
+
+    EXPECT_EQ(tree.size(), static_cast<size_t>(count));
+    // 64 keys per node and nodes at least half full
+    EXPECT_LE(tree.height(), 5);
+    EXPECT_EQ(*tree.min(), 0);
+    EXPECT_EQ(*tree.max(), count - 1);
+    for (int i = 0; i < count; i += 997)
+        EXPECT_TRUE(tree.contains(i));
+}
+
+TEST(BTreeSet, BidirectionalIteration) {
+    TinyBTree<int> tree;
+    for (int i = 1; i <= 50; ++i)
+        tree.insert(i);
+
+    std::vector<int> backwards;
+    for (auto it = tree.end(); it != tree.begin();)
+        backwards.push_back(*--it);
+
+    EXPECT_EQ(backwards.size(), 50u);
+    EXPECT_TRUE(std::ranges::equal(
+        backwards, std::views::iota(1, 51) | std::views::reverse));
+}
+
+template <typename T> void checkCountLess() {
+    std::vector<T> keys;
+    for (int i = 0; i < 37; ++i)
+        keys.push_back(static_cast<T>(i * 3));
+
+    for (int i = -1; i < 115; ++i) {
+        const T key = static_cast<T>(i);
+        for (size_t n : {size_t{0}, size_t{5}, keys.size()}) {
+            const auto expected = std::lower_bound(keys.begin(),
+                                                   keys.begin() + n, key) -
+                                  keys.begin();
+            EXPECT_EQ(countLess(keys.data(), n, key),
+                      static_cast<size_t>(expected));
+        }
+    }
+}
+
+TEST(BTreeSet, CountLessMatchesLowerBound) {
+    checkCountLess<int32_t>();
+    checkCountLess<uint32_t>();
+    checkCountLess<int64_t>();
+    checkCountLess<uint64_t>();
+    checkCountLess<int16_t>();
+    checkCountLess<float>();
+    checkCountLess<double>();
+}
+
+TEST(BTreeSet, CountLessUnsignedHighBit) {
+    const uint32_t keys[] = {1, 2, 0x80000000u, 0x80000001u, 0xffffffffu};
+
+    EXPECT_EQ(countLess(keys, 5, 0x80000000u), 2u);
+    EXPECT_EQ(countLess(keys, 5, 0xfffffffeu), 4u);
+    EXPECT_EQ(countLess(keys, 5, 0u), 0u);
+}
+// NOLINTEND
@@ -0,0 +1,61 @@
+// NOLINTBEGIN
+#include "compact_avl/compact_avl_tree.h"
+#include "ordered_set_tests.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <gtest/gtest.h>
+#include <iterator>
+#include <ranges>
+#include <vector>
+
+struct CompactAVLTreeTraits {
+    template <typename T, typename Compare = std::less<T>>
+    using Set = CompactAVLTree<T, Compare>;
+    // no nodes to shrink, the small sets just run fewer operations
+    template <typename T> using Small = CompactAVLTree<T>;
+    template <typename S> static bool isReset(const S &tree) {
+        return tree.height() == 0;
+    }
+};
+
+INSTANTIATE_TYPED_TEST_SUITE_P(CompactAVLTree, OrderedSetTest,
+                               CompactAVLTreeTraits);
+
+TEST(CompactAVLTree, NodeSize) {
+    EXPECT_EQ(CompactAVLTree<int>::NODE_SIZE, 16u);
+    EXPECT_EQ(CompactAVLTree<long>::NODE_SIZE, 24u);
+}
+
+TEST(CompactAVLTree, HeightStaysLogarithmic) {
+    CompactAVLTree<int> tree;
+    const int count = 1 << 20;
+
+    for (int i = 0; i < count; ++i)
+        tree.insert(i);
+    // An AVL tree is at most 1.44 log2(n) high
+    EXPECT_LE(tree.height(), static_cast<int>(1.44 * std::log2(count)) + 1);
+
+    for (int i = 0; i < count; i += 2)
+        tree.remove(i);
+    EXPECT_EQ(tree.size(), static_cast<size_t>(count / 2));
+    EXPECT_LE(tree.height(), static_cast<int>(1.44 * std::log2(count)) + 1);
+    EXPECT_EQ(*tree.min(), 1);
+    EXPECT_EQ(*tree.max(), count - 1);
+}
+
+TEST(CompactAVLTree, BidirectionalIteration) {
+    CompactAVLTree<int> tree;
+    for (int i = 1; i <= 50; ++i)
+        tree.insert(i);
+
+    std::vector<int> backwards;
+    for (auto it = tree.end(); it != tree.begin();)
+        backwards.push_back(*--it);
+
+    EXPECT_EQ(backwards.size(), 50u);
+    EXPECT_TRUE(std::ranges::equal(
+        backwards, std::views::iota(1, 51) | std::views::reverse));
+    EXPECT_EQ(*std::prev(tree.lower_bound(100)), 50);
+}
+// NOLINTEND
@@ -0,0 +1,314 @@
+// NOLINTBEGIN
+#include "concurrent_avl/concurrent_avl_tree.h"
+#include <atomic>
+#include <cmath>
+#include <gtest/gtest.h>
+#include <optional>
+#include <random>
+#include <set>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+TEST(ConcurrentAVLTree, Initialization) {
+    ConcurrentAVLTree<int> tree;
+
+    EXPECT_TRUE(tree.empty());
+    EXPECT_EQ(tree.size(), 0u);
+    EXPECT_EQ(tree.height(), 0);
+    EXPECT_EQ(tree.min(), std::nullopt);
+    EXPECT_EQ(tree.max(), std::nullopt);
+    EXPECT_FALSE(tree.contains(1));
+    EXPECT_FALSE(tree.remove(1));
+}
+
+TEST(ConcurrentAVLTree, RandomizedAgainstStdSet) {
+    ConcurrentAVLTree<int> tree;
+    std::set<int> reference;
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> dist(0, 20000);
+
+    for (int i = 0; i < 100000; ++i) {
+        const int value = dist(gen);
+        if (i % 3 == 0) {
+            ASSERT_EQ(tree.remove(value), reference.erase(value) == 1);
+        } else {
+            ASSERT_EQ(tree.insert(value), reference.insert(value).second);
+        }
+    }
+
+    EXPECT_EQ(tree.size(), reference.size());
+    EXPECT_EQ(*tree.min(), *reference.begin());
+    EXPECT_EQ(*tree.max(), *reference.rbegin());
+    for (int i = 0; i <= 20000; ++i) {
+        EXPECT_EQ(tree.contains(i), reference.count(i) == 1);
+    }
+    // Routing nodes add to the height, but not by much
+    EXPECT_LE(tree.height(), 2 * static_cast<int>(std::log2(20000)));
+
+    for (int value : reference) {
+        ASSERT_TRUE(tree.remove(value));
+    }
+    EXPECT_TRUE(tree.empty());
+    EXPECT_EQ(tree.height(), 0);
+    EXPECT_EQ(tree.min(), std::nullopt);
+}
+
+TEST(ConcurrentAVLTree, RoutingNodes) {
+    ConcurrentAVLTree<int> tree;
+    for (int value : {4, 2, 6, 1, 3, 5, 7})
+        tree.insert(value);
+
+    // 4 has two children and stays as a routing node
+    EXPECT_TRUE(tree.remove(4));
+    EXPECT_FALSE(tree.contains(4));
+    EXPECT_EQ(tree.search(4), std::nullopt);
+    EXPECT_FALSE(tree.remove(4));
+    EXPECT_EQ(tree.size(), 6u);
+
+    EXPECT_TRUE(tree.insert(4));
+    EXPECT_FALSE(tree.insert(4));
+    EXPECT_TRUE(tree.contains(4));
+
+    // Removed values at either end are skipped by min and max
+    EXPECT_TRUE(tree.remove(1));
+    EXPECT_TRUE(tree.remove(2));
+    EXPECT_TRUE(tree.remove(7));
+    EXPECT_EQ(*tree.min(), 3);
+    EXPECT_EQ(*tree.max(), 6);
+}
+
+TEST(ConcurrentAVLTree, HeterogeneousLookup) {
+    ConcurrentAVLTree<std::string, std::less<>> tree;
+    tree.insert("apple");
+    tree.insert("banana");
+
+    EXPECT_TRUE(tree.contains(std::string_view("apple")));
+    ASSERT_NE(tree.search(std::string_view("banana")), std::nullopt);
+    EXPECT_EQ(*tree.search(std::string_view("banana")), "banana");
+    EXPECT_TRUE(tree.remove(std::string_view("apple")));
+    EXPECT_EQ(tree.size(), 1u);
+}
+
+TEST(ConcurrentAVLTree, ConcurrentInsertAndRemove) {
+    ConcurrentAVLTree<int> tree;
+    const int threads = 8;
+    const int perThread = 20000;
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&tree, t] {
+            for (int i = 0; i < perThread; ++i)
+                tree.insert(i * threads + t);
+        });
+    }
+    for (auto &worker : workers)
+        worker.join();
+
+    EXPECT_EQ(tree.size(), static_cast<size_t>(threads * perThread));
+    for (int i = 0; i < threads * perThread; ++i)
+        ASSERT_TRUE(tree.contains(i));
+
+    workers.clear();
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&tree, t] {
+            for (int i = 0; i < perThread; ++i) {
+                if (i % 2 == 0)
+                    tree.remove(i * threads + t);
+            }
+        });
+    }
+    for (auto &worker : workers)
+        worker.join();
+
+    EXPECT_EQ(tree.size(), static_cast<size_t>(threads * perThread / 2));
+    for (int i = 0; i < threads * perThread; ++i)
+        ASSERT_EQ(tree.contains(i), (i / threads) % 2 == 1);
+}
+
+// Writers churn the odd values while readers look for the even ones, which
+// never leave the tree. Rotations must not make a reader miss any of them.
+TEST(ConcurrentAVLTree, ReadersDuringRotations) {
+    ConcurrentAVLTree<int> tree;
+    const int range = 4096;
+    for (int i = 0; i < range; i += 2)
+        tree.insert(i);
+
+    std::atomic<bool> done{false};
+    std::atomic<int> misses{0};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t) {
+        readers.emplace_back([&, t] {
+            std::mt19937 gen(t);
+            std::uniform_int_distribution<int> dist(0, range / 2 - 1);
+            while (!done.load()) {
+                const int value = 2 * dist(gen);
+                if (!tree.contains(value))
+                    misses.fetch_add(1);
+                if (tree.contains(value + range))
+                    misses.fetch_add(1);
+            }
+        });
+    }
+
+    std::vector<std::thread> writers;
+    for (int t = 0; t < 2; ++t) {
+        writers.emplace_back([&, t] {
+            std::mt19937 gen(100 + t);
+            std::uniform_int_distribution<int> dist(0, range / 2 - 1);
+            for (int i = 0; i < 200000; ++i) {
+                const int value = 2 * dist(gen) + 1;
+                if (gen() % 2 == 0)
+                    tree.insert(value);
+                else
+                    tree.remove(value);
+            }
+        });
+    }
+    for (auto &writer : writers)
+        writer.join();
+    done.store(true);
+    for (auto &reader : readers)
+        reader.join();
+
+    EXPECT_EQ(misses.load(), 0);
+    for (int i = 0; i < range; i += 2)
+        EXPECT_TRUE(tree.contains(i));
+}
+
+// Every writer owns the values of one residue class, so each can keep its
+// own reference set while they all rebalance the same tree
+TEST(ConcurrentAVLTree, ConcurrentWritersAgainstStdSet) {
+    ConcurrentAVLTree<int> tree;
+    const int threads = 8;
+    const int range = 1 << 14;
+    std::vector<std::set<int>> references(threads);
+
+    std::vector<std::thread> writers;
+    for (int t = 0; t < threads; ++t) {
+        writers.emplace_back([&, t] {
+            std::mt19937 gen(t);
+            std::uniform_int_distribution<int> dist(0, range / threads - 1);
+            for (int i = 0; i < 50000; ++i) {
+                const int value = dist(gen) * threads + t;
+                if (gen() % 3 == 0) {
+                    EXPECT_EQ(tree.remove(value),
+                              references[t].erase(value) == 1);
+                } else {
+                    EXPECT_EQ(tree.insert(value),
+                              references[t].insert(value).second);
+                }
+            }
+        });
+    }
+    for (auto &writer : writers)
+        writer.join();
+
+    std::set<int> reference;
+    for (const auto &part : references)
+        reference.insert(part.begin(), part.end());
+    EXPECT_EQ(tree.size(), reference.size());
+    for (int i = 0; i < range; ++i)
+        ASSERT_EQ(tree.contains(i), reference.count(i) == 1);
+    EXPECT_EQ(*tree.min(), *reference.begin());
+    EXPECT_EQ(*tree.max(), *reference.rbegin());
+    // Once the writers are done every height is repaired
+    EXPECT_LE(tree.height(), 2 * static_cast<int>(std::log2(range)));
+}
+
+TEST(ConcurrentAVLTree, MinMaxDuringWrites) {
+    ConcurrentAVLTree<int> tree;
+    const int range = 4096;
+    tree.insert(0);
+    tree.insert(range);
+
+    std::atomic<bool> done{false};
+    std::atomic<int> misses{0};
+    std::thread reader([&] {
+        while (!done.load()) {
+            if (tree.min() != 0 || tree.max() != range)
+                misses.fetch_add(1);
+        }
+    });
+
+    std::vector<std::thread> writers;
+    for (int t = 0; t < 4; ++t) {
+        writers.emplace_back([&, t] {
+            std::mt19937 gen(t);
+            std::uniform_int_distribution<int> dist(1, range - 1);
+            for (int i = 0; i < 100000; ++i) {
+                if (gen() % 2 == 0)
+                    tree.insert(dist(gen));
+                else
+                    tree.remove(dist(gen));
+            }
+        });
+    }
+    for (auto &writer : writers)
+        writer.join();
+    done.store(true);
+    reader.join();
+
+    EXPECT_EQ(misses.load(), 0);
+}
+
+TEST(ConcurrentAVLTree, ClearDuringWrites) {
+    ConcurrentAVLTree<int> tree;
+    const int range = 2048;
+    std::atomic<bool> done{false};
+
+    std::vector<std::thread> writers;
+    for (int t = 0; t < 4; ++t) {
+        writers.emplace_back([&, t] {
+            std::mt19937 gen(t);
+            std::uniform_int_distribution<int> dist(0, range - 1);
+            while (!done.load()) {
+                if (gen() % 3 == 0)
+                    tree.remove(dist(gen));
+                else
+                    tree.insert(dist(gen));
+            }
+        });
+    }
+    for (int round = 0; round < 200; ++round) {
+        std::this_thread::yield();
+        tree.clear();
+    }
+    done.store(true);
+    for (auto &writer : writers)
+        writer.join();
+
+    // Values that made it into a tree before it was cleared are not
+    // counted twice
+    std::size_t found = 0;
+    for (int i = 0; i < range; ++i)
+        found += tree.contains(i) ? 1 : 0;
+    EXPECT_EQ(tree.size(), found);
+    tree.clear();
+    EXPECT_TRUE(tree.empty());
+    EXPECT_EQ(tree.height(), 0);
+}
+
+TEST(ConcurrentAVLTree, ClearWhileReading) {
+    ConcurrentAVLTree<int> tree;
+    std::atomic<bool> done{false};
+
+    std::thread reader([&] {
+        while (!done.load()) {
+            for (int i = 0; i < 1000; i += 7)
+                (void)tree.contains(i);
+        }
+    });
+    for (int round = 0; round < 50; ++round) {
+        for (int i = 0; i < 1000; ++i)
+            tree.insert(i);
+        tree.clear();
+    }
+    done.store(true);
+    reader.join();
+
+    EXPECT_TRUE(tree.empty());
+    EXPECT_FALSE(tree.contains(0));
+}
+// NOLINTEND
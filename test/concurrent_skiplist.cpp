@@ -0,0 +1,251 @@
+// NOLINTBEGIN
+#include "concurrent_skiplist/concurrent_skiplist.h"
+#include <atomic>
+#include <gtest/gtest.h>
+#include <optional>
+#include <random>
+#include <set>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+TEST(ConcurrentSkipList, Initialization) {
+    ConcurrentSkipList<int> list;
+
+    EXPECT_TRUE(list.empty());
+    EXPECT_EQ(list.size(), 0u);
+    EXPECT_EQ(list.min(), std::nullopt);
+    EXPECT_EQ(list.max(), std::nullopt);
+    EXPECT_FALSE(list.contains(1));
+    EXPECT_FALSE(list.remove(1));
+}
+
+TEST(ConcurrentSkipList, RandomizedAgainstStdSet) {
+    ConcurrentSkipList<int> list;
+    std::set<int> reference;
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> dist(0, 20000);
+
+    for (int i = 0; i < 100000; ++i) {
+        const int value = dist(gen);
+        if (i % 3 == 0) {
+            ASSERT_EQ(list.remove(value), reference.erase(value) == 1);
+        } else {
+            ASSERT_EQ(list.insert(value), reference.insert(value).second);
+        }
+    }
+
+    EXPECT_EQ(list.size(), reference.size());
+    EXPECT_EQ(*list.min(), *reference.begin());
+    EXPECT_EQ(*list.max(), *reference.rbegin());
+    for (int i = 0; i <= 20000; ++i) {
+        EXPECT_EQ(list.contains(i), reference.count(i) == 1);
+    }
+
+    for (int value : reference) {
+        ASSERT_TRUE(list.remove(value));
+    }
+    EXPECT_TRUE(list.empty());
+    EXPECT_EQ(list.min(), std::nullopt);
+    EXPECT_EQ(list.max(), std::nullopt);
+}
+
+TEST(ConcurrentSkipList, HeterogeneousLookup) {
+    ConcurrentSkipList<std::string, std::less<>> list;
+    list.insert("apple");
+    list.insert("banana");
+
+    EXPECT_TRUE(list.contains(std::string_view("apple")));
+    ASSERT_NE(list.search(std::string_view("banana")), std::nullopt);
+    EXPECT_EQ(*list.search(std::string_view("banana")), "banana");
+    EXPECT_TRUE(list.remove(std::string_view("apple")));
+    EXPECT_FALSE(list.remove(std::string_view("apple")));
+    EXPECT_EQ(list.size(), 1u);
+}
+
+TEST(ConcurrentSkipList, ConcurrentInsertAndRemove) {
+    ConcurrentSkipList<int> list;
+    const int threads = 8;
+    const int perThread = 20000;
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&list, t] {
+            for (int i = 0; i < perThread; ++i)
+                list.insert(i * threads + t);
+        });
+    }
+    for (auto &worker : workers)
+        worker.join();
+
+    EXPECT_EQ(list.size(), static_cast<size_t>(threads * perThread));
+    for (int i = 0; i < threads * perThread; ++i)
+        ASSERT_TRUE(list.contains(i));
+
+    workers.clear();
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&list, t] {
+            for (int i = 0; i < perThread; ++i) {
+                if (i % 2 == 0)
+                    list.remove(i * threads + t);
+            }
+        });
+    }
+    for (auto &worker : workers)
+        worker.join();
+
+    EXPECT_EQ(list.size(), static_cast<size_t>(threads * perThread / 2));
+    for (int i = 0; i < threads * perThread; ++i)
+        ASSERT_EQ(list.contains(i), (i / threads) % 2 == 1);
+}
+
+// Every thread inserts and removes the same few values, so inserters and
+// removers of one value keep racing. Each successful insert or remove is
+// counted, which has to add up to what is left in the list.
+TEST(ConcurrentSkipList, ContendedValues) {
+    ConcurrentSkipList<int> list;
+    const int range = 64;
+    std::atomic<int> balance[range] = {};
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 8; ++t) {
+        workers.emplace_back([&, t] {
+            std::mt19937 gen(t);
+            std::uniform_int_distribution<int> dist(0, range - 1);
+            for (int i = 0; i < 50000; ++i) {
+                const int value = dist(gen);
+                if (gen() % 2 == 0) {
+                    if (list.insert(value))
+                        balance[value].fetch_add(1);
+                } else if (list.remove(value)) {
+                    balance[value].fetch_sub(1);
+                }
+            }
+        });
+    }
+    for (auto &worker : workers)
+        worker.join();
+
+    size_t present = 0;
+    for (int value = 0; value < range; ++value) {
+        ASSERT_EQ(list.contains(value), balance[value].load() == 1);
+        present += balance[value].load();
+    }
+    EXPECT_EQ(list.size(), present);
+}
+
+// Writers churn the odd values while readers look for the even ones, which
+// never leave the list
+TEST(ConcurrentSkipList, ReadersDuringWrites) {
+    ConcurrentSkipList<int> list;
+    const int range = 4096;
+    for (int i = 0; i < range; i += 2)
+        list.insert(i);
+
+    std::atomic<bool> done{false};
+    std::atomic<int> misses{0};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t) {
+        readers.emplace_back([&, t] {
+            std::mt19937 gen(t);
+            std::uniform_int_distribution<int> dist(0, range / 2 - 1);
+            while (!done.load()) {
+                const int value = 2 * dist(gen);
+                if (!list.contains(value))
+                    misses.fetch_add(1);
+                if (list.contains(value + range))
+                    misses.fetch_add(1);
+            }
+        });
+    }
+
+    std::vector<std::thread> writers;
+    for (int t = 0; t < 2; ++t) {
+        writers.emplace_back([&, t] {
+            std::mt19937 gen(100 + t);
+            std::uniform_int_distribution<int> dist(0, range / 2 - 1);
+            for (int i = 0; i < 200000; ++i) {
+                const int value = 2 * dist(gen) + 1;
+                if (gen() % 2 == 0)
+                    list.insert(value);
+                else
+                    list.remove(value);
+            }
+        });
+    }
+    for (auto &writer : writers)
+        writer.join();
+    done.store(true);
+    for (auto &reader : readers)
+        reader.join();
+
+    EXPECT_EQ(misses.load(), 0);
+    for (int i = 0; i < range; i += 2)
+        EXPECT_TRUE(list.contains(i));
+    EXPECT_EQ(*list.min(), 0);
+}
+
+// Writers keep inserting and removing the very values the reader looks up,
+// so the nodes it finds are retired and freed while it uses the results
+TEST(ConcurrentSkipList, LookupsDuringChurn) {
+    ConcurrentSkipList<std::string> list;
+    const std::string key(64, 'k');
+    const std::string low(64, 'a');
+    const std::string high(64, 'z');
+    list.insert(low);
+    list.insert(high);
+
+    std::atomic<bool> done{false};
+    std::atomic<int> misses{0};
+    std::thread reader([&] {
+        while (!done.load()) {
+            const auto found = list.search(key);
+            if (found.has_value() && *found != key)
+                misses.fetch_add(1);
+            if (list.min() != low || list.max() != high)
+                misses.fetch_add(1);
+        }
+    });
+
+    std::vector<std::thread> writers;
+    for (int t = 0; t < 3; ++t) {
+        writers.emplace_back([&] {
+            for (int i = 0; i < 100000; ++i) {
+                list.insert(key);
+                list.remove(key);
+            }
+        });
+    }
+    for (auto &writer : writers)
+        writer.join();
+    done.store(true);
+    reader.join();
+
+    EXPECT_EQ(misses.load(), 0);
+    EXPECT_EQ(list.size(), 2u);
+}
+
+TEST(ConcurrentSkipList, ClearWhileReading) {
+    ConcurrentSkipList<int> list;
+    std::atomic<bool> done{false};
+
+    std::thread reader([&] {
+        while (!done.load()) {
+            for (int i = 0; i < 1000; i += 7)
+                (void)list.contains(i);
+            (void)list.max();
+        }
+    });
+    for (int round = 0; round < 50; ++round) {
+        for (int i = 0; i < 1000; ++i)
+            list.insert(i);
+        list.clear();
+    }
+    done.store(true);
+    reader.join();
+
+    EXPECT_TRUE(list.empty());
+    EXPECT_FALSE(list.contains(0));
+}
+// NOLINTEND
@@ -0,0 +1,127 @@
+// NOLINTBEGIN
+#include "avl_tree/avl_tree.h"
+#include "frozen/frozen_set.h"
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <iterator>
+#include <random>
+#include <ranges>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+TEST(FrozenSet, Empty) {
+    AVLTree<int> tree;
+    FrozenSet<int> frozen = tree.freeze();
+
+    EXPECT_TRUE(frozen.empty());
+    EXPECT_EQ(frozen.size(), 0u);
+    EXPECT_EQ(frozen.begin(), frozen.end());
+    EXPECT_FALSE(frozen.contains(1));
+    EXPECT_EQ(frozen.search(1), nullptr);
+    EXPECT_EQ(frozen.lower_bound(1), frozen.end());
+}
+
+// Every size up to 100 covers complete trees and all shapes of partial last
+// levels
+TEST(FrozenSet, LookupsForEverySize) {
+    for (int n = 1; n <= 100; ++n) {
+        AVLTree<int> tree;
+        for (int i = 0; i < n; ++i)
+            tree.insert(2 * i);
+        FrozenSet<int> frozen = tree.freeze();
+
+        ASSERT_EQ(frozen.size(), static_cast<size_t>(n));
+        ASSERT_TRUE(std::ranges::equal(frozen, tree));
+        for (int key = -1; key <= 2 * n; ++key) {
+            ASSERT_EQ(frozen.contains(key), tree.contains(key));
+            auto lower = frozen.lower_bound(key);
+            auto expected = tree.lower_bound(key);
+            ASSERT_EQ(lower == frozen.end(), expected == tree.end());
+            if (lower != frozen.end()) {
+                ASSERT_EQ(*lower, *expected);
+            }
+            auto upper = frozen.upper_bound(key);
+            expected = tree.upper_bound(key);
+            ASSERT_EQ(upper == frozen.end(), expected == tree.end());
+            if (upper != frozen.end()) {
+                ASSERT_EQ(*upper, *expected);
+            }
+        }
+    }
+}
+
+TEST(FrozenSet, RandomizedAgainstStdSet) {
+    AVLTree<int> tree;
+    std::set<int> reference;
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> dist(0, 1000000);
+
+    for (int i = 0; i < 50000; ++i) {
+        const int value = dist(gen);
+        tree.insert(value);
+        reference.insert(value);
+    }
+    FrozenSet<int> frozen = tree.freeze();
+
+    EXPECT_EQ(tree.size(), reference.size());
+    EXPECT_TRUE(std::ranges::equal(frozen, reference));
+    for (int i = 0; i < 50000; ++i) {
+        const int key = dist(gen);
+        auto lower = frozen.lower_bound(key);
+        auto expected = reference.lower_bound(key);
+        ASSERT_EQ(lower == frozen.end(), expected == reference.end());
+        if (expected != reference.end()) {
+            ASSERT_EQ(*lower, *expected);
+        }
+        ASSERT_EQ(frozen.contains(key), reference.count(key) == 1);
+    }
+}
+
+TEST(FrozenSet, BidirectionalIteration) {
+    AVLTree<int> tree;
+    for (int i = 1; i <= 50; ++i)
+        tree.insert(i);
+    FrozenSet<int> frozen = tree.freeze();
+
+    std::vector<int> backwards;
+    for (auto it = frozen.end(); it != frozen.begin();)
+        backwards.push_back(*--it);
+
+    EXPECT_TRUE(std::ranges::equal(
+        backwards, std::views::iota(1, 51) | std::views::reverse));
+}
+
+TEST(FrozenSet, HeterogeneousLookup) {
+    AVLTree<std::string, std::less<>> tree;
+    tree.insert("apple");
+    tree.insert("banana");
+    tree.insert("cherry");
+    FrozenSet<std::string, std::less<>> frozen = tree.freeze();
+
+    EXPECT_TRUE(frozen.contains(std::string_view("apple")));
+    EXPECT_FALSE(frozen.contains(std::string_view("apricot")));
+    EXPECT_EQ(*frozen.lower_bound(std::string_view("b")), "banana");
+    EXPECT_EQ(*frozen.upper_bound(std::string_view("banana")), "cherry");
+    // The tree keeps its values
+    EXPECT_EQ(tree.size(), 3u);
+    EXPECT_EQ(*tree.min(), "apple");
+}
+
+TEST(FrozenSet, Move) {
+    AVLTree<int> tree;
+    for (int i = 0; i < 1000; ++i)
+        tree.insert(i);
+    FrozenSet<int> frozen = tree.freeze();
+
+    FrozenSet<int> moved(std::move(frozen));
+    EXPECT_EQ(moved.size(), 1000u);
+    EXPECT_TRUE(frozen.empty());
+
+    frozen = std::move(moved);
+    EXPECT_EQ(frozen.size(), 1000u);
+    EXPECT_TRUE(frozen.contains(999));
+    EXPECT_TRUE(moved.empty());
+}
+// NOLINTEND
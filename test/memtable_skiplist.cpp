@@ -0,0 +1,131 @@
+// NOLINTBEGIN
+#include "memtable/memtable_skiplist.h"
+#include <algorithm>
+#include <atomic>
+#include <gtest/gtest.h>
+#include <iterator>
+#include <numeric>
+#include <random>
+#include <set>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+TEST(MemtableSkipList, Initialization) {
+    MemtableSkipList<int> list;
+
+    EXPECT_TRUE(list.empty());
+    EXPECT_EQ(list.size(), 0u);
+    EXPECT_EQ(list.min(), nullptr);
+    EXPECT_EQ(list.max(), nullptr);
+    EXPECT_FALSE(list.contains(1));
+    EXPECT_EQ(list.begin(), list.end());
+    EXPECT_EQ(list.lower_bound(1), list.end());
+}
+
+TEST(MemtableSkipList, RandomizedAgainstStdSet) {
+    MemtableSkipList<int> list;
+    std::set<int> reference;
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> dist(0, 20000);
+
+    for (int i = 0; i < 50000; ++i) {
+        const int value = dist(gen);
+        ASSERT_EQ(list.insert(value), reference.insert(value).second);
+    }
+
+    EXPECT_EQ(list.size(), reference.size());
+    EXPECT_EQ(*list.min(), *reference.begin());
+    EXPECT_EQ(*list.max(), *reference.rbegin());
+    EXPECT_TRUE(std::equal(list.begin(), list.end(), reference.begin(),
+                           reference.end()));
+    for (int i = -1; i <= 20001; ++i) {
+        ASSERT_EQ(list.contains(i), reference.count(i) == 1);
+        auto it = list.lower_bound(i);
+        auto expected = reference.lower_bound(i);
+        if (expected == reference.end()) {
+            ASSERT_EQ(it, list.end());
+        } else {
+            ASSERT_NE(it, list.end());
+            ASSERT_EQ(*it, *expected);
+        }
+    }
+}
+
+TEST(MemtableSkipList, HeterogeneousLookup) {
+    MemtableSkipList<std::string, std::less<>> list;
+    EXPECT_TRUE(list.insert("banana"));
+    EXPECT_TRUE(list.insert(std::string("apple")));
+    EXPECT_FALSE(list.insert("apple"));
+
+    EXPECT_TRUE(list.contains(std::string_view("apple")));
+    ASSERT_NE(list.search(std::string_view("banana")), nullptr);
+    EXPECT_EQ(*list.search(std::string_view("banana")), "banana");
+    EXPECT_EQ(*list.lower_bound(std::string_view("b")), "banana");
+    EXPECT_EQ(list.size(), 2u);
+}
+
+TEST(MemtableSkipList, HugePageArena) {
+    MemtableSkipList<long, std::less<long>, true> list;
+    for (long i = 999; i >= 0; --i)
+        list.insert(i);
+
+    EXPECT_EQ(list.size(), 1000u);
+    EXPECT_EQ(std::distance(list.begin(), list.end()), 1000);
+    EXPECT_EQ(*list.min(), 0);
+    EXPECT_EQ(*list.max(), 999);
+}
+
+// One writer inserts a shuffled range while readers keep looking. A value a
+// reader found once has to stay, and every walk along the list has to be
+// sorted.
+TEST(MemtableSkipList, ReadersDuringInsert) {
+    MemtableSkipList<int> list;
+    const int range = 100000;
+    std::vector<int> values(range);
+    std::iota(values.begin(), values.end(), 0);
+    std::shuffle(values.begin(), values.end(), std::mt19937(7));
+
+    std::atomic<bool> done{false};
+    std::atomic<int> errors{0};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t) {
+        readers.emplace_back([&, t] {
+            std::mt19937 gen(t);
+            std::uniform_int_distribution<int> dist(0, range - 1);
+            std::vector<int> seen;
+            while (!done.load()) {
+                const int value = dist(gen);
+                if (list.contains(value))
+                    seen.push_back(value);
+                for (int old : seen) {
+                    if (!list.contains(old))
+                        errors.fetch_add(1);
+                }
+                if (seen.size() > 64)
+                    seen.clear();
+
+                auto it = list.lower_bound(value);
+                for (int step = 0; step < 64 && it != list.end(); ++step) {
+                    const int prev = *it++;
+                    if (it != list.end() && *it <= prev)
+                        errors.fetch_add(1);
+                }
+            }
+        });
+    }
+
+    for (int value : values)
+        list.insert(value);
+    done.store(true);
+    for (auto &reader : readers)
+        reader.join();
+
+    EXPECT_EQ(errors.load(), 0);
+    EXPECT_EQ(list.size(), static_cast<size_t>(range));
+    int expected = 0;
+    for (int value : list)
+        ASSERT_EQ(value, expected++);
+}
+// NOLINTEND
@@ -0,0 +1,165 @@
+// NOLINTBEGIN
+#include "mmap_avl/mmap_avl_tree.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <iterator>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace {
+// A fresh file in the temp directory that is gone again after the test
+class TreeFile {
+  public:
+    explicit TreeFile(const std::string &name)
+        : path(std::filesystem::temp_directory_path() / name) {
+        std::filesystem::remove(path);
+    }
+    ~TreeFile() { std::filesystem::remove(path); }
+
+    std::filesystem::path path;
+};
+} // namespace
+
+TEST(MmapAVLTree, Initialization) {
+    TreeFile file("mmap_avl_init.tree");
+    MmapAVLTree<int> tree(file.path);
+
+    EXPECT_TRUE(tree.empty());
+    EXPECT_EQ(tree.size(), 0u);
+    EXPECT_EQ(tree.height(), 0);
+    EXPECT_EQ(tree.min(), nullptr);
+    EXPECT_EQ(tree.begin(), tree.end());
+    EXPECT_FALSE(tree.remove(1));
+    EXPECT_FALSE(tree.readOnly());
+    EXPECT_GT(tree.capacity(), 0u);
+    EXPECT_EQ(std::filesystem::file_size(file.path), MAPPED_NODES_CHUNK);
+}
+
+TEST(MmapAVLTree, RandomizedAgainstStdSet) {
+    TreeFile file("mmap_avl_random.tree");
+    MmapAVLTree<int> tree(file.path);
+    std::set<int> reference;
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> dist(0, 1 << 20);
+
+    // enough values to grow the file by a few chunks
+    for (int i = 0; i < 1000000; ++i) {
+        const int value = dist(gen);
+        if (i % 4 == 0) {
+            ASSERT_EQ(tree.remove(value), reference.erase(value) == 1);
+        } else {
+            ASSERT_EQ(tree.insert(value), reference.insert(value).second);
+        }
+    }
+
+    EXPECT_EQ(tree.size(), reference.size());
+    EXPECT_TRUE(std::ranges::equal(tree, reference));
+    EXPECT_LE(tree.height(), 1.45 * std::log2(reference.size() + 2));
+    EXPECT_GE(tree.capacity(), tree.size());
+    EXPECT_EQ(std::filesystem::file_size(file.path) % MAPPED_NODES_CHUNK, 0u);
+    EXPECT_GT(std::filesystem::file_size(file.path), MAPPED_NODES_CHUNK);
+}
+
+TEST(MmapAVLTree, ReopenKeepsContents) {
+    TreeFile file("mmap_avl_reopen.tree");
+    std::set<int64_t> reference;
+    {
+        MmapAVLTree<int64_t> tree(file.path);
+        for (int64_t i = 0; i < 100000; ++i) {
+            tree.insert(i * 7919 % 100003);
+            reference.insert(i * 7919 % 100003);
+        }
+        for (int64_t i = 0; i < 100000; i += 3) {
+            tree.remove(i);
+            reference.erase(i);
+        }
+        tree.sync();
+    }
+
+    MmapAVLTree<int64_t> tree(file.path);
+    EXPECT_EQ(tree.size(), reference.size());
+    EXPECT_TRUE(std::ranges::equal(tree, reference));
+    EXPECT_EQ(*tree.lower_bound(int64_t{3}), 4);
+
+    // changes after reopening go on where the file left off
+    EXPECT_TRUE(tree.insert(-1));
+    EXPECT_TRUE(tree.remove(int64_t{4}));
+    reference.insert(-1);
+    reference.erase(4);
+    EXPECT_TRUE(std::ranges::equal(tree, reference));
+}
+
+TEST(MmapAVLTree, ReadOnlySharing) {
+    TreeFile file("mmap_avl_shared.tree");
+    {
+        MmapAVLTree<int> tree(file.path);
+        tree.reserve(5000);
+        for (int i = 0; i < 5000; ++i)
+            tree.insert(2 * i);
+    }
+
+    const MmapAVLTree<int> first(file.path, true);
+    MmapAVLTree<int> second(file.path, true);
+    EXPECT_TRUE(second.readOnly());
+    EXPECT_TRUE(std::ranges::equal(first, second));
+    EXPECT_TRUE(second.contains(4000));
+    EXPECT_FALSE(second.contains(4001));
+
+    EXPECT_THROW(second.insert(1), std::logic_error);
+    EXPECT_THROW(second.remove(2), std::logic_error);
+    EXPECT_THROW(second.clear(), std::logic_error);
+    EXPECT_EQ(second.size(), 5000u);
+    second.sync();
+}
+
+TEST(MmapAVLTree, RejectsOtherFiles) {
+    TreeFile file("mmap_avl_reject.tree");
+    EXPECT_THROW(MmapAVLTree<int>(file.path, true), std::system_error);
+
+    { MmapAVLTree<int64_t> wider(file.path); }
+    EXPECT_THROW(MmapAVLTree<int>{file.path}, std::runtime_error);
+
+    {
+        std::ofstream out(file.path, std::ios::binary | std::ios::trunc);
+        out << std::string(100, 'x');
+    }
+    EXPECT_THROW(MmapAVLTree<int>{file.path}, std::runtime_error);
+
+    {
+        std::ofstream out(file.path, std::ios::binary | std::ios::trunc);
+        out << "short";
+    }
+    EXPECT_THROW(MmapAVLTree<int>(file.path, true), std::runtime_error);
+}
+
+TEST(MmapAVLTree, MoveKeepsFiles) {
+    TreeFile firstFile("mmap_avl_move_first.tree");
+    TreeFile secondFile("mmap_avl_move_second.tree");
+    MmapAVLTree<int> first(firstFile.path);
+    MmapAVLTree<int> second(secondFile.path);
+    for (int i = 0; i < 100; ++i) {
+        first.insert(i);
+        second.insert(-i);
+    }
+
+    MmapAVLTree<int> moved(std::move(first));
+    EXPECT_EQ(moved.size(), 100u);
+    EXPECT_TRUE(first.empty());
+    EXPECT_THROW(first.insert(1), std::logic_error);
+
+    // assigning closes the file of second instead of clearing it
+    second = std::move(moved);
+    EXPECT_EQ(*second.min(), 0);
+    MmapAVLTree<int> reopened(secondFile.path);
+    EXPECT_EQ(reopened.size(), 100u);
+    EXPECT_EQ(*reopened.min(), -99);
+}
+// NOLINTEND
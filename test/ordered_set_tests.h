@@ -0,0 +1,204 @@
+#pragma once
+// NOLINTBEGIN
+#include <algorithm>
+#include <functional>
+#include <gtest/gtest.h>
+#include <iterator>
+#include <random>
+#include <ranges>
+#include <set>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * Tests every ordered set with iterators, bounds and range scans has to
+ * pass. A test file instantiates them with a traits type that provides
+ *
+ *   template <typename T, typename Compare = std::less<T>> using Set;
+ *   template <typename T> using Small;  // few values per node, if it has
+ *                                       // nodes, so every split and merge
+ *                                       // path runs often
+ *   template <typename S> static bool isReset(const S &set);  // no memory
+ *
+ * and keeps only the tests specific to its container.
+ */
+template <typename Traits> class OrderedSetTest : public testing::Test {};
+
+TYPED_TEST_SUITE_P(OrderedSetTest);
+
+TYPED_TEST_P(OrderedSetTest, Initialization) {
+    typename TypeParam::template Set<int> set;
+
+    EXPECT_TRUE(set.empty());
+    EXPECT_EQ(set.size(), 0u);
+    EXPECT_TRUE(TypeParam::isReset(set));
+    EXPECT_EQ(set.min(), nullptr);
+    EXPECT_EQ(set.max(), nullptr);
+    EXPECT_EQ(set.begin(), set.end());
+    EXPECT_EQ(set.lower_bound(1), set.end());
+    EXPECT_FALSE(set.contains(1));
+    EXPECT_FALSE(set.remove(1));
+}
+
+TYPED_TEST_P(OrderedSetTest, InsertSearchRemove) {
+    typename TypeParam::template Set<int> set;
+
+    EXPECT_TRUE(set.insert(5));
+    EXPECT_TRUE(set.insert(3));
+    EXPECT_FALSE(set.insert(5));
+    ASSERT_NE(set.search(3), nullptr);
+    EXPECT_EQ(*set.search(3), 3);
+    EXPECT_EQ(set.search(4), nullptr);
+
+    EXPECT_TRUE(set.remove(3));
+    EXPECT_FALSE(set.remove(3));
+    EXPECT_EQ(set.size(), 1u);
+    EXPECT_TRUE(set.remove(5));
+    EXPECT_TRUE(set.empty());
+    EXPECT_TRUE(TypeParam::isReset(set));
+    EXPECT_EQ(set.max(), nullptr);
+}
+
+template <typename Traits, typename Set>
+void checkAgainstStdSet(int operations, int range) {
+    Set set;
+    std::set<int> reference;
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> dist(0, range);
+
+    for (int i = 0; i < operations; ++i) {
+        const int value = dist(gen);
+        if (i % 3 == 0) {
+            ASSERT_EQ(set.remove(value), reference.erase(value) == 1);
+        } else {
+            ASSERT_EQ(set.insert(value), reference.insert(value).second);
+        }
+    }
+
+    EXPECT_EQ(set.size(), reference.size());
+    EXPECT_TRUE(std::ranges::equal(set, reference));
+    EXPECT_EQ(*set.min(), *reference.begin());
+    EXPECT_EQ(*set.max(), *reference.rbegin());
+    for (int i = -1; i <= range + 1; ++i) {
+        ASSERT_EQ(set.contains(i), reference.count(i) == 1);
+        auto it = set.lower_bound(i);
+        auto expected = reference.lower_bound(i);
+        if (expected == reference.end()) {
+            ASSERT_EQ(it, set.end());
+        } else {
+            ASSERT_NE(it, set.end());
+            ASSERT_EQ(*it, *expected);
+        }
+    }
+
+    // Drain in random order, so every merge and rebalance path runs
+    std::vector<int> order(reference.begin(), reference.end());
+    std::shuffle(order.begin(), order.end(), gen);
+    for (size_t i = 0; i < order.size(); ++i) {
+        ASSERT_TRUE(set.remove(order[i]));
+        reference.erase(order[i]);
+        if (i % 1000 == 0) {
+            ASSERT_TRUE(std::ranges::equal(set, reference));
+        }
+    }
+    EXPECT_TRUE(set.empty());
+    EXPECT_TRUE(Traits::isReset(set));
+    EXPECT_EQ(set.begin(), set.end());
+}
+
+TYPED_TEST_P(OrderedSetTest, RandomizedAgainstStdSet) {
+    checkAgainstStdSet<TypeParam, typename TypeParam::template Set<int>>(
+        100000, 20000);
+}
+
+TYPED_TEST_P(OrderedSetTest, RandomizedSmallNodes) {
+    checkAgainstStdSet<TypeParam, typename TypeParam::template Small<int>>(
+        30000, 3000);
+}
+
+TYPED_TEST_P(OrderedSetTest, NonTrivialValues) {
+    typename TypeParam::template Small<std::string> set;
+    std::set<std::string> reference;
+
+    for (int i = 0; i < 2000; ++i) {
+        std::string value = std::to_string(i * 7919 % 2003);
+        EXPECT_EQ(set.insert(value), reference.insert(value).second);
+    }
+    for (int i = 0; i < 2000; i += 2) {
+        std::string value = std::to_string(i);
+        EXPECT_EQ(set.remove(value), reference.erase(value) == 1);
+    }
+
+    EXPECT_TRUE(std::ranges::equal(set, reference));
+}
+
+TYPED_TEST_P(OrderedSetTest, BoundsAndRanges) {
+    typename TypeParam::template Small<int> set;
+    for (int i = 0; i < 100; i += 3)
+        set.insert(i);
+
+    EXPECT_EQ(*set.lower_bound(-5), 0);
+    EXPECT_EQ(*set.lower_bound(10), 12);
+    EXPECT_EQ(*set.lower_bound(12), 12);
+    EXPECT_EQ(*set.upper_bound(12), 15);
+    EXPECT_EQ(set.lower_bound(100), set.end());
+
+    auto [first, last] = set.equal_range(12);
+    EXPECT_EQ(std::distance(first, last), 1);
+    auto [none, same] = set.equal_range(13);
+    EXPECT_EQ(none, same);
+
+    std::vector<int> visited;
+    set.forEachInRange(10, 30, [&](int value) { visited.push_back(value); });
+    EXPECT_EQ(visited, (std::vector<int>{12, 15, 18, 21, 24, 27}));
+
+    visited.clear();
+    set.forEachInRange(0, 100, [&](int value) {
+        visited.push_back(value);
+        return visited.size() < 3;
+    });
+    EXPECT_EQ(visited, (std::vector<int>{0, 3, 6}));
+}
+
+TYPED_TEST_P(OrderedSetTest, HeterogeneousLookup) {
+    typename TypeParam::template Set<std::string, std::less<>> set;
+    set.insert("apple");
+    set.insert("banana");
+
+    EXPECT_TRUE(set.contains(std::string_view("apple")));
+    ASSERT_NE(set.search(std::string_view("banana")), nullptr);
+    EXPECT_EQ(*set.lower_bound(std::string_view("b")), "banana");
+    EXPECT_TRUE(set.remove(std::string_view("apple")));
+    EXPECT_FALSE(set.remove(std::string_view("apple")));
+    EXPECT_EQ(set.size(), 1u);
+}
+
+TYPED_TEST_P(OrderedSetTest, MoveAndSwap) {
+    using Set = typename TypeParam::template Set<int>;
+    Set set;
+    for (int i = 0; i < 1000; ++i)
+        set.insert(i);
+
+    Set moved(std::move(set));
+    EXPECT_EQ(moved.size(), 1000u);
+    EXPECT_TRUE(set.empty());
+    EXPECT_EQ(set.begin(), set.end());
+
+    set.insert(-1);
+    swap(set, moved);
+    EXPECT_EQ(set.size(), 1000u);
+    EXPECT_EQ(*moved.min(), -1);
+
+    moved = std::move(set);
+    EXPECT_EQ(moved.size(), 1000u);
+    EXPECT_EQ(*moved.max(), 999);
+    EXPECT_TRUE(moved.insert(1000));
+}
+
+REGISTER_TYPED_TEST_SUITE_P(OrderedSetTest, Initialization, InsertSearchRemove,
+                            RandomizedAgainstStdSet, RandomizedSmallNodes,
+                            NonTrivialValues, BoundsAndRanges,
+                            HeterogeneousLookup, MoveAndSwap);
+// NOLINTEND
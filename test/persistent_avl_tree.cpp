@@ -0,0 +1,267 @@
+// NOLINTBEGIN
+#include "persistent_avl/persistent_avl_tree.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <gtest/gtest.h>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <set>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+TEST(PersistentAVLTree, Initialization) {
+    PersistentAVLTree<int> tree;
+
+    EXPECT_TRUE(tree.empty());
+    EXPECT_EQ(tree.size(), 0u);
+    EXPECT_EQ(tree.height(), 0);
+    EXPECT_EQ(tree.min(), nullptr);
+    EXPECT_EQ(tree.max(), nullptr);
+    EXPECT_EQ(tree.begin(), tree.end());
+    EXPECT_FALSE(tree.contains(1));
+    EXPECT_FALSE(tree.remove(1));
+}
+
+TEST(PersistentAVLTree, RandomizedAgainstStdSet) {
+    PersistentAVLTree<int> tree;
+    std::set<int> reference;
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> dist(0, 20000);
+
+    for (int i = 0; i < 100000; ++i) {
+        const int value = dist(gen);
+        if (i % 3 == 0) {
+            ASSERT_EQ(tree.remove(value), reference.erase(value) == 1);
+        } else {
+            ASSERT_EQ(tree.insert(value), reference.insert(value).second);
+        }
+    }
+
+    EXPECT_EQ(tree.size(), reference.size());
+    EXPECT_TRUE(std::ranges::equal(tree, reference));
+    EXPECT_TRUE(std::equal(reference.rbegin(), reference.rend(),
+                           std::make_reverse_iterator(tree.end())));
+    EXPECT_EQ(*tree.min(), *reference.begin());
+    EXPECT_EQ(*tree.max(), *reference.rbegin());
+    EXPECT_LE(tree.height(), 1.45 * std::log2(reference.size() + 2));
+
+    for (int value : reference) {
+        ASSERT_TRUE(tree.remove(value));
+    }
+    EXPECT_TRUE(tree.empty());
+    EXPECT_EQ(tree.height(), 0);
+}
+
+// Every snapshot has to keep the contents it was taken with, while the tree
+// and the snapshots around it keep changing
+TEST(PersistentAVLTree, SnapshotsAreIsolated) {
+    PersistentAVLTree<int> tree;
+    std::set<int> reference;
+    std::vector<PersistentAVLTree<int>> snapshots;
+    std::vector<std::set<int>> expected;
+    std::mt19937 gen(7);
+    std::uniform_int_distribution<int> dist(0, 2000);
+
+    for (int i = 0; i < 20000; ++i) {
+        const int value = dist(gen);
+        if (gen() % 3 == 0) {
+            ASSERT_EQ(tree.remove(value), reference.erase(value) == 1);
+        } else {
+            ASSERT_EQ(tree.insert(value), reference.insert(value).second);
+        }
+        if (i % 1000 == 0) {
+            snapshots.push_back(tree.snapshot());
+            expected.push_back(reference);
+        }
+    }
+
+    // Dropping some snapshots frees nodes the others may still share
+    for (size_t i = 0; i < snapshots.size(); i += 3) {
+        snapshots[i].clear();
+        expected[i].clear();
+    }
+    // Changing a snapshot leaves the tree alone
+    snapshots[1].insert(-1);
+    expected[1].insert(-1);
+    EXPECT_TRUE(snapshots[1].remove(*expected[1].rbegin()));
+    expected[1].erase(std::prev(expected[1].end()));
+
+    EXPECT_TRUE(std::ranges::equal(tree, reference));
+    for (size_t i = 0; i < snapshots.size(); ++i) {
+        EXPECT_EQ(snapshots[i].size(), expected[i].size());
+        EXPECT_TRUE(std::ranges::equal(snapshots[i], expected[i]));
+    }
+}
+
+TEST(PersistentAVLTree, CopyAndMove) {
+    PersistentAVLTree<std::string> tree;
+    for (int i = 0; i < 100; ++i)
+        tree.insert(std::to_string(i));
+
+    PersistentAVLTree<std::string> copy = tree;
+    EXPECT_EQ(copy.search("42"), tree.search("42"));
+    copy.remove("42");
+    EXPECT_TRUE(tree.contains("42"));
+    EXPECT_FALSE(copy.contains("42"));
+
+    PersistentAVLTree<std::string> moved = std::move(copy);
+    EXPECT_EQ(moved.size(), 99u);
+    EXPECT_TRUE(copy.empty());
+
+    moved = tree;
+    EXPECT_TRUE(std::ranges::equal(moved, tree));
+    tree.clear();
+    EXPECT_EQ(moved.size(), 100u);
+}
+
+TEST(PersistentAVLTree, RangeQueries) {
+    PersistentAVLTree<int> tree;
+    for (int i = 0; i < 100; i += 2)
+        tree.insert(i);
+
+    EXPECT_EQ(*tree.lower_bound(10), 10);
+    EXPECT_EQ(*tree.lower_bound(11), 12);
+    EXPECT_EQ(*tree.upper_bound(10), 12);
+    EXPECT_EQ(tree.lower_bound(99), tree.end());
+    EXPECT_EQ(*std::prev(tree.lower_bound(99)), 98);
+
+    auto [first, last] = tree.equal_range(20);
+    EXPECT_EQ(std::distance(first, last), 1);
+    auto [lo, hi] = tree.equal_range(21);
+    EXPECT_EQ(lo, hi);
+
+    std::vector<int> visited;
+    tree.forEachInRange(10, 20, [&](int value) { visited.push_back(value); });
+    EXPECT_EQ(visited, (std::vector<int>{10, 12, 14, 16, 18}));
+
+    visited.clear();
+    tree.forEachInRange(0, 100, [&](int value) {
+        visited.push_back(value);
+        return visited.size() < 3;
+    });
+    EXPECT_EQ(visited, (std::vector<int>{0, 2, 4}));
+}
+
+TEST(PersistentAVLTree, HeterogeneousLookup) {
+    PersistentAVLTree<std::string, std::less<>> tree;
+    tree.insert("apple");
+    tree.insert("banana");
+
+    EXPECT_TRUE(tree.contains(std::string_view("apple")));
+    ASSERT_NE(tree.search(std::string_view("banana")), nullptr);
+    EXPECT_EQ(*tree.lower_bound(std::string_view("b")), "banana");
+    EXPECT_TRUE(tree.remove(std::string_view("apple")));
+    EXPECT_EQ(tree.size(), 1u);
+}
+
+// Without snapshots every node is owned and changed in place, values are
+// only copied onto the paths a snapshot shares
+TEST(PersistentAVLTree, CopiesOnlySharedPaths) {
+    PersistentAVLTree<std::shared_ptr<int>> tree;
+    std::vector<std::shared_ptr<int>> values;
+    for (int i = 0; i < 1000; ++i) {
+        values.push_back(std::make_shared<int>(i));
+        tree.insert(values.back());
+    }
+    for (int i = 0; i < 1000; i += 2)
+        tree.remove(values[i]);
+    for (const auto &value : values)
+        ASSERT_LE(value.use_count(), 2);
+
+    PersistentAVLTree<std::shared_ptr<int>> snapshot = tree.snapshot();
+    tree.insert(values[0]);
+    long copies = 0;
+    for (const auto &value : values)
+        copies += std::max(0L, value.use_count() - 2);
+    EXPECT_GT(copies, 0);
+    EXPECT_LE(copies, tree.height() + 1);
+
+    snapshot.clear();
+    tree.remove(values[0]);
+    tree.insert(values[0]);
+    EXPECT_EQ(values[0].use_count(), 2);
+}
+
+// A duplicate insert or a missing remove ends in the one descent and leaves
+// the shared nodes alone
+TEST(PersistentAVLTree, FailedChangesCopyNothing) {
+    PersistentAVLTree<std::shared_ptr<int>> tree;
+    std::vector<std::shared_ptr<int>> values;
+    for (int i = 0; i < 1000; ++i) {
+        values.push_back(std::make_shared<int>(i));
+        tree.insert(values.back());
+    }
+    PersistentAVLTree<std::shared_ptr<int>> snapshot = tree.snapshot();
+
+    EXPECT_FALSE(tree.insert(values[500]));
+    EXPECT_FALSE(tree.remove(std::make_shared<int>(-1)));
+    for (const auto &value : values)
+        ASSERT_EQ(value.use_count(), 2);
+    EXPECT_EQ(tree.size(), 1000u);
+
+    EXPECT_TRUE(tree.remove(values[500]));
+    EXPECT_FALSE(tree.contains(values[500]));
+    EXPECT_TRUE(snapshot.contains(values[500]));
+}
+
+// Readers iterate their own snapshot without locks while the writer changes
+// the tree and publishes new snapshots
+TEST(PersistentAVLTree, ReadersOnSnapshots) {
+    PersistentAVLTree<int> tree;
+    for (int i = 0; i < 1000; ++i)
+        tree.insert(2 * i);
+
+    std::atomic<bool> done{false};
+    std::atomic<int> errors{0};
+    // only the handoff of a new snapshot takes a lock, reading it does not
+    std::mutex publishLock;
+    PersistentAVLTree<int> published = tree.snapshot();
+
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t) {
+        readers.emplace_back([&] {
+            while (!done.load()) {
+                PersistentAVLTree<int> snapshot;
+                {
+                    std::lock_guard<std::mutex> lock(publishLock);
+                    snapshot = published;
+                }
+                size_t seen = 0;
+                int last = -1;
+                for (int value : snapshot) {
+                    if (value <= last)
+                        errors.fetch_add(1);
+                    last = value;
+                    ++seen;
+                }
+                if (seen != snapshot.size() || !snapshot.contains(0))
+                    errors.fetch_add(1);
+            }
+        });
+    }
+
+    std::mt19937 gen(3);
+    for (int round = 0; round < 200; ++round) {
+        for (int i = 0; i < 50; ++i) {
+            const int value = 2 * static_cast<int>(gen() % 1000) + 1;
+            if (gen() % 2 == 0)
+                tree.insert(value);
+            else
+                tree.remove(value);
+        }
+        PersistentAVLTree<int> snapshot = tree.snapshot();
+        std::lock_guard<std::mutex> lock(publishLock);
+        published.swap(snapshot);
+    }
+    done.store(true);
+    for (auto &reader : readers)
+        reader.join();
+
+    EXPECT_EQ(errors.load(), 0);
+}
+// NOLINTEND
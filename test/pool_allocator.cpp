@@ -0,0 +1,77 @@
+// NOLINTBEGIN
+#include "allocator/pool_allocator.h"
+#include <gtest/gtest.h>
+#include <set>
+
+TEST(PoolAllocator, FreedBlocksAreReused) {
+    PoolAllocator<long> allocator;
+
+    long *first = allocator.allocate(1);
+    allocator.deallocate(first, 1);
+    long *second = allocator.allocate(1);
+
+    EXPECT_EQ(first, second);
+    allocator.deallocate(second, 1);
+}
+
+TEST(PoolAllocator, DistinctLiveBlocks) {
+    PoolAllocator<int> allocator;
+    std::set<int *> blocks;
+
+    for (int i = 0; i < 10000; ++i) {
+        int *block = allocator.allocate(1);
+        *block = i;
+        EXPECT_TRUE(blocks.insert(block).second);
+    }
+
+    for (int *block : blocks) {
+        EXPECT_GE(*block, 0);
+        allocator.deallocate(block, 1);
+    }
+}
+
+TEST(PoolAllocator, OversizedBlocks) {
+    PoolAllocator<char> allocator;
+
+    char *large = allocator.allocate(1 << 16);
+    large[0] = 'a';
+    large[(1 << 16) - 1] = 'b';
+    allocator.deallocate(large, 1 << 16);
+
+    // Oversized blocks are still released together with the arena
+    (void)allocator.allocate(1 << 16);
+    allocator.release();
+}
+
+TEST(PoolAllocator, RebindSharesArena) {
+    PoolAllocator<int> allocator;
+    PoolAllocator<double> rebound(allocator);
+    PoolAllocator<int> back(rebound);
+
+    EXPECT_TRUE(allocator == back);
+    EXPECT_FALSE(allocator == PoolAllocator<int>());
+}
+
+TEST(PoolAllocator, ReleaseAllowsReuse) {
+    PoolAllocator<int> allocator;
+
+    for (int i = 0; i < 1000; ++i) {
+        (void)allocator.allocate(1);
+    }
+    allocator.release();
+
+    int *block = allocator.allocate(1);
+    *block = 42;
+    EXPECT_EQ(*block, 42);
+}
+
+TEST(PoolAllocator, HugePages) {
+    PoolAllocator<int, true> allocator;
+
+    int *block = allocator.allocate(1);
+    *block = 7;
+    EXPECT_EQ(*block, 7);
+    allocator.deallocate(block, 1);
+    allocator.release();
+}
+// NOLINTEND
@@ -1,150 +1,709 @@
-// // NOLINTBEGIN
-// #include "skiplist/skiplist.h"
-// #include <gtest/gtest.h>
-//
-// TEST(SkipList, Initialization) {
-//     SkipList<int> list;
-//
-//     EXPECT_TRUE(list.empty());
-//     EXPECT_EQ(list.size(), 0u);
-//     EXPECT_EQ(list.min(), nullptr);
-//     EXPECT_EQ(list.max(), nullptr);
-// }
-//
-// TEST(SkipList, SimpleInsertion) {
-//     SkipList<int> list;
-//
-//     EXPECT_TRUE(list.insert(1));
-//     ASSERT_NE(list.search(1), nullptr);
-//     EXPECT_EQ(*list.search(1), 1);
-// }
-//
-// TEST(SkipList, DuplicateKeyInsertion) {
-//     SkipList<int> list;
-//
-//     list.insert(1);
-//     EXPECT_FALSE(list.insert(1));
-//     ASSERT_NE(list.search(1), nullptr);
-//     EXPECT_EQ(*list.search(1), 1);
-//     EXPECT_EQ(list.size(), 1u);
-// }
-//
-// TEST(SkipList, EmptyRemoval) {
-//     SkipList<int> list;
-//     EXPECT_FALSE(list.remove(1));
-// }
-//
-// TEST(SkipList, NonExistentRemoval) {
-//     SkipList<int> list;
-//     list.insert(1);
-//     EXPECT_FALSE(list.remove(2));
-// }
-//
-// TEST(SkipList, OnlyNodeRemoval) {
-//     SkipList<int> list;
-//     list.insert(1);
-//     EXPECT_TRUE(list.remove(1));
-//     EXPECT_EQ(list.size(), 0u);
-//     EXPECT_TRUE(list.empty());
-// }
-//
-// TEST(SkipList, Clear) {
-//     SkipList<int> list;
-//     list.insert(1);
-//     list.insert(2);
-//     list.clear();
-//
-//     EXPECT_EQ(list.size(), 0);
-//     EXPECT_TRUE(list.empty());
-// }
-//
-// TEST(SkipList, Search) {
-//     SkipList<int> list;
-//     list.insert(1);
-//     list.insert(2);
-//     list.insert(3);
-//
-//     EXPECT_EQ(*list.search(1), 1);
-//     EXPECT_EQ(*list.search(2), 2);
-//     EXPECT_EQ(*list.search(3), 3);
-//     list.remove(2);
-//     EXPECT_EQ(list.search(2), nullptr);
-// }
-//
-// // TEST(SkipList, Iteration) {
-// //     SkipList<int> list;
-// //     list.insert(3);
-// //     list.insert(2);
-// //     list.insert(1);
-// //
-// //     auto it = list.begin();
-// //     EXPECT_EQ(*it++, 1);
-// //     EXPECT_EQ(*it++, 2);
-// //     EXPECT_EQ(*it++, 3);
-// //     EXPECT_EQ(it, list.end());
-// // }
-//
-// TEST(SkipList, MinMaxEmptyList) {
-//     SkipList<int> list;
-//
-//     EXPECT_EQ(list.min(), nullptr);
-//     EXPECT_EQ(list.max(), nullptr);
-// }
-//
-// TEST(SkipList, MinMaxSingleElement) {
-//     SkipList<int> list;
-//     list.insert(42);
-//
-//     ASSERT_NE(list.min(), nullptr);
-//     ASSERT_NE(list.max(), nullptr);
-//     EXPECT_EQ(*list.min(), 42);
-//     EXPECT_EQ(*list.max(), 42);
-// }
-//
-// TEST(SkipList, MinMaxMultipleElements) {
-//     SkipList<int> list;
-//     list.insert(10);
-//     list.insert(20);
-//     list.insert(5);
-//     list.insert(15);
-//
-//     ASSERT_NE(list.min(), nullptr);
-//     ASSERT_NE(list.max(), nullptr);
-//     EXPECT_EQ(*list.min(), 5);
-//     EXPECT_EQ(*list.max(), 20);
-// }
-//
-// TEST(SkipList, ContainsFunctionality) {
-//     SkipList<int> list;
-//     list.insert(7);
-//     list.insert(3);
-//     list.insert(9);
-//
-//     EXPECT_TRUE(list.contains(3));
-//     EXPECT_TRUE(list.contains(7));
-//     EXPECT_TRUE(list.contains(9));
-//     EXPECT_FALSE(list.contains(4));
-//     EXPECT_FALSE(list.contains(10));
-// }
-//
-// TEST(SkipList, SizeAndEmpty) {
-//     SkipList<int> list;
-//
-//     EXPECT_TRUE(list.empty());
-//     EXPECT_EQ(list.size(), 0u);
-//
-//     list.insert(1);
-//     EXPECT_FALSE(list.empty());
-//     EXPECT_EQ(list.size(), 1u);
-//
-//     list.insert(2);
-//     list.insert(3);
-//     EXPECT_EQ(list.size(), 3u);
-//
-//     list.remove(2);
-//     EXPECT_TRUE(list.contains(1));
-//     EXPECT_TRUE(list.contains(3));
-//     EXPECT_EQ(list.size(), 2u);
-// }
-//
-// // NOLINTEND
+// NOLINTBEGIN
+#include "skiplist/skiplist.h"
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <gtest/gtest.h>
+#include <iterator>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <ranges>
+#include <set>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+TEST(SkipList, Initialization) {
+    SkipList<int> list;
+
+    EXPECT_TRUE(list.empty());
+    EXPECT_EQ(list.size(), 0u);
+    EXPECT_EQ(list.min(), nullptr);
+    EXPECT_EQ(list.max(), nullptr);
+}
+
+TEST(SkipList, SimpleInsertion) {
+    SkipList<int> list;
+
+    EXPECT_TRUE(list.insert(1));
+    ASSERT_NE(list.search(1), nullptr);
+    EXPECT_EQ(*list.search(1), 1);
+}
+
+TEST(SkipList, DuplicateKeyInsertion) {
+    SkipList<int> list;
+
+    list.insert(1);
+    EXPECT_FALSE(list.insert(1));
+    ASSERT_NE(list.search(1), nullptr);
+    EXPECT_EQ(*list.search(1), 1);
+    EXPECT_EQ(list.size(), 1u);
+}
+
+TEST(SkipList, EmptyRemoval) {
+    SkipList<int> list;
+    EXPECT_FALSE(list.remove(1));
+}
+
+TEST(SkipList, NonExistentRemoval) {
+    SkipList<int> list;
+    list.insert(1);
+    EXPECT_FALSE(list.remove(2));
+}
+
+TEST(SkipList, OnlyNodeRemoval) {
+    SkipList<int> list;
+    list.insert(1);
+    EXPECT_TRUE(list.remove(1));
+    EXPECT_EQ(list.size(), 0u);
+    EXPECT_TRUE(list.empty());
+}
+
+TEST(SkipList, Clear) {
+    SkipList<int> list;
+    list.insert(1);
+    list.insert(2);
+    list.clear();
+
+    EXPECT_EQ(list.size(), 0);
+    EXPECT_TRUE(list.empty());
+}
+
+TEST(SkipList, Search) {
+    SkipList<int> list;
+    list.insert(1);
+    list.insert(2);
+    list.insert(3);
+
+    EXPECT_EQ(*list.search(1), 1);
+    EXPECT_EQ(*list.search(2), 2);
+    EXPECT_EQ(*list.search(3), 3);
+    list.remove(2);
+    EXPECT_EQ(list.search(2), nullptr);
+}
+
+TEST(SkipList, Iteration) {
+    SkipList<int> list;
+    list.insert(3);
+    list.insert(2);
+    list.insert(1);
+
+    auto it = list.begin();
+    EXPECT_EQ(*it++, 1);
+    EXPECT_EQ(*it++, 2);
+    EXPECT_EQ(*it++, 3);
+    EXPECT_EQ(it, list.end());
+}
+
+TEST(SkipList, MinMaxEmptyList) {
+    SkipList<int> list;
+
+    EXPECT_EQ(list.min(), nullptr);
+    EXPECT_EQ(list.max(), nullptr);
+}
+
+TEST(SkipList, MinMaxSingleElement) {
+    SkipList<int> list;
+    list.insert(42);
+
+    ASSERT_NE(list.min(), nullptr);
+    ASSERT_NE(list.max(), nullptr);
+    EXPECT_EQ(*list.min(), 42);
+    EXPECT_EQ(*list.max(), 42);
+}
+
+TEST(SkipList, MinMaxMultipleElements) {
+    SkipList<int> list;
+    list.insert(10);
+    list.insert(20);
+    list.insert(5);
+    list.insert(15);
+
+    ASSERT_NE(list.min(), nullptr);
+    ASSERT_NE(list.max(), nullptr);
+    EXPECT_EQ(*list.min(), 5);
+    EXPECT_EQ(*list.max(), 20);
+}
+
+TEST(SkipList, ContainsFunctionality) {
+    SkipList<int> list;
+    list.insert(7);
+    list.insert(3);
+    list.insert(9);
+
+    EXPECT_TRUE(list.contains(3));
+    EXPECT_TRUE(list.contains(7));
+    EXPECT_TRUE(list.contains(9));
+    EXPECT_FALSE(list.contains(4));
+    EXPECT_FALSE(list.contains(10));
+}
+
+TEST(SkipList, SizeAndEmpty) {
+    SkipList<int> list;
+
+    EXPECT_TRUE(list.empty());
+    EXPECT_EQ(list.size(), 0u);
+
+    list.insert(1);
+    EXPECT_FALSE(list.empty());
+    EXPECT_EQ(list.size(), 1u);
+
+    list.insert(2);
+    list.insert(3);
+    EXPECT_EQ(list.size(), 3u);
+
+    list.remove(2);
+    EXPECT_TRUE(list.contains(1));
+    EXPECT_TRUE(list.contains(3));
+    EXPECT_EQ(list.size(), 2u);
+}
+
+TEST(SkipList, HeterogeneousLookup) {
+    SkipList<std::string, std::less<>> list;
+    list.insert("apple");
+    list.insert("banana");
+    list.insert("cherry");
+
+    std::string_view key = "banana";
+    ASSERT_NE(list.search(key), nullptr);
+    EXPECT_EQ(*list.search(key), "banana");
+    EXPECT_TRUE(list.contains("cherry"));
+    EXPECT_FALSE(list.contains(std::string_view("durian")));
+
+    EXPECT_TRUE(list.remove(key));
+    EXPECT_FALSE(list.remove("banana"));
+    EXPECT_EQ(list.size(), 2u);
+}
+
+TEST(SkipList, RandomizedAgainstStdSet) {
+    SkipList<int> list;
+    std::set<int> reference;
+    std::mt19937 gen(3);
+    std::uniform_int_distribution<int> dist(0, 1000);
+
+    for (int i = 0; i < 10000; ++i) {
+        const int value = dist(gen);
+        if (i % 3 == 0) {
+            EXPECT_EQ(list.remove(value), reference.erase(value) == 1);
+        } else {
+            EXPECT_EQ(list.insert(value), reference.insert(value).second);
+        }
+    }
+
+    EXPECT_EQ(list.size(), reference.size());
+    EXPECT_EQ(*list.min(), *reference.begin());
+    EXPECT_EQ(*list.max(), *reference.rbegin());
+    for (int i = 0; i <= 1000; ++i) {
+        EXPECT_EQ(list.contains(i), reference.count(i) == 1);
+    }
+    EXPECT_TRUE(std::ranges::equal(list, reference));
+}
+
+TEST(SkipList, MoveOnlyValues) {
+    SkipList<std::unique_ptr<int>> list;
+
+    EXPECT_TRUE(list.insert(std::make_unique<int>(1)));
+    EXPECT_TRUE(list.emplace(new int(2)));
+    EXPECT_EQ(list.size(), 2u);
+}
+
+TEST(SkipList, EmplaceDuplicate) {
+    SkipList<std::string> list;
+
+    EXPECT_TRUE(list.emplace(3, 'a'));
+    EXPECT_FALSE(list.emplace("aaa"));
+    EXPECT_EQ(list.size(), 1u);
+    EXPECT_EQ(*list.min(), "aaa");
+}
+
+TEST(SkipList, MoveAndSwap) {
+    SkipList<int> list;
+    for (int i = 0; i < 100; ++i)
+        list.insert(i);
+
+    SkipList<int> moved(std::move(list));
+    EXPECT_EQ(moved.size(), 100u);
+    EXPECT_TRUE(list.empty());
+    EXPECT_EQ(list.min(), nullptr);
+
+    // the moved-from list stays usable
+    list.insert(500);
+    EXPECT_TRUE(list.contains(500));
+
+    SkipList<int> assigned;
+    assigned.insert(-1);
+    assigned = std::move(moved);
+    EXPECT_EQ(assigned.size(), 100u);
+    EXPECT_FALSE(assigned.contains(-1));
+    EXPECT_EQ(*assigned.max(), 99);
+
+    swap(assigned, list);
+    EXPECT_EQ(list.size(), 100u);
+    EXPECT_EQ(assigned.size(), 1u);
+    EXPECT_TRUE(assigned.contains(500));
+}
+
+// values with a stricter alignment than the forward pointers behind them
+struct alignas(64) WideValue {
+    int key;
+
+    explicit WideValue(int key) : key(key) {
+        if (key < 0) {
+            throw std::invalid_argument("negative key");
+        }
+    }
+    bool operator<(const WideValue &other) const { return key < other.key; }
+};
+
+TEST(SkipList, InlineTowers) {
+    SkipList<WideValue> list(100);
+    for (int i = 0; i < 10000; ++i) {
+        EXPECT_TRUE(list.emplace((i * 7919) % 10000));
+    }
+    EXPECT_FALSE(list.emplace(5));
+    EXPECT_THROW(list.emplace(-1), std::invalid_argument);
+    EXPECT_EQ(list.size(), 10000u);
+
+    int expected = 0;
+    for (const WideValue &value : list) {
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(&value) % 64, 0u);
+        EXPECT_EQ(value.key, expected++);
+    }
+    for (int i = 0; i < 10000; i += 2) {
+        EXPECT_TRUE(list.remove(WideValue(i)));
+    }
+    EXPECT_EQ(list.size(), 5000u);
+    EXPECT_EQ(list.min()->key, 1);
+    EXPECT_EQ(list.max()->key, 9999);
+}
+
+struct CountingLess {
+    static inline size_t comparisons = 0;
+
+    bool operator()(int lhs, int rhs) const {
+        ++comparisons;
+        return lhs < rhs;
+    }
+};
+
+TEST(SkipList, AppendsUseFingers) {
+    SkipList<int, CountingLess> list;
+    const int count = 10000;
+
+    CountingLess::comparisons = 0;
+    for (int i = 0; i < count; ++i)
+        list.insert(i);
+    for (int i = -1; i >= -count; --i)
+        list.insert(i);
+
+    EXPECT_LE(CountingLess::comparisons, static_cast<size_t>(3 * count));
+    EXPECT_EQ(list.size(), static_cast<size_t>(2 * count));
+    EXPECT_EQ(*list.min(), -count);
+    EXPECT_EQ(*list.max(), count - 1);
+    EXPECT_TRUE(std::ranges::is_sorted(list));
+
+    // the express lanes are still intact for regular lookups
+    for (int i = -count; i < count; i += 97)
+        EXPECT_TRUE(list.contains(i));
+}
+
+TEST(SkipList, FingersFollowRemoval) {
+    SkipList<int> list;
+    for (int i = 0; i < 100; ++i)
+        list.insert(i);
+
+    for (int i = 99; i >= 50; --i) {
+        EXPECT_TRUE(list.remove(i));
+        EXPECT_EQ(*list.max(), i - 1);
+    }
+    EXPECT_TRUE(list.insert(1000));
+    EXPECT_TRUE(list.insert(60));
+    EXPECT_EQ(*list.max(), 1000);
+
+    list.clear();
+    EXPECT_EQ(list.max(), nullptr);
+    EXPECT_TRUE(list.insert(5));
+    EXPECT_EQ(*list.max(), 5);
+}
+
+TEST(SkipList, BoundsAgainstStdSet) {
+    SkipList<int> container;
+    std::set<int> reference;
+    std::mt19937 gen(11);
+    std::uniform_int_distribution<int> dist(0, 3000);
+
+    for (int i = 0; i < 1000; ++i) {
+        const int value = dist(gen);
+        container.insert(value);
+        reference.insert(value);
+    }
+
+    for (int i = -1; i <= 3001; ++i) {
+        auto lower = container.lower_bound(i);
+        auto upper = container.upper_bound(i);
+        auto expectedLower = reference.lower_bound(i);
+        auto expectedUpper = reference.upper_bound(i);
+
+        ASSERT_EQ(lower == container.end(), expectedLower == reference.end());
+        if (lower != container.end()) {
+            EXPECT_EQ(*lower, *expectedLower);
+        }
+        ASSERT_EQ(upper == container.end(), expectedUpper == reference.end());
+        if (upper != container.end()) {
+            EXPECT_EQ(*upper, *expectedUpper);
+        }
+
+        auto [first, last] = container.equal_range(i);
+        EXPECT_EQ(std::distance(first, last),
+                  static_cast<std::ptrdiff_t>(reference.count(i)));
+    }
+}
+
+TEST(SkipList, ForEachInRange) {
+    SkipList<int> container;
+    for (int i = 0; i < 100; i += 3)
+        container.insert(i);
+
+    std::vector<int> visited;
+    container.forEachInRange(10, 30, [&](int value) {
+        visited.push_back(value);
+    });
+    EXPECT_EQ(visited, (std::vector<int>{12, 15, 18, 21, 24, 27}));
+
+    // hi is exclusive, an empty or inverted range visits nothing
+    visited.clear();
+    container.forEachInRange(12, 12, [&](int value) {
+        visited.push_back(value);
+    });
+    container.forEachInRange(50, 10, [&](int value) {
+        visited.push_back(value);
+    });
+    EXPECT_TRUE(visited.empty());
+
+    // returning false stops the scan
+    container.forEachInRange(0, 100, [&](int value) {
+        visited.push_back(value);
+        return visited.size() < 4;
+    });
+    EXPECT_EQ(visited, (std::vector<int>{0, 3, 6, 9}));
+}
+
+TEST(SkipList, HeterogeneousRangeQueries) {
+    SkipList<std::string, std::less<>> container;
+    for (const char *word : {"apple", "banana", "cherry", "date"})
+        container.insert(word);
+
+    EXPECT_EQ(*container.lower_bound(std::string_view("b")), "banana");
+    EXPECT_EQ(*container.upper_bound(std::string_view("banana")), "cherry");
+
+    std::vector<std::string> visited;
+    container.forEachInRange(std::string_view("b"), std::string_view("d"),
+                             [&](const std::string &value) {
+                                 visited.push_back(value);
+                             });
+    EXPECT_EQ(visited, (std::vector<std::string>{"banana", "cherry"}));
+}
+
+TEST(SkipList, BatchInsertAndRemove) {
+    SkipList<int> list;
+    std::set<int> reference;
+    std::mt19937 gen(11);
+
+    for (int round = 0; round < 6; ++round) {
+        std::uniform_int_distribution<int> dist(0, 50000);
+        std::vector<int> batch(10000);
+        for (int &value : batch)
+            value = dist(gen);
+
+        size_t expected = 0;
+        if (round % 3 == 2) {
+            for (int value : batch)
+                expected += reference.erase(value);
+            EXPECT_EQ(list.removeBatch(batch), expected);
+        } else {
+            for (int value : batch)
+                expected += reference.insert(value).second ? 1 : 0;
+            EXPECT_EQ(list.insertBatch(batch), expected);
+        }
+
+        ASSERT_EQ(list.size(), reference.size());
+        ASSERT_TRUE(std::ranges::equal(list, reference));
+        EXPECT_EQ(*list.min(), *reference.begin());
+        EXPECT_EQ(*list.max(), *reference.rbegin());
+    }
+
+    // the tails stay right for the appends of a plain insert
+    EXPECT_EQ(list.insertBatch(std::vector<int>{-5, 60000, -5}), 2u);
+    EXPECT_EQ(*list.max(), 60000);
+    EXPECT_TRUE(list.insert(60001));
+    EXPECT_EQ(*list.max(), 60001);
+    EXPECT_EQ(list.removeBatch(std::vector<int>{60000, 60001}), 2u);
+    EXPECT_EQ(*list.max(), *reference.rbegin());
+    EXPECT_TRUE(list.contains(-5));
+
+    const size_t remaining = list.size();
+    EXPECT_EQ(list.removeBatch(std::views::iota(-10, 50001)), remaining);
+    EXPECT_TRUE(list.empty());
+    EXPECT_EQ(list.max(), nullptr);
+    EXPECT_TRUE(list.insert(1));
+    EXPECT_EQ(*list.min(), 1);
+}
+
+TEST(SkipList, OrderStatistics) {
+    SkipList<int> list;
+    for (int i = 99; i >= 0; --i)
+        list.insert(i * 2);
+
+    for (size_t k = 0; k < 100; ++k) {
+        ASSERT_NE(list.select(k), nullptr);
+        EXPECT_EQ(*list.select(k), static_cast<int>(k) * 2);
+        EXPECT_EQ(list.rank(static_cast<int>(k) * 2), k);
+        EXPECT_EQ(list.rank(static_cast<int>(k) * 2 + 1), k + 1);
+    }
+    EXPECT_EQ(list.select(100), nullptr);
+    EXPECT_EQ(list.rank(-1), 0u);
+    EXPECT_EQ(list.rank(1000), 100u);
+
+    SkipList<int> empty;
+    EXPECT_EQ(empty.select(0), nullptr);
+    EXPECT_EQ(empty.rank(0), 0u);
+    EXPECT_TRUE(empty.slice(0, 10).empty());
+}
+
+// every way of linking and unlinking nodes has to keep the widths right
+TEST(SkipList, OrderStatisticsAgainstStdSet) {
+    SkipList<int> list;
+    std::set<int> reference;
+    std::mt19937 gen(5);
+    std::uniform_int_distribution<int> dist(0, 5000);
+
+    const auto check = [&] {
+        ASSERT_EQ(list.size(), reference.size());
+        size_t k = 0;
+        for (int value : reference) {
+            ASSERT_EQ(*list.select(k), value);
+            ASSERT_EQ(list.rank(value), k);
+            ASSERT_EQ(list.rank(value + 1), k + 1);
+            ++k;
+        }
+        ASSERT_EQ(list.select(k), nullptr);
+    };
+
+    for (int round = 0; round < 8; ++round) {
+        for (int i = 0; i < 2000; ++i) {
+            const int value = dist(gen);
+            switch (gen() % 4) {
+            case 0:
+                ASSERT_EQ(list.remove(value), reference.erase(value) == 1);
+                break;
+            case 1:
+                ASSERT_EQ(list.emplace(value), reference.insert(value).second);
+                break;
+            default:
+                ASSERT_EQ(list.insert(value), reference.insert(value).second);
+            }
+        }
+        check();
+
+        std::vector<int> batch(500);
+        for (int &value : batch)
+            value = dist(gen);
+        if (round % 2 == 0) {
+            list.insertBatch(batch);
+            reference.insert(batch.begin(), batch.end());
+        } else {
+            list.removeBatch(batch);
+            for (int value : batch)
+                reference.erase(value);
+        }
+        check();
+    }
+
+    // appends at either end take the fast path past the express lanes
+    for (int i = 1; i <= 100; ++i) {
+        list.insert(-i);
+        list.insert(5000 + i);
+        reference.insert(-i);
+        reference.insert(5000 + i);
+    }
+    check();
+
+    SkipList<int> moved(std::move(list));
+    list = std::move(moved);
+    check();
+    list.clear();
+    reference.clear();
+    list.insert(3);
+    reference.insert(3);
+    check();
+}
+
+TEST(SkipList, Slice) {
+    SkipList<int> list;
+    for (int i = 0; i < 1000; ++i)
+        list.insert(i * 10);
+
+    std::vector<int> expected;
+    for (int i = 100; i < 150; ++i)
+        expected.push_back(i * 10);
+    EXPECT_TRUE(std::ranges::equal(list.slice(100, 50), expected));
+
+    // slices are cut off at the end of the list
+    EXPECT_TRUE(std::ranges::equal(list.slice(998, 10),
+                                   std::vector<int>{9980, 9990}));
+    EXPECT_TRUE(std::ranges::equal(list.slice(0, 1), std::vector<int>{0}));
+    EXPECT_TRUE(list.slice(1000, 5).empty());
+    EXPECT_TRUE(list.slice(10, 0).empty());
+    EXPECT_EQ(std::ranges::distance(list.slice(0, SIZE_MAX)), 1000);
+}
+
+TEST(SkipList, ContainsMany) {
+    SkipList<int> list;
+    std::vector<int> keys(1000);
+    std::iota(keys.begin(), keys.end(), -500);
+    std::vector<int *> results(keys.size());
+    auto found = std::make_unique<bool[]>(keys.size());
+    std::span<bool> flags(found.get(), keys.size());
+    std::ranges::fill(flags, true);
+
+    // an empty container finds nothing
+    EXPECT_EQ(list.containsMany(keys, flags), 0u);
+    EXPECT_TRUE(std::ranges::none_of(flags, std::identity{}));
+
+    // large enough for the interleaved searches, with a key count that is
+    // not a multiple of the group size
+    std::mt19937 gen(5);
+    std::uniform_int_distribution<int> dist(0, 2 * 200000);
+    std::vector<int> values(200000);
+    for (int &value : values)
+        value = dist(gen);
+    list.insertBatch(values);
+    keys.resize(10007);
+    for (int &key : keys)
+        key = dist(gen);
+    results.assign(keys.size(), nullptr);
+    found = std::make_unique<bool[]>(keys.size());
+    flags = std::span<bool>(found.get(), keys.size());
+
+    size_t expected = 0;
+    for (int key : keys)
+        expected += list.contains(key) ? 1 : 0;
+    EXPECT_EQ(list.containsMany(keys, flags), expected);
+    list.searchMany(keys, results);
+    for (size_t i = 0; i < keys.size(); ++i) {
+        ASSERT_EQ(flags[i], list.contains(keys[i]));
+        ASSERT_EQ(results[i], list.search(keys[i]));
+    }
+}
+
+TEST(SkipList, SnapshotRoundTrip) {
+    const std::filesystem::path path =
+        std::filesystem::temp_directory_path() / "skiplist_snapshot.bin";
+    SkipList<int> list;
+    std::set<int> reference;
+    std::mt19937 gen(9);
+    std::uniform_int_distribution<int> dist(-100000, 100000);
+    for (int i = 0; i < 50000; ++i) {
+        const int value = dist(gen);
+        list.insert(value);
+        reference.insert(value);
+    }
+    list.save(path);
+
+    SkipList<int> loaded;
+    loaded.insert(7);
+    loaded.load(path);
+    EXPECT_EQ(loaded.size(), reference.size());
+    EXPECT_TRUE(std::ranges::equal(loaded, reference));
+    EXPECT_TRUE(loaded.insert(200001));
+    EXPECT_TRUE(loaded.remove(*reference.begin()));
+
+    // an empty snapshot empties the target
+    SkipList<int> empty;
+    empty.save(path);
+    loaded.load(path);
+    EXPECT_TRUE(loaded.empty());
+    EXPECT_EQ(loaded.begin(), loaded.end());
+
+    // a file written with another order still loads
+    SkipList<int, std::greater<int>> descending;
+    for (int value : reference)
+        descending.insert(value);
+    descending.save(path);
+    loaded.load(path);
+    EXPECT_TRUE(std::ranges::equal(loaded, reference));
+
+    std::filesystem::remove(path);
+}
+
+TEST(SkipList, SnapshotRejectsDamagedFiles) {
+    const std::filesystem::path path =
+        std::filesystem::temp_directory_path() / "skiplist_damaged.bin";
+    SkipList<int> list;
+    for (int i = 0; i < 1000; ++i)
+        list.insert(i);
+    list.save(path);
+
+    SkipList<int> loaded;
+    loaded.insert(-1);
+    {
+        std::fstream file(path, std::ios::in | std::ios::out |
+                                    std::ios::binary);
+        file.seekp(100);
+        file.put('\x7f');
+    }
+    EXPECT_THROW(loaded.load(path), std::runtime_error);
+    // a failed load leaves the contents alone
+    EXPECT_EQ(loaded.size(), 1u);
+    EXPECT_TRUE(loaded.contains(-1));
+
+    list.save(path);
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 4);
+    EXPECT_THROW(loaded.load(path), std::runtime_error);
+
+    list.save(path);
+    SkipList<long long> wider;
+    EXPECT_THROW(wider.load(path), std::runtime_error);
+
+    std::filesystem::remove(path);
+    EXPECT_THROW(loaded.load(path), std::system_error);
+    EXPECT_TRUE(loaded.contains(-1));
+}
+
+TEST(SkipList, CountingStats) {
+    SkipList<int, std::less<int>, CountingStats> list;
+    std::mt19937 gen(11);
+    std::uniform_int_distribution<int> dist(0, 100000);
+    size_t inserted = 0;
+    for (int i = 0; i < 20000; ++i)
+        inserted += list.insert(dist(gen)) ? 1 : 0;
+
+    StatsSnapshot stats = list.stats().snapshot();
+    EXPECT_EQ(stats.allocations, inserted);
+    EXPECT_EQ(stats.rotations(), 0u);
+    EXPECT_GT(stats.comparisons, stats.searches());
+    // every node got a level, about half of them stay on the lowest lane
+    uint64_t levels = 0;
+    for (uint64_t count : stats.levels)
+        levels += count;
+    EXPECT_EQ(levels, inserted);
+    EXPECT_EQ(stats.levels[0], 0u);
+    EXPECT_GT(stats.levels[1], inserted / 3);
+    EXPECT_LT(stats.levels[1], inserted * 2 / 3);
+
+    list.stats().reset();
+    EXPECT_EQ(list.stats().snapshot().comparisons, 0u);
+    for (int i = 0; i < 1000; ++i)
+        static_cast<void>(list.contains(dist(gen)));
+    stats = list.stats().snapshot();
+    EXPECT_EQ(stats.searches(), 1000u);
+    EXPECT_EQ(stats.allocations, 0u);
+}
+
+// NOLINTEND
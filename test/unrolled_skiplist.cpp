@@ -0,0 +1,49 @@
+// NOLINTBEGIN
+#include "unrolled_skiplist/unrolled_skiplist.h"
+#include "ordered_set_tests.h"
+#include <gtest/gtest.h>
+#include <functional>
+#include <memory>
+
+struct UnrolledSkipListTraits {
+    template <typename T, typename Compare = std::less<T>>
+    using Set = UnrolledSkipList<T, Compare>;
+    // Four values per block, so every split, refill and merge path runs often
+    template <typename T> using Small = UnrolledSkipList<T, std::less<T>, 1>;
+    template <typename S> static bool isReset(const S &list) {
+        return list.blocks() == 0;
+    }
+};
+
+INSTANTIATE_TYPED_TEST_SUITE_P(UnrolledSkipList, OrderedSetTest,
+                               UnrolledSkipListTraits);
+
+TEST(UnrolledSkipList, BlocksStayFilled) {
+    UnrolledSkipList<int> list;
+    const int count = 100000;
+    for (int i = 0; i < count; ++i)
+        list.insert(i);
+
+    // 64 ints per block and splits leave both halves half full
+    EXPECT_LE(list.blocks(), static_cast<size_t>(count / 32 + 1));
+    EXPECT_EQ(*list.max(), count - 1);
+
+    // removing most values merges the blocks that ran low
+    for (int i = 0; i < count; ++i) {
+        if (i % 10 != 0)
+            list.remove(i);
+    }
+    EXPECT_EQ(list.size(), static_cast<size_t>(count / 10));
+    EXPECT_LE(list.blocks(), static_cast<size_t>(count / 10 / 16 + 1));
+    EXPECT_EQ(*list.min(), 0);
+    EXPECT_EQ(*list.max(), count - 10);
+}
+
+TEST(UnrolledSkipList, MoveOnlyValues) {
+    UnrolledSkipList<std::unique_ptr<int>> list;
+
+    EXPECT_TRUE(list.insert(std::make_unique<int>(1)));
+    EXPECT_TRUE(list.insert(std::make_unique<int>(2)));
+    EXPECT_EQ(list.size(), 2u);
+}
+// NOLINTEND